@@ -54,6 +54,10 @@ int main( int argc, char** argv )
         the_main.add_config_option< unsigned >( "-n,--n-files", "daq.n-files", "Number of files to be written in parallel" );
         the_main.add_config_option< unsigned >( "-d,--duration", "daq.duration", "Run duration in ms" );
         the_main.add_config_option< double >( "-m,--max-file-size-mb", "daq.max-file-size-mb", "Maximum file size in MB" );
+        the_main.add_config_option< double >( "--max-file-duration-s", "daq.max-file-duration-s", "Rotate files every this many seconds instead of by size" );
+        the_main.add_config_option< unsigned >( "--max-file-records", "daq.max-file-records", "Rotate files every this many records of each stream instead of by size" );
+        the_main.add_config_option< unsigned >( "--on-deck-depth", "daq.on-deck-depth", "Number of continuation files kept ready for switching" );
+        the_main.add_config_flag< bool >( "--preallocate-files", "daq.preallocate-files", "Flag to reserve the maximum file size on disk for each egg file" );
 
         // Package version
         the_main.set_version( new psyllid::version() );
@@ -0,0 +1,98 @@
+/*
+ * raw_to_egg3.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Converts a raw egg file, written by the raw-streaming-writer node, to an egg3 file.
+ *  The egg3 file has a single stream with a single channel, with the metadata from the raw egg header.
+ *  If the raw egg file wasn't finished (e.g. psyllid stopped during the run), the records that were indexed are converted.
+ *
+ *  Usage: > raw_to_egg3 [input raw egg file] [output egg3 file]
+ *
+ *  Returns 0 if the file was converted; -1 otherwise.
+ */
+
+#include "psyllid_error.hh"
+#include "raw_egg.hh"
+
+#include "logger.hh"
+
+#include "M3Monarch.hh"
+
+#include <cstring>
+#include <memory>
+#include <string>
+#include <vector>
+
+using namespace psyllid;
+
+LOGGER( plog, "raw_to_egg3" );
+
+int main( int argc, char** argv )
+{
+    if( argc < 3 )
+    {
+        LERROR( plog, "Usage: raw_to_egg3 [input raw egg file] [output egg3 file]" );
+        return -1;
+    }
+    std::string t_in_filename( argv[ 1 ] );
+    std::string t_out_filename( argv[ 2 ] );
+
+    try
+    {
+        raw_egg_file_reader t_reader;
+        t_reader.open( t_in_filename );
+        const raw_egg_header& t_raw_header = t_reader.header();
+        if( ! t_reader.was_finished() )
+        {
+            LWARN( plog, "Raw egg file <" << t_in_filename << "> was not finished; " << t_reader.get_n_records() << " records were recovered from its index" );
+        }
+
+        std::unique_ptr< monarch3::Monarch3 > t_egg( monarch3::Monarch3::OpenForWriting( t_out_filename ) );
+        monarch3::M3Header* t_egg_header = t_egg->GetHeader();
+        t_egg_header->SetFilename( t_out_filename );
+        t_egg_header->SetTimestamp( t_raw_header.f_timestamp );
+        t_egg_header->SetDescription( t_raw_header.f_description );
+        t_egg_header->SetRunDuration( t_raw_header.f_run_duration );
+
+        std::vector< unsigned > t_chan_vec;
+        unsigned t_stream_no = t_egg_header->AddStream( t_raw_header.f_source,
+                t_raw_header.f_acq_rate, t_raw_header.f_record_size, t_raw_header.f_sample_size, t_raw_header.f_data_type_size,
+                t_raw_header.f_data_format, t_raw_header.f_bit_depth, t_raw_header.f_bit_alignment, &t_chan_vec );
+        for( std::vector< unsigned >::const_iterator it = t_chan_vec.begin(); it != t_chan_vec.end(); ++it )
+        {
+            t_egg_header->GetChannelHeaders()[ *it ].SetVoltageOffset( t_raw_header.f_v_offset );
+            t_egg_header->GetChannelHeaders()[ *it ].SetVoltageRange( t_raw_header.f_v_range );
+            t_egg_header->GetChannelHeaders()[ *it ].SetDACGain( t_raw_header.f_dac_gain );
+            t_egg_header->GetChannelHeaders()[ *it ].SetFrequencyMin( t_raw_header.f_freq_min );
+            t_egg_header->GetChannelHeaders()[ *it ].SetFrequencyRange( t_raw_header.f_freq_range );
+        }
+        t_egg->WriteHeader();
+
+        monarch3::M3Stream* t_stream = t_egg->GetStream( t_stream_no );
+        monarch3::M3Record* t_record = t_stream->GetStreamRecord();
+        std::vector< int8_t > t_buffer( t_raw_header.f_record_bytes );
+        for( uint64_t i_record = 0; i_record < t_reader.get_n_records(); ++i_record )
+        {
+            const raw_egg_index_entry& t_entry = t_reader.get_entry( i_record );
+            t_reader.read_record( i_record, t_buffer.data() );
+            t_record->SetRecordId( t_entry.f_id );
+            t_record->SetTime( t_entry.f_time );
+            ::memcpy( t_record->GetData(), t_buffer.data(), t_buffer.size() );
+            if( ! t_stream->WriteRecord( i_record == 0 || t_entry.is_new_acq() ) )
+            {
+                throw error() << "Unable to write record " << i_record << " (ID " << t_entry.f_id << ")";
+            }
+        }
+
+        t_egg->FinishWriting();
+        LINFO( plog, "Converted " << t_reader.get_n_records() << " records from <" << t_in_filename << "> to <" << t_out_filename << ">" );
+    }
+    catch( std::exception& e )
+    {
+        LERROR( plog, "Unable to convert <" << t_in_filename << ">: " << e.what() );
+        return -1;
+    }
+
+    return 0;
+}
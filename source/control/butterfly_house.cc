@@ -24,6 +24,10 @@ namespace psyllid
     butterfly_house::butterfly_house() :
             control_access(),
             f_max_file_size_mb( 500 ),
+            f_max_file_duration_s( 0. ),
+            f_max_file_records( 0 ),
+            f_on_deck_depth( 1 ),
+            f_preallocate_files( false ),
             f_file_infos(),
             f_mw_ptrs(),
             f_writers(),
@@ -52,6 +56,14 @@ namespace psyllid
         {
             f_file_infos.resize( a_daq_config.get_value( "n-files", 1U ) );
             set_max_file_size_mb( a_daq_config.get_value( "max-file-size-mb", get_max_file_size_mb() ) );
+            set_max_file_duration_s( a_daq_config.get_value( "max-file-duration-s", get_max_file_duration_s() ) );
+            set_max_file_records( a_daq_config.get_value( "max-file-records", get_max_file_records() ) );
+            if( get_max_file_duration_s() > 0. && get_max_file_records() > 0 )
+            {
+                throw error() << "Only one of max-file-duration-s and max-file-records can be set";
+            }
+            set_on_deck_depth( a_daq_config.get_value( "on-deck-depth", get_on_deck_depth() ) );
+            set_preallocate_files( a_daq_config.get_value( "preallocate-files", get_preallocate_files() ) );
         }
 
         for( file_infos_it fi_it = f_file_infos.begin(); fi_it != f_file_infos.end(); ++fi_it )
@@ -89,19 +101,14 @@ namespace psyllid
                 LDEBUG( plog, "Creating file <" << t_filename << ">" );
                 f_mw_ptrs[ t_file_num ] = monarch_wrap_ptr( new monarch_wrapper( t_filename ) );
                 f_mw_ptrs[ t_file_num ]->set_max_file_size( f_max_file_size_mb );
+                f_mw_ptrs[ t_file_num ]->set_max_file_duration( f_max_file_duration_s );
+                f_mw_ptrs[ t_file_num ]->set_max_file_records( f_max_file_records );
+                f_mw_ptrs[ t_file_num ]->set_on_deck_depth( f_on_deck_depth );
+                f_mw_ptrs[ t_file_num ]->set_preallocate( f_preallocate_files );
 
                 header_wrap_ptr t_hwrap_ptr = f_mw_ptrs[ t_file_num ]->get_header();
                 unique_lock t_header_lock( t_hwrap_ptr->get_lock() );
-                t_hwrap_ptr->header().SetDescription( f_file_infos[ t_file_num ].f_description );
-
-                time_t t_raw_time = time( nullptr );
-                struct tm* t_processed_time = gmtime( &t_raw_time );
-                char t_timestamp[ 512 ];
-                strftime( t_timestamp, 512, scarab::date_time_format, t_processed_time );
-                //LWARN( plog, "raw: " << t_raw_time << "   proc'd: " << t_processed_time->tm_hour << " " << t_processed_time->tm_min << " " << t_processed_time->tm_year << "   timestamp: " << t_timestamp );
-                t_hwrap_ptr->header().SetTimestamp( t_timestamp );
-
-                t_hwrap_ptr->header().SetRunDuration( t_run_duration );
+                fill_header( t_hwrap_ptr, f_file_infos[ t_file_num ].f_description, t_run_duration );
 
                 // writer/stream setup
                 LDEBUG( plog, "Setting up streams" );
@@ -150,6 +157,53 @@ namespace psyllid
         return;
     }
 
+    monarch_wrap_ptr butterfly_house::start_standalone_file( const std::string& a_filename, const std::string& a_description, unsigned a_duration_ms, egg_writer* a_writer )
+    {
+        LINFO( plog, "Starting standalone egg3 file <" << a_filename << ">" );
+
+        monarch_wrap_ptr t_mw_ptr( new monarch_wrapper( a_filename ) );
+        t_mw_ptr->set_max_file_size( get_max_file_size_mb() );
+        t_mw_ptr->set_max_file_duration( get_max_file_duration_s() );
+        t_mw_ptr->set_max_file_records( get_max_file_records() );
+        t_mw_ptr->set_on_deck_depth( get_on_deck_depth() );
+        t_mw_ptr->set_preallocate( get_preallocate_files() );
+
+        header_wrap_ptr t_hwrap_ptr = t_mw_ptr->get_header();
+        unique_lock t_header_lock( t_hwrap_ptr->get_lock() );
+        fill_header( t_hwrap_ptr, a_description, a_duration_ms );
+
+        a_writer->prepare_to_write( t_mw_ptr, t_hwrap_ptr );
+
+        // the header mutex is locked again in monarch_wrapper::start_using()
+        t_header_lock.unlock();
+
+        t_mw_ptr->start_using();
+        return t_mw_ptr;
+    }
+
+    void butterfly_house::finish_standalone_file( monarch_wrap_ptr a_mw_ptr )
+    {
+        a_mw_ptr->cancel();
+        a_mw_ptr->stop_using();
+        a_mw_ptr->finish_file();
+        return;
+    }
+
+    void butterfly_house::fill_header( header_wrap_ptr a_hwrap_ptr, const std::string& a_description, unsigned a_duration_ms )
+    {
+        a_hwrap_ptr->header().SetDescription( a_description );
+
+        time_t t_raw_time = time( nullptr );
+        struct tm* t_processed_time = gmtime( &t_raw_time );
+        char t_timestamp[ 512 ];
+        strftime( t_timestamp, 512, scarab::date_time_format, t_processed_time );
+        //LWARN( plog, "raw: " << t_raw_time << "   proc'd: " << t_processed_time->tm_hour << " " << t_processed_time->tm_min << " " << t_processed_time->tm_year << "   timestamp: " << t_timestamp );
+        a_hwrap_ptr->header().SetTimestamp( t_timestamp );
+
+        a_hwrap_ptr->header().SetRunDuration( a_duration_ms );
+        return;
+    }
+
     void butterfly_house::register_writer( egg_writer* a_writer, unsigned a_file_num )
     {
         std::unique_lock< std::mutex > t_lock( f_house_mutex );
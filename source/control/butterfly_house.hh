@@ -50,13 +50,17 @@ namespace psyllid
      @details
      Holds one monarch pointer per file.
      Registers the writer and creates, prepares, starts and finishes egg files via monarch3_wrapper.
-     butterfly_house gets the file size from the psyllid config file and the filename, run duration and description from daq_control.
+     butterfly_house gets the file size, rotation, on-deck depth and preallocation settings from the psyllid config file and the filename, run duration and description from daq_control.
      It adds this information to the file header.
      */
     class butterfly_house : public scarab::singleton< butterfly_house >, public control_access
     {
         public:
             mv_accessible( double, max_file_size_mb );
+            mv_accessible( double, max_file_duration_s );
+            mv_accessible( unsigned, max_file_records );
+            mv_accessible( unsigned, on_deck_depth );
+            mv_accessible( bool, preallocate_files );
 
         public:
             void register_file( unsigned a_file_num, const std::string& a_filename, const std::string& a_description, unsigned a_duration_ms );
@@ -67,6 +71,13 @@ namespace psyllid
 
             void finish_files();
 
+            /// Creates, prepares and starts a file that is not one of the run's files, with a single writer (e.g. for a dump of buffered data).
+            /// The file is split like the run's files (by size, duration or number of records).
+            monarch_wrap_ptr start_standalone_file( const std::string& a_filename, const std::string& a_description, unsigned a_duration_ms, egg_writer* a_writer );
+
+            /// Finishes a file started with start_standalone_file(); the writer must have finished its stream
+            void finish_standalone_file( monarch_wrap_ptr a_mw_ptr );
+
             void register_writer( egg_writer* a_writer, unsigned a_file_num );
 
             void unregister_writer( egg_writer* a_writer );
@@ -78,6 +89,9 @@ namespace psyllid
             const std::string& get_description( unsigned a_file_num );
 
         private:
+            /// Sets the description, timestamp and run duration; the header lock must be held
+            void fill_header( header_wrap_ptr a_hwrap_ptr, const std::string& a_description, unsigned a_duration_ms );
+
             struct file_info
             {
                 std::string f_filename;
@@ -950,10 +950,29 @@ namespace psyllid
         t_server_node.add( "status", param_value( interpret_status( get_status() ) ) );
         t_server_node.add( "status-value", param_value( status_to_uint( get_status() ) ) );
 
-        // TODO: add status of nodes
+        // status of the active nodes that report any
+        param_node t_nodes_node;
+        if( f_node_bindings != nullptr )
+        {
+            for( active_node_bindings::const_iterator t_binding_it = f_node_bindings->begin(); t_binding_it != f_node_bindings->end(); ++t_binding_it )
+            {
+                param_node t_node_status;
+                try
+                {
+                    t_binding_it->second.first->dump_status( t_binding_it->second.second, t_node_status );
+                }
+                catch( std::exception& e )
+                {
+                    LWARN( plog, "Unable to get the status of node <" << t_binding_it->first << ">: " << e.what() );
+                    continue;
+                }
+                if( ! t_node_status.empty() ) t_nodes_node.add( t_binding_it->first, t_node_status );
+            }
+        }
 
         param_ptr_t t_payload_ptr( new param_node() );
         t_payload_ptr->as_node().add( "server", t_server_node );
+        if( ! t_nodes_node.empty() ) t_payload_ptr->as_node().add( "nodes", t_nodes_node );
 
         return a_request->reply( dripline::dl_success(), "DAQ status request succeeded", std::move(t_payload_ptr) );
 
@@ -56,6 +56,10 @@ namespace psyllid
      - "activate-at-startup" (boolean): whether or not the DAQ control is activated immediately on startup
      - "n-files" (integer): number of files that will be written in parallel
      - "max-file-size-mb" (float): maximum egg file size; writing will switch to a new file after that is reached
+     - "max-file-duration-s" (float): if nonzero, egg files are rotated every max-file-duration-s seconds instead of by size; each stream switches files at the first record boundary after the file's time is up
+     - "max-file-records" (integer): if nonzero, egg files are rotated every max-file-records records of each stream instead of by size; only one of max-file-duration-s and max-file-records can be set
+     - "on-deck-depth" (integer): number of continuation files kept open and ready for switching; increase it if files fill faster than they can be created
+     - "preallocate-files" (boolean): whether each egg file reserves max-file-size-mb of disk space when it's created (Linux only); unused space is released when the file is finished
      */
     class daq_control : public scarab::cancelable, public control_access
     {
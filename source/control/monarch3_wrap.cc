@@ -18,9 +18,17 @@
 
 #include <boost/filesystem.hpp>
 
+#include <cerrno>
+#include <cstring>
 #include <future>
 #include <signal.h>
 
+#ifdef __linux__
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
 
 namespace psyllid
 {
@@ -41,6 +49,61 @@ namespace psyllid
     }
 
 
+    //***************************
+    // file preallocation
+    //***************************
+
+    // Reserves disk space for the first a_size_mb of the file without changing its size (fallocate with FALLOC_FL_KEEP_SIZE),
+    // so that the filesystem allocates the file's extents now rather than as HDF5 appends records.
+    // Returns false, after logging a warning, if the space couldn't be reserved; the file is still usable.
+    bool preallocate_file( const std::string& a_filename, double a_size_mb )
+    {
+#ifdef __linux__
+        if( a_size_mb <= 0. ) return false;
+        int t_fd = ::open( a_filename.c_str(), O_WRONLY );
+        if( t_fd < 0 )
+        {
+            LWARN( plog, "Unable to open <" << a_filename << "> to preallocate it: " << strerror( errno ) );
+            return false;
+        }
+        int t_result = ::fallocate( t_fd, FALLOC_FL_KEEP_SIZE, 0, (off_t)( a_size_mb * 1.e6 ) );
+        int t_errno = errno;
+        ::close( t_fd );
+        if( t_result != 0 )
+        {
+            LWARN( plog, "Unable to preallocate " << a_size_mb << " MB for <" << a_filename << ">: " << strerror( t_errno ) );
+            return false;
+        }
+        LDEBUG( plog, "Preallocated " << a_size_mb << " MB for <" << a_filename << ">" );
+        return true;
+#else
+        LWARN( plog, "File preallocation is only available on Linux; <" << a_filename << "> was not preallocated" );
+        return false;
+#endif
+    }
+
+    // Releases any space reserved past the end of a finished file
+    void trim_file( const std::string& a_filename )
+    {
+#ifdef __linux__
+        int t_fd = ::open( a_filename.c_str(), O_WRONLY );
+        if( t_fd < 0 )
+        {
+            LWARN( plog, "Unable to open <" << a_filename << "> to trim it: " << strerror( errno ) );
+            return;
+        }
+        // truncating to the current size frees the blocks past the end of the file
+        struct stat t_stat;
+        if( ::fstat( t_fd, &t_stat ) != 0 || ::ftruncate( t_fd, t_stat.st_size ) != 0 )
+        {
+            LWARN( plog, "Unable to trim <" << a_filename << ">: " << strerror( errno ) );
+        }
+        ::close( t_fd );
+#endif
+        return;
+    }
+
+
     //***************************
     // monarch_on_deck_manager
     //***************************
@@ -48,10 +111,14 @@ namespace psyllid
     monarch_on_deck_manager::monarch_on_deck_manager( monarch_wrapper* a_monarch_wrap ) :
             scarab::cancelable(),
             f_monarch_wrap( a_monarch_wrap ),
-            f_monarch_on_deck(),
+            f_monarchs_on_deck(),
+            f_monarch_to_finish(),
             f_od_condition(),
             f_od_continue_condition(),
-            f_od_mutex()
+            f_od_mutex(),
+            f_create_mutex(),
+            f_on_deck_depth( 1 ),
+            f_n_pool_dry( 0 )
     {}
 
     monarch_on_deck_manager::~monarch_on_deck_manager()
@@ -63,32 +130,26 @@ namespace psyllid
 
         while( ! is_canceled() && f_monarch_wrap->f_stage != monarch_stage::finished )
         {
-            unique_lock t_od_lock( f_od_mutex );
+            {
+                unique_lock t_od_lock( f_od_mutex );
 
-            // wait on the condition variable
-            f_od_condition.wait_for( t_od_lock, std::chrono::milliseconds( 500 ) );
+                // wait on the condition variable
+                f_od_condition.wait_for( t_od_lock, std::chrono::milliseconds( 500 ) );
+            }
 
-            // this particular setup of the while on t_do_wait and the if-elseif-else structure
-            // is used so that any of the actions can be taken in any order without going through waiting on the condition.
+            // the files are finished and created without the on-deck mutex locked, so that the switch thread can take an on-deck file in the meantime.
+            // finishing comes first, so that the to-finish slot is free for the next switch; then the on-deck pool is filled one file at a time.
             bool t_do_wait = false;
             try
             {
-                while( ! t_do_wait )
+                while( ! t_do_wait && ! is_canceled() )
                 {
-                    if( f_monarch_to_finish )
+                    if( mtf_exists() )
                     {
                         // then we need to finish a file
-                        // finish the old file
-                        LDEBUG( plog, "Finishing pre-existing to-finish file" );
-                        finish_to_finish_nolock();
+                        finish_to_finish();
                     }
-                    else if( ! f_monarch_on_deck )
-                    {
-                        // then we need to make a new on-deck monarch
-                        unique_lock t_header_lock( f_monarch_wrap->get_header()->get_lock() );
-                        create_on_deck_nolock();
-                    }
-                    else
+                    else if( ! fill_on_deck() )
                     {
                         t_do_wait = true;
                     }
@@ -136,7 +197,8 @@ namespace psyllid
             monarch3::M3Header* t_new_header = t_new_monarch->GetHeader();
             t_new_header->CopyBasicInfo( t_old_header_ptr->header() );
             t_new_header->SetFilename( t_new_filename );
-            t_new_header->SetDescription( t_old_header_ptr->ptr()->GetDescription() + "\nContinuation of file " + t_old_header_ptr->ptr()->GetFilename() );
+            // the predecessor isn't known until the file is taken from the pool, so it's added to the description then
+            t_new_header->SetDescription( f_monarch_wrap->f_base_description );
 
             // for each stream, create new stream in new file
             std::vector< monarch3::M3StreamHeader >* t_old_stream_headers = &t_old_header_ptr->ptr()->GetStreamHeaders();
@@ -175,12 +237,12 @@ namespace psyllid
                 }
             }
 
-            // write the new header
-            LTRACE( plog, "Writing new header" );
-            t_new_monarch->WriteHeader();
+            // the header is written when the file is taken from the pool (see get_on_deck())
+            if( f_monarch_wrap->f_preallocate ) preallocate_file( t_new_filename, f_monarch_wrap->f_max_file_size_mb );
 
-            // switch out the monarch pointers, f_monarch_on_deck <--> t_new_monarch
-            f_monarch_on_deck.swap( t_new_monarch );
+            // add the new file to the end of the pool
+            unique_lock t_od_lock( f_od_mutex );
+            f_monarchs_on_deck.push_back( t_new_monarch );
         }
         catch(...)
         {
@@ -189,16 +251,89 @@ namespace psyllid
         return;
     }
 
+    void monarch_on_deck_manager::set_on_deck_depth( unsigned a_depth )
+    {
+        if( a_depth == 0 )
+        {
+            throw error() << "On-deck depth must be at least 1";
+        }
+        f_on_deck_depth = a_depth;
+        return;
+    }
+
+    bool monarch_on_deck_manager::fill_on_deck()
+    {
+        unique_lock t_create_lock( f_create_mutex );
+        if( get_n_on_deck() >= f_on_deck_depth ) return false;
+
+        unique_lock t_header_lock( f_monarch_wrap->get_header()->get_lock() );
+        create_on_deck_nolock();
+        return true;
+    }
+
+    void monarch_on_deck_manager::create_on_deck()
+    {
+        unique_lock t_create_lock( f_create_mutex );
+        // the manager thread may have added a file while this thread waited for the creation mutex
+        if( mod_exists() ) return;
+
+        unique_lock t_header_lock( f_monarch_wrap->get_header()->get_lock() );
+        create_on_deck_nolock();
+        return;
+    }
+
+    void monarch_on_deck_manager::fill_pool()
+    {
+        while( fill_on_deck() ) {}
+        return;
+    }
+
+    void monarch_on_deck_manager::get_on_deck( std::shared_ptr< monarch3::Monarch3 >& a_monarch, const std::string& a_predecessor_filename )
+    {
+        unique_lock t_od_lock( f_od_mutex );
+        if( f_monarchs_on_deck.empty() )
+        {
+            // the pool ran dry, so the file is created here, on the switching thread
+            uint64_t t_n_dry = ++f_n_pool_dry;
+            LWARN( plog, "No on-deck file was ready; creating one synchronously (the on-deck pool has run dry " << t_n_dry << " time(s); consider increasing on-deck-depth)" );
+            t_od_lock.unlock();
+            create_on_deck();
+            t_od_lock.lock();
+        }
+        // only the switch thread takes files from the pool, so it can't have been emptied again
+        a_monarch = f_monarchs_on_deck.front();
+        f_monarchs_on_deck.pop_front();
+        t_od_lock.unlock();
+
+        // replace the file that was taken
+        notify();
+
+        // the file now has its place in the sequence, so its header can be written
+        monarch3::M3Header* t_header = a_monarch->GetHeader();
+        t_header->SetDescription( f_monarch_wrap->f_base_description + "\nContinuation of file " + a_predecessor_filename );
+        LTRACE( plog, "Writing header for <" << t_header->GetFilename() << ">" );
+        try
+        {
+            a_monarch->WriteHeader();
+        }
+        catch( monarch3::M3Exception& e )
+        {
+            throw error() << "Unable to write the header for <" << t_header->GetFilename() << ">: " << e.what();
+        }
+        return;
+    }
+
     void monarch_on_deck_manager::clear_on_deck()
     {
-        f_od_mutex.lock();
-        if( f_monarch_on_deck )
+        unique_lock t_create_lock( f_create_mutex );
+        unique_lock t_od_lock( f_od_mutex );
+        while( ! f_monarchs_on_deck.empty() )
         {
-            std::string t_filename( f_monarch_on_deck->GetHeader()->GetFilename() );
+            std::string t_filename( f_monarchs_on_deck.front()->GetHeader()->GetFilename() );
             try
             {
                 LDEBUG( plog, "Closing on-deck file <" << t_filename << ">" );
-                f_monarch_on_deck.reset();
+                f_monarchs_on_deck.pop_front();
             }
             catch( monarch3::M3Exception& e )
             {
@@ -214,19 +349,23 @@ namespace psyllid
                 LWARN( plog, "File could not be removed: <" << t_filename << ">\n" << e.what() );
             }
         }
-        f_od_mutex.unlock();
         return;
     }
 
     void monarch_on_deck_manager::finish_to_finish()
     {
+        // take the file out of the slot, and finish it without the on-deck mutex locked
+        std::shared_ptr< monarch3::Monarch3 > t_to_finish;
         f_od_mutex.lock();
-        if( f_monarch_to_finish )
+        t_to_finish.swap( f_monarch_to_finish );
+        f_od_mutex.unlock();
+        if( t_to_finish )
         {
             LDEBUG( plog, "Finishing to-finish file" );
-            finish_to_finish_nolock();
+            std::string t_filename( t_to_finish->GetHeader()->GetFilename() );
+            t_to_finish->FinishWriting();
+            if( f_monarch_wrap->f_preallocate ) trim_file( t_filename );
         }
-        f_od_mutex.unlock();
         return;
     }
 
@@ -239,16 +378,24 @@ namespace psyllid
             f_orig_filename( a_filename ),
             f_filename_base(),
             f_filename_ext(),
+            f_base_description(),
             f_file_count( 1 ),
             f_max_file_size_mb( 0. ),
+            f_max_file_duration_ns( 0 ),
+            f_max_file_records( 0 ),
+            f_preallocate( false ),
             f_file_size_est_mb( 0. ),
-            f_wait_to_write(),
             f_switch_thread( nullptr ),
             f_ok_to_write( true ),
             f_do_switch_flag( false ),
             f_do_switch_trig(),
             f_monarch(),
             f_monarch_mutex(),
+            f_file_epoch( 0 ),
+            f_monarch_retiring(),
+            f_newest_adopted( false ),
+            f_rotation_start(),
+            f_boundary_ns( 0 ),
             f_header_wrap(),
             f_stream_wraps(),
             f_run_start_time( std::chrono::steady_clock::now() ),
@@ -308,10 +455,17 @@ namespace psyllid
 
         try
         {
+            if( f_monarch_retiring )
+            {
+                f_monarch_retiring->FinishWriting();
+                f_monarch_retiring.reset();
+            }
             if( f_monarch )
             {
+                std::string t_filename( f_monarch->GetHeader()->GetFilename() );
                 f_monarch->FinishWriting();
                 f_monarch.reset();
+                if( f_preallocate ) trim_file( t_filename );
             }
 
         }
@@ -320,7 +474,7 @@ namespace psyllid
             LERROR( plog, "Unable to write file on monarch_wrapper deletion: " << e.what() );
         }
 
-        f_wait_to_write.notify_all();
+        f_ok_to_write = false;
 
         f_monarch_mutex.unlock();
 
@@ -359,7 +513,18 @@ namespace psyllid
         {
             try
             {
-                stream_wrap_ptr t_stream_ptr( new stream_wrapper( *f_monarch.get(), a_stream_no, this ) );
+                // with boundary rotation, the writer starts in the file the other writers are in, and adopts the newest file at the boundary
+                stream_wrap_ptr t_stream_ptr( new stream_wrapper( f_monarch_retiring ? *f_monarch_retiring.get() : *f_monarch.get(), a_stream_no, this ) );
+                if( f_monarch_retiring )
+                {
+                    monarch3::M3Stream* t_next_stream = f_monarch->GetStream( a_stream_no );
+                    if( t_next_stream == nullptr )
+                    {
+                        throw error() << "Stream <" << a_stream_no << "> was invalid";
+                    }
+                    t_stream_ptr->f_next_stream.store( t_next_stream );
+                    t_stream_ptr->f_epoch.store( f_file_epoch - 1 );
+                }
                 f_stream_wraps[ a_stream_no ] = t_stream_ptr;
             }
             catch( error& e )
@@ -384,10 +549,16 @@ namespace psyllid
             throw error() << "On-deck thread already exists";
         }
 
+        if( f_max_file_duration_ns > 0 && f_max_file_records > 0 )
+        {
+            throw error() << "Files can be rotated by duration or by number of records, but not both";
+        }
+
         unique_lock t_monarch_lock( f_monarch_mutex );
         unique_lock t_header_lock( f_header_wrap->get_lock() );
 
         LDEBUG( plog, "Writing the header for file <" << f_header_wrap->header().GetFilename() );
+        f_base_description = f_header_wrap->header().GetDescription();
         try
         {
             f_monarch->WriteHeader();
@@ -401,9 +572,17 @@ namespace psyllid
 
         t_header_lock.unlock();
 
+        if( f_preallocate ) preallocate_file( f_orig_filename, f_max_file_size_mb );
+
+        // fill the on-deck pool before any data is written, so that the first switches don't wait for files to be created
+        LDEBUG( plog, "Creating " << f_monarch_od_manager.get_on_deck_depth() << " on-deck file(s)" );
+        f_monarch_od_manager.fill_pool();
+
         // prepare file-switching components
 
-        f_do_switch_flag = false;
+        // with boundary rotation, the boundaries are counted from now, and the first switch is made right away, so that the next file is ready for the writers
+        f_rotation_start = std::chrono::steady_clock::now();
+        f_do_switch_flag = uses_boundary_rotation();
 
         LDEBUG( plog, "Starting the switch thread for file <" << f_header_wrap->header().GetFilename() << ">" );
         f_switch_thread = new std::thread( &monarch_wrapper::execute_switch_loop, this );
@@ -429,32 +608,30 @@ namespace psyllid
         {
             unique_lock t_lock( f_monarch_mutex );
 
-            // wait on the condition variable
-            while( ! f_do_switch_flag.load() && ! is_canceled() )
+            // wait on the condition variable; with boundary rotation, the next switch is made once the writers have all adopted the newest file
+            while( ( f_monarch_retiring ? ! writers_adopted_newest() : ! f_do_switch_flag.load() ) && ! is_canceled() )
             {
                 f_do_switch_trig.wait_for( t_lock, std::chrono::milliseconds( 500 ) );
             }
             if( is_canceled() ) break;
             //if( f_stage == monarch_stage::finished) break;
 
-            // f_monarch_mutex is locked at this point
-
-            f_ok_to_write = false;
+            // f_monarch_mutex is locked at this point; writers don't need it, so they keep writing during the switch
 
             LDEBUG( plog, "Switching egg files" );
             try
             {
+                if( f_monarch_retiring ) retire_old_file();
                 switch_to_new_file();
             }
             catch( std::exception& e )
             {
                 LERROR( plog, "Caught exception while switching to new file: " << e.what() );
+                f_ok_to_write = false;
                 scarab::signal_handler::cancel_all( RETURN_ERROR );
             }
 
             f_do_switch_flag = false;
-            f_ok_to_write = true;
-            f_wait_to_write.notify_all();
 
         } // end while( ! f_monarch_od_manager.is_canceled() && f_monarch_wrap->f_stage != monarch_stage::finished )
 
@@ -471,6 +648,27 @@ namespace psyllid
         return;
     }
 
+    bool monarch_wrapper::writers_adopted_newest() const
+    {
+        if( ! f_monarch_retiring || f_stream_wraps.empty() ) return false;
+        for( std::map< unsigned, stream_wrap_ptr >::const_iterator t_stream_it = f_stream_wraps.begin(); t_stream_it != f_stream_wraps.end(); ++t_stream_it )
+        {
+            if( t_stream_it->second->f_epoch.load( std::memory_order_acquire ) != f_file_epoch ) return false;
+        }
+        return true;
+    }
+
+    void monarch_wrapper::retire_old_file()
+    {
+        LDEBUG( plog, "Writers have all left <" << f_monarch_retiring->GetHeader()->GetFilename() << ">; it will be finished" );
+        // the to-finish slot must be empty before the retiring file is put in it
+        f_monarch_od_manager.finish_to_finish();
+        f_monarch_od_manager.set_as_to_finish( f_monarch_retiring );
+        f_monarch_retiring.reset();
+        f_monarch_od_manager.notify();
+        return;
+    }
+
     void monarch_wrapper::stop_using()
     {
         if( f_od_thread == nullptr )
@@ -517,8 +715,6 @@ namespace psyllid
     {
         unique_lock t_monarch_lock( f_monarch_mutex );
 
-        std::string t_filename( f_monarch->GetHeader()->GetFilename() );
-
         f_monarch_od_manager.finish_to_finish();
 
         if( f_stage == monarch_stage::preparing )
@@ -527,7 +723,7 @@ namespace psyllid
             try
             {
                 f_monarch->WriteHeader();
-                LDEBUG( plog, "Header written for file <" << t_filename << ">" );
+                LDEBUG( plog, "Header written for file <" << f_monarch->GetHeader()->GetFilename() << ">" );
             }
             catch( monarch3::M3Exception& e )
             {
@@ -547,11 +743,58 @@ namespace psyllid
                 throw error() << "Streams did not all finish after 5 seconds";
             }
             t_monarch_lock.lock();
+
+            if( f_monarch_retiring )
+            {
+                if( f_newest_adopted.load() )
+                {
+                    // some writers reached the boundary, so both files have records
+                    f_monarch_od_manager.set_as_to_finish( f_monarch_retiring );
+                    f_monarch_od_manager.finish_to_finish();
+                }
+                else
+                {
+                    // the run ended before the boundary, so the newest file has no records; the retiring file is the last one
+                    std::string t_unused_filename( f_monarch->GetHeader()->GetFilename() );
+                    f_monarch.swap( f_monarch_retiring );
+                    unique_lock t_header_lock( f_header_wrap->get_lock() );
+                    f_header_wrap->f_header = f_monarch->GetHeader();
+                    t_header_lock.unlock();
+                    try
+                    {
+                        LDEBUG( plog, "Closing unused file <" << t_unused_filename << ">" );
+                        f_monarch_retiring.reset();
+                    }
+                    catch( monarch3::M3Exception& e )
+                    {
+                        LWARN( plog, "File could not be closed properly: " << e.what() );
+                    }
+                    try
+                    {
+                        LDEBUG( plog, "The run ended before the boundary; now removing <" << t_unused_filename << ">" );
+                        boost::filesystem::remove( t_unused_filename );
+                    }
+                    catch( boost::filesystem::filesystem_error& e )
+                    {
+                        LWARN( plog, "File could not be removed: <" << t_unused_filename << ">\n" << e.what() );
+                    }
+                }
+                f_monarch_retiring.reset();
+            }
         }
+
+        std::string t_filename( f_monarch->GetHeader()->GetFilename() );
         LINFO( plog, "Finished writing file <" << t_filename << ">" );
+        if( f_monarch_od_manager.get_n_pool_dry() > 0 )
+        {
+            LWARN( plog, "The on-deck pool (depth " << f_monarch_od_manager.get_on_deck_depth() << ") ran dry " << f_monarch_od_manager.get_n_pool_dry() <<
+                    " time(s) while writing; new files were created on the write path" );
+        }
+        f_ok_to_write = false;
         set_stage( monarch_stage::finished );
         f_monarch->FinishWriting();
         f_monarch.reset();
+        if( f_preallocate ) trim_file( t_filename );
         f_file_size_est_mb = 0.;
         return;
     }
@@ -562,46 +805,86 @@ namespace psyllid
 
         try
         {
-            LDEBUG( plog, "Switching to new file; locking header mutex, and monarch mutex" );
-            unique_lock t_header_lock( f_header_wrap->get_lock() );
+            LDEBUG( plog, "Switching to new file" );
             //unique_lock t_monarch_lock( f_monarch_mutex ); // monarch mutex is already locked in the loop in execute_switch_loop
 
+            // the on-deck manager locks its mutex before the header mutex, so the header mutex is only locked after the on-deck calls
+
             // if the to-finish monarch is full for some reason, empty it
             LTRACE( plog, "Synchronous call to finish to-finish" );
             f_monarch_od_manager.finish_to_finish();
 
-            // if the on-deck monarch doesn't exist, create it
-            LTRACE( plog, "Synchronous call to create on-deck" );
-            f_monarch_od_manager.create_on_deck();
+            // take the next on-deck monarch; if the pool has run dry, it's created synchronously
+            LTRACE( plog, "Getting on-deck file" );
+            std::shared_ptr< monarch3::Monarch3 > t_new_monarch;
+            f_monarch_od_manager.get_on_deck( t_new_monarch, f_monarch->GetHeader()->GetFilename() );
 
             LTRACE( plog, "Switching file pointers" );
 
-            // move the old file to the to_finish pointer
-            f_monarch_od_manager.set_as_to_finish( f_monarch );
-
-            // move the on_deck pointer to the current pointer
-            f_monarch_od_manager.get_on_deck( f_monarch );
+            // the old file stays open until the writers have left it
+            std::shared_ptr< monarch3::Monarch3 > t_old_monarch;
+            t_old_monarch.swap( f_monarch );
+            f_monarch.swap( t_new_monarch );
 
             f_file_size_est_mb = 0.;
 
             LTRACE( plog, "Switching header pointer" );
 
             // swap out the header pointer
+            unique_lock t_header_lock( f_header_wrap->get_lock() );
             f_header_wrap->f_header = f_monarch->GetHeader();
             t_header_lock.unlock();
 
-            LTRACE( plog, "Switching stream pointers" );
+            LTRACE( plog, "Publishing stream pointers" );
 
-            // swap out the stream pointers
+            // publish the new streams; each writer switches to its new stream when it starts its next record
+            ++f_file_epoch;
+            if( uses_boundary_rotation() )
+            {
+                f_newest_adopted.store( false );
+                int64_t t_start_ns = std::chrono::duration_cast< std::chrono::nanoseconds >( f_rotation_start.time_since_epoch() ).count();
+                f_boundary_ns.store( t_start_ns + (int64_t)f_file_epoch * f_max_file_duration_ns );
+            }
             for( std::map< unsigned, stream_wrap_ptr >::iterator t_stream_it = f_stream_wraps.begin(); t_stream_it != f_stream_wraps.end(); ++t_stream_it )
             {
-                t_stream_it->second->f_stream = f_monarch->GetStream( t_stream_it->first );
-                if( t_stream_it->second->f_stream == nullptr )
+                monarch3::M3Stream* t_new_stream = f_monarch->GetStream( t_stream_it->first );
+                if( t_new_stream == nullptr )
                 {
                     throw error() << "Stream <" << t_stream_it->first << "> was invalid";
                 }
+                t_stream_it->second->f_next_stream.store( t_new_stream, std::memory_order_release );
+                t_stream_it->second->f_next_epoch.store( f_file_epoch );
+            }
+
+            if( uses_boundary_rotation() )
+            {
+                // the writers stay in the old file until they reach the boundary; the switch loop finishes it once they've all left
+                f_monarch_retiring.swap( t_old_monarch );
+                LDEBUG( plog, "Published <" << f_header_wrap->ptr()->GetFilename() << ">; writers will switch to it at the next boundary" );
+                return;
             }
 
+            // wait until no writer is in a record that might have started in the old file;
+            // any record started after this point uses the new file
+            LTRACE( plog, "Waiting for writers to leave the old file" );
+            auto t_wait_start = std::chrono::steady_clock::now();
+            for( std::map< unsigned, stream_wrap_ptr >::iterator t_stream_it = f_stream_wraps.begin(); t_stream_it != f_stream_wraps.end(); ++t_stream_it )
+            {
+                // a writer has left the old file once it's outside of a record, or once it has picked up the new stream
+                stream_wrapper* t_swrap = t_stream_it->second.get();
+                for( unsigned i_spin = 0; t_swrap->f_in_record.load() && t_swrap->f_epoch.load( std::memory_order_acquire ) != f_file_epoch && ! is_canceled(); ++i_spin )
+                {
+                    if( i_spin < 100 ) std::this_thread::yield();
+                    else std::this_thread::sleep_for( std::chrono::microseconds( 100 ) );
+                }
+            }
+            double t_wait_us = std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - t_wait_start ).count();
+            (void)t_wait_us; // only logged, and LDEBUG is compiled out in release builds
+            LDEBUG( plog, "Writers left the old file after " << t_wait_us << " us" );
+
+            // move the old file to the to_finish pointer
+            f_monarch_od_manager.set_as_to_finish( t_old_monarch );
+
             LDEBUG( plog, "Switch to new file is complete: <" << f_header_wrap->ptr()->GetFilename() << ">" );
 
             //f_file_switch_started = false;
@@ -629,7 +912,8 @@ namespace psyllid
         double t_file_size_est_mb = f_file_size_est_mb.load() + a_size;
         f_file_size_est_mb = t_file_size_est_mb;
         LTRACE( plog, "File contribution: " << a_size << " MB;  Estimated file size is now " << t_file_size_est_mb << " MB;  limit is " << f_max_file_size_mb << " MB" );
-        if( t_file_size_est_mb >= f_max_file_size_mb )
+        // with boundary rotation, the switches are made ahead of the boundaries, not by size
+        if( ! uses_boundary_rotation() && t_file_size_est_mb >= f_max_file_size_mb )
         {
             LDEBUG( plog, "Max file size exceeded (" << t_file_size_est_mb << " MB >= " << f_max_file_size_mb << " MB)" );
             trigger_switch();
@@ -639,15 +923,7 @@ namespace psyllid
 
     inline bool monarch_wrapper::okay_to_write()
     {
-        LTRACE( plog, "Checking ok to write" );
-        if( f_ok_to_write.load() ) return f_monarch.operator bool();
-        std::mutex t_wait_mutex;
-        unique_lock t_wait_lock( t_wait_mutex );
-        while( ! f_ok_to_write.load() )
-        {
-            f_wait_to_write.wait_for( t_wait_lock, std::chrono::milliseconds( 100 ) );
-        }
-        return f_monarch.operator bool();
+        return f_ok_to_write.load( std::memory_order_acquire );
     }
 
 
@@ -698,22 +974,34 @@ namespace psyllid
     stream_wrapper::stream_wrapper( monarch3::Monarch3& a_monarch, unsigned a_stream_no, monarch_wrapper* a_monarch_wrapper ) :
             f_monarch_wrapper( a_monarch_wrapper ),
             f_stream( a_monarch.GetStream( a_stream_no ) ),
+            f_epoch( a_monarch_wrapper->f_file_epoch ),
             f_is_valid( true ),
-            f_record_size_mb( 1.e-6 * (double)f_stream->GetStreamRecordNBytes() )
+            f_next_stream( f_stream ),
+            f_next_epoch( a_monarch_wrapper->f_file_epoch ),
+            f_in_record( false ),
+            f_n_file_records( 0 ),
+            f_record_size_mb( 0. )
     {
         if( f_stream == nullptr )
         {
             throw error() << "Invalid stream number requested: " << a_stream_no;
         }
+        f_record_size_mb = 1.e-6 * (double)f_stream->GetStreamRecordNBytes();
     }
 
     stream_wrapper::stream_wrapper( stream_wrapper&& a_orig ) :
             f_monarch_wrapper( a_orig.f_monarch_wrapper ),
             f_stream( a_orig.f_stream ),
+            f_epoch( a_orig.f_epoch.load() ),
             f_is_valid( a_orig.f_is_valid ),
+            f_next_stream( a_orig.f_next_stream.load() ),
+            f_next_epoch( a_orig.f_next_epoch.load() ),
+            f_in_record( false ),
+            f_n_file_records( a_orig.f_n_file_records ),
             f_record_size_mb( a_orig.f_record_size_mb )
     {
         a_orig.f_stream = nullptr;
+        a_orig.f_next_stream.store( nullptr );
         a_orig.f_is_valid = false;
     }
 
@@ -724,7 +1012,12 @@ namespace psyllid
     {
         f_monarch_wrapper = a_orig.f_monarch_wrapper;
         f_stream = a_orig.f_stream;
+        f_epoch.store( a_orig.f_epoch.load() );
+        f_next_stream.store( a_orig.f_next_stream.load() );
+        f_next_epoch.store( a_orig.f_next_epoch.load() );
+        f_n_file_records = a_orig.f_n_file_records;
         a_orig.f_stream = nullptr;
+        a_orig.f_next_stream.store( nullptr );
         a_orig.f_is_valid = false;
         f_record_size_mb = a_orig.f_record_size_mb;
         return *this;
@@ -733,19 +1026,67 @@ namespace psyllid
     /// Write the record contents to the file
     bool stream_wrapper::write_record( monarch3::RecordIdType a_rec_id, monarch3::TimeType a_rec_time, const void* a_rec_block, uint64_t a_bytes, bool a_is_new_acq )
     {
-        LTRACE( plog, "Writing record <" << a_rec_id << ">" );
+        monarch3::byte_type* t_data = begin_record();
+        if( t_data == nullptr ) return false;
+        ::memcpy( t_data, a_rec_block, a_bytes );
+        return commit_record( a_rec_id, a_rec_time, a_is_new_acq );
+    }
+
+    monarch3::byte_type* stream_wrapper::begin_record()
+    {
         if( ! f_monarch_wrapper->okay_to_write() )
         {
             LERROR( plog, "Unable to write to monarch file" );
-            //f_mutex.unlock();
-            return false;
+            return nullptr;
         }
-        get_stream_record()->SetRecordId( a_rec_id );
-        get_stream_record()->SetTime( a_rec_time );
-        ::memcpy( get_stream_record()->GetData(), a_rec_block, a_bytes );
+        enter_record();
+        return get_stream_record()->GetData();
+    }
+
+    bool stream_wrapper::commit_record( monarch3::RecordIdType a_rec_id, monarch3::TimeType a_rec_time, bool a_is_new_acq )
+    {
+        LTRACE( plog, "Writing record <" << a_rec_id << ">" );
+        monarch3::M3Record* t_record = get_stream_record();
+        t_record->SetRecordId( a_rec_id );
+        t_record->SetTime( a_rec_time );
         bool t_return = f_stream->WriteRecord( a_is_new_acq );
+        ++f_n_file_records;
+        exit_record();
         f_monarch_wrapper->record_file_contribution( f_record_size_mb );
         return t_return;
     }
 
+    bool stream_wrapper::write_records( const record_info* a_records, size_t a_n_records, uint64_t a_bytes )
+    {
+        if( a_n_records == 0 ) return true;
+        LTRACE( plog, "Writing " << a_n_records << " records, starting with <" << a_records[ 0 ].f_id << ">" );
+        if( ! f_monarch_wrapper->okay_to_write() )
+        {
+            LERROR( plog, "Unable to write to monarch file" );
+            return false;
+        }
+        enter_record();
+        monarch3::M3Record* t_record = get_stream_record();
+        bool t_return = true;
+        size_t i_record = 0;
+        for( ; i_record < a_n_records && t_return; ++i_record )
+        {
+            // with boundary rotation, the batch is split at the boundary
+            if( f_monarch_wrapper->uses_boundary_rotation() && f_next_epoch.load() != f_epoch.load( std::memory_order_relaxed ) && f_monarch_wrapper->boundary_reached( f_n_file_records ) )
+            {
+                exit_record();
+                enter_record();
+                t_record = get_stream_record();
+            }
+            t_record->SetRecordId( a_records[ i_record ].f_id );
+            t_record->SetTime( a_records[ i_record ].f_time );
+            ::memcpy( t_record->GetData(), a_records[ i_record ].f_block, a_bytes );
+            t_return = f_stream->WriteRecord( a_records[ i_record ].f_is_new_acq );
+            ++f_n_file_records;
+        }
+        exit_record();
+        f_monarch_wrapper->record_file_contribution( f_record_size_mb * (double)i_record );
+        return t_return;
+    }
+
 } /* namespace psyllid */
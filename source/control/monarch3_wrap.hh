@@ -29,6 +29,7 @@
 
 #include "cancelable.hh"
 
+#include <deque>
 #include <future>
 #include <map>
 #include <memory>
@@ -81,8 +82,15 @@ namespace psyllid
 
      Similarly, to help speed things along, file completion is also handled asynchronously by the same manager object.
 
-     The "on-deck" monarch object is the new file waiting to be used.
+     The "on-deck" monarch objects are the new files waiting to be used, in the order they'll be used; the manager keeps up to on-deck-depth of them
+     open, with their headers filled in.  A deeper pool absorbs bursts of file switches that come faster than new files can be created.
+     A file's header is written when it's taken from the pool, so that its description names the file it actually continues.
+     If the pool is empty when a file is needed, the new file is created synchronously, and the pool is counted as having run dry.
      The "to-finish" monarch object is a recently finished file waiting to be closed.
+
+     Files are created and finished without holding the on-deck mutex, so taking a file from the pool never waits for file I/O.
+     Creation is serialized by a separate mutex, so that the files enter the pool in the order of their file numbers.
+     Lock order: creation mutex, then header mutex, then on-deck mutex.
     */
     class monarch_on_deck_manager : public scarab::cancelable
     {
@@ -90,22 +98,33 @@ namespace psyllid
             monarch_on_deck_manager( monarch_wrapper* a_monarch_wrap );
             ~monarch_on_deck_manager();
 
-            const monarch3::Monarch3* od_ptr() const {return f_monarch_on_deck.get();}
+            /// Returns the next on-deck monarch object, or nullptr if there are none
+            const monarch3::Monarch3* od_ptr() const;
             const monarch3::Monarch3* tf_ptr() const {return f_monarch_to_finish.get();}
 
-            /// Return true if both f_monarch_on_deck and f_monarch_to_finish are empty
+            /// Return true if there are no on-deck monarch objects and f_monarch_to_finish is empty
             bool pointers_empty() const;
-            /// Return true if f_monarch_on_deck exists
+            /// Return true if there's at least one on-deck monarch object
             bool mod_exists() const;
             /// Return true if f_monarch_to_finish exists
             bool mtf_exists() const;
 
+            /// Set the number of on-deck files to keep ready (at least 1); should be set before the manager is started
+            void set_on_deck_depth( unsigned a_depth );
+            unsigned get_on_deck_depth() const;
+            /// Number of on-deck files currently ready
+            unsigned get_n_on_deck() const;
+            /// Number of times a file was needed and none was ready
+            uint64_t get_n_pool_dry() const;
+
             /// Execute the thread loop: handle the asynchronous processing of the on-deck and to-finish monarch objects
             void execute();
 
-            /// Create the on-deck monarch object if it doesn't exist already (synchronous)
+            /// Create an on-deck monarch object if there are none (synchronous)
             void create_on_deck();
-            /// Clear the on-deck monarch object (synchronous)
+            /// Create on-deck monarch objects until there are on-deck-depth of them (synchronous)
+            void fill_pool();
+            /// Clear the on-deck monarch objects (synchronous)
             void clear_on_deck();
             /// Finish the to-finish monarch object (synchronous)
             void finish_to_finish();
@@ -115,20 +134,26 @@ namespace psyllid
 
             /// Give a monarch object to the on-deck manager with the intent that it be finished asynchronously
             void set_as_to_finish( std::shared_ptr< monarch3::Monarch3 >& a_monarch );
-            /// Get the on-deck monarch object that has been created asynchronously
-            void get_on_deck( std::shared_ptr< monarch3::Monarch3 >& a_monarch );
+            /// Get the next on-deck monarch object, with its header written as the continuation of a_predecessor_filename; if none is ready, one is created synchronously
+            void get_on_deck( std::shared_ptr< monarch3::Monarch3 >& a_monarch, const std::string& a_predecessor_filename );
 
         private:
+            /// Creates a new file, with its header filled in but not written, and adds it to the on-deck pool; the creation mutex must be held
             void create_on_deck_nolock();
-            void finish_to_finish_nolock();
+            /// Adds a file to the on-deck pool if it has fewer than on-deck-depth files; returns true if a file was added
+            bool fill_on_deck();
 
             const monarch_wrapper* f_monarch_wrap;
 
-            std::shared_ptr< monarch3::Monarch3 > f_monarch_on_deck;
+            std::deque< std::shared_ptr< monarch3::Monarch3 > > f_monarchs_on_deck;
             std::shared_ptr< monarch3::Monarch3 > f_monarch_to_finish;
             std::condition_variable f_od_condition;
             std::condition_variable f_od_continue_condition;
-            std::mutex f_od_mutex;
+            mutable std::mutex f_od_mutex;
+            std::mutex f_create_mutex;
+
+            unsigned f_on_deck_depth;
+            std::atomic< uint64_t > f_n_pool_dry;
 
     };
 
@@ -148,6 +173,25 @@ namespace psyllid
      Provides the thread-safe, synchronized access to the Monarch object.  All thread safety is handled by the interface functions.
 
      Also owns a monarch_on_deck_manager object to handle asynchronous creation of on-deck files and finishing of completed files.
+
+     File switching: writing records never waits for a switch.  The switch thread publishes each stream of the new file to its stream_wrapper,
+     along with a new epoch number; each writer picks up the new stream at its next record boundary, with one atomic load per record.
+     The switch thread then waits until no stream_wrapper is still in a record that it started in the old file,
+     and only then hands the old file to the on-deck manager to be finished.
+
+     File rotation: by default, a new file is started when the estimated size of the current file reaches max-file-size.
+     Files can instead be rotated at fixed boundaries, so that every file has the same length: every max-file-duration (wall-clock time,
+     on a grid starting when the first file is started), or every max-file-records records of each stream.  With boundary rotation, the next file
+     is taken from the on-deck pool and published as soon as the previous switch completes, and each writer adopts it at the first record boundary
+     at or after the boundary, so the switch adds no deadtime and no record lands on the wrong side of the boundary.  The file the writers are
+     still in is kept open (the "retiring" file) until they've all adopted the new file.  If the run ends before the boundary,
+     the published file has no records, and it's removed.  The size limit isn't used to rotate files with boundary rotation.
+     Writers wake the switch thread as they adopt a file, so the next file is published right after the last writer adopts;
+     a file only runs past its boundary if a writer reaches the boundary before that switch has finished (e.g. when the on-deck pool has run dry).
+
+     Preallocation (optional): each file reserves max-file-size of disk space, without changing its size, before any records are written to it,
+     so that the filesystem doesn't allocate extents while data is streaming in.  The reserved space past the end of the file is released when
+     the file is finished.  Linux only; if the filesystem doesn't support it, a warning is logged and the file is written normally.
     */
     class monarch_wrapper : public scarab::cancelable
     {
@@ -174,7 +218,7 @@ namespace psyllid
 
             void trigger_switch();
 
-            /// Ensure that the file is available to write to (via a stream)
+            /// Returns true if the file is available to write to (via a stream); does not block
             bool okay_to_write();
 
             /// Switch to a new file that continues the first file.
@@ -199,26 +243,56 @@ namespace psyllid
             /// Set the maximum file size used to determine when a new file is automatically started.
             void set_max_file_size( double a_size );
 
+            /// Rotate files every a_duration_s seconds of wall-clock time (0 to disable); must be set before start_using()
+            void set_max_file_duration( double a_duration_s );
+            /// Rotate files every a_n_records records of each stream (0 to disable); must be set before start_using()
+            void set_max_file_records( uint64_t a_n_records );
+            /// True if files are rotated at time or record-count boundaries rather than by size
+            bool uses_boundary_rotation() const;
+
+            /// If true, each file reserves max-file-size of disk space when it's created, and the unused space is released when it's finished.
+            /// Must be set before start_using().
+            void set_preallocate( bool a_flag );
+
+            /// Set the number of on-deck files to keep ready for switching; must be set before start_using()
+            void set_on_deck_depth( unsigned a_depth );
+            /// Number of file switches for which no on-deck file was ready
+            uint64_t get_n_on_deck_dry() const;
+
             /// If keeping track of file sizes for automatically creating new files, use this to inform the monarch_wrapper that a given number of bytes was written to the file.
             /// This should be called every time a record is written to the file.
             void record_file_contribution( double a_size );
 
+            /// With boundary rotation, whether a writer that has written a_n_file_records records to its current file has reached the boundary
+            bool boundary_reached( uint64_t a_n_file_records ) const;
+
         private:
             friend class monarch_on_deck_manager;
+            friend class stream_wrapper;
 
             void do_cancellation( int a_code );
 
+            /// True if there's a retiring file and every stream has adopted the newest file; f_monarch_mutex must be locked
+            bool writers_adopted_newest() const;
+            /// Hands the retiring file to the on-deck manager to be finished; f_monarch_mutex must be locked
+            void retire_old_file();
+            /// Called by a writer when it adopts the newest file
+            void notify_adopted();
+
             monarch_wrapper( const monarch_wrapper& ) = delete;
             monarch_wrapper& operator=( const monarch_wrapper& ) = delete;
 
             std::string f_orig_filename;
             std::string f_filename_base;
             std::string f_filename_ext;
+            std::string f_base_description; // description of the first file, which the continuation files build on
             mutable unsigned f_file_count;
 
             double f_max_file_size_mb;
+            int64_t f_max_file_duration_ns;
+            uint64_t f_max_file_records;
+            bool f_preallocate;
             std::atomic< double > f_file_size_est_mb;
-            std::condition_variable f_wait_to_write;
             std::thread* f_switch_thread;
             std::atomic< bool > f_ok_to_write;
             std::atomic< bool > f_do_switch_flag;
@@ -226,6 +300,13 @@ namespace psyllid
 
             std::shared_ptr< monarch3::Monarch3 > f_monarch;
             mutable std::mutex f_monarch_mutex;
+            uint64_t f_file_epoch; // number of file switches; protected by f_monarch_mutex
+
+            // boundary rotation
+            std::shared_ptr< monarch3::Monarch3 > f_monarch_retiring; // the file the writers are in until they adopt f_monarch; protected by f_monarch_mutex
+            std::atomic< bool > f_newest_adopted; // whether any writer has adopted f_monarch since it was published
+            std::chrono::steady_clock::time_point f_rotation_start;
+            std::atomic< int64_t > f_boundary_ns; // steady-clock time at which writers adopt f_monarch, with time rotation
 
             header_wrap_ptr f_header_wrap;
 
@@ -306,10 +387,12 @@ namespace psyllid
      Provides the ability to write records in a thread-safe synchronized way.
 
      Thread synchronization strategy:
-       - Owns a mutex to control use of the stream.
-       - Provides lock() and unlock() functions to manually lock and unlock the mutex.
-       - Provides access to a reference to the mutex to allow its use in a lock.
-       - Use of lock() and unlock() should be used for more speed-critical applications, with the understanding that the risks for unintentionally leaving the mutex locked is greater.
+       - Records are written by one thread at a time, which owns f_stream.
+       - When the monarch_wrapper switches files, it publishes the new file's stream (f_next_stream) and epoch (f_next_epoch);
+         the writer adopts them when it starts its next record, so writing never waits for a switch.
+       - While writing a record, f_in_record is set; before finishing the old file, the monarch_wrapper waits until each writer
+         is either outside of a record or has picked up the new epoch (f_epoch).
+       - The record returned by get_stream_record() belongs to the current file; use it between begin_record() and commit_record().
     */
     class stream_wrapper
     {
@@ -327,20 +410,52 @@ namespace psyllid
             /// Get the pointer to a particular channel record
             monarch3::M3Record* get_channel_record( unsigned a_chan_no );
 
+            /// Two-phase writing, step 1: checks that the file is available, and returns the stream record's data buffer, to be filled in place with the next record's contents.
+            /// Returns nullptr if the file is unavailable.  Otherwise commit_record() must follow: a file switch can't complete until it does.
+            monarch3::byte_type* begin_record();
+            /// Two-phase writing, step 2: writes the record filled since begin_record() to the file
+            bool commit_record( monarch3::RecordIdType a_rec_id, monarch3::TimeType a_rec_time, bool a_is_new_acq );
+
             /// Write the record contents to the file
             bool write_record( monarch3::RecordIdType a_rec_id, monarch3::TimeType a_rec_time, const void* a_rec_block, uint64_t a_bytes, bool a_is_new_acq );
 
+            /// Information for each record written by write_records()
+            struct record_info
+            {
+                monarch3::RecordIdType f_id;
+                monarch3::TimeType f_time;
+                const void* f_block;
+                bool f_is_new_acq;
+            };
+            /// Write a batch of records, each of a_bytes bytes, to the file.
+            /// The whole batch goes to one file; a file switch takes effect with the next record written after the batch
+            /// (with boundary rotation, the batch is split at the boundary).
+            /// The file is checked for availability, and the file size is updated, once for the whole batch; Monarch still writes the records one at a time.
+            /// Returns false if the file is unavailable or any record could not be written.
+            bool write_records( const record_info* a_records, size_t a_n_records, uint64_t a_bytes );
+
         private:
             stream_wrapper( const stream_wrapper& ) = delete;
             stream_wrapper& operator=( const stream_wrapper& ) = delete;
 
             friend class monarch_wrapper;
 
+            /// Marks the start of writing a record, and picks up the stream of a new file if there was a switch
+            void enter_record();
+            /// Marks the end of writing a record
+            void exit_record();
+
             monarch_wrapper* f_monarch_wrapper;
 
-            monarch3::M3Stream* f_stream;
+            monarch3::M3Stream* f_stream; // only used by the writing thread
+            std::atomic< uint64_t > f_epoch; // epoch of f_stream; only changed by the writing thread
             bool f_is_valid;
 
+            std::atomic< monarch3::M3Stream* > f_next_stream;
+            std::atomic< uint64_t > f_next_epoch; // published after f_next_stream
+            std::atomic< bool > f_in_record;
+            uint64_t f_n_file_records; // records written to f_stream; only used by the writing thread
+
             double f_record_size_mb;
     };
 
@@ -349,54 +464,58 @@ namespace psyllid
     // monarch_on_deck_manager
     //***************************
 
+    inline const monarch3::Monarch3* monarch_on_deck_manager::od_ptr() const
+    {
+        unique_lock t_od_lock( f_od_mutex );
+        return f_monarchs_on_deck.empty() ? nullptr : f_monarchs_on_deck.front().get();
+    }
+
     inline bool monarch_on_deck_manager::pointers_empty() const
     {
-        return ! f_monarch_on_deck && ! f_monarch_to_finish;
+        unique_lock t_od_lock( f_od_mutex );
+        return f_monarchs_on_deck.empty() && ! f_monarch_to_finish;
     }
 
     inline bool monarch_on_deck_manager::mod_exists() const
     {
-        return f_monarch_on_deck.operator bool();
+        unique_lock t_od_lock( f_od_mutex );
+        return ! f_monarchs_on_deck.empty();
     }
 
     inline bool monarch_on_deck_manager::mtf_exists() const
     {
+        unique_lock t_od_lock( f_od_mutex );
         return f_monarch_to_finish.operator bool();
     }
 
-    inline void monarch_on_deck_manager::notify()
+    inline unsigned monarch_on_deck_manager::get_on_deck_depth() const
     {
-        f_od_condition.notify_one();
-        return;
+        return f_on_deck_depth;
     }
 
-    inline void monarch_on_deck_manager::set_as_to_finish( std::shared_ptr< monarch3::Monarch3 >& a_monarch )
+    inline unsigned monarch_on_deck_manager::get_n_on_deck() const
     {
-        f_od_mutex.lock();
-        f_monarch_to_finish.swap( a_monarch );
-        f_od_mutex.unlock();
-        return;
+        unique_lock t_od_lock( f_od_mutex );
+        return f_monarchs_on_deck.size();
     }
-    inline void monarch_on_deck_manager::get_on_deck( std::shared_ptr< monarch3::Monarch3 >& a_monarch )
+
+    inline uint64_t monarch_on_deck_manager::get_n_pool_dry() const
     {
-        f_od_mutex.lock();
-        a_monarch.swap( f_monarch_on_deck );
-        f_od_mutex.unlock();
-        return;
+        return f_n_pool_dry.load();
     }
 
-    inline void monarch_on_deck_manager::create_on_deck()
+    inline void monarch_on_deck_manager::notify()
     {
-        f_od_mutex.lock();
-        if( ! f_monarch_on_deck ) create_on_deck_nolock();
-        f_od_mutex.unlock();
+        f_od_condition.notify_one();
         return;
     }
 
-    inline void monarch_on_deck_manager::finish_to_finish_nolock()
+    inline void monarch_on_deck_manager::set_as_to_finish( std::shared_ptr< monarch3::Monarch3 >& a_monarch )
     {
-        f_monarch_to_finish->FinishWriting();
-        f_monarch_to_finish.reset();
+        f_od_mutex.lock();
+        f_monarch_to_finish.swap( a_monarch );
+        f_od_mutex.unlock();
+        return;
     }
 
 
@@ -425,6 +544,61 @@ namespace psyllid
         return;
     }
 
+    inline void monarch_wrapper::set_max_file_duration( double a_duration_s )
+    {
+        f_max_file_duration_ns = (int64_t)( a_duration_s * 1.e9 );
+        return;
+    }
+
+    inline void monarch_wrapper::set_max_file_records( uint64_t a_n_records )
+    {
+        f_max_file_records = a_n_records;
+        return;
+    }
+
+    inline bool monarch_wrapper::uses_boundary_rotation() const
+    {
+        return f_max_file_duration_ns > 0 || f_max_file_records > 0;
+    }
+
+    inline bool monarch_wrapper::boundary_reached( uint64_t a_n_file_records ) const
+    {
+        if( f_max_file_records > 0 ) return a_n_file_records >= f_max_file_records;
+        if( f_max_file_duration_ns > 0 )
+        {
+            return std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now().time_since_epoch() ).count() >= f_boundary_ns.load( std::memory_order_relaxed );
+        }
+        return true;
+    }
+
+    inline void monarch_wrapper::notify_adopted()
+    {
+        f_newest_adopted.store( true );
+        // the switch loop checks whether the writers have adopted with f_monarch_mutex locked, so locking it here means the wakeup can't fall
+        // between its check and its wait; it's only held briefly, since the switch that published this file has finished
+        unique_lock t_lock( f_monarch_mutex );
+        t_lock.unlock();
+        f_do_switch_trig.notify_one();
+        return;
+    }
+
+    inline void monarch_wrapper::set_preallocate( bool a_flag )
+    {
+        f_preallocate = a_flag;
+        return;
+    }
+
+    inline void monarch_wrapper::set_on_deck_depth( unsigned a_depth )
+    {
+        f_monarch_od_manager.set_on_deck_depth( a_depth );
+        return;
+    }
+
+    inline uint64_t monarch_wrapper::get_n_on_deck_dry() const
+    {
+        return f_monarch_od_manager.get_n_pool_dry();
+    }
+
     inline void monarch_wrapper::do_cancellation( int a_code )
     {
         f_monarch_od_manager.cancel( a_code );
@@ -471,6 +645,28 @@ namespace psyllid
         return f_stream->GetChannelRecord( a_chan_no );
     }
 
+    inline void stream_wrapper::enter_record()
+    {
+        // sequentially consistent, so that either the switch thread sees this store, or this thread sees the switch's new epoch
+        f_in_record.store( true );
+        uint64_t t_next_epoch = f_next_epoch.load();
+        // with boundary rotation, the new file is published ahead of time, and only adopted once the boundary is reached
+        if( t_next_epoch != f_epoch.load( std::memory_order_relaxed ) && f_monarch_wrapper->boundary_reached( f_n_file_records ) )
+        {
+            f_stream = f_next_stream.load( std::memory_order_acquire );
+            f_epoch.store( t_next_epoch, std::memory_order_release );
+            f_n_file_records = 0;
+            if( f_monarch_wrapper->uses_boundary_rotation() ) f_monarch_wrapper->notify_adopted();
+        }
+        return;
+    }
+
+    inline void stream_wrapper::exit_record()
+    {
+        f_in_record.store( false, std::memory_order_release );
+        return;
+    }
+
 } /* namespace psyllid */
 
 #endif /* PSYLLID_MONARCH3_WRAP_HH_ */
@@ -33,7 +33,7 @@ namespace psyllid
      @details
      Every midge node has a binding class that inherits from node_binding.
      An instance of these binding classes is created by the stream_manager who adds them to the midge object together with the node class.
-     The binding classes allow to apply and dump node configurations and do run commands while the daq is activated.
+     The binding classes allow to apply and dump node configurations, do run commands, and dump node status while the daq is activated.
      */
     class node_binding
     {
@@ -57,6 +57,15 @@ namespace psyllid
             /// Throws psyllid::error if the command fails, and returns false if the command is unrecognized
             virtual bool run_command( midge::node* a_node, const std::string& a_cmd, const scarab::param_node& a_args ) const = 0;
 
+            /// Adds the run-time status of the given node (e.g. statistics of the data processed) to a_status; nodes without status add nothing
+            /// Throws psyllid::error if the node is the wrong type
+            virtual void dump_status( const midge::node* a_node, scarab::param_node& a_status ) const = 0;
+
+            /// Given this node's configuration (a_config), adds to a_downstream_config any settings that nodes receiving its output need
+            /// (e.g. the sample rate, for a node that changes it); nodes that don't change how their output is described add nothing
+            /// Throws psyllid::error if the configuration can't be described downstream
+            virtual void configure_downstream( const scarab::param_node& a_config, scarab::param_node& a_downstream_config ) const = 0;
+
     };
 
 
@@ -81,6 +90,10 @@ namespace psyllid
 
             virtual bool run_command( midge::node* a_node, const std::string& a_cmd, const scarab::param_node& a_args ) const;
 
+            virtual void dump_status( const midge::node* a_node, scarab::param_node& a_status ) const;
+
+            virtual void configure_downstream( const scarab::param_node& a_config, scarab::param_node& a_downstream_config ) const;
+
         private:
             virtual void do_apply_config( x_node_type* a_node, const scarab::param_node& a_config ) const = 0;
             virtual void do_dump_config( const x_node_type* a_node, scarab::param_node& a_config ) const = 0;
@@ -88,6 +101,12 @@ namespace psyllid
             /// in derived classes, should throw a std::exception if the command fails, and return false if the command is unrecognized
             virtual bool do_run_command( x_node_type* a_node, const std::string& a_cmd, const scarab::param_node& a_args ) const;
 
+            /// in derived classes, should be thread-safe with respect to the node's execution, since it's called while the node is running
+            virtual void do_dump_status( const x_node_type* a_node, scarab::param_node& a_status ) const;
+
+            /// a_config is the builder's configuration, without the node's defaults
+            virtual void do_configure_downstream( const scarab::param_node& a_config, scarab::param_node& a_downstream_config ) const;
+
     };
 
 
@@ -135,6 +154,13 @@ namespace psyllid
 
             virtual bool run_command( midge::node* a_node, const std::string& a_cmd, const scarab::param_node& a_args ) const;
 
+            virtual void dump_status( const midge::node* a_node, scarab::param_node& a_status ) const;
+
+            virtual void configure_downstream( const scarab::param_node& a_config, scarab::param_node& a_downstream_config ) const;
+
+            /// Uses the builder's configuration
+            void configure_downstream( scarab::param_node& a_downstream_config ) const;
+
     };
 
 
@@ -258,6 +284,51 @@ namespace psyllid
         return false;
     }
 
+    template< class x_node_type, class x_node_binding >
+    void _node_binding< x_node_type, x_node_binding >::dump_status( const midge::node* a_node, scarab::param_node& a_status ) const
+    {
+        const x_node_type* t_derived_node = dynamic_cast< const x_node_type* >( a_node );
+        if( t_derived_node == nullptr )
+        {
+            throw error() << "Node type does not match builder type (dump_status(node*, param_node&))";
+        }
+        try
+        {
+            do_dump_status( t_derived_node, a_status );
+        }
+        catch( std::exception& e )
+        {
+            throw psyllid::error() << e.what();
+        }
+        return;
+    }
+
+    template< class x_node_type, class x_node_binding >
+    void _node_binding< x_node_type, x_node_binding >::do_dump_status( const x_node_type*, scarab::param_node& ) const
+    {
+        return;
+    }
+
+    template< class x_node_type, class x_node_binding >
+    void _node_binding< x_node_type, x_node_binding >::configure_downstream( const scarab::param_node& a_config, scarab::param_node& a_downstream_config ) const
+    {
+        try
+        {
+            do_configure_downstream( a_config, a_downstream_config );
+        }
+        catch( std::exception& e )
+        {
+            throw psyllid::error() << e.what();
+        }
+        return;
+    }
+
+    template< class x_node_type, class x_node_binding >
+    void _node_binding< x_node_type, x_node_binding >::do_configure_downstream( const scarab::param_node&, scarab::param_node& ) const
+    {
+        return;
+    }
+
 
     //****************
     // node_builder
@@ -305,6 +376,24 @@ namespace psyllid
         return f_binding->run_command( a_node, a_cmd, a_args );
     }
 
+    inline void node_builder::dump_status( const midge::node* a_node, scarab::param_node& a_status ) const
+    {
+        f_binding->dump_status( a_node, a_status );
+        return;
+    }
+
+    inline void node_builder::configure_downstream( const scarab::param_node& a_config, scarab::param_node& a_downstream_config ) const
+    {
+        f_binding->configure_downstream( a_config, a_downstream_config );
+        return;
+    }
+
+    inline void node_builder::configure_downstream( scarab::param_node& a_downstream_config ) const
+    {
+        f_binding->configure_downstream( f_config, a_downstream_config );
+        return;
+    }
+
 
     //*****************
     // _node_builder
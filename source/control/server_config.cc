@@ -60,6 +60,10 @@ namespace psyllid
         t_daq_node.add( "n-files", 1U );
         t_daq_node.add( "duration", 1000U );
         t_daq_node.add( "max-file-size-mb", 500.0 );
+        t_daq_node.add( "max-file-duration-s", 0.0 );
+        t_daq_node.add( "max-file-records", 0U );
+        t_daq_node.add( "on-deck-depth", 1U );
+        t_daq_node.add( "preallocate-files", false );
         add( "daq", t_daq_node );
 
         param_node t_batch_commands;
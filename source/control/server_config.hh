@@ -28,6 +28,10 @@ namespace psyllid
      - n-files
      - duration
      - max-file-size-mb
+     - max-file-duration-s
+     - max-file-records
+     - on-deck-depth
+     - preallocate-files
 
      These default configurations, together with the configurations from the command line and the config-file, are passed to scarab::configurator by the psyllid executable.
      The configurator combines them and extracts the final psyllid configuration which is then passed to the run_server during initialization.
@@ -145,10 +145,42 @@ namespace psyllid
         }
 
         t_node_it->second->configure_builder( a_config );
+        configure_downstream_nodes( a_stream_name, t_stream_it->second );
 
         return;
     }
 
+    void stream_manager::configure_downstream_nodes( const std::string& a_stream_name, stream_template& a_stream )
+    {
+        // connections are "[node].[output]:[node].[input]", with the node names prefixed by the stream name
+        std::string t_prefix( a_stream_name + "_" );
+
+        // each pass carries the settings one node further downstream, so a chain of nodes is covered after as many passes as there are nodes
+        for( unsigned i_pass = 0; i_pass < a_stream.f_nodes.size(); ++i_pass )
+        {
+            for( stream_template::connections_t::const_iterator t_conn_it = a_stream.f_connections.begin(); t_conn_it != a_stream.f_connections.end(); ++t_conn_it )
+            {
+                size_t t_colon = t_conn_it->find( ':' );
+                if( t_colon == std::string::npos ) continue;
+                std::string t_from_name( t_conn_it->substr( 0, t_conn_it->find( '.' ) ) );
+                std::string t_to_name( t_conn_it->substr( t_colon + 1, t_conn_it->find( '.', t_colon ) - t_colon - 1 ) );
+                if( t_from_name.compare( 0, t_prefix.size(), t_prefix ) != 0 || t_to_name.compare( 0, t_prefix.size(), t_prefix ) != 0 ) continue;
+
+                stream_template::nodes_t::iterator t_from_it = a_stream.f_nodes.find( t_from_name.substr( t_prefix.size() ) );
+                stream_template::nodes_t::iterator t_to_it = a_stream.f_nodes.find( t_to_name.substr( t_prefix.size() ) );
+                if( t_from_it == a_stream.f_nodes.end() || t_to_it == a_stream.f_nodes.end() ) continue;
+
+                param_node t_downstream_config;
+                t_from_it->second->configure_downstream( t_downstream_config );
+                if( t_downstream_config.empty() ) continue;
+
+                LDEBUG( plog, "Configuring node <" << t_to_name << "> for the output of <" << t_from_name << ">:\n" << t_downstream_config );
+                t_to_it->second->configure_builder( t_downstream_config );
+            }
+        }
+        return;
+    }
+
     void stream_manager::_dump_node_config( const std::string& a_stream_name, const std::string& a_node_name, param_node& a_config ) const
     {
         std::unique_lock< std::mutex > t_lock( f_manager_mutex );
@@ -277,6 +309,8 @@ namespace psyllid
             t_stream.f_connections.insert( t_connection );
         }
 
+        configure_downstream_nodes( a_name, t_stream );
+
         // add the new stream to the vector of streams
         f_must_reset_midge = true;
         f_streams.insert( streams_t::value_type( a_name, t_stream ) );
@@ -33,6 +33,7 @@ namespace psyllid
      With initialization, stream_manager is given the node configurations set for the currently running psyllid instance.
      A stream is added for every configured set of midge nodes.
      For every node in a node config an instance of the nodes builder class is created.
+     Nodes that change how their output is described (e.g. its sample rate) pass the new settings to the builders of the nodes connected to their outputs.
      daq_control activate-daq calls reset_midge in stream_manager.
      reset_midge makes fresh copies of the configured node classes and the node binding classes and adds the classes and all the node connections to the midge object.
      The node binding classes allow access to the nodes held and owned by midge.
@@ -110,6 +111,9 @@ namespace psyllid
             void _configure_node( const std::string& a_stream_name, const std::string& a_node_name, const scarab::param_node& a_config );
             void _dump_node_config( const std::string& a_stream_name, const std::string& a_node_name, scarab::param_node& a_config ) const;
 
+            /// Passes each node's downstream settings (see node_binding::configure_downstream) to the nodes connected to its outputs
+            void configure_downstream_nodes( const std::string& a_stream_name, stream_template& a_stream );
+
             void clear_node_bindings();
 
             typedef std::map< std::string, stream_template > streams_t;
@@ -0,0 +1,270 @@
+/*
+ * channelizer.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "channelizer.hh"
+
+#include "psyllid_error.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <algorithm>
+#include <cstring>
+#include <vector>
+
+using midge::stream;
+
+namespace psyllid
+{
+    REGISTER_NODE_AND_BUILDER( channelizer, "channelizer", channelizer_binding );
+
+    LOGGER( plog, "channelizer" );
+
+    channelizer::channelizer() :
+            f_length( 10 ),
+            f_decimation( 10 ),
+            f_center_offset( 0. ),
+            f_taps_per_phase( 16 ),
+            f_cutoff( 0.8 ),
+            f_output_gain( 0. ),
+            f_acq_rate( 100 ),
+            f_center_freq( 50.e6 ),
+            f_freq_range( 100.e6 ),
+            f_decimator()
+    {
+    }
+
+    channelizer::~channelizer()
+    {
+    }
+
+    void channelizer::initialize()
+    {
+        double t_sample_rate = (double)f_acq_rate * 1.e6;
+        f_decimator.configure( f_center_offset / t_sample_rate, f_decimation, f_taps_per_phase, f_cutoff, f_output_gain );
+
+        LINFO( plog, "Channelizer selects " << f_freq_range / (double)f_decimation << " Hz centered at " << f_center_freq + f_center_offset <<
+                " Hz, with " << f_decimator.taps().size() << " filter taps using " << to_string( f_decimator.get_isa() ) <<
+                " instructions; the output rate is " << (double)f_acq_rate / (double)f_decimation << " MHz" );
+
+        out_buffer< 0 >().initialize( f_length );
+        return;
+    }
+
+    void channelizer::fill_output_config( scarab::param_node& a_config ) const
+    {
+        if( f_decimation == 0 || f_acq_rate % f_decimation != 0 )
+        {
+            throw error() << "Decimation factor <" << f_decimation << "> does not divide the acquisition rate <" << f_acq_rate <<
+                    " MHz>; the output rate could not be recorded";
+        }
+        scarab::param_node t_dev_node;
+        t_dev_node.add( "acq-rate", f_acq_rate / f_decimation );
+        a_config.add( "device", t_dev_node );
+        a_config.add( "center-freq", f_center_freq + f_center_offset );
+        a_config.add( "freq-range", f_freq_range / (double)f_decimation );
+        return;
+    }
+
+    void channelizer::execute( midge::diptera* a_midge )
+    {
+        LDEBUG( plog, "execute channelizer" );
+        try
+        {
+            midge::enum_t t_in_command = stream::s_none;
+
+            time_data* t_in_data = nullptr;
+            time_data* t_out_data = nullptr;
+
+            const size_t t_samples_per_pkt = PAYLOAD_SIZE / 2;
+            std::vector< int8_t > t_out_buffer( 2 * ( t_samples_per_pkt / f_decimation + 1 ) );
+
+            uint64_t t_expected_pkt = 0;
+            bool t_have_packet = false;
+
+            while( ! is_canceled() )
+            {
+                t_in_command = in_stream< 0 >().get();
+                if( t_in_command == stream::s_none ) continue;
+                if( t_in_command == stream::s_error ) break;
+
+                LTRACE( plog, "Channelizer reading stream 0 (time) at index " << in_stream< 0 >().get_current_index() );
+
+                if( t_in_command == stream::s_exit )
+                {
+                    LDEBUG( plog, "Channelizer is exiting" );
+                    out_stream< 0 >().set( stream::s_exit );
+                    break;
+                }
+
+                if( t_in_command == stream::s_stop )
+                {
+                    LDEBUG( plog, "Channelizer is stopping" );
+                    if( f_decimator.get_n_clipped() > 0 )
+                    {
+                        LWARN( plog, f_decimator.get_n_clipped() << " output values were clipped in this run; consider reducing the output gain" );
+                    }
+                    t_out_data = nullptr;
+                    if( ! out_stream< 0 >().set( stream::s_stop ) ) break;
+                    continue;
+                }
+
+                if( t_in_command == stream::s_start )
+                {
+                    LDEBUG( plog, "Channelizer is starting" );
+                    f_decimator.reset();
+                    f_decimator.set_n_clipped( 0 );
+                    t_out_data = nullptr;
+                    t_have_packet = false;
+                    if( ! out_stream< 0 >().set( stream::s_start ) ) break;
+                    continue;
+                }
+
+                if( t_in_command == stream::s_run )
+                {
+                    t_in_data = in_stream< 0 >().data();
+                    uint64_t t_in_pkt = t_in_data->get_pkt_in_session();
+
+                    if( t_have_packet && t_in_pkt != t_expected_pkt )
+                    {
+                        LDEBUG( plog, "Missing time packets (expected " << t_expected_pkt << "; got " << t_in_pkt << "); resetting the filter" );
+                        f_decimator.reset();
+                        t_out_data = nullptr;
+                    }
+                    t_have_packet = true;
+                    t_expected_pkt = t_in_pkt + 1;
+
+                    uint64_t t_first_out = 0;
+                    size_t t_n_out = f_decimator.process( t_in_data->get_array()[ 0 ], t_samples_per_pkt, t_in_pkt * t_samples_per_pkt, t_out_buffer.data(), t_first_out );
+
+                    // distribute the output samples into output packets
+                    bool t_stream_error = false;
+                    size_t i_out = 0;
+                    while( i_out < t_n_out )
+                    {
+                        uint64_t t_out_sample = t_first_out + i_out;
+                        size_t t_pos = t_out_sample % t_samples_per_pkt;
+                        size_t t_n_copy = std::min< size_t >( t_samples_per_pkt - t_pos, t_n_out - i_out );
+
+                        if( t_out_data == nullptr )
+                        {
+                            if( t_pos != 0 )
+                            {
+                                // after a reset, output starts with the next output packet
+                                i_out += t_n_copy;
+                                continue;
+                            }
+                            uint64_t t_out_pkt = t_out_sample / t_samples_per_pkt;
+                            t_out_data = out_stream< 0 >().data();
+                            t_out_data->set_unix_time( t_in_data->get_unix_time() );
+                            t_out_data->set_digital_id( t_in_data->get_digital_id() );
+                            t_out_data->set_if_id( t_in_data->get_if_id() );
+                            t_out_data->set_user_data_1( t_in_data->get_user_data_1() );
+                            t_out_data->set_user_data_0( t_in_data->get_user_data_0() );
+                            t_out_data->set_reserved_0( t_in_data->get_reserved_0() );
+                            t_out_data->set_reserved_1( t_in_data->get_reserved_1() );
+                            t_out_data->set_freq_not_time( false );
+                            t_out_data->set_pkt_in_session( t_out_pkt );
+                            t_out_data->set_pkt_in_batch( t_out_pkt % BATCH_COUNTER_SIZE );
+                        }
+
+                        ::memcpy( t_out_data->get_array()[ t_pos ], t_out_buffer.data() + 2*i_out, 2 * t_n_copy );
+                        i_out += t_n_copy;
+
+                        if( t_pos + t_n_copy == t_samples_per_pkt )
+                        {
+                            LTRACE( plog, "Channelizer writing output packet " << t_out_data->get_pkt_in_session() );
+                            t_out_data = nullptr;
+                            if( ! out_stream< 0 >().set( stream::s_run ) )
+                            {
+                                t_stream_error = true;
+                                break;
+                            }
+                        }
+                    }
+                    if( t_stream_error )
+                    {
+                        LERROR( plog, "Channelizer output stream error" );
+                        break;
+                    }
+
+                    continue;
+                }
+            }
+
+            return;
+        }
+        catch(...)
+        {
+            LWARN( plog, "an error occurred executing channelizer" );
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+    }
+
+    void channelizer::finalize()
+    {
+        LDEBUG( plog, "finalize channelizer" );
+        out_buffer< 0 >().finalize();
+        return;
+    }
+
+
+    channelizer_binding::channelizer_binding() :
+            _node_binding< channelizer, channelizer_binding >()
+    {
+    }
+
+    channelizer_binding::~channelizer_binding()
+    {
+    }
+
+    void channelizer_binding::do_apply_config( channelizer* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Configuring channelizer with:\n" << a_config );
+        a_node->set_length( a_config.get_value( "length", a_node->get_length() ) );
+        a_node->set_decimation( a_config.get_value( "decimation", a_node->get_decimation() ) );
+        a_node->set_center_offset( a_config.get_value( "center-offset", a_node->get_center_offset() ) );
+        a_node->set_taps_per_phase( a_config.get_value( "taps-per-phase", a_node->get_taps_per_phase() ) );
+        a_node->set_cutoff( a_config.get_value( "cutoff", a_node->get_cutoff() ) );
+        a_node->set_output_gain( a_config.get_value( "output-gain", a_node->get_output_gain() ) );
+        a_node->set_center_freq( a_config.get_value( "center-freq", a_node->get_center_freq() ) );
+        a_node->set_freq_range( a_config.get_value( "freq-range", a_node->get_freq_range() ) );
+        if( a_config.has( "device" ) )
+        {
+            const scarab::param_node& t_dev_config = a_config["device"].as_node();
+            a_node->set_acq_rate( t_dev_config.get_value( "acq-rate", a_node->get_acq_rate() ) );
+        }
+        return;
+    }
+
+    void channelizer_binding::do_dump_config( const channelizer* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Dumping configuration for channelizer" );
+        a_config.add( "length", a_node->get_length() );
+        a_config.add( "decimation", a_node->get_decimation() );
+        a_config.add( "center-offset", a_node->get_center_offset() );
+        a_config.add( "taps-per-phase", a_node->get_taps_per_phase() );
+        a_config.add( "cutoff", a_node->get_cutoff() );
+        a_config.add( "output-gain", a_node->get_output_gain() );
+        a_config.add( "center-freq", a_node->get_center_freq() );
+        a_config.add( "freq-range", a_node->get_freq_range() );
+        scarab::param_node t_dev_node = scarab::param_node();
+        t_dev_node.add( "acq-rate", a_node->get_acq_rate() );
+        a_config.add( "device", t_dev_node );
+        return;
+    }
+
+    void channelizer_binding::do_configure_downstream( const scarab::param_node& a_config, scarab::param_node& a_downstream_config ) const
+    {
+        // the builder's configuration doesn't include the defaults, so they come from a node
+        channelizer t_node;
+        do_apply_config( &t_node, a_config );
+        t_node.fill_output_config( a_downstream_config );
+        return;
+    }
+
+} /* namespace psyllid */
@@ -0,0 +1,115 @@
+/*
+ * channelizer.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_CHANNELIZER_HH_
+#define PSYLLID_CHANNELIZER_HH_
+
+#include "iq_decimator.hh"
+#include "node_builder.hh"
+#include "time_data.hh"
+
+#include "transformer.hh"
+
+namespace psyllid
+{
+
+    /*!
+     @class channelizer
+     @brief A transformer that selects a sub-band of the time data and decimates it, to reduce the rate of time data written.
+
+     @details
+
+     The band centered at center-offset from the center of the input band is mixed to baseband, low-pass filtered, and decimated
+     by the decimation factor (see iq_decimator); the output is int8 IQ time data, 4096 samples per packet, as for the input.
+     The filter uses the best instruction set available on the CPU.
+
+     Output packets are numbered as if the digitizer had been running at the decimated rate:
+     output sample m is computed at input sample m * decimation (counting from the start of the session),
+     and it goes in output packet m / 4096.  The pkt_in_session and pkt_in_batch of the output packets are set accordingly,
+     and the other header fields are copied from the input packet in which the output packet starts.
+
+     If input packets are missing, the filter is reset and the partial output packet is dropped;
+     output resumes at the start of the next output packet.  The first outputs after a reset include the filter's startup transient.
+
+     The nodes connected to the output (e.g. writers) are configured for the decimated data when the stream is set up
+     (see node_binding::configure_downstream), so their headers describe the output band:
+     - "device": "acq-rate": acq-rate / decimation; the decimation factor must divide the acquisition rate in MHz, since rates are recorded in whole MHz
+     - "center-freq": center-freq + center-offset
+     - "freq-range": freq-range / decimation
+     These replace the values the downstream nodes would otherwise get from the stream's configuration.
+
+     The number of samples clipped when the output is converted to int8 is logged at the end of each run.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "channelizer"
+
+     Available configuration values:
+     - "length": uint -- the size of the output buffer
+     - "decimation": uint -- the decimation factor
+     - "center-offset": double -- the center of the selected band relative to the center of the input band, in Hz
+     - "taps-per-phase": uint -- the number of filter taps per output sample; the filter has taps-per-phase * decimation taps
+     - "cutoff": double -- the filter cutoff as a fraction of the output band's half-width; in (0, 1]
+     - "output-gain": double -- the scaling applied before the output is rounded to int8; if 0, it's chosen to keep the RMS of white noise unchanged
+     - "center-freq": double -- the center frequency of the input data in Hz
+     - "freq-range": double -- the frequency window (bandwidth) of the input data in Hz
+     - "device": node -- digitizer parameters
+       - "acq-rate": uint -- acquisition rate of the input data in MHz
+
+     Input Stream:
+     - 0: time_data
+
+     Output Stream:
+     - 0: time_data
+    */
+    class channelizer :
+            public midge::_transformer< midge::type_list< time_data >, midge::type_list< time_data > >
+    {
+        public:
+            channelizer();
+            virtual ~channelizer();
+
+        public:
+            mv_accessible( uint64_t, length );
+            mv_accessible( unsigned, decimation );
+            mv_accessible( double, center_offset ); // Hz
+            mv_accessible( unsigned, taps_per_phase );
+            mv_accessible( double, cutoff );
+            mv_accessible( double, output_gain );
+            mv_accessible( unsigned, acq_rate ); // MHz
+            mv_accessible( double, center_freq ); // Hz
+            mv_accessible( double, freq_range ); // Hz
+
+        public:
+            /// Adds the acq-rate, center-freq and freq-range of the output to a_config; throws psyllid::error if the output rate isn't a whole number of MHz
+            void fill_output_config( scarab::param_node& a_config ) const;
+
+        public:
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            iq_decimator f_decimator;
+    };
+
+
+    class channelizer_binding : public _node_binding< channelizer, channelizer_binding >
+    {
+        public:
+            channelizer_binding();
+            virtual ~channelizer_binding();
+
+        private:
+            virtual void do_apply_config( channelizer* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_config( const channelizer* a_node, scarab::param_node& a_config ) const;
+
+            virtual void do_configure_downstream( const scarab::param_node& a_config, scarab::param_node& a_downstream_config ) const;
+    };
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_CHANNELIZER_HH_ */
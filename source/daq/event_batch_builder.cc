@@ -0,0 +1,323 @@
+/*
+ * event_batch_builder.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "event_batch_builder.hh"
+
+#include <algorithm>
+
+namespace psyllid
+{
+    // Returns the position of the first set bit (or clear bit, if a_invert is all ones) in [a_pos, a_end), or a_end if there is none
+    static inline size_t find_next_bit( const uint64_t* a_bits, size_t a_pos, size_t a_end, uint64_t a_invert )
+    {
+        while( a_pos < a_end )
+        {
+            size_t t_word = a_pos / 64;
+            uint64_t t_bits = ( a_bits[ t_word ] ^ a_invert ) >> ( a_pos % 64 );
+            if( t_bits != 0 )
+            {
+                return std::min< size_t >( a_pos + __builtin_ctzll( t_bits ), a_end );
+            }
+            a_pos = ( t_word + 1 ) * 64;
+        }
+        return a_end;
+    }
+
+    static inline size_t find_next_set( const uint64_t* a_bits, size_t a_pos, size_t a_end )
+    {
+        return find_next_bit( a_bits, a_pos, a_end, 0 );
+    }
+
+    static inline size_t find_next_clear( const uint64_t* a_bits, size_t a_pos, size_t a_end )
+    {
+        return find_next_bit( a_bits, a_pos, a_end, ~uint64_t( 0 ) );
+    }
+
+    // Returns the position of the last set bit in [a_begin, a_end), or a_end if there is none
+    static inline size_t find_prev_set( const uint64_t* a_bits, size_t a_begin, size_t a_end )
+    {
+        size_t t_pos = a_end;
+        while( t_pos > a_begin )
+        {
+            size_t t_last = t_pos - 1;
+            size_t t_word_start = t_last - t_last % 64;
+            uint64_t t_bits = a_bits[ t_last / 64 ] & ( ~uint64_t( 0 ) >> ( 63 - t_last % 64 ) );
+            if( t_word_start < a_begin ) t_bits &= ~uint64_t( 0 ) << ( a_begin - t_word_start );
+            if( t_bits != 0 ) return t_word_start + 63 - __builtin_clzll( t_bits );
+            t_pos = t_word_start;
+        }
+        return a_end;
+    }
+
+    // Returns the position in [a_pos, a_end) of the a_length-th consecutive clear bit, counting a_carry clear bits just before a_pos
+    // (a_carry < a_length), or a_end if there is no such gap.
+    // Gaps are found a word at a time: the runs of a_length clear bits in a word are found by and-ing shifted copies of it.
+    static inline size_t find_gap_end( const uint64_t* a_bits, size_t a_pos, size_t a_end, uint64_t a_length, uint64_t a_carry )
+    {
+        uint64_t t_run = a_carry;
+        while( a_pos < a_end )
+        {
+            unsigned t_n_bits = (unsigned)std::min< size_t >( 64 - a_pos % 64, a_end - a_pos );
+            uint64_t t_set = a_bits[ a_pos / 64 ] >> ( a_pos % 64 );
+            // positions past the end count as set, so that gaps don't extend past it
+            if( t_n_bits < 64 ) t_set |= ~uint64_t( 0 ) << t_n_bits;
+
+            // the gap continuing from before this word
+            unsigned t_lead = t_set != 0 ? __builtin_ctzll( t_set ) : 64;
+            if( t_run + t_lead >= a_length ) return a_pos + ( a_length - t_run - 1 );
+            if( t_lead >= t_n_bits )
+            {
+                t_run += t_n_bits;
+                a_pos += t_n_bits;
+                continue;
+            }
+
+            // gaps that start within this word and end before its last bit
+            if( a_length <= 64 )
+            {
+                uint64_t t_gaps = ~t_set;
+                uint64_t t_width = 1;
+                for( ; 2 * t_width <= a_length; t_width *= 2 ) t_gaps &= t_gaps >> t_width;
+                if( t_width < a_length ) t_gaps &= t_gaps >> ( a_length - t_width );
+                if( t_gaps != 0 ) return a_pos + __builtin_ctzll( t_gaps ) + a_length - 1;
+            }
+
+            // the gap at the end of this word carries over to the next
+            t_run = t_n_bits - 1 - ( 63 - __builtin_clzll( t_set & ( ~uint64_t( 0 ) >> ( 64 - t_n_bits ) ) ) );
+            a_pos += t_n_bits;
+        }
+        return a_end;
+    }
+
+
+    event_batch_builder::event_batch_builder() :
+            f_pretrigger( 0 ),
+            f_skip_tolerance( 0 ),
+            f_n_triggers( 1 ),
+            f_state( state_t::untriggered ),
+            f_have_id( false ),
+            f_earliest_id( 0 ),
+            f_start_id( 0 ),
+            f_last_trigger_id( 0 ),
+            f_trigger_count( 0 ),
+            f_skip_count( 0 ),
+            f_flag_bits(),
+            f_high_bits()
+    {
+    }
+
+    event_batch_builder::~event_batch_builder()
+    {
+    }
+
+    void event_batch_builder::reset()
+    {
+        f_state = state_t::untriggered;
+        f_have_id = false;
+        f_earliest_id = 0;
+        f_start_id = 0;
+        f_last_trigger_id = 0;
+        f_trigger_count = 0;
+        f_skip_count = 0;
+        return;
+    }
+
+    void event_batch_builder::start_candidate( uint64_t a_id )
+    {
+        f_start_id = std::max( f_earliest_id, a_id >= f_pretrigger ? a_id - f_pretrigger : 0 );
+        f_last_trigger_id = a_id;
+        f_trigger_count = 1;
+        f_skip_count = 0;
+        return;
+    }
+
+    void event_batch_builder::end_event( std::vector< id_range_event >& a_events )
+    {
+        a_events.emplace_back();
+        a_events.back().set_start_id( f_start_id );
+        a_events.back().set_end_id( f_last_trigger_id );
+        f_earliest_id = f_last_trigger_id + 1;
+        f_state = state_t::untriggered;
+        f_skip_count = 0;
+        return;
+    }
+
+    void event_batch_builder::process_flag( uint64_t a_id, bool a_flag, bool a_high_threshold, std::vector< id_range_event >& a_events )
+    {
+        if( ! f_have_id )
+        {
+            f_earliest_id = a_id;
+            f_have_id = true;
+        }
+
+        switch( f_state )
+        {
+            case state_t::untriggered:
+                if( a_flag )
+                {
+                    start_candidate( a_id );
+                    f_state = ( a_high_threshold || f_n_triggers <= 1 ) ? state_t::triggered : state_t::collecting_triggers;
+                }
+                break;
+            case state_t::collecting_triggers:
+                if( a_flag )
+                {
+                    ++f_trigger_count;
+                    f_last_trigger_id = a_id;
+                    if( a_high_threshold || f_trigger_count >= f_n_triggers ) f_state = state_t::triggered;
+                }
+                else
+                {
+                    f_state = state_t::untriggered;
+                }
+                break;
+            case state_t::triggered:
+                if( a_flag )
+                {
+                    f_last_trigger_id = a_id;
+                    f_skip_count = 0;
+                }
+                else if( ++f_skip_count > f_skip_tolerance )
+                {
+                    end_event( a_events );
+                }
+                break;
+        }
+        return;
+    }
+
+    void event_batch_builder::process_batch( const trigger_flag* a_flags, size_t a_n_flags, std::vector< id_range_event >& a_events )
+    {
+        if( a_n_flags == 0 ) return;
+
+        size_t t_n_words = ( a_n_flags + 63 ) / 64;
+        f_flag_bits.resize( t_n_words );
+        f_high_bits.resize( t_n_words );
+
+        // each bitmap word is built in a register and stored once, without branching on the flags;
+        // any ID that isn't consecutive leaves a nonzero bit in t_id_mismatch
+        uint64_t t_first_id = a_flags[ 0 ].get_id();
+        uint64_t t_id_mismatch = 0;
+        for( size_t i_word = 0; i_word < t_n_words && t_id_mismatch == 0; ++i_word )
+        {
+            const trigger_flag* t_word_flags = a_flags + i_word * 64;
+            const uint64_t t_word_first_id = t_first_id + i_word * 64;
+            const unsigned t_n_bits = (unsigned)std::min< size_t >( 64, a_n_flags - i_word * 64 );
+            uint64_t t_flag_word = 0;
+            uint64_t t_high_word = 0;
+            for( unsigned i_bit = 0; i_bit < t_n_bits; ++i_bit )
+            {
+                const trigger_flag& t_flag = t_word_flags[ i_bit ];
+                t_id_mismatch |= t_flag.get_id() ^ ( t_word_first_id + i_bit );
+                uint64_t t_is_flagged = t_flag.get_flag();
+                t_flag_word |= t_is_flagged << i_bit;
+                t_high_word |= ( t_is_flagged & uint64_t( t_flag.get_high_threshold() ) ) << i_bit;
+            }
+            f_flag_bits[ i_word ] = t_flag_word;
+            f_high_bits[ i_word ] = t_high_word;
+        }
+
+        if( t_id_mismatch != 0 )
+        {
+            for( size_t i_flag = 0; i_flag < a_n_flags; ++i_flag )
+            {
+                process_flag( a_flags[ i_flag ], a_events );
+            }
+            return;
+        }
+
+        process_batch( t_first_id, f_flag_bits.data(), f_high_bits.data(), a_n_flags, a_events );
+        return;
+    }
+
+    void event_batch_builder::process_batch( uint64_t a_first_id, const uint64_t* a_flags, const uint64_t* a_high, size_t a_n_flags, std::vector< id_range_event >& a_events )
+    {
+        if( a_n_flags == 0 ) return;
+
+        if( ! f_have_id )
+        {
+            f_earliest_id = a_first_id;
+            f_have_id = true;
+        }
+
+        // each pass through the loop handles a run of flagged or unflagged packets starting at t_pos
+        size_t t_pos = 0;
+        while( t_pos < a_n_flags )
+        {
+            switch( f_state )
+            {
+                case state_t::untriggered:
+                {
+                    size_t t_trig = find_next_set( a_flags, t_pos, a_n_flags );
+                    if( t_trig == a_n_flags )
+                    {
+                        t_pos = a_n_flags;
+                        break;
+                    }
+                    start_candidate( a_first_id + t_trig );
+                    bool t_high = a_high != nullptr && ( ( a_high[ t_trig / 64 ] >> ( t_trig % 64 ) ) & 1 );
+                    f_state = ( t_high || f_n_triggers <= 1 ) ? state_t::triggered : state_t::collecting_triggers;
+                    t_pos = t_trig + 1;
+                    break;
+                }
+                case state_t::collecting_triggers:
+                {
+                    // the run of flags starting here either reaches n-triggers (or a high-threshold flag), or the candidate is dropped
+                    size_t t_run_end = find_next_clear( a_flags, t_pos, a_n_flags );
+                    size_t t_needed = f_n_triggers - f_trigger_count;
+                    size_t t_high = a_high != nullptr ? find_next_set( a_high, t_pos, t_run_end ) : t_run_end;
+                    if( t_high < t_run_end || t_run_end - t_pos >= t_needed )
+                    {
+                        size_t t_trig = std::min( t_high, t_pos + t_needed - 1 );
+                        f_trigger_count += t_trig - t_pos + 1;
+                        f_last_trigger_id = a_first_id + t_trig;
+                        f_state = state_t::triggered;
+                        t_pos = t_trig + 1;
+                    }
+                    else
+                    {
+                        f_trigger_count += t_run_end - t_pos;
+                        if( t_run_end > t_pos ) f_last_trigger_id = a_first_id + t_run_end - 1;
+                        if( t_run_end < a_n_flags ) f_state = state_t::untriggered;
+                        t_pos = std::min( t_run_end + 1, a_n_flags );
+                    }
+                    break;
+                }
+                case state_t::triggered:
+                {
+                    // the event ends at the first gap longer than the skip tolerance, and its last flag is the last one before that gap
+                    size_t t_gap_end = find_gap_end( a_flags, t_pos, a_n_flags, f_skip_tolerance + 1, f_skip_count );
+                    size_t t_last = find_prev_set( a_flags, t_pos, t_gap_end );
+                    if( t_last != t_gap_end ) f_last_trigger_id = a_first_id + t_last;
+                    if( t_gap_end < a_n_flags )
+                    {
+                        end_event( a_events );
+                        t_pos = t_gap_end + 1;
+                    }
+                    else
+                    {
+                        f_skip_count = t_last != t_gap_end ? a_n_flags - 1 - t_last : f_skip_count + a_n_flags - t_pos;
+                        t_pos = a_n_flags;
+                    }
+                    break;
+                }
+            }
+        }
+
+        return;
+    }
+
+    void event_batch_builder::flush( std::vector< id_range_event >& a_events )
+    {
+        if( f_state == state_t::triggered )
+        {
+            end_event( a_events );
+        }
+        f_state = state_t::untriggered;
+        return;
+    }
+
+} /* namespace psyllid */
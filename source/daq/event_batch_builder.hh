@@ -0,0 +1,116 @@
+/*
+ * event_batch_builder.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_EVENT_BATCH_BUILDER_HH_
+#define PSYLLID_EVENT_BATCH_BUILDER_HH_
+
+#include "id_range_event.hh"
+#include "trigger_flag.hh"
+
+#include "member_variables.hh"
+
+#include <vector>
+
+namespace psyllid
+{
+
+    /*!
+     @class event_batch_builder
+     @brief Builds events from trigger flags, either one flag at a time or a batch of flags at a time
+
+     @details
+     Event-building rules:
+     - An event starts when n-triggers consecutive packets are flagged, or immediately when a flagged packet has its high_threshold set.
+     - Up to pretrigger packets before the first flagged packet are included at the start of the event,
+       but never packets that belong to the previous event.
+     - An event continues through up to skip-tolerance consecutive packets that aren't flagged;
+       the next packet that isn't flagged ends the event.
+     - An event ends with its last flagged packet.  Events still open when the run ends are closed by flush().
+     - Flagged packets that don't reach n-triggers do not start an event.
+
+     With pretrigger 2 and skip tolerance 1, flags 0,0,0,1,1,1,0,1,1,0,0,1,1,1,0,1,0,0,0,1 (IDs 0-19) give events 1-8, 9-15 and 17-19.
+
+     process_flag() applies these rules one flag at a time.
+     process_batch() applies them to an array of flags with consecutive IDs: the flags are packed into bitmaps a word at a time,
+     runs of flagged packets are found with bit scans, and the gap that ends an event is found by testing a whole bitmap word at once,
+     so the work done is proportional to the number of events and bitmap words rather than the number of packets.
+     Both give identical events, and the two can be mixed; the state carries over between calls.
+
+     The events are ID ranges; the packets themselves can be read in place from a packet_ring with get_event_span(),
+     as long as the ring is sized for the pretrigger and skip tolerance (see packet_ring::n_slots_for_events()).
+
+     Not thread-safe.
+    */
+    class event_batch_builder
+    {
+        public:
+            event_batch_builder();
+            virtual ~event_batch_builder();
+
+        public:
+            mv_accessible( uint64_t, pretrigger );
+            mv_accessible( uint64_t, skip_tolerance );
+            mv_accessible( uint64_t, n_triggers );
+
+        public:
+            /// Clears the state, e.g. at the start of a run
+            void reset();
+
+            /// Processes one flag; completed events are appended to a_events
+            void process_flag( uint64_t a_id, bool a_flag, bool a_high_threshold, std::vector< id_range_event >& a_events );
+            void process_flag( const trigger_flag& a_flag, std::vector< id_range_event >& a_events );
+
+            /// Processes a batch of flags; completed events are appended to a_events.
+            /// If the IDs are not consecutive, the flags are processed one at a time.
+            void process_batch( const trigger_flag* a_flags, size_t a_n_flags, std::vector< id_range_event >& a_events );
+
+            /// Processes a batch of flags with consecutive IDs starting at a_first_id, given as bitmaps (bit i of the bitmap is ID a_first_id + i).
+            /// a_high may be null if no flags have high_threshold set.
+            void process_batch( uint64_t a_first_id, const uint64_t* a_flags, const uint64_t* a_high, size_t a_n_flags, std::vector< id_range_event >& a_events );
+
+            /// Closes the open event, if any (e.g. at the end of a run)
+            void flush( std::vector< id_range_event >& a_events );
+
+            /// Returns true if an event is in progress
+            bool is_triggered() const;
+
+        private:
+            enum class state_t
+            {
+                untriggered,
+                collecting_triggers,
+                triggered
+            };
+
+            void start_candidate( uint64_t a_id );
+            void end_event( std::vector< id_range_event >& a_events );
+
+            state_t f_state;
+            bool f_have_id;
+            uint64_t f_earliest_id; // earliest ID that can be part of the next event
+            uint64_t f_start_id; // start of the current event, including pretrigger
+            uint64_t f_last_trigger_id;
+            uint64_t f_trigger_count;
+            uint64_t f_skip_count;
+
+            std::vector< uint64_t > f_flag_bits;
+            std::vector< uint64_t > f_high_bits;
+    };
+
+    inline bool event_batch_builder::is_triggered() const
+    {
+        return f_state == state_t::triggered;
+    }
+
+    inline void event_batch_builder::process_flag( const trigger_flag& a_flag, std::vector< id_range_event >& a_events )
+    {
+        process_flag( a_flag.get_id(), a_flag.get_flag(), a_flag.get_high_threshold(), a_events );
+        return;
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_EVENT_BATCH_BUILDER_HH_ */
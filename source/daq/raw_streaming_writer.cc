@@ -0,0 +1,591 @@
+/*
+ * raw_streaming_writer.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "raw_streaming_writer.hh"
+
+#include "butterfly_house.hh"
+#include "psyllid_error.hh"
+
+#include "midge_error.hh"
+
+#include "digital.hh"
+#include "logger.hh"
+
+#include <cmath>
+#include <deque>
+#include <sstream>
+
+using midge::stream;
+
+using std::string;
+using std::vector;
+
+namespace psyllid
+{
+    REGISTER_NODE_AND_BUILDER( raw_streaming_writer, "raw-streaming-writer", raw_streaming_writer_binding );
+
+    LOGGER( plog, "raw_streaming_writer" );
+
+    raw_streaming_writer::raw_streaming_writer() :
+            egg_writer(),
+            f_file_num( 0 ),
+            f_bit_depth( 8 ),
+            f_data_type_size( 1 ),
+            f_sample_size( 2 ),
+            f_record_size( 4096 ),
+            f_acq_rate( 100 ),
+            f_v_offset( 0. ),
+            f_v_range( 0.5 ),
+            f_center_freq( 50.e6 ),
+            f_freq_range( 100.e6 ),
+            f_batch_size( 64 ),
+            f_queue_depth( 16 ),
+            f_max_stall_ms( 1000 ),
+            f_direct_io( false ),
+            f_io_uring( false ),
+            f_io_uring_depth( 8 ),
+            f_compression( "none" ),
+            f_compression_level( 1 ),
+            f_compression_threads( 2 ),
+            f_last_pkt_in_batch( 0 ),
+            f_adc_stats(),
+            f_header(),
+            f_filename_base(),
+            f_capacity( 0 ),
+            f_file(),
+            f_file_count( 0 ),
+            f_queue(),
+            f_writer_thread(),
+            f_write_failed( false ),
+            f_uring(),
+            f_using_io_uring( false ),
+            f_compressor(),
+            f_compressed(),
+            f_stored_bytes(),
+            f_n_files( 0 ),
+            f_n_records_written( 0 ),
+            f_using_direct_io( false )
+    {
+    }
+
+    raw_streaming_writer::~raw_streaming_writer()
+    {
+        stop_writer_thread();
+    }
+
+    void raw_streaming_writer::prepare_to_write( monarch_wrap_ptr, header_wrap_ptr a_hw_ptr )
+    {
+        scarab::dig_calib_params t_dig_params;
+        scarab::get_calib_params( f_bit_depth, f_data_type_size, f_v_offset, f_v_range, true, &t_dig_params );
+
+        // the same stream and channel information that streaming_writer puts in the egg3 header
+        f_header = raw_egg_header();
+        f_header.f_source = "Psyllid - ROACH2";
+        f_header.f_acq_rate = f_acq_rate;
+        f_header.f_record_size = f_record_size;
+        f_header.f_sample_size = f_sample_size;
+        f_header.f_data_type_size = f_data_type_size;
+        f_header.f_data_format = monarch3::sDigitizedS;
+        f_header.f_bit_depth = f_bit_depth;
+        f_header.f_bit_alignment = monarch3::sBitsAlignedLeft;
+        f_header.f_record_bytes = f_record_size * f_sample_size * f_data_type_size;
+        f_header.f_v_offset = t_dig_params.v_offset;
+        f_header.f_v_range = t_dig_params.v_range;
+        f_header.f_dac_gain = t_dig_params.dac_gain;
+        f_header.f_freq_min = f_center_freq - 0.5 * f_freq_range;
+        f_header.f_freq_range = f_freq_range;
+        f_header.f_compression = record_compression_from_string( f_compression );
+
+        // the run information comes from the egg3 header, which the butterfly_house has filled in (and locked)
+        const monarch3::M3Header& t_egg_header = a_hw_ptr->header();
+        f_header.f_timestamp = t_egg_header.GetTimestamp();
+        f_header.f_description = t_egg_header.GetDescription();
+        f_header.f_run_duration = t_egg_header.GetRunDuration();
+
+        string t_egg_filename( t_egg_header.GetFilename() );
+        string::size_type t_ext_pos = t_egg_filename.find_last_of( '.' );
+        f_filename_base = t_ext_pos == string::npos ? t_egg_filename : t_egg_filename.substr( 0, t_ext_pos );
+
+        f_capacity = raw_egg_file_writer::capacity_for_size( butterfly_house::get_instance()->get_max_file_size_mb(), f_header.f_record_bytes );
+        if( f_capacity == 0 )
+        {
+            throw error() << "Maximum file size is too small for a raw egg file with " << f_header.f_record_bytes << "-byte records";
+        }
+        LDEBUG( plog, "Raw egg files will be written to <" << get_raw_filename( 0 ) << ">, with up to " << f_capacity << " records per file" );
+        return;
+    }
+
+    void raw_streaming_writer::initialize()
+    {
+        if( f_batch_size == 0 || f_queue_depth == 0 )
+        {
+            throw error() << "Batch size and queue depth must be positive";
+        }
+        if( f_io_uring && f_io_uring_depth == 0 )
+        {
+            throw error() << "io_uring queue depth must be positive";
+        }
+        if( record_compression_from_string( f_compression ) != record_compression::none && f_compression_threads == 0 )
+        {
+            throw error() << "Number of compression threads must be positive";
+        }
+        butterfly_house::get_instance()->register_writer( this, f_file_num );
+        return;
+    }
+
+    string raw_streaming_writer::get_raw_filename( unsigned a_file_count ) const
+    {
+        std::stringstream t_filename;
+        t_filename << f_filename_base;
+        if( a_file_count > 0 ) t_filename << '_' << a_file_count;
+        t_filename << ".rawegg";
+        return t_filename.str();
+    }
+
+    void raw_streaming_writer::open_file()
+    {
+        string t_filename( get_raw_filename( f_file_count ) );
+        f_header.f_filename = t_filename;
+        f_file.open( t_filename, f_header, f_capacity, f_direct_io );
+        if( f_direct_io && ! f_file.uses_direct_io() && f_header.f_compression == record_compression::none )
+        {
+            LWARN( plog, "Direct I/O is not available for <" << t_filename << ">; writing through the page cache" );
+        }
+        f_using_direct_io.store( f_file.uses_direct_io() );
+        f_n_files.fetch_add( 1 );
+        LINFO( plog, "Writing raw egg file <" << t_filename << ">" );
+        return;
+    }
+
+    void raw_streaming_writer::finish_file()
+    {
+        if( ! f_file.is_open() ) return;
+        f_queue.flush();
+        f_queue.wait_until_empty();
+        // the queue is empty, so the writer thread isn't using the file
+        string t_filename( f_file.get_filename() );
+        uint64_t t_n_records = f_file.get_n_records();
+        try
+        {
+            f_file.finish();
+        }
+        catch( error& e )
+        {
+            // the writer thread has already reported the failure, and the node reports it when it next handles a packet
+            LERROR( plog, "Unable to finish raw egg file <" << t_filename << ">: " << e.what() );
+            return;
+        }
+        LINFO( plog, "Finished raw egg file <" << t_filename << "> with " << t_n_records << " records" );
+        return;
+    }
+
+    void raw_streaming_writer::write_batch( const record_batch_queue::batch& a_batch, int8_t* a_compressed, vector< const int8_t* >& a_records, vector< raw_egg_index_entry >& a_entries )
+    {
+        for( size_t i_record = 0; i_record < a_batch.f_n_records; ++i_record )
+        {
+            const record_batch_queue::record& t_record = a_batch.f_records[ i_record ];
+            a_records[ i_record ] = t_record.f_data;
+            a_entries[ i_record ] = { t_record.f_id, t_record.f_time, t_record.f_is_new_acq ? raw_egg_index_entry::s_new_acq : 0U, 0U };
+        }
+        LTRACE( plog, "Writing queued batch of " << a_batch.f_n_records << " records" );
+        try
+        {
+            if( f_compressor.is_running() )
+            {
+                // the records are packed into the batch's compression buffer, and written from there
+                f_compressor.compress( a_records.data(), a_batch.f_n_records, a_compressed, f_stored_bytes.data() );
+                const int8_t* t_stored = a_compressed;
+                for( size_t i_record = 0; i_record < a_batch.f_n_records; ++i_record )
+                {
+                    a_records[ i_record ] = t_stored;
+                    if( f_stored_bytes[ i_record ] < f_header.f_record_bytes )
+                    {
+                        a_entries[ i_record ].f_flags |= raw_egg_index_entry::s_compressed;
+                        a_entries[ i_record ].f_stored_bytes = f_stored_bytes[ i_record ];
+                    }
+                    t_stored += f_stored_bytes[ i_record ];
+                }
+            }
+
+            // a batch can be split across the end of one file and the start of the next
+            size_t t_n_written = 0;
+            while( t_n_written < a_batch.f_n_records )
+            {
+                if( f_file.is_full() )
+                {
+                    LINFO( plog, "Raw egg file <" << f_file.get_filename() << "> is full" );
+                    f_file.finish();
+                    ++f_file_count;
+                    open_file();
+                }
+                t_n_written += f_file.write( a_records.data() + t_n_written, a_entries.data() + t_n_written, a_batch.f_n_records - t_n_written );
+            }
+            f_n_records_written.fetch_add( t_n_written );
+        }
+        catch( error& e )
+        {
+            LERROR( plog, "Unable to write queued records; first record ID: " << a_entries.front().f_id << "\n" << e.what() );
+            f_write_failed.store( true );
+        }
+        return;
+    }
+
+    void raw_streaming_writer::write_queue()
+    {
+        LDEBUG( plog, "Raw streaming writer's writer thread is starting" );
+        vector< const int8_t* > t_records( f_queue.get_batch_size() );
+        vector< raw_egg_index_entry > t_entries( f_queue.get_batch_size() );
+        f_stored_bytes.resize( f_queue.get_batch_size() );
+        // a batch is held until it's written, so the compression buffer for batch n isn't in use by batch n - queue-depth anymore
+        const size_t t_compressed_batch_bytes = f_queue.get_batch_size() * f_queue.get_record_size();
+        uint64_t t_n_taken = 0;
+
+        // with io_uring, each batch is held until its writes have completed; for each batch held, the number of chains submitted by the end of its writes
+        const bool t_use_uring = f_uring.is_initialized();
+        std::deque< uint64_t > t_held;
+
+        while( true )
+        {
+            const record_batch_queue::batch* t_batch = t_held.empty() ? f_queue.next_batch() : f_queue.try_next_batch();
+            if( t_batch == nullptr )
+            {
+                // closed, or nothing new to write while writes are in flight
+                if( t_held.empty() ) break;
+                f_uring.wait_for_completion();
+            }
+            else
+            {
+                // after a failure, the rest of the run is discarded; the node throws the error when it next handles a packet
+                int8_t* t_compressed = f_compressed.empty() ? nullptr : f_compressed.data() + ( t_n_taken % f_queue.get_n_batches() ) * t_compressed_batch_bytes;
+                ++t_n_taken;
+                if( ! f_write_failed.load() ) write_batch( *t_batch, t_compressed, t_records, t_entries );
+                if( ! t_use_uring )
+                {
+                    f_queue.release_batch();
+                    continue;
+                }
+                t_held.push_back( f_uring.get_n_submitted() );
+                f_uring.poll();
+            }
+            while( ! t_held.empty() && t_held.front() <= f_uring.get_n_completed() )
+            {
+                t_held.pop_front();
+                f_queue.release_batch();
+            }
+        }
+        LDEBUG( plog, "Raw streaming writer's writer thread is exiting" );
+        return;
+    }
+
+    void raw_streaming_writer::start_io_uring()
+    {
+        f_file.set_uring( nullptr );
+        if( ! f_io_uring ) return;
+        try
+        {
+            f_uring.initialize( f_io_uring_depth );
+        }
+        catch( error& e )
+        {
+            LWARN( plog, "io_uring is not available; writing with pwritev\n" << e.what() );
+            return;
+        }
+        // the batches are written in place (from the queue, or from the compression buffers), so that memory is registered for fixed-buffer writes
+        bool t_registered = f_compressed.empty() ? f_uring.register_buffer( f_queue.get_storage(), f_queue.get_storage_size() ) : f_uring.register_buffer( f_compressed.data(), f_compressed.size() );
+        if( ! t_registered )
+        {
+            LWARN( plog, "Unable to register the record memory with io_uring (is the locked-memory limit too small?); writing from unregistered memory" );
+        }
+        f_file.set_uring( &f_uring );
+        f_using_io_uring.store( true );
+        LDEBUG( plog, "Writing with io_uring, with up to " << f_io_uring_depth << " writes in flight" );
+        return;
+    }
+
+    void raw_streaming_writer::start_compression()
+    {
+        f_compressed.clear();
+        // the files' headers are filled in for each run, so the compression and record size are taken from the configuration
+        record_compression t_compression = record_compression_from_string( f_compression );
+        if( t_compression == record_compression::none ) return;
+        size_t t_record_bytes = f_record_size * f_sample_size * f_data_type_size;
+        f_compressed.resize( (size_t)f_queue_depth * f_batch_size * t_record_bytes );
+        f_compressor.start( t_compression, f_compression_level, f_compression_threads, t_record_bytes );
+        LDEBUG( plog, "Compressing records with " << f_compression << " (level " << f_compression_level << ") on " << f_compression_threads << " threads" );
+        return;
+    }
+
+    void raw_streaming_writer::stop_writer_thread()
+    {
+        if( f_writer_thread.joinable() )
+        {
+            f_queue.close();
+            f_writer_thread.join();
+        }
+        // waits for any writes still in flight
+        f_uring.close();
+        f_using_io_uring.store( false );
+        f_compressor.stop();
+        return;
+    }
+
+    void raw_streaming_writer::execute( midge::diptera* a_midge )
+    {
+        LDEBUG( plog, "execute raw streaming writer" );
+        try
+        {
+            midge::enum_t t_time_command = stream::s_none;
+
+            time_data* t_time_data = nullptr;
+
+            uint64_t t_bytes_per_record = f_record_size * f_sample_size * f_data_type_size;
+            if( t_bytes_per_record != PAYLOAD_SIZE )
+            {
+                throw error() << "Record size (" << t_bytes_per_record << " bytes) must match the packet payload size (" << PAYLOAD_SIZE << " bytes)";
+            }
+            uint64_t t_record_length_nsec = llrint( (double)(PAYLOAD_SIZE / 2) / (double)f_acq_rate * 1.e3 );
+
+            uint64_t t_first_pkt_in_run = 0;
+
+            adc_packet_stats t_packet_stats;
+
+            f_queue.allocate( f_queue_depth, f_batch_size, t_bytes_per_record );
+            f_write_failed.store( false );
+            start_compression();
+            start_io_uring();
+            f_writer_thread = std::thread( &raw_streaming_writer::write_queue, this );
+            const std::chrono::milliseconds t_max_stall( f_max_stall_ms );
+            bool t_dropping = false;
+
+            bool t_is_new_acquisition = true;
+            bool t_start_file_with_next_data = false;
+
+            while( ! is_canceled() )
+            {
+                t_time_command = in_stream< 0 >().get();
+                if( t_time_command == stream::s_none ) continue;
+                if( t_time_command == stream::s_error ) break;
+
+                LTRACE( plog, "Raw writer reading stream 0 (time) at index " << in_stream< 0 >().get_current_index() );
+
+                if( t_time_command == stream::s_exit )
+                {
+                    LDEBUG( plog, "Raw streaming writer is exiting" );
+
+                    finish_file();
+                    break;
+                }
+
+                if( t_time_command == stream::s_stop )
+                {
+                    LDEBUG( plog, "Raw streaming writer is stopping" );
+
+                    finish_file();
+                    continue;
+                }
+
+                if( t_time_command == stream::s_start )
+                {
+                    LDEBUG( plog, "Will start file with next data" );
+
+                    finish_file();
+
+                    f_adc_stats.reset();
+                    f_queue.reset_stats();
+                    f_uring.reset_stats();
+                    f_uring.clear_error();
+                    f_compressor.reset_stats();
+                    f_write_failed.store( false );
+                    f_n_files.store( 0 );
+                    f_n_records_written.store( 0 );
+
+                    f_file_count = 0;
+                    open_file();
+
+                    t_start_file_with_next_data = true;
+                    continue;
+                }
+
+                if( t_time_command == stream::s_run )
+                {
+                    t_time_data = in_stream< 0 >().data();
+
+                    if( t_start_file_with_next_data )
+                    {
+                        LDEBUG( plog, "Handling first packet in run" );
+
+                        t_first_pkt_in_run = t_time_data->get_pkt_in_session();
+
+                        t_is_new_acquisition = true;
+
+                        t_start_file_with_next_data = false;
+                    }
+
+                    uint64_t t_time_id = t_time_data->get_pkt_in_session();
+                    LTRACE( plog, "Writing packet (in session) " << t_time_id );
+
+                    uint32_t t_expected_pkt_in_batch = f_last_pkt_in_batch + 1;
+                    if( t_expected_pkt_in_batch >= BATCH_COUNTER_SIZE ) t_expected_pkt_in_batch = 0;
+                    if( ! t_is_new_acquisition && t_time_data->get_pkt_in_batch() != t_expected_pkt_in_batch ) t_is_new_acquisition = true;
+                    f_last_pkt_in_batch = t_time_data->get_pkt_in_batch();
+
+                    if( f_write_failed.load() )
+                    {
+                        throw midge::node_nonfatal_error() << "Unable to write queued records to raw egg file";
+                    }
+
+                    int8_t* t_record_data = f_queue.begin_record( t_max_stall );
+                    if( t_record_data == nullptr )
+                    {
+                        if( ! t_dropping ) LWARN( plog, "Record queue is full; dropping records, starting with " << t_time_id );
+                        t_dropping = true;
+                        // the next record written follows a gap
+                        t_is_new_acquisition = true;
+                        continue;
+                    }
+                    if( t_dropping ) LWARN( plog, "Record queue has space again; " << f_queue.get_n_dropped() << " records dropped so far in this run" );
+                    t_dropping = false;
+
+                    // the ADC statistics are computed while the packet is copied, so the packet is only read once
+                    copy_adc_stats( *t_time_data, t_record_data, t_packet_stats );
+                    f_queue.commit_record( t_time_id, t_record_length_nsec * ( t_time_id - t_first_pkt_in_run ), t_is_new_acquisition );
+
+                    LTRACE( plog, "Packet queued (" << t_time_id << ")" );
+
+                    f_adc_stats.add( t_packet_stats );
+
+                    t_is_new_acquisition = false;
+
+                    continue;
+                }
+
+            } // end while( ! is_cancelled() )
+
+            // final attempt to finish the file if the outer while loop is broken without the stream having been stopped or exited
+            finish_file();
+            stop_writer_thread();
+
+            return;
+        }
+        catch(...)
+        {
+            LWARN( plog, "an error occurred executing raw streaming writer" );
+            stop_writer_thread();
+            try
+            {
+                f_file.finish();
+            }
+            catch( error& e )
+            {
+                LERROR( plog, "Unable to finish raw egg file: " << e.what() );
+            }
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+    }
+
+    void raw_streaming_writer::finalize()
+    {
+        LDEBUG( plog, "finalize raw streaming writer" );
+        butterfly_house::get_instance()->unregister_writer( this );
+        return;
+    }
+
+
+    raw_streaming_writer_binding::raw_streaming_writer_binding() :
+            _node_binding< raw_streaming_writer, raw_streaming_writer_binding >()
+    {
+    }
+
+    raw_streaming_writer_binding::~raw_streaming_writer_binding()
+    {
+    }
+
+    void raw_streaming_writer_binding::do_apply_config( raw_streaming_writer* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Configuring raw_streaming_writer with:\n" << a_config );
+        a_node->set_file_num( a_config.get_value( "file-num", a_node->get_file_num() ) );
+        if( a_config.has( "device" ) )
+        {
+            const scarab::param_node& t_dev_config = a_config["device"].as_node();
+            a_node->set_bit_depth( t_dev_config.get_value( "bit-depth", a_node->get_bit_depth() ) );
+            a_node->set_data_type_size( t_dev_config.get_value( "data-type-size", a_node->get_data_type_size() ) );
+            a_node->set_sample_size( t_dev_config.get_value( "sample-size", a_node->get_sample_size() ) );
+            a_node->set_record_size( t_dev_config.get_value( "record-size", a_node->get_record_size() ) );
+            a_node->set_acq_rate( t_dev_config.get_value( "acq-rate", a_node->get_acq_rate() ) );
+            a_node->set_v_offset( t_dev_config.get_value( "v-offset", a_node->get_v_offset() ) );
+            a_node->set_v_range( t_dev_config.get_value( "v-range", a_node->get_v_range() ) );
+        }
+        a_node->set_center_freq( a_config.get_value( "center-freq", a_node->get_center_freq() ) );
+        a_node->set_freq_range( a_config.get_value( "freq-range", a_node->get_freq_range() ) );
+        a_node->set_batch_size( a_config.get_value( "batch-size", a_node->get_batch_size() ) );
+        a_node->set_queue_depth( a_config.get_value( "queue-depth", a_node->get_queue_depth() ) );
+        a_node->set_max_stall_ms( a_config.get_value( "max-stall-ms", a_node->get_max_stall_ms() ) );
+        a_node->set_direct_io( a_config.get_value( "direct-io", a_node->get_direct_io() ) );
+        a_node->set_io_uring( a_config.get_value( "io-uring", a_node->get_io_uring() ) );
+        a_node->set_io_uring_depth( a_config.get_value( "io-uring-depth", a_node->get_io_uring_depth() ) );
+        a_node->compression() = a_config.get_value( "compression", a_node->compression() );
+        a_node->set_compression_level( a_config.get_value( "compression-level", a_node->get_compression_level() ) );
+        a_node->set_compression_threads( a_config.get_value( "compression-threads", a_node->get_compression_threads() ) );
+        return;
+    }
+
+    void raw_streaming_writer_binding::do_dump_config( const raw_streaming_writer* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Dumping configuration for raw_streaming_writer" );
+        a_config.add( "file-num", a_node->get_file_num() );
+        scarab::param_node t_dev_node = scarab::param_node();
+        t_dev_node.add( "bit-depth", a_node->get_bit_depth() );
+        t_dev_node.add( "data-type-size", a_node->get_data_type_size() );
+        t_dev_node.add( "sample-size", a_node->get_sample_size() );
+        t_dev_node.add( "record-size", a_node->get_record_size() );
+        t_dev_node.add( "acq-rate", a_node->get_acq_rate() );
+        t_dev_node.add( "v-offset", a_node->get_v_offset() );
+        t_dev_node.add( "v-range", a_node->get_v_range() );
+        a_config.add( "device", t_dev_node );
+        a_config.add( "center-freq", a_node->get_center_freq() );
+        a_config.add( "freq-range", a_node->get_freq_range() );
+        a_config.add( "batch-size", a_node->get_batch_size() );
+        a_config.add( "queue-depth", a_node->get_queue_depth() );
+        a_config.add( "max-stall-ms", a_node->get_max_stall_ms() );
+        a_config.add( "direct-io", a_node->get_direct_io() );
+        a_config.add( "io-uring", a_node->get_io_uring() );
+        a_config.add( "io-uring-depth", a_node->get_io_uring_depth() );
+        a_config.add( "compression", a_node->compression() );
+        a_config.add( "compression-level", a_node->get_compression_level() );
+        a_config.add( "compression-threads", a_node->get_compression_threads() );
+        return;
+    }
+
+    void raw_streaming_writer_binding::do_dump_status( const raw_streaming_writer* a_node, scarab::param_node& a_status ) const
+    {
+        scarab::param_node t_adc_node;
+        a_node->get_adc_stats().fill_status( t_adc_node );
+        a_status.add( "adc", t_adc_node );
+        scarab::param_node t_queue_node;
+        a_node->get_queue().fill_status( t_queue_node );
+        a_status.add( "queue", t_queue_node );
+        scarab::param_node t_files_node;
+        t_files_node.add( "n-files", a_node->get_n_files() );
+        t_files_node.add( "n-records", a_node->get_n_records_written() );
+        t_files_node.add( "direct-io", a_node->get_using_direct_io() );
+        a_status.add( "files", t_files_node );
+        scarab::param_node t_uring_node;
+        t_uring_node.add( "enabled", a_node->get_using_io_uring() );
+        scarab::param_node t_submit_node;
+        a_node->get_io_uring_stats().get_submit_latency().fill_status( t_submit_node );
+        t_uring_node.add( "submit-latency", t_submit_node );
+        scarab::param_node t_complete_node;
+        a_node->get_io_uring_stats().get_complete_latency().fill_status( t_complete_node );
+        t_uring_node.add( "complete-latency", t_complete_node );
+        a_status.add( "io-uring", t_uring_node );
+        scarab::param_node t_compression_node;
+        a_node->get_compressor().fill_status( t_compression_node );
+        a_status.add( "compression", t_compression_node );
+        return;
+    }
+
+} /* namespace psyllid */
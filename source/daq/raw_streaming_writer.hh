@@ -0,0 +1,249 @@
+/*
+ * raw_streaming_writer.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_RAW_STREAMING_WRITER_HH_
+#define PSYLLID_RAW_STREAMING_WRITER_HH_
+
+#include "adc_stats.hh"
+#include "egg_writer.hh"
+#include "node_builder.hh"
+#include "raw_egg.hh"
+#include "record_batch_queue.hh"
+#include "record_compression.hh"
+#include "time_data.hh"
+#include "uring_writer.hh"
+
+#include "consumer.hh"
+
+#include <atomic>
+#include <thread>
+
+namespace psyllid
+{
+
+    /*!
+     @class raw_streaming_writer
+     @brief A consumer that writes all time ROACH packets to raw egg files, bypassing HDF5
+
+     @details
+
+     For streams whose rate is more than the egg3 (HDF5) writing can sustain.  Records are written to raw egg files (see raw_egg_header):
+     a small header with the same metadata that streaming_writer puts in the egg3 header, the records back to back, and a record index.
+     Each file is pre-sized for the number of records that fit in max-file-size-mb, and a new file is started when it's full.
+     raw_to_egg3 converts the files to standard egg3 files offline.
+
+     The node registers with the butterfly_house like the egg3 writers, and takes the run's filename, timestamp, description and duration from
+     the egg3 header; it doesn't add a stream to the egg3 file.  The raw files are named after the egg3 file, with the extension ".rawegg"
+     (continuation files: [base]_1.rawegg, [base]_2.rawegg, ...).  The egg3 file for the node's file number is still created, with just the run header,
+     so the node is best given a file number of its own.
+
+     Writing is asynchronous, as with streaming_writer in async mode: the node copies each packet into a preallocated queue of queue-depth batches
+     of batch-size records (computing the ADC statistics during the copy), and a writer thread writes each batch to the file with one pwritev call
+     for the data and one for the index entries.  If the queue fills, the node waits for up to max-stall-ms; a record that still doesn't fit is dropped,
+     and the next record written starts a new acquisition.
+
+     With io-uring, the writer thread submits each batch's writes through io_uring (see uring_writer) instead of calling pwritev, so that
+     several batches can be in flight at once, and holds the batch until its writes complete.  The queue's memory is registered with the kernel
+     for fixed-buffer writes.  If io_uring isn't available (Psyllid built without it, or an older kernel), pwritev is used, with a warning.
+
+     With compression, the writer thread compresses each batch on a pool of compression-threads threads (see record_compressor) before writing it;
+     each record is stored compressed if that makes it smaller.  The compressed batches go into queue-depth buffers of their own (which are then the
+     memory registered with io_uring).  Compressed files can't be written with direct I/O, so direct-io is ignored.  raw_to_egg3 decompresses the records.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "raw-streaming-writer"
+
+     Available configuration values:
+     - "file-num": uint -- the file number to register with the butterfly_house
+     - "device": node -- digitizer parameters
+       - "bit-depth": uint -- bit depth of each sample
+       - "data-type-size": uint -- number of bytes in each sample (or component of a sample for sample-size > 1)
+       - "sample-size": uint -- number of components in each sample (1 for real sampling; 2 for IQ sampling)
+       - "record-size": uint -- number of samples in each record
+       - "acq-rate": uint -- acquisition rate in MHz
+       - "v-offset": double -- voltage offset for ADC calibration
+       - "v-range": double -- voltage range for ADC calibration
+     - "center-freq": double -- the center frequency of the data being digitized in Hz
+     - "freq-range": double -- the frequency window (bandwidth) of the data being digitized in Hz
+     - "batch-size": uint -- number of records written to the file together
+     - "queue-depth": uint -- number of batches that can be queued for the writer thread
+     - "max-stall-ms": uint -- how long to wait for the writer thread when the queue is full before dropping a record
+     - "direct-io": bool -- if true, the record data is written with O_DIRECT, bypassing the page cache
+     - "io-uring": bool -- if true, the files are written with io_uring
+     - "io-uring-depth": uint -- with io-uring, the number of batch writes that can be in flight at once
+     - "compression": string -- lossless compression of the records: "none", "deflate", or "bitshuffle-deflate" (see record_compression)
+     - "compression-level": int -- zlib compression level, from 1 (fastest) to 9 (smallest)
+     - "compression-threads": uint -- number of threads compressing each batch
+
+     Each record holds one packet, so the record size (record-size * sample-size * data-type-size) must equal the packet payload size.
+
+     The status contains "adc" (see adc_stats), "queue" (see record_batch_queue), "files":
+     - "n-files": uint -- number of raw files written in the current run
+     - "n-records": uint -- number of records written in the current run
+     - "direct-io": bool -- whether the current file is written with direct I/O
+     and "io-uring":
+     - "enabled": bool -- whether io_uring is being used
+     - "submit-latency", "complete-latency": node -- distributions of the time to submit each batch's writes, and the time for them to complete,
+       for the current run (see latency_histogram)
+     and "compression" (see record_compressor): the compression ratio and per-thread compression rate for the current run
+
+     Input Stream:
+     - 0: time_data
+
+     Output Streams: (none)
+    */
+    class raw_streaming_writer :
+            public midge::_consumer< midge::type_list< time_data > >,
+            public egg_writer
+    {
+        public:
+            raw_streaming_writer();
+            virtual ~raw_streaming_writer();
+
+        public:
+            mv_accessible( unsigned, file_num );
+
+            mv_accessible( unsigned, bit_depth ); // # of bits
+            mv_accessible( unsigned, data_type_size ); // # of bytes
+            mv_accessible( unsigned, sample_size );  // # of components
+            mv_accessible( unsigned, record_size ); // # of samples
+            mv_accessible( unsigned, acq_rate ); // MHz
+            mv_accessible( double, v_offset ); // V
+            mv_accessible( double, v_range ); // V
+            mv_accessible( double, center_freq ); // Hz
+            mv_accessible( double, freq_range ); // Hz
+            mv_accessible( unsigned, batch_size );
+            mv_accessible( unsigned, queue_depth );
+            mv_accessible( unsigned, max_stall_ms );
+            mv_accessible( bool, direct_io );
+            mv_accessible( bool, io_uring );
+            mv_accessible( unsigned, io_uring_depth );
+            mv_referrable( std::string, compression );
+            mv_accessible( int, compression_level );
+            mv_accessible( unsigned, compression_threads );
+
+        public:
+            virtual void prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr );
+
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+            /// ADC statistics for the current run; can be read from any thread
+            const adc_stats& get_adc_stats() const;
+            /// Queue for the writer thread; the statistics can be read from any thread
+            const record_batch_queue& get_queue() const;
+
+            unsigned get_n_files() const;
+            uint64_t get_n_records_written() const;
+            bool get_using_direct_io() const;
+            bool get_using_io_uring() const;
+            /// io_uring backend; its latency distributions can be read from any thread
+            const uring_writer& get_io_uring_stats() const;
+            /// Compression threads; the statistics can be read from any thread
+            const record_compressor& get_compressor() const;
+
+        private:
+            std::string get_raw_filename( unsigned a_file_count ) const;
+            /// Opens raw file number f_file_count; throws psyllid::error on failure
+            void open_file();
+            /// Writes the queued batches and finishes the file
+            void finish_file();
+
+            /// Allocates the compression buffers and starts the compression threads, if the records are compressed
+            void start_compression();
+            /// Sets up io_uring for the writer thread, if requested and available
+            void start_io_uring();
+
+            /// Writer thread: writes queued batches to the file until the queue is closed
+            void write_queue();
+            /// With compression, the batch is compressed into a_compressed, which must hold a batch of records
+            void write_batch( const record_batch_queue::batch& a_batch, int8_t* a_compressed, std::vector< const int8_t* >& a_records, std::vector< raw_egg_index_entry >& a_entries );
+            /// Also closes io_uring, once the writes in flight are done, and stops the compression threads
+            void stop_writer_thread();
+
+            unsigned f_last_pkt_in_batch;
+
+            adc_stats f_adc_stats;
+
+            raw_egg_header f_header;
+            std::string f_filename_base;
+            uint64_t f_capacity;
+            raw_egg_file_writer f_file; // only used by the writer thread while records are queued
+            unsigned f_file_count;
+
+            record_batch_queue f_queue;
+            std::thread f_writer_thread;
+            std::atomic< bool > f_write_failed;
+            uring_writer f_uring; // only used by the writer thread while records are queued
+            std::atomic< bool > f_using_io_uring;
+            record_compressor f_compressor;
+            std::vector< int8_t > f_compressed; // a buffer for each batch in the queue; only used by the writer thread while records are queued
+            std::vector< uint32_t > f_stored_bytes;
+
+            std::atomic< unsigned > f_n_files;
+            std::atomic< uint64_t > f_n_records_written;
+            std::atomic< bool > f_using_direct_io;
+    };
+
+    inline const adc_stats& raw_streaming_writer::get_adc_stats() const
+    {
+        return f_adc_stats;
+    }
+
+    inline const record_batch_queue& raw_streaming_writer::get_queue() const
+    {
+        return f_queue;
+    }
+
+    inline unsigned raw_streaming_writer::get_n_files() const
+    {
+        return f_n_files.load();
+    }
+
+    inline uint64_t raw_streaming_writer::get_n_records_written() const
+    {
+        return f_n_records_written.load();
+    }
+
+    inline bool raw_streaming_writer::get_using_direct_io() const
+    {
+        return f_using_direct_io.load();
+    }
+
+    inline bool raw_streaming_writer::get_using_io_uring() const
+    {
+        return f_using_io_uring.load();
+    }
+
+    inline const uring_writer& raw_streaming_writer::get_io_uring_stats() const
+    {
+        return f_uring;
+    }
+
+    inline const record_compressor& raw_streaming_writer::get_compressor() const
+    {
+        return f_compressor;
+    }
+
+
+    class raw_streaming_writer_binding : public _node_binding< raw_streaming_writer, raw_streaming_writer_binding >
+    {
+        public:
+            raw_streaming_writer_binding();
+            virtual ~raw_streaming_writer_binding();
+
+        private:
+            virtual void do_apply_config( raw_streaming_writer* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_config( const raw_streaming_writer* a_node, scarab::param_node& a_config ) const;
+
+            virtual void do_dump_status( const raw_streaming_writer* a_node, scarab::param_node& a_status ) const;
+    };
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_RAW_STREAMING_WRITER_HH_ */
@@ -0,0 +1,363 @@
+/*
+ * ring_recorder.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "ring_recorder.hh"
+
+#include "butterfly_house.hh"
+#include "psyllid_error.hh"
+
+#include "digital.hh"
+#include "logger.hh"
+#include "param.hh"
+
+#include <cmath>
+#include <cstring>
+#include <sstream>
+#include <system_error>
+
+using midge::stream;
+
+using std::string;
+using std::vector;
+
+namespace psyllid
+{
+    REGISTER_NODE_AND_BUILDER( ring_recorder, "ring-recorder", ring_recorder_binding );
+
+    LOGGER( plog, "ring_recorder" );
+
+    ring_recorder::ring_recorder() :
+            egg_writer(),
+            f_duration( 1. ),
+            f_headroom( 0.5 ),
+            f_use_huge_pages( true ),
+            f_bit_depth( 8 ),
+            f_data_type_size( 1 ),
+            f_sample_size( 2 ),
+            f_acq_rate( 100 ),
+            f_v_offset( 0. ),
+            f_v_range( 0.5 ),
+            f_center_freq( 50.e6 ),
+            f_freq_range( 100.e6 ),
+            f_ring(),
+            f_n_dump_packets( 0 ),
+            f_dump_thread(),
+            f_dumping( false ),
+            f_n_dumps( 0 ),
+            f_stream_no( 0 )
+    {
+    }
+
+    ring_recorder::~ring_recorder()
+    {
+        join_dump_thread();
+    }
+
+    void ring_recorder::prepare_to_write( monarch_wrap_ptr, header_wrap_ptr a_hw_ptr )
+    {
+        scarab::dig_calib_params t_dig_params;
+        scarab::get_calib_params( f_bit_depth, f_data_type_size, f_v_offset, f_v_range, true, &t_dig_params );
+
+        vector< unsigned > t_chan_vec;
+        f_stream_no = a_hw_ptr->header().AddStream( "Psyllid - ring recorder",
+                f_acq_rate, PAYLOAD_SIZE / ( f_sample_size * f_data_type_size ), f_sample_size, f_data_type_size,
+                monarch3::sDigitizedS, f_bit_depth, monarch3::sBitsAlignedLeft, &t_chan_vec );
+
+        for( std::vector< unsigned >::const_iterator it = t_chan_vec.begin(); it != t_chan_vec.end(); ++it )
+        {
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetVoltageOffset( t_dig_params.v_offset );
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetVoltageRange( t_dig_params.v_range );
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetDACGain( t_dig_params.dac_gain );
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetFrequencyMin( f_center_freq - 0.5 * f_freq_range );
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetFrequencyRange( f_freq_range );
+        }
+
+        return;
+    }
+
+    void ring_recorder::initialize()
+    {
+        if( f_duration <= 0. || f_headroom < 0. )
+        {
+            throw error() << "Ring recorder duration must be positive and headroom must be non-negative (duration: " << f_duration << " s; headroom: " << f_headroom << " s)";
+        }
+
+        double t_packets_per_sec = (double)f_acq_rate * 1.e6 / (double)( PAYLOAD_SIZE / ( f_sample_size * f_data_type_size ) );
+        f_n_dump_packets = (uint64_t)std::ceil( f_duration * t_packets_per_sec );
+        uint64_t t_n_slots = f_n_dump_packets + (uint64_t)std::ceil( f_headroom * t_packets_per_sec );
+
+        f_ring.allocate( t_n_slots, f_use_huge_pages );
+        LINFO( plog, "Ring recorder allocated " << t_n_slots << " packets (" << 1.e-6 * (double)( t_n_slots * PAYLOAD_SIZE ) << " MB)" <<
+                ( f_ring.uses_huge_pages() ? " in huge pages" : "" ) << "; dumps will contain up to " << f_n_dump_packets << " packets" );
+        if( f_use_huge_pages && ! f_ring.uses_huge_pages() )
+        {
+            LINFO( plog, "Huge pages were not available for the ring recorder; using normal pages" );
+        }
+        return;
+    }
+
+    void ring_recorder::execute( midge::diptera* a_midge )
+    {
+        LDEBUG( plog, "execute ring recorder" );
+        try
+        {
+            midge::enum_t t_time_command = stream::s_none;
+
+            time_data* t_time_data = nullptr;
+
+            while( ! is_canceled() )
+            {
+                t_time_command = in_stream< 0 >().get();
+                if( t_time_command == stream::s_none ) continue;
+                if( t_time_command == stream::s_error ) break;
+
+                LTRACE( plog, "Ring recorder reading stream 0 (time) at index " << in_stream< 0 >().get_current_index() );
+
+                if( t_time_command == stream::s_exit )
+                {
+                    LDEBUG( plog, "Ring recorder is exiting" );
+                    break;
+                }
+
+                if( t_time_command == stream::s_stop )
+                {
+                    LDEBUG( plog, "Ring recorder is stopping" );
+                    continue;
+                }
+
+                if( t_time_command == stream::s_start )
+                {
+                    LDEBUG( plog, "Ring recorder is starting; clearing the ring" );
+                    f_ring.clear();
+                    continue;
+                }
+
+                if( t_time_command == stream::s_run )
+                {
+                    t_time_data = in_stream< 0 >().data();
+
+                    if( ! f_ring.empty() && t_time_data->get_pkt_in_session() <= f_ring.get_newest_id() )
+                    {
+                        LWARN( plog, "Packet ID went backwards (" << f_ring.get_newest_id() << " to " << t_time_data->get_pkt_in_session() << "); clearing the ring" );
+                        f_ring.clear();
+                    }
+
+                    f_ring.write( *t_time_data );
+                    continue;
+                }
+
+            } // end while( ! is_cancelled() )
+
+            return;
+        }
+        catch(...)
+        {
+            LWARN( plog, "an error occurred executing ring recorder" );
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+    }
+
+    void ring_recorder::finalize()
+    {
+        LDEBUG( plog, "finalize ring recorder" );
+        join_dump_thread();
+        return;
+    }
+
+    void ring_recorder::dump( const std::string& a_filename, const std::string& a_description )
+    {
+        // claim the dump; only one request can succeed until the dump thread has finished
+        bool t_idle = false;
+        if( ! f_dumping.compare_exchange_strong( t_idle, true ) )
+        {
+            throw error() << "A dump is already in progress";
+        }
+        join_dump_thread();
+
+        ++f_n_dumps;
+        string t_filename( a_filename );
+        if( t_filename.empty() )
+        {
+            std::stringstream t_filename_sstr;
+            t_filename_sstr << "ring_dump_" << f_n_dumps << ".egg";
+            t_filename = t_filename_sstr.str();
+        }
+
+        try
+        {
+            f_dump_thread = std::thread( &ring_recorder::do_dump, this, t_filename, a_description );
+        }
+        catch( std::system_error& e )
+        {
+            f_dumping.store( false );
+            throw error() << "Unable to start the dump thread: " << e.what();
+        }
+        return;
+    }
+
+    void ring_recorder::join_dump_thread()
+    {
+        if( f_dump_thread.joinable() )
+        {
+            LDEBUG( plog, "Waiting for the ring-recorder dump to finish" );
+            f_dump_thread.join();
+        }
+        return;
+    }
+
+    void ring_recorder::do_dump( std::string a_filename, std::string a_description )
+    {
+        try
+        {
+            // packets from a later generation (after the ring is cleared for a new run) can have the same IDs as the ones being dumped
+            uint64_t t_generation = f_ring.get_generation();
+            if( f_ring.empty() )
+            {
+                LWARN( plog, "Ring recorder is empty; nothing to dump" );
+                f_dumping.store( false );
+                return;
+            }
+
+            uint64_t t_last_id = f_ring.get_newest_id();
+            uint64_t t_first_id = t_last_id + 1 > f_n_dump_packets ? t_last_id + 1 - f_n_dump_packets : 0;
+            if( t_first_id < f_ring.get_oldest_id() ) t_first_id = f_ring.get_oldest_id();
+
+            double t_record_length_nsec = (double)( PAYLOAD_SIZE / ( f_sample_size * f_data_type_size ) ) / (double)f_acq_rate * 1.e3;
+            unsigned t_duration_ms = (unsigned)llrint( 1.e-6 * t_record_length_nsec * (double)( t_last_id - t_first_id + 1 ) );
+
+            LINFO( plog, "Dumping packets " << t_first_id << " to " << t_last_id << " to <" << a_filename << ">" );
+
+            monarch_wrap_ptr t_mw_ptr = butterfly_house::get_instance()->start_standalone_file( a_filename, a_description, t_duration_ms, this );
+            stream_wrap_ptr t_swrap_ptr = t_mw_ptr->get_stream( f_stream_no );
+
+            // packets are copied out of the ring and checked before being written, since the ring keeps filling during the dump
+            vector< int8_t > t_buffer( PAYLOAD_SIZE );
+            uint64_t t_n_written = 0, t_n_skipped = 0;
+            bool t_is_new_acquisition = true;
+            bool t_cleared = false;
+            for( uint64_t t_id = t_first_id; t_id <= t_last_id && ! is_canceled(); ++t_id )
+            {
+                if( f_ring.get_generation() != t_generation )
+                {
+                    t_cleared = true;
+                    break;
+                }
+                if( ! f_ring.has( t_id ) )
+                {
+                    ++t_n_skipped;
+                    t_is_new_acquisition = true;
+                    continue;
+                }
+                ::memcpy( t_buffer.data(), f_ring.payload( t_id ), PAYLOAD_SIZE );
+                if( ! f_ring.is_intact( t_id ) )
+                {
+                    ++t_n_skipped;
+                    t_is_new_acquisition = true;
+                    continue;
+                }
+                if( f_ring.get_generation() != t_generation )
+                {
+                    t_cleared = true;
+                    break;
+                }
+
+                if( ! t_swrap_ptr->write_record( t_id, (uint64_t)llrint( t_record_length_nsec * (double)( t_id - t_first_id ) ), t_buffer.data(), PAYLOAD_SIZE, t_is_new_acquisition ) )
+                {
+                    throw error() << "Unable to write record to file; record ID: " << t_id;
+                }
+                ++t_n_written;
+                t_is_new_acquisition = false;
+            }
+
+            t_swrap_ptr.reset();
+            t_mw_ptr->finish_stream( f_stream_no );
+            butterfly_house::get_instance()->finish_standalone_file( t_mw_ptr );
+
+            LINFO( plog, "Ring-recorder dump to <" << a_filename << "> is complete; " << t_n_written << " packets written" );
+            if( t_cleared )
+            {
+                LWARN( plog, "The ring was cleared for a new run during the dump; the dump stopped early" );
+            }
+            if( t_n_skipped != 0 )
+            {
+                LWARN( plog, t_n_skipped << " packets were missing or were overwritten before they could be dumped; consider increasing the headroom" );
+            }
+        }
+        catch( std::exception& e )
+        {
+            LERROR( plog, "Ring-recorder dump to <" << a_filename << "> failed: " << e.what() );
+        }
+
+        f_dumping.store( false );
+        return;
+    }
+
+
+    ring_recorder_binding::ring_recorder_binding() :
+            _node_binding< ring_recorder, ring_recorder_binding >()
+    {
+    }
+
+    ring_recorder_binding::~ring_recorder_binding()
+    {
+    }
+
+    void ring_recorder_binding::do_apply_config( ring_recorder* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Configuring ring_recorder with:\n" << a_config );
+        a_node->set_duration( a_config.get_value( "duration", a_node->get_duration() ) );
+        a_node->set_headroom( a_config.get_value( "headroom", a_node->get_headroom() ) );
+        a_node->set_use_huge_pages( a_config.get_value( "use-huge-pages", a_node->get_use_huge_pages() ) );
+        if( a_config.has( "device" ) )
+        {
+            const scarab::param_node& t_dev_config = a_config["device"].as_node();
+            a_node->set_bit_depth( t_dev_config.get_value( "bit-depth", a_node->get_bit_depth() ) );
+            a_node->set_data_type_size( t_dev_config.get_value( "data-type-size", a_node->get_data_type_size() ) );
+            a_node->set_sample_size( t_dev_config.get_value( "sample-size", a_node->get_sample_size() ) );
+            a_node->set_acq_rate( t_dev_config.get_value( "acq-rate", a_node->get_acq_rate() ) );
+            a_node->set_v_offset( t_dev_config.get_value( "v-offset", a_node->get_v_offset() ) );
+            a_node->set_v_range( t_dev_config.get_value( "v-range", a_node->get_v_range() ) );
+        }
+        a_node->set_center_freq( a_config.get_value( "center-freq", a_node->get_center_freq() ) );
+        a_node->set_freq_range( a_config.get_value( "freq-range", a_node->get_freq_range() ) );
+        return;
+    }
+
+    void ring_recorder_binding::do_dump_config( const ring_recorder* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Dumping configuration for ring_recorder" );
+        a_config.add( "duration", a_node->get_duration() );
+        a_config.add( "headroom", a_node->get_headroom() );
+        a_config.add( "use-huge-pages", a_node->get_use_huge_pages() );
+        scarab::param_node t_dev_node = scarab::param_node();
+        t_dev_node.add( "bit-depth", a_node->get_bit_depth() );
+        t_dev_node.add( "data-type-size", a_node->get_data_type_size() );
+        t_dev_node.add( "sample-size", a_node->get_sample_size() );
+        t_dev_node.add( "acq-rate", a_node->get_acq_rate() );
+        t_dev_node.add( "v-offset", a_node->get_v_offset() );
+        t_dev_node.add( "v-range", a_node->get_v_range() );
+        a_config.add( "device", t_dev_node );
+        a_config.add( "center-freq", a_node->get_center_freq() );
+        a_config.add( "freq-range", a_node->get_freq_range() );
+        return;
+    }
+
+    bool ring_recorder_binding::do_run_command( ring_recorder* a_node, const std::string& a_cmd, const scarab::param_node& a_args ) const
+    {
+        if( a_cmd == "dump" )
+        {
+            a_node->dump( a_args.get_value( "filename", "" ), a_args.get_value( "description", "" ) );
+            return true;
+        }
+        else
+        {
+            LWARN( plog, "Unrecognized command: <" << a_cmd << ">" );
+            return false;
+        }
+    }
+
+} /* namespace psyllid */
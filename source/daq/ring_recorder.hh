@@ -0,0 +1,147 @@
+/*
+ * ring_recorder.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_RING_RECORDER_HH_
+#define PSYLLID_RING_RECORDER_HH_
+
+#include "egg_writer.hh"
+#include "node_builder.hh"
+#include "packet_ring.hh"
+#include "time_data.hh"
+
+#include "consumer.hh"
+
+#include <atomic>
+#include <thread>
+
+namespace psyllid
+{
+
+    /*!
+     @class ring_recorder
+     @brief A consumer that keeps the most recent time data in memory, and writes it to an egg file on command.
+
+     @details
+
+     All time packets are copied into a preallocated ring (see packet_ring) that holds the last "duration" seconds of data,
+     plus "headroom" seconds that give a dump time to read the oldest packets before they're overwritten.
+     The ring is backed by huge pages if they're available.
+
+     The "dump" command writes the last "duration" seconds in the ring to a new egg file.
+     The dump runs in its own thread, using the butterfly_house to create and finish the file, while the ring keeps filling.
+     Only one dump can be in progress at a time.  Packets that were overwritten before they could be written are skipped,
+     and the following record is marked as a new acquisition; the number skipped is logged.
+
+     The ring is cleared at the start of each run, since packet IDs restart.  If that happens during a dump, the dump stops at that point,
+     so that packets from the new run aren't written as if they were the old data.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "ring-recorder"
+
+     Available configuration values:
+     - "duration": double -- length of data, in seconds, written by a dump
+     - "headroom": double -- additional length of data, in seconds, held in the ring
+     - "use-huge-pages": bool -- whether to try to allocate the ring with huge pages
+     - "device": node -- digitizer parameters
+       - "bit-depth": uint -- bit depth of each sample
+       - "data-type-size": uint -- number of bytes in each sample (or component of a sample for sample-size > 1)
+       - "sample-size": uint -- number of components in each sample (1 for real sampling; 2 for IQ sampling)
+       - "acq-rate": uint -- acquisition rate in MHz
+       - "v-offset": double -- voltage offset for ADC calibration
+       - "v-range": double -- voltage range for ADC calibration
+     - "center-freq": double -- the center frequency of the data being digitized in Hz
+     - "freq-range": double -- the frequency window (bandwidth) of the data being digitized in Hz
+
+     Available DAQ commands:
+     - "dump": write the contents of the ring to an egg file
+       - "filename": string -- the file to write; default is ring_dump_[n].egg, where n counts the dumps
+       - "description": string -- the file description
+
+     Input Stream:
+     - 0: time_data
+
+     Output Streams: (none)
+    */
+    class ring_recorder :
+            public midge::_consumer< midge::type_list< time_data > >,
+            public egg_writer
+    {
+        public:
+            ring_recorder();
+            virtual ~ring_recorder();
+
+        public:
+            mv_accessible( double, duration ); // s
+            mv_accessible( double, headroom ); // s
+            mv_accessible( bool, use_huge_pages );
+
+            mv_accessible( unsigned, bit_depth ); // # of bits
+            mv_accessible( unsigned, data_type_size ); // # of bytes
+            mv_accessible( unsigned, sample_size );  // # of components
+            mv_accessible( unsigned, acq_rate ); // MHz
+            mv_accessible( double, v_offset ); // V
+            mv_accessible( double, v_range ); // V
+            mv_accessible( double, center_freq ); // Hz
+            mv_accessible( double, freq_range ); // Hz
+
+        public:
+            /// Starts writing the ring contents to a file asynchronously; throws if a dump is already in progress
+            void dump( const std::string& a_filename, const std::string& a_description );
+
+            bool is_dumping() const;
+
+            /// Number of packets that can be written by a dump
+            uint64_t get_n_dump_packets() const;
+
+        public:
+            virtual void prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr );
+
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            void do_dump( std::string a_filename, std::string a_description );
+            void join_dump_thread();
+
+            packet_ring f_ring;
+            uint64_t f_n_dump_packets;
+
+            std::thread f_dump_thread;
+            std::atomic< bool > f_dumping; // set when a dump is started (only one can start), and cleared by the dump thread
+            unsigned f_n_dumps;
+
+            unsigned f_stream_no;
+    };
+
+    inline bool ring_recorder::is_dumping() const
+    {
+        return f_dumping.load();
+    }
+
+    inline uint64_t ring_recorder::get_n_dump_packets() const
+    {
+        return f_n_dump_packets;
+    }
+
+
+    class ring_recorder_binding : public _node_binding< ring_recorder, ring_recorder_binding >
+    {
+        public:
+            ring_recorder_binding();
+            virtual ~ring_recorder_binding();
+
+        private:
+            virtual void do_apply_config( ring_recorder* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_config( const ring_recorder* a_node, scarab::param_node& a_config ) const;
+
+            virtual bool do_run_command( ring_recorder* a_node, const std::string& a_cmd, const scarab::param_node& a_args ) const;
+    };
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_RING_RECORDER_HH_ */
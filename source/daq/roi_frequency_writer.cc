@@ -0,0 +1,346 @@
+/*
+ * roi_frequency_writer.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "roi_frequency_writer.hh"
+
+#include "butterfly_house.hh"
+#include "psyllid_error.hh"
+
+#include "midge_error.hh"
+
+#include "digital.hh"
+#include "logger.hh"
+#include "param.hh"
+
+#include <algorithm>
+#include <cmath>
+
+using midge::stream;
+
+using std::string;
+using std::vector;
+
+namespace psyllid
+{
+    REGISTER_NODE_AND_BUILDER( roi_frequency_writer, "roi-frequency-writer", roi_frequency_writer_binding );
+
+    LOGGER( plog, "roi_frequency_writer" );
+
+    roi_frequency_writer::roi_frequency_writer() :
+            egg_writer(),
+            f_file_num( 0 ),
+            f_bit_depth( 8 ),
+            f_acq_rate( 100 ),
+            f_v_offset( 0. ),
+            f_v_range( 0.5 ),
+            f_center_freq( 50.e6 ),
+            f_freq_range( 100.e6 ),
+            f_bin_ranges(),
+            f_last_pkt_in_batch( 0 ),
+            f_monarch_ptr(),
+            f_stream_nos()
+    {
+    }
+
+    roi_frequency_writer::~roi_frequency_writer()
+    {
+    }
+
+    void roi_frequency_writer::add_bin_range( unsigned a_first, unsigned a_last )
+    {
+        const unsigned t_n_bins = PAYLOAD_SIZE / 2;
+        if( a_first > a_last || a_last >= t_n_bins )
+        {
+            throw error() << "Invalid bin range [" << a_first << ", " << a_last << "]; bins must be in [0, " << t_n_bins - 1 << "] and first <= last";
+        }
+        for( const bin_range& t_range : f_bin_ranges )
+        {
+            if( a_first <= t_range.f_last && t_range.f_first <= a_last )
+            {
+                throw error() << "Bin range [" << a_first << ", " << a_last << "] overlaps with [" << t_range.f_first << ", " << t_range.f_last << "]";
+            }
+        }
+        bin_range t_range = { a_first, a_last };
+        f_bin_ranges.push_back( t_range );
+        return;
+    }
+
+    void roi_frequency_writer::clear_bin_ranges()
+    {
+        f_bin_ranges.clear();
+        return;
+    }
+
+    unsigned roi_frequency_writer::get_n_roi_bins() const
+    {
+        unsigned t_n_bins = 0;
+        for( const bin_range& t_range : f_bin_ranges )
+        {
+            t_n_bins += t_range.f_last - t_range.f_first + 1;
+        }
+        return t_n_bins;
+    }
+
+    void roi_frequency_writer::prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr )
+    {
+        f_monarch_ptr = a_mw_ptr;
+
+        scarab::dig_calib_params t_dig_params;
+        scarab::get_calib_params( f_bit_depth, sizeof( freq_data::iq_t ) / 2, f_v_offset, f_v_range, true, &t_dig_params );
+
+        const double t_bin_width = f_freq_range / (double)( PAYLOAD_SIZE / 2 );
+        const double t_freq_min = f_center_freq - 0.5 * f_freq_range;
+
+        f_stream_nos.clear();
+        vector< unsigned > t_chan_vec;
+        for( const bin_range& t_range : f_bin_ranges )
+        {
+            unsigned t_n_bins = t_range.f_last - t_range.f_first + 1;
+            t_chan_vec.clear();
+            f_stream_nos.push_back( a_hw_ptr->header().AddStream( "Psyllid - ROACH2 frequency ROI",
+                    f_acq_rate, t_n_bins, 2, sizeof( freq_data::iq_t ) / 2,
+                    monarch3::sDigitizedS, f_bit_depth, monarch3::sBitsAlignedLeft, &t_chan_vec ) );
+
+            for( std::vector< unsigned >::const_iterator it = t_chan_vec.begin(); it != t_chan_vec.end(); ++it )
+            {
+                a_hw_ptr->header().GetChannelHeaders()[ *it ].SetVoltageOffset( t_dig_params.v_offset );
+                a_hw_ptr->header().GetChannelHeaders()[ *it ].SetVoltageRange( t_dig_params.v_range );
+                a_hw_ptr->header().GetChannelHeaders()[ *it ].SetDACGain( t_dig_params.dac_gain );
+                a_hw_ptr->header().GetChannelHeaders()[ *it ].SetFrequencyMin( t_freq_min + t_bin_width * (double)t_range.f_first );
+                a_hw_ptr->header().GetChannelHeaders()[ *it ].SetFrequencyRange( t_bin_width * (double)t_n_bins );
+            }
+        }
+
+        return;
+    }
+
+    void roi_frequency_writer::initialize()
+    {
+        if( f_bin_ranges.empty() )
+        {
+            add_bin_range( 0, PAYLOAD_SIZE / 2 - 1 );
+        }
+        LINFO( plog, "Writing " << get_n_roi_bins() << " of " << PAYLOAD_SIZE / 2 << " frequency bins in " << f_bin_ranges.size() <<
+                " range(s); " << 100. * (double)get_n_roi_bins() / (double)( PAYLOAD_SIZE / 2 ) << "% of the frequency data rate" );
+
+        butterfly_house::get_instance()->register_writer( this, f_file_num );
+        return;
+    }
+
+    void roi_frequency_writer::report_bandwidth( uint64_t a_n_packets ) const
+    {
+        if( a_n_packets == 0 ) return;
+        double t_roi_mb = 1.e-6 * (double)( a_n_packets * get_n_roi_bins() * sizeof( freq_data::iq_t ) );
+        double t_full_mb = 1.e-6 * (double)( a_n_packets * PAYLOAD_SIZE );
+        LINFO( plog, "ROI frequency writer wrote " << t_roi_mb << " MB from " << a_n_packets << " packets, instead of " << t_full_mb <<
+                " MB for whole packets (saved " << t_full_mb - t_roi_mb << " MB)" );
+        return;
+    }
+
+    void roi_frequency_writer::execute( midge::diptera* a_midge )
+    {
+        LDEBUG( plog, "execute ROI frequency writer" );
+        try
+        {
+            midge::enum_t t_freq_command = stream::s_none;
+
+            freq_data* t_freq_data = nullptr;
+
+            vector< stream_wrap_ptr > t_swrap_ptrs;
+
+            uint64_t t_record_length_nsec = llrint( (double)(PAYLOAD_SIZE / 2) / (double)f_acq_rate * 1.e3 );
+
+            uint64_t t_first_pkt_in_run = 0;
+            uint64_t t_n_packets = 0;
+
+            bool t_is_new_acquisition = true;
+            bool t_start_file_with_next_data = false;
+
+            while( ! is_canceled() )
+            {
+                t_freq_command = in_stream< 0 >().get();
+                if( t_freq_command == stream::s_none ) continue;
+                if( t_freq_command == stream::s_error ) break;
+
+                LTRACE( plog, "ROI frequency writer reading stream 0 (freq) at index " << in_stream< 0 >().get_current_index() );
+
+                if( t_freq_command == stream::s_exit )
+                {
+                    LDEBUG( plog, "ROI frequency writer is exiting" );
+
+                    if( ! t_swrap_ptrs.empty() )
+                    {
+                        for( unsigned t_stream_no : f_stream_nos ) f_monarch_ptr->finish_stream( t_stream_no );
+                        t_swrap_ptrs.clear();
+                        report_bandwidth( t_n_packets );
+                    }
+
+                    break;
+                }
+
+                if( t_freq_command == stream::s_stop )
+                {
+                    LDEBUG( plog, "ROI frequency writer is stopping" );
+
+                    if( ! t_swrap_ptrs.empty() )
+                    {
+                        for( unsigned t_stream_no : f_stream_nos ) f_monarch_ptr->finish_stream( t_stream_no );
+                        t_swrap_ptrs.clear();
+                        report_bandwidth( t_n_packets );
+                    }
+
+                    continue;
+                }
+
+                if( t_freq_command == stream::s_start )
+                {
+                    LDEBUG( plog, "Will start file with next data" );
+
+                    t_swrap_ptrs.clear();
+
+                    for( unsigned t_stream_no : f_stream_nos )
+                    {
+                        LDEBUG( plog, "Getting stream <" << t_stream_no << ">" );
+                        t_swrap_ptrs.push_back( f_monarch_ptr->get_stream( t_stream_no ) );
+                    }
+
+                    t_n_packets = 0;
+                    t_start_file_with_next_data = true;
+                    continue;
+                }
+
+                if( t_freq_command == stream::s_run )
+                {
+                    t_freq_data = in_stream< 0 >().data();
+
+                    if( t_start_file_with_next_data )
+                    {
+                        LDEBUG( plog, "Handling first packet in run" );
+
+                        t_first_pkt_in_run = t_freq_data->get_pkt_in_session();
+
+                        t_is_new_acquisition = true;
+
+                        t_start_file_with_next_data = false;
+                    }
+
+                    uint64_t t_freq_id = t_freq_data->get_pkt_in_session();
+                    LTRACE( plog, "Writing ROIs for packet (in session) " << t_freq_id );
+
+                    uint32_t t_expected_pkt_in_batch = f_last_pkt_in_batch + 1;
+                    if( t_expected_pkt_in_batch >= BATCH_COUNTER_SIZE ) t_expected_pkt_in_batch = 0;
+                    if( ! t_is_new_acquisition && t_freq_data->get_pkt_in_batch() != t_expected_pkt_in_batch ) t_is_new_acquisition = true;
+                    f_last_pkt_in_batch = t_freq_data->get_pkt_in_batch();
+
+                    // the bins in each range are contiguous in the packet, so each record is written straight from the packet
+                    for( unsigned i_range = 0; i_range < f_bin_ranges.size(); ++i_range )
+                    {
+                        const bin_range& t_range = f_bin_ranges[ i_range ];
+                        if( ! t_swrap_ptrs[ i_range ]->write_record( t_freq_id, t_record_length_nsec * ( t_freq_id - t_first_pkt_in_run ),
+                                t_freq_data->get_array() + t_range.f_first, ( t_range.f_last - t_range.f_first + 1 ) * sizeof( freq_data::iq_t ), t_is_new_acquisition ) )
+                        {
+                            throw midge::node_nonfatal_error() << "Unable to write record to file; record ID: " << t_freq_id << "; bin range " << i_range;
+                        }
+                    }
+
+                    ++t_n_packets;
+                    t_is_new_acquisition = false;
+
+                    continue;
+                }
+
+            } // end while( ! is_cancelled() )
+
+            // final attempt to finish the streams if the outer while loop is broken without the streams having been stopped or exited
+            if( ! t_swrap_ptrs.empty() )
+            {
+                for( unsigned t_stream_no : f_stream_nos ) f_monarch_ptr->finish_stream( t_stream_no );
+                t_swrap_ptrs.clear();
+            }
+
+            return;
+        }
+        catch(...)
+        {
+            LWARN( plog, "an error occurred executing ROI frequency writer" );
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+    }
+
+    void roi_frequency_writer::finalize()
+    {
+        LDEBUG( plog, "finalize ROI frequency writer" );
+        butterfly_house::get_instance()->unregister_writer( this );
+        return;
+    }
+
+
+    roi_frequency_writer_binding::roi_frequency_writer_binding() :
+            _node_binding< roi_frequency_writer, roi_frequency_writer_binding >()
+    {
+    }
+
+    roi_frequency_writer_binding::~roi_frequency_writer_binding()
+    {
+    }
+
+    void roi_frequency_writer_binding::do_apply_config( roi_frequency_writer* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Configuring roi_frequency_writer with:\n" << a_config );
+        a_node->set_file_num( a_config.get_value( "file-num", a_node->get_file_num() ) );
+        if( a_config.has( "bin-ranges" ) )
+        {
+            a_node->clear_bin_ranges();
+            const scarab::param_array& t_ranges = a_config[ "bin-ranges" ].as_array();
+            for( unsigned i_range = 0; i_range < t_ranges.size(); ++i_range )
+            {
+                const scarab::param_array& t_range = t_ranges[ i_range ].as_array();
+                if( t_range.size() != 2 )
+                {
+                    throw error() << "Each bin range must be given as [first bin, last bin]";
+                }
+                a_node->add_bin_range( t_range[ 0 ]().as_uint(), t_range[ 1 ]().as_uint() );
+            }
+        }
+        if( a_config.has( "device" ) )
+        {
+            const scarab::param_node& t_dev_config = a_config["device"].as_node();
+            a_node->set_bit_depth( t_dev_config.get_value( "bit-depth", a_node->get_bit_depth() ) );
+            a_node->set_acq_rate( t_dev_config.get_value( "acq-rate", a_node->get_acq_rate() ) );
+            a_node->set_v_offset( t_dev_config.get_value( "v-offset", a_node->get_v_offset() ) );
+            a_node->set_v_range( t_dev_config.get_value( "v-range", a_node->get_v_range() ) );
+        }
+        a_node->set_center_freq( a_config.get_value( "center-freq", a_node->get_center_freq() ) );
+        a_node->set_freq_range( a_config.get_value( "freq-range", a_node->get_freq_range() ) );
+        return;
+    }
+
+    void roi_frequency_writer_binding::do_dump_config( const roi_frequency_writer* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Dumping configuration for roi_frequency_writer" );
+        a_config.add( "file-num", a_node->get_file_num() );
+        scarab::param_array t_ranges;
+        for( const roi_frequency_writer::bin_range& t_range : a_node->get_bin_ranges() )
+        {
+            scarab::param_array t_range_array;
+            t_range_array.push_back( scarab::param_value( t_range.f_first ) );
+            t_range_array.push_back( scarab::param_value( t_range.f_last ) );
+            t_ranges.push_back( t_range_array );
+        }
+        a_config.add( "bin-ranges", t_ranges );
+        scarab::param_node t_dev_node = scarab::param_node();
+        t_dev_node.add( "bit-depth", a_node->get_bit_depth() );
+        t_dev_node.add( "acq-rate", a_node->get_acq_rate() );
+        t_dev_node.add( "v-offset", a_node->get_v_offset() );
+        t_dev_node.add( "v-range", a_node->get_v_range() );
+        a_config.add( "device", t_dev_node );
+        a_config.add( "center-freq", a_node->get_center_freq() );
+        a_config.add( "freq-range", a_node->get_freq_range() );
+        return;
+    }
+
+} /* namespace psyllid */
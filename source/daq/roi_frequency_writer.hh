@@ -0,0 +1,127 @@
+/*
+ * roi_frequency_writer.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_ROI_FREQUENCY_WRITER_HH_
+#define PSYLLID_ROI_FREQUENCY_WRITER_HH_
+
+#include "egg_writer.hh"
+#include "freq_data.hh"
+#include "node_builder.hh"
+
+#include "consumer.hh"
+
+#include <vector>
+
+namespace psyllid
+{
+
+    /*!
+     @class roi_frequency_writer
+     @brief A consumer that writes only selected regions of interest (ranges of frequency bins) from each freq_data packet to an egg file.
+
+     @details
+
+     Each bin range is written as its own stream, with fixed-size records containing only the bins in that range.
+     The channel header for each stream has its frequency minimum and range set to those of the bins written,
+     so the records can be interpreted like those of a narrower-band digitizer.
+
+     Bin i covers the frequencies starting at (center-freq - freq-range/2) + i * freq-range/4096.
+     Ranges are inclusive, and may not overlap.
+
+     The fraction of the frequency data that's written is logged when the node is initialized, and the bytes written are logged at the end of each run.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "roi-frequency-writer"
+
+     Available configuration values:
+     - "file-num": uint -- the file number the data are written to
+     - "bin-ranges": array of arrays -- each range is [first bin, last bin]; the default is the whole spectrum, [[0, 4095]]
+     - "device": node -- digitizer parameters
+       - "bit-depth": uint -- bit depth of each sample
+       - "acq-rate": uint -- acquisition rate in MHz
+       - "v-offset": double -- voltage offset for ADC calibration
+       - "v-range": double -- voltage range for ADC calibration
+     - "center-freq": double -- the center frequency of the data being digitized in Hz
+     - "freq-range": double -- the frequency window (bandwidth) of the data being digitized in Hz
+
+     Input Stream:
+     - 0: freq_data
+
+     Output Streams: (none)
+    */
+    class roi_frequency_writer :
+            public midge::_consumer< midge::type_list< freq_data > >,
+            public egg_writer
+    {
+        public:
+            struct bin_range
+            {
+                unsigned f_first;
+                unsigned f_last;
+            };
+
+        public:
+            roi_frequency_writer();
+            virtual ~roi_frequency_writer();
+
+        public:
+            mv_accessible( unsigned, file_num );
+
+            mv_accessible( unsigned, bit_depth ); // # of bits
+            mv_accessible( unsigned, acq_rate ); // MHz
+            mv_accessible( double, v_offset ); // V
+            mv_accessible( double, v_range ); // V
+            mv_accessible( double, center_freq ); // Hz
+            mv_accessible( double, freq_range ); // Hz
+
+        public:
+            void add_bin_range( unsigned a_first, unsigned a_last );
+            void clear_bin_ranges();
+            const std::vector< bin_range >& get_bin_ranges() const;
+
+            /// Total number of bins written from each packet
+            unsigned get_n_roi_bins() const;
+
+        public:
+            virtual void prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr );
+
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            /// Logs the number of bytes written during the run, compared to writing whole packets
+            void report_bandwidth( uint64_t a_n_packets ) const;
+
+            std::vector< bin_range > f_bin_ranges;
+
+            unsigned f_last_pkt_in_batch;
+
+            monarch_wrap_ptr f_monarch_ptr;
+            std::vector< unsigned > f_stream_nos;
+    };
+
+    inline const std::vector< roi_frequency_writer::bin_range >& roi_frequency_writer::get_bin_ranges() const
+    {
+        return f_bin_ranges;
+    }
+
+
+    class roi_frequency_writer_binding : public _node_binding< roi_frequency_writer, roi_frequency_writer_binding >
+    {
+        public:
+            roi_frequency_writer_binding();
+            virtual ~roi_frequency_writer_binding();
+
+        private:
+            virtual void do_apply_config( roi_frequency_writer* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_config( const roi_frequency_writer* a_node, scarab::param_node& a_config ) const;
+    };
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_ROI_FREQUENCY_WRITER_HH_ */
@@ -0,0 +1,184 @@
+/*
+ * shm_tap.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "shm_tap.hh"
+
+#include "psyllid_error.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+using midge::stream;
+
+namespace psyllid
+{
+    REGISTER_NODE_AND_BUILDER( shm_tap_time, "shm-tap-time", shm_tap_time_binding );
+    REGISTER_NODE_AND_BUILDER( shm_tap_freq, "shm-tap-freq", shm_tap_freq_binding );
+
+    LOGGER( plog, "shm_tap" );
+
+    namespace
+    {
+        template< class x_data >
+        struct shm_tap_traits;
+
+        template<>
+        struct shm_tap_traits< time_data >
+        {
+            static const uint32_t s_data_type = PSYLLID_SHM_TAP_TIME_DATA;
+            static const char* default_name() { return "/psyllid_tap_time"; }
+        };
+
+        template<>
+        struct shm_tap_traits< freq_data >
+        {
+            static const uint32_t s_data_type = PSYLLID_SHM_TAP_FREQ_DATA;
+            static const char* default_name() { return "/psyllid_tap_freq"; }
+        };
+    }
+
+    template< class x_data >
+    _shm_tap< x_data >::_shm_tap() :
+            f_shm_name( shm_tap_traits< x_data >::default_name() ),
+            f_n_slots( 1024 ),
+            f_ring()
+    {
+    }
+
+    template< class x_data >
+    _shm_tap< x_data >::~_shm_tap()
+    {
+    }
+
+    template< class x_data >
+    void _shm_tap< x_data >::initialize()
+    {
+        f_ring.create( f_shm_name, f_n_slots, shm_tap_traits< x_data >::s_data_type );
+        LINFO( plog, "Publishing packets to shared memory <" << f_shm_name << "> with " << f_n_slots << " slots (" <<
+                psyllid_shm_tap_size( f_n_slots ) << " bytes)" );
+        return;
+    }
+
+    template< class x_data >
+    void _shm_tap< x_data >::execute( midge::diptera* a_midge )
+    {
+        LDEBUG( plog, "execute shm tap" );
+        try
+        {
+            midge::enum_t t_in_command = stream::s_none;
+
+            x_data* t_data = nullptr;
+
+            while( ! this->is_canceled() )
+            {
+                t_in_command = this->template in_stream< 0 >().get();
+                if( t_in_command == stream::s_none ) continue;
+                if( t_in_command == stream::s_error ) break;
+
+                LTRACE( plog, "Shm tap reading stream 0 at index " << this->template in_stream< 0 >().get_current_index() );
+
+                if( t_in_command == stream::s_exit )
+                {
+                    LDEBUG( plog, "Shm tap is exiting" );
+                    break;
+                }
+
+                if( t_in_command == stream::s_stop )
+                {
+                    LDEBUG( plog, "Shm tap is stopping; " << f_ring.get_n_published() << " packets published so far" );
+                    continue;
+                }
+
+                if( t_in_command == stream::s_start )
+                {
+                    LDEBUG( plog, "Shm tap is starting" );
+                    continue;
+                }
+
+                if( t_in_command == stream::s_run )
+                {
+                    t_data = this->template in_stream< 0 >().data();
+                    f_ring.publish( *t_data, t_data->get_pkt_in_session() );
+                    continue;
+                }
+            }
+
+            return;
+        }
+        catch(...)
+        {
+            LWARN( plog, "an error occurred executing shm tap" );
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+    }
+
+    template< class x_data >
+    void _shm_tap< x_data >::finalize()
+    {
+        LDEBUG( plog, "finalize shm tap" );
+        f_ring.destroy();
+        return;
+    }
+
+    template class _shm_tap< time_data >;
+    template class _shm_tap< freq_data >;
+
+
+    template< class x_node >
+    _shm_tap_binding< x_node >::_shm_tap_binding() :
+            _node_binding< x_node, _shm_tap_binding< x_node > >()
+    {
+    }
+
+    template< class x_node >
+    _shm_tap_binding< x_node >::~_shm_tap_binding()
+    {
+    }
+
+    template< class x_node >
+    void _shm_tap_binding< x_node >::do_apply_config( x_node* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Configuring shm tap with:\n" << a_config );
+        a_node->shm_name() = a_config.get_value( "shm-name", a_node->shm_name() );
+        a_node->set_n_slots( a_config.get_value( "n-slots", a_node->get_n_slots() ) );
+        return;
+    }
+
+    template< class x_node >
+    void _shm_tap_binding< x_node >::do_dump_config( const x_node* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Dumping configuration for shm tap" );
+        a_config.add( "shm-name", a_node->shm_name() );
+        a_config.add( "n-slots", a_node->get_n_slots() );
+        return;
+    }
+
+    template< class x_node >
+    void _shm_tap_binding< x_node >::do_dump_status( const x_node* a_node, scarab::param_node& a_status ) const
+    {
+        const shm_packet_ring& t_ring = a_node->get_ring();
+        a_status.add( "shm-name", a_node->shm_name() );
+        a_status.add( "n-published", t_ring.get_n_published() );
+        scarab::param_array t_readers;
+        std::vector< shm_packet_ring::reader_status > t_reader_status = t_ring.get_readers();
+        for( std::vector< shm_packet_ring::reader_status >::const_iterator t_it = t_reader_status.begin(); t_it != t_reader_status.end(); ++t_it )
+        {
+            scarab::param_node t_reader;
+            t_reader.add( "pid", t_it->f_pid );
+            t_reader.add( "lag", t_it->f_lag );
+            t_reader.add( "n-read", t_it->f_n_read );
+            t_reader.add( "n-overruns", t_it->f_n_overruns );
+            t_readers.push_back( t_reader );
+        }
+        a_status.add( "readers", t_readers );
+        return;
+    }
+
+    template class _shm_tap_binding< shm_tap_time >;
+    template class _shm_tap_binding< shm_tap_freq >;
+
+} /* namespace psyllid */
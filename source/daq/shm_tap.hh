@@ -0,0 +1,108 @@
+/*
+ * shm_tap.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_SHM_TAP_HH_
+#define PSYLLID_SHM_TAP_HH_
+
+#include "freq_data.hh"
+#include "node_builder.hh"
+#include "shm_packet_ring.hh"
+#include "time_data.hh"
+
+#include "consumer.hh"
+
+namespace psyllid
+{
+
+    /*!
+     @class _shm_tap
+     @brief A consumer that publishes every packet it receives to a shared-memory ring, which other processes can read live.
+
+     @details
+
+     Analysis programs read the packets in place from the shared memory, using the C header psyllid_shm_tap.h (see there for an example);
+     they don't need to link to psyllid.  Each reader receives every packet, and up to 16 readers can be attached at once.
+
+     The tap never waits for readers.  A reader that falls more than n-slots packets behind loses the packets that are overwritten;
+     the number lost is counted for each reader, and is reported with the readers' positions in the node's status.
+
+     The shared-memory object is created when the node is initialized and removed when it's finalized;
+     sequence numbers continue across runs.  It's readable and writable by the user and group running psyllid.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node types: "shm-tap-time" (shm_tap_time) and "shm-tap-freq" (shm_tap_freq)
+
+     Available configuration values:
+     - "shm-name": string -- name of the shared-memory object, of the form "/name"; defaults to "/psyllid_tap_time" or "/psyllid_tap_freq"
+     - "n-slots": uint -- number of packets in the ring
+
+     Status:
+     - "shm-name": string -- name of the shared-memory object
+     - "n-published": uint -- number of packets published
+     - "readers": array of nodes, one for each reader attached:
+       - "pid": int -- process ID of the reader
+       - "lag": uint -- number of packets published that the reader has not read yet
+       - "n-read": uint -- number of packets read
+       - "n-overruns": uint -- number of packets overwritten before the reader read them
+
+     Input Stream:
+     - 0: time_data (shm_tap_time) or freq_data (shm_tap_freq)
+
+     Output Streams: (none)
+    */
+    template< class x_data >
+    class _shm_tap :
+            public midge::_consumer< midge::type_list< x_data > >
+    {
+        public:
+            _shm_tap();
+            virtual ~_shm_tap();
+
+        public:
+            mv_referrable( std::string, shm_name );
+            mv_accessible( uint64_t, n_slots );
+
+        public:
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+            const shm_packet_ring& get_ring() const;
+
+        private:
+            shm_packet_ring f_ring;
+    };
+
+    template< class x_data >
+    inline const shm_packet_ring& _shm_tap< x_data >::get_ring() const
+    {
+        return f_ring;
+    }
+
+    typedef _shm_tap< time_data > shm_tap_time;
+    typedef _shm_tap< freq_data > shm_tap_freq;
+
+
+    template< class x_node >
+    class _shm_tap_binding : public _node_binding< x_node, _shm_tap_binding< x_node > >
+    {
+        public:
+            _shm_tap_binding();
+            virtual ~_shm_tap_binding();
+
+        private:
+            virtual void do_apply_config( x_node* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_config( const x_node* a_node, scarab::param_node& a_config ) const;
+            virtual void do_dump_status( const x_node* a_node, scarab::param_node& a_status ) const;
+    };
+
+    typedef _shm_tap_binding< shm_tap_time > shm_tap_time_binding;
+    typedef _shm_tap_binding< shm_tap_freq > shm_tap_freq_binding;
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_SHM_TAP_HH_ */
@@ -0,0 +1,292 @@
+/*
+ * spectrum_integrator.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "spectrum_integrator.hh"
+
+#include "butterfly_house.hh"
+#include "psyllid_error.hh"
+#include "spectrum_average.hh"
+#include "spectrum_kernels.hh"
+
+#include "midge_error.hh"
+
+#include "logger.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <iomanip>
+#include <sstream>
+
+using midge::stream;
+
+using std::string;
+using std::vector;
+
+namespace psyllid
+{
+    REGISTER_NODE_AND_BUILDER( spectrum_integrator, "spectrum-integrator", spectrum_integrator_binding );
+
+    LOGGER( plog, "spectrum_integrator" );
+
+    spectrum_integrator::spectrum_integrator() :
+            egg_writer(),
+            f_file_num( 0 ),
+            f_n_spectra( 100 ),
+            f_integration_time( 0. ),
+            f_decimation( 1 ),
+            f_acq_rate( 100 ),
+            f_center_freq( 50.e6 ),
+            f_freq_range( 100.e6 ),
+            f_last_pkt_in_batch( 0 ),
+            f_sum(),
+            f_output(),
+            f_monarch_ptr(),
+            f_stream_no( 0 )
+    {
+    }
+
+    spectrum_integrator::~spectrum_integrator()
+    {
+    }
+
+    void spectrum_integrator::prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr )
+    {
+        f_monarch_ptr = a_mw_ptr;
+
+        f_n_spectra = spectra_per_integration( f_n_spectra, f_integration_time, f_acq_rate );
+
+        vector< unsigned > t_chan_vec;
+        f_stream_no = a_hw_ptr->header().AddStream( "Psyllid - spectrum integrator",
+                f_acq_rate, f_output.size(), 1, sizeof( float ),
+                monarch3::sAnalog, 8 * sizeof( float ), monarch3::sBitsAlignedLeft, &t_chan_vec );
+
+        for( std::vector< unsigned >::const_iterator it = t_chan_vec.begin(); it != t_chan_vec.end(); ++it )
+        {
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetFrequencyMin( f_center_freq - 0.5 * f_freq_range );
+            a_hw_ptr->header().GetChannelHeaders()[ *it ].SetFrequencyRange( f_freq_range );
+        }
+
+        // The egg3 acquisition rate is an integer number of MHz, so it can't hold the record rate, which is well below 1 MHz;
+        // it stays the digitizer rate, and the reduced rate and integration parameters are added to the description
+        // as "stream.<stream number>.<key> = <value>" lines, so they can be parsed when the file is read.
+        const double t_record_rate = spectrum_rate( f_acq_rate ) / (double)f_n_spectra;
+        const string t_prefix = "stream." + std::to_string( f_stream_no ) + ".";
+        std::stringstream t_desc;
+        t_desc << std::setprecision( 12 );
+        t_desc << a_hw_ptr->header().GetDescription();
+        if( ! a_hw_ptr->header().GetDescription().empty() ) t_desc << '\n';
+        t_desc << "Stream " << f_stream_no << ": integrated power spectra\n";
+        t_desc << t_prefix << "record-rate = " << t_record_rate << "\n";
+        t_desc << t_prefix << "record-length = " << 1. / t_record_rate << "\n";
+        t_desc << t_prefix << "n-spectra = " << f_n_spectra << "\n";
+        t_desc << t_prefix << "decimation = " << f_decimation << "\n";
+        t_desc << t_prefix << "bin-width = " << f_freq_range / (double)f_output.size();
+        a_hw_ptr->header().SetDescription( t_desc.str() );
+
+        return;
+    }
+
+    void spectrum_integrator::initialize()
+    {
+        const unsigned t_n_bins = PAYLOAD_SIZE / 2;
+        if( f_decimation == 0 || t_n_bins % f_decimation != 0 )
+        {
+            throw error() << "Decimation factor <" << f_decimation << "> must divide the number of frequency bins (" << t_n_bins << ")";
+        }
+        f_n_spectra = spectra_per_integration( f_n_spectra, f_integration_time, f_acq_rate );
+        LDEBUG( plog, "Averaging " << f_n_spectra << " spectra per record" );
+
+        f_sum.assign( t_n_bins, 0.f );
+        f_output.assign( t_n_bins / f_decimation, 0.f );
+
+        butterfly_house::get_instance()->register_writer( this, f_file_num );
+        return;
+    }
+
+    void spectrum_integrator::execute( midge::diptera* a_midge )
+    {
+        LDEBUG( plog, "execute spectrum integrator" );
+        try
+        {
+            midge::enum_t t_freq_command = stream::s_none;
+
+            freq_data* t_freq_data = nullptr;
+
+            stream_wrap_ptr t_swrap_ptr;
+
+            uint64_t t_bytes_per_record = f_output.size() * sizeof( float );
+            uint64_t t_spectrum_length_nsec = llrint( (double)(PAYLOAD_SIZE / 2) / (double)f_acq_rate * 1.e3 );
+
+            uint64_t t_first_pkt_in_run = 0;
+            uint64_t t_first_pkt_in_record = 0;
+            uint64_t t_record_id = 0;
+            unsigned t_n_summed = 0;
+
+            bool t_is_new_acquisition = true;
+            bool t_start_file_with_next_data = false;
+
+            while( ! is_canceled() )
+            {
+                t_freq_command = in_stream< 0 >().get();
+                if( t_freq_command == stream::s_none ) continue;
+                if( t_freq_command == stream::s_error ) break;
+
+                LTRACE( plog, "Spectrum integrator reading stream 0 (freq) at index " << in_stream< 0 >().get_current_index() );
+
+                if( t_freq_command == stream::s_exit )
+                {
+                    LDEBUG( plog, "Spectrum integrator is exiting" );
+
+                    if( t_swrap_ptr )
+                    {
+                        f_monarch_ptr->finish_stream( f_stream_no );
+                        t_swrap_ptr.reset();
+                    }
+
+                    break;
+                }
+
+                if( t_freq_command == stream::s_stop )
+                {
+                    LDEBUG( plog, "Spectrum integrator is stopping; discarding " << t_n_summed << " spectra in the partial integration" );
+
+                    if( t_swrap_ptr )
+                    {
+                        f_monarch_ptr->finish_stream( f_stream_no );
+                        t_swrap_ptr.reset();
+                    }
+
+                    continue;
+                }
+
+                if( t_freq_command == stream::s_start )
+                {
+                    LDEBUG( plog, "Will start file with next data" );
+
+                    if( t_swrap_ptr ) t_swrap_ptr.reset();
+
+                    LDEBUG( plog, "Getting stream <" << f_stream_no << ">" );
+                    t_swrap_ptr = f_monarch_ptr->get_stream( f_stream_no );
+
+                    std::fill( f_sum.begin(), f_sum.end(), 0.f );
+                    t_n_summed = 0;
+                    t_record_id = 0;
+
+                    t_start_file_with_next_data = true;
+                    continue;
+                }
+
+                if( t_freq_command == stream::s_run )
+                {
+                    t_freq_data = in_stream< 0 >().data();
+
+                    if( t_start_file_with_next_data )
+                    {
+                        LDEBUG( plog, "Handling first packet in run" );
+
+                        t_first_pkt_in_run = t_freq_data->get_pkt_in_session();
+
+                        t_is_new_acquisition = true;
+
+                        t_start_file_with_next_data = false;
+                    }
+
+                    uint32_t t_expected_pkt_in_batch = f_last_pkt_in_batch + 1;
+                    if( t_expected_pkt_in_batch >= BATCH_COUNTER_SIZE ) t_expected_pkt_in_batch = 0;
+                    if( ! t_is_new_acquisition && t_freq_data->get_pkt_in_batch() != t_expected_pkt_in_batch ) t_is_new_acquisition = true;
+                    f_last_pkt_in_batch = t_freq_data->get_pkt_in_batch();
+
+                    if( t_n_summed == 0 ) t_first_pkt_in_record = t_freq_data->get_pkt_in_session();
+
+                    accumulate_power( *t_freq_data, f_sum.data() );
+                    ++t_n_summed;
+
+                    if( t_n_summed < f_n_spectra ) continue;
+
+                    average_spectra( f_sum.data(), f_n_spectra, f_decimation, f_output.data(), f_output.size() );
+                    t_n_summed = 0;
+
+                    LTRACE( plog, "Writing integrated record " << t_record_id );
+                    if( ! t_swrap_ptr->write_record( t_record_id, t_spectrum_length_nsec * ( t_first_pkt_in_record - t_first_pkt_in_run ), f_output.data(), t_bytes_per_record, t_is_new_acquisition ) )
+                    {
+                        throw midge::node_nonfatal_error() << "Unable to write record to file; record ID: " << t_record_id;
+                    }
+
+                    ++t_record_id;
+                    t_is_new_acquisition = false;
+
+                    continue;
+                }
+
+            } // end while( ! is_cancelled() )
+
+            // final attempt to finish the stream if the outer while loop is broken without the stream having been stopped or exited
+            if( t_swrap_ptr )
+            {
+                f_monarch_ptr->finish_stream( f_stream_no );
+                t_swrap_ptr.reset();
+            }
+
+            return;
+        }
+        catch(...)
+        {
+            LWARN( plog, "an error occurred executing spectrum integrator" );
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+    }
+
+    void spectrum_integrator::finalize()
+    {
+        LDEBUG( plog, "finalize spectrum integrator" );
+        butterfly_house::get_instance()->unregister_writer( this );
+        return;
+    }
+
+
+    spectrum_integrator_binding::spectrum_integrator_binding() :
+            _node_binding< spectrum_integrator, spectrum_integrator_binding >()
+    {
+    }
+
+    spectrum_integrator_binding::~spectrum_integrator_binding()
+    {
+    }
+
+    void spectrum_integrator_binding::do_apply_config( spectrum_integrator* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Configuring spectrum_integrator with:\n" << a_config );
+        a_node->set_file_num( a_config.get_value( "file-num", a_node->get_file_num() ) );
+        a_node->set_n_spectra( a_config.get_value( "n-spectra", a_node->get_n_spectra() ) );
+        a_node->set_integration_time( a_config.get_value( "integration-time", a_node->get_integration_time() ) );
+        a_node->set_decimation( a_config.get_value( "decimation", a_node->get_decimation() ) );
+        if( a_config.has( "device" ) )
+        {
+            const scarab::param_node& t_dev_config = a_config["device"].as_node();
+            a_node->set_acq_rate( t_dev_config.get_value( "acq-rate", a_node->get_acq_rate() ) );
+        }
+        a_node->set_center_freq( a_config.get_value( "center-freq", a_node->get_center_freq() ) );
+        a_node->set_freq_range( a_config.get_value( "freq-range", a_node->get_freq_range() ) );
+        return;
+    }
+
+    void spectrum_integrator_binding::do_dump_config( const spectrum_integrator* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Dumping configuration for spectrum_integrator" );
+        a_config.add( "file-num", a_node->get_file_num() );
+        a_config.add( "n-spectra", a_node->get_n_spectra() );
+        a_config.add( "integration-time", a_node->get_integration_time() );
+        a_config.add( "decimation", a_node->get_decimation() );
+        scarab::param_node t_dev_node = scarab::param_node();
+        t_dev_node.add( "acq-rate", a_node->get_acq_rate() );
+        a_config.add( "device", t_dev_node );
+        a_config.add( "center-freq", a_node->get_center_freq() );
+        a_config.add( "freq-range", a_node->get_freq_range() );
+        return;
+    }
+
+} /* namespace psyllid */
@@ -0,0 +1,106 @@
+/*
+ * spectrum_integrator.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_SPECTRUM_INTEGRATOR_HH_
+#define PSYLLID_SPECTRUM_INTEGRATOR_HH_
+
+#include "egg_writer.hh"
+#include "freq_data.hh"
+#include "node_builder.hh"
+
+#include "consumer.hh"
+
+#include <vector>
+
+namespace psyllid
+{
+
+    /*!
+     @class spectrum_integrator
+     @brief A consumer that averages consecutive power spectra and writes them to an egg file at a reduced rate.
+
+     @details
+
+     Each record written is the average of n-spectra consecutive power spectra (|I|^2 + |Q|^2 of the freq_data samples),
+     optionally decimated in frequency by averaging groups of adjacent bins.
+     Records are written as single-precision floats (analog data format, 4 bytes per sample),
+     so the frequency-data I/O rate is reduced by a factor of (n-spectra * decimation / 2) compared to writing every freq_data packet.
+
+     Record timing: the record ID is the integration number in the run, and the record time is the time of the first spectrum in the integration.
+     The stream acquisition rate in the egg3 header is an integer number of MHz, so it can't hold the record rate; it stays that of the digitizer (acq-rate).
+     The record rate (Hz), record length (s), n-spectra, decimation, and output bin width (Hz) are instead added to the file description,
+     one "stream.<stream number>.<key> = <value>" line each (keys: record-rate, record-length, n-spectra, decimation, bin-width).
+     If packets are missing, the next record is marked as a new acquisition.
+     A partial integration is discarded when the run stops.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "spectrum-integrator"
+
+     Available configuration values:
+     - "file-num": uint -- the file number the integrated spectra are written to
+     - "n-spectra": uint -- number of spectra averaged in each record
+     - "integration-time": double -- integration time in seconds; if > 0, overrides n-spectra using the spectrum rate given by acq-rate
+     - "decimation": uint -- number of adjacent bins averaged together; must divide the number of bins (4096)
+     - "device": node -- digitizer parameters
+       - "acq-rate": uint -- acquisition rate in MHz
+     - "center-freq": double -- the center frequency of the data being digitized in Hz
+     - "freq-range": double -- the frequency window (bandwidth) of the data being digitized in Hz
+
+     Input Stream:
+     - 0: freq_data
+
+     Output Streams: (none)
+    */
+    class spectrum_integrator :
+            public midge::_consumer< midge::type_list< freq_data > >,
+            public egg_writer
+    {
+        public:
+            spectrum_integrator();
+            virtual ~spectrum_integrator();
+
+        public:
+            mv_accessible( unsigned, file_num );
+            mv_accessible( unsigned, n_spectra );
+            mv_accessible( double, integration_time ); // s
+            mv_accessible( unsigned, decimation );
+            mv_accessible( unsigned, acq_rate ); // MHz
+            mv_accessible( double, center_freq ); // Hz
+            mv_accessible( double, freq_range ); // Hz
+
+        public:
+            virtual void prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr );
+
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+        private:
+            unsigned f_last_pkt_in_batch;
+
+            std::vector< float > f_sum;
+            std::vector< float > f_output;
+
+            monarch_wrap_ptr f_monarch_ptr;
+            unsigned f_stream_no;
+    };
+
+
+    class spectrum_integrator_binding : public _node_binding< spectrum_integrator, spectrum_integrator_binding >
+    {
+        public:
+            spectrum_integrator_binding();
+            virtual ~spectrum_integrator_binding();
+
+        private:
+            virtual void do_apply_config( spectrum_integrator* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_config( const spectrum_integrator* a_node, scarab::param_node& a_config ) const;
+    };
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_SPECTRUM_INTEGRATOR_HH_ */
@@ -0,0 +1,265 @@
+/*
+ * spectrum_monitor.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "spectrum_monitor.hh"
+
+#include "psyllid_error.hh"
+#include "spectrum_average.hh"
+#include "spectrum_kernels.hh"
+
+#include "logger.hh"
+#include "param.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <cstring>
+
+#include <sys/socket.h>
+#include <unistd.h>
+
+using midge::stream;
+
+using std::string;
+using std::vector;
+
+namespace psyllid
+{
+    REGISTER_NODE_AND_BUILDER( spectrum_monitor, "spectrum-monitor", spectrum_monitor_binding );
+
+    LOGGER( plog, "spectrum_monitor" );
+
+    spectrum_monitor::spectrum_monitor() :
+            f_socket_path( "/tmp/psyllid_spectrum_monitor" ),
+            f_n_spectra( 100 ),
+            f_integration_time( 0. ),
+            f_decimation( 1 ),
+            f_acq_rate( 100 ),
+            f_center_freq( 50.e6 ),
+            f_freq_range( 100.e6 ),
+            f_sum(),
+            f_message(),
+            f_socket( -1 ),
+            f_address(),
+            f_warned_send_error( false ),
+            f_n_sent( 0 ),
+            f_n_dropped( 0 )
+    {
+    }
+
+    spectrum_monitor::~spectrum_monitor()
+    {
+        if( f_socket >= 0 ) ::close( f_socket );
+    }
+
+    void spectrum_monitor::initialize()
+    {
+        const unsigned t_n_bins = PAYLOAD_SIZE / 2;
+        if( f_decimation == 0 || t_n_bins % f_decimation != 0 )
+        {
+            throw error() << "Decimation factor <" << f_decimation << "> must divide the number of frequency bins (" << t_n_bins << ")";
+        }
+        f_n_spectra = spectra_per_integration( f_n_spectra, f_integration_time, f_acq_rate );
+
+        f_address = sockaddr_un();
+        f_address.sun_family = AF_UNIX;
+        if( f_socket_path.empty() || f_socket_path.size() >= sizeof( f_address.sun_path ) )
+        {
+            throw error() << "Invalid socket path <" << f_socket_path << ">; it must be non-empty and shorter than " << sizeof( f_address.sun_path ) << " characters";
+        }
+        ::strncpy( f_address.sun_path, f_socket_path.c_str(), sizeof( f_address.sun_path ) - 1 );
+
+        if( f_socket >= 0 ) ::close( f_socket );
+        f_socket = ::socket( AF_UNIX, SOCK_DGRAM, 0 );
+        if( f_socket < 0 )
+        {
+            throw error() << "Unable to create the spectrum monitor socket: " << ::strerror( errno );
+        }
+
+        f_sum.assign( t_n_bins, 0.f );
+        f_message.assign( sizeof( spectrum_monitor_header ) + t_n_bins / f_decimation * sizeof( float ), 0 );
+
+        spectrum_monitor_header* t_header = reinterpret_cast< spectrum_monitor_header* >( f_message.data() );
+        t_header->f_magic = s_spectrum_monitor_magic;
+        t_header->f_version = s_spectrum_monitor_version;
+        t_header->f_header_size = sizeof( spectrum_monitor_header );
+        t_header->f_n_spectra = f_n_spectra;
+        t_header->f_n_bins = t_n_bins / f_decimation;
+        t_header->f_decimation = f_decimation;
+        t_header->f_freq_min = f_center_freq - 0.5 * f_freq_range;
+        t_header->f_bin_width = f_freq_range / (double)t_header->f_n_bins;
+
+        f_n_sent.store( 0 );
+        f_n_dropped.store( 0 );
+
+        LINFO( plog, "Spectrum monitor will send " << t_header->f_n_bins << "-bin spectra (" << f_message.size() << " bytes), averaged over " <<
+                f_n_spectra << " spectra, to <" << f_socket_path << ">" );
+        return;
+    }
+
+    bool spectrum_monitor::send_message()
+    {
+        ssize_t t_sent = ::sendto( f_socket, f_message.data(), f_message.size(), MSG_DONTWAIT | MSG_NOSIGNAL,
+                reinterpret_cast< const struct sockaddr* >( &f_address ), sizeof( f_address ) );
+        if( t_sent == (ssize_t)f_message.size() ) return true;
+
+        if( t_sent < 0 && errno != EAGAIN && errno != EWOULDBLOCK && errno != ENOBUFS && errno != ENOENT && errno != ECONNREFUSED && ! f_warned_send_error )
+        {
+            // the expected failures are a full receive queue (slow reader) and no reader; anything else is worth a warning, once per run
+            LWARN( plog, "Unable to send spectrum to <" << f_socket_path << ">: " << ::strerror( errno ) );
+            f_warned_send_error = true;
+        }
+        return false;
+    }
+
+    void spectrum_monitor::execute( midge::diptera* a_midge )
+    {
+        LDEBUG( plog, "execute spectrum monitor" );
+        try
+        {
+            midge::enum_t t_freq_command = stream::s_none;
+
+            freq_data* t_freq_data = nullptr;
+
+            spectrum_monitor_header* t_header = reinterpret_cast< spectrum_monitor_header* >( f_message.data() );
+            uint64_t t_sequence = 0;
+            unsigned t_n_summed = 0;
+
+            while( ! is_canceled() )
+            {
+                t_freq_command = in_stream< 0 >().get();
+                if( t_freq_command == stream::s_none ) continue;
+                if( t_freq_command == stream::s_error ) break;
+
+                LTRACE( plog, "Spectrum monitor reading stream 0 (freq) at index " << in_stream< 0 >().get_current_index() );
+
+                if( t_freq_command == stream::s_exit )
+                {
+                    LDEBUG( plog, "Spectrum monitor is exiting" );
+                    break;
+                }
+
+                if( t_freq_command == stream::s_stop )
+                {
+                    LDEBUG( plog, "Spectrum monitor is stopping; discarding " << t_n_summed << " spectra in the partial integration" );
+                    LINFO( plog, "Spectrum monitor has sent " << f_n_sent.load() << " spectra and dropped " << f_n_dropped.load() );
+                    continue;
+                }
+
+                if( t_freq_command == stream::s_start )
+                {
+                    LDEBUG( plog, "Spectrum monitor is starting" );
+                    std::fill( f_sum.begin(), f_sum.end(), 0.f );
+                    t_n_summed = 0;
+                    f_warned_send_error = false;
+                    continue;
+                }
+
+                if( t_freq_command == stream::s_run )
+                {
+                    t_freq_data = in_stream< 0 >().data();
+
+                    if( t_n_summed == 0 )
+                    {
+                        t_header->f_first_pkt_in_session = t_freq_data->get_pkt_in_session();
+                        t_header->f_unix_time = t_freq_data->get_unix_time();
+                    }
+
+                    accumulate_power( *t_freq_data, f_sum.data() );
+                    ++t_n_summed;
+
+                    if( t_n_summed < f_n_spectra ) continue;
+
+                    average_spectra( f_sum.data(), f_n_spectra, f_decimation, reinterpret_cast< float* >( f_message.data() + sizeof( spectrum_monitor_header ) ), t_header->f_n_bins );
+                    t_n_summed = 0;
+
+                    t_header->f_sequence = t_sequence++;
+                    t_header->f_n_dropped = f_n_dropped.load( std::memory_order_relaxed );
+                    if( send_message() )
+                    {
+                        f_n_sent.fetch_add( 1, std::memory_order_relaxed );
+                    }
+                    else
+                    {
+                        LTRACE( plog, "Dropped spectrum " << t_header->f_sequence );
+                        f_n_dropped.fetch_add( 1, std::memory_order_relaxed );
+                    }
+
+                    continue;
+                }
+
+            } // end while( ! is_cancelled() )
+
+            return;
+        }
+        catch(...)
+        {
+            LWARN( plog, "an error occurred executing spectrum monitor" );
+            if( a_midge ) a_midge->throw_ex( std::current_exception() );
+            else throw;
+        }
+    }
+
+    void spectrum_monitor::finalize()
+    {
+        LDEBUG( plog, "finalize spectrum monitor" );
+        if( f_socket >= 0 )
+        {
+            ::close( f_socket );
+            f_socket = -1;
+        }
+        return;
+    }
+
+
+    spectrum_monitor_binding::spectrum_monitor_binding() :
+            _node_binding< spectrum_monitor, spectrum_monitor_binding >()
+    {
+    }
+
+    spectrum_monitor_binding::~spectrum_monitor_binding()
+    {
+    }
+
+    void spectrum_monitor_binding::do_apply_config( spectrum_monitor* a_node, const scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Configuring spectrum_monitor with:\n" << a_config );
+        a_node->socket_path() = a_config.get_value( "socket-path", a_node->socket_path() );
+        a_node->set_n_spectra( a_config.get_value( "n-spectra", a_node->get_n_spectra() ) );
+        a_node->set_integration_time( a_config.get_value( "integration-time", a_node->get_integration_time() ) );
+        a_node->set_decimation( a_config.get_value( "decimation", a_node->get_decimation() ) );
+        if( a_config.has( "device" ) )
+        {
+            const scarab::param_node& t_dev_config = a_config["device"].as_node();
+            a_node->set_acq_rate( t_dev_config.get_value( "acq-rate", a_node->get_acq_rate() ) );
+        }
+        a_node->set_center_freq( a_config.get_value( "center-freq", a_node->get_center_freq() ) );
+        a_node->set_freq_range( a_config.get_value( "freq-range", a_node->get_freq_range() ) );
+        return;
+    }
+
+    void spectrum_monitor_binding::do_dump_config( const spectrum_monitor* a_node, scarab::param_node& a_config ) const
+    {
+        LDEBUG( plog, "Dumping configuration for spectrum_monitor" );
+        a_config.add( "socket-path", a_node->socket_path() );
+        a_config.add( "n-spectra", a_node->get_n_spectra() );
+        a_config.add( "integration-time", a_node->get_integration_time() );
+        a_config.add( "decimation", a_node->get_decimation() );
+        scarab::param_node t_dev_node = scarab::param_node();
+        t_dev_node.add( "acq-rate", a_node->get_acq_rate() );
+        a_config.add( "device", t_dev_node );
+        a_config.add( "center-freq", a_node->get_center_freq() );
+        a_config.add( "freq-range", a_node->get_freq_range() );
+        return;
+    }
+
+    void spectrum_monitor_binding::do_dump_status( const spectrum_monitor* a_node, scarab::param_node& a_status ) const
+    {
+        a_status.add( "n-sent", a_node->get_n_sent() );
+        a_status.add( "n-dropped", a_node->get_n_dropped() );
+        return;
+    }
+
+} /* namespace psyllid */
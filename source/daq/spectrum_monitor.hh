@@ -0,0 +1,153 @@
+/*
+ * spectrum_monitor.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_SPECTRUM_MONITOR_HH_
+#define PSYLLID_SPECTRUM_MONITOR_HH_
+
+#include "freq_data.hh"
+#include "node_builder.hh"
+
+#include "consumer.hh"
+
+#include <atomic>
+#include <string>
+#include <vector>
+
+#include <sys/un.h>
+
+namespace psyllid
+{
+    /*!
+     @brief Header of the messages sent by the spectrum monitor
+
+     @details
+     Each message is one datagram: this header followed by n_bins single-precision floats (the average power in each output bin,
+     in ADC units squared, from the lowest frequency to the highest).
+     All values are in the byte order of the host running psyllid.
+    */
+    struct spectrum_monitor_header
+    {
+        uint32_t f_magic; // s_spectrum_monitor_magic
+        uint16_t f_version; // s_spectrum_monitor_version
+        uint16_t f_header_size; // bytes; the spectrum starts at this offset
+        uint64_t f_sequence; // number of the integration since the node was initialized; gaps indicate dropped messages
+        uint64_t f_first_pkt_in_session; // packet number of the first spectrum in the integration
+        uint32_t f_unix_time; // time of the first spectrum in the integration, from the packet header
+        uint32_t f_n_spectra; // number of spectra averaged
+        uint32_t f_n_bins; // number of output bins
+        uint32_t f_decimation; // number of input bins averaged into each output bin
+        double f_freq_min; // frequency of the low edge of the first output bin, in Hz
+        double f_bin_width; // width of each output bin, in Hz
+        uint64_t f_n_dropped; // total number of messages dropped so far
+    };
+    static_assert( sizeof( spectrum_monitor_header ) == 64, "spectrum_monitor_header should not be padded" );
+
+    static const uint32_t s_spectrum_monitor_magic = 0x4d535350; // "PSSM" in little-endian byte order
+    static const uint16_t s_spectrum_monitor_version = 1;
+
+
+    /*!
+     @class spectrum_monitor
+     @brief A consumer that averages power spectra and publishes them on a local datagram socket, for live monitoring.
+
+     @details
+
+     Each message is the average of n-spectra consecutive power spectra (|I|^2 + |Q|^2 of the freq_data samples),
+     optionally decimated in frequency by averaging groups of adjacent bins; see spectrum_monitor_header for the message format.
+
+     Messages are sent to a Unix-domain datagram socket bound by the monitoring program at socket-path.
+     Sending never blocks: if no program is listening, or if the listener's receive queue is full because it is reading too slowly,
+     the message is dropped and counted.  The numbers of messages sent and dropped are reported in the node's status.
+     Integrations are not interrupted by missing packets; a partial integration is discarded when the run stops.
+
+     Parameter setting is not thread-safe.  Executing is thread-safe.
+
+     Node type: "spectrum-monitor"
+
+     Available configuration values:
+     - "socket-path": string -- path of the Unix-domain datagram socket the spectra are sent to
+     - "n-spectra": uint -- number of spectra averaged in each message
+     - "integration-time": double -- integration time in seconds; if > 0, overrides n-spectra using the spectrum rate given by acq-rate
+     - "decimation": uint -- number of adjacent bins averaged together; must divide the number of bins (4096)
+     - "device": node -- digitizer parameters
+       - "acq-rate": uint -- acquisition rate in MHz
+     - "center-freq": double -- the center frequency of the data being digitized in Hz
+     - "freq-range": double -- the frequency window (bandwidth) of the data being digitized in Hz
+
+     Status:
+     - "n-sent": uint -- number of messages sent
+     - "n-dropped": uint -- number of messages dropped
+
+     Input Stream:
+     - 0: freq_data
+
+     Output Streams: (none)
+    */
+    class spectrum_monitor :
+            public midge::_consumer< midge::type_list< freq_data > >
+    {
+        public:
+            spectrum_monitor();
+            virtual ~spectrum_monitor();
+
+        public:
+            mv_referrable( std::string, socket_path );
+            mv_accessible( unsigned, n_spectra );
+            mv_accessible( double, integration_time ); // s
+            mv_accessible( unsigned, decimation );
+            mv_accessible( unsigned, acq_rate ); // MHz
+            mv_accessible( double, center_freq ); // Hz
+            mv_accessible( double, freq_range ); // Hz
+
+        public:
+            virtual void initialize();
+            virtual void execute( midge::diptera* a_midge = nullptr );
+            virtual void finalize();
+
+            uint64_t get_n_sent() const;
+            uint64_t get_n_dropped() const;
+
+        private:
+            /// Sends the message without blocking; returns false if it was dropped
+            bool send_message();
+
+            std::vector< float > f_sum;
+            std::vector< char > f_message;
+
+            int f_socket;
+            struct sockaddr_un f_address;
+            bool f_warned_send_error;
+
+            std::atomic< uint64_t > f_n_sent;
+            std::atomic< uint64_t > f_n_dropped;
+    };
+
+    inline uint64_t spectrum_monitor::get_n_sent() const
+    {
+        return f_n_sent.load( std::memory_order_relaxed );
+    }
+
+    inline uint64_t spectrum_monitor::get_n_dropped() const
+    {
+        return f_n_dropped.load( std::memory_order_relaxed );
+    }
+
+
+    class spectrum_monitor_binding : public _node_binding< spectrum_monitor, spectrum_monitor_binding >
+    {
+        public:
+            spectrum_monitor_binding();
+            virtual ~spectrum_monitor_binding();
+
+        private:
+            virtual void do_apply_config( spectrum_monitor* a_node, const scarab::param_node& a_config ) const;
+            virtual void do_dump_config( const spectrum_monitor* a_node, scarab::param_node& a_config ) const;
+            virtual void do_dump_status( const spectrum_monitor* a_node, scarab::param_node& a_status ) const;
+    };
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_SPECTRUM_MONITOR_HH_ */
@@ -41,7 +41,18 @@ namespace psyllid
             f_v_range( 0.5 ),
             f_center_freq( 50.e6 ),
             f_freq_range( 100.e6 ),
+            f_batch_size( 1 ),
+            f_async( false ),
+            f_queue_depth( 64 ),
+            f_max_stall_ms( 1000 ),
             f_last_pkt_in_batch( 0 ),
+            f_batch_data(),
+            f_batch(),
+            f_adc_stats(),
+            f_queue(),
+            f_writer_thread(),
+            f_async_stream( nullptr ),
+            f_async_write_failed( false ),
             f_monarch_ptr(),
             f_stream_no( 0 )
     {
@@ -49,6 +60,7 @@ namespace psyllid
 
     streaming_writer::~streaming_writer()
     {
+        stop_writer_thread();
     }
 
     void streaming_writer::prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr )
@@ -80,10 +92,86 @@ namespace psyllid
 
     void streaming_writer::initialize()
     {
+        if( f_batch_size == 0 )
+        {
+            throw error() << "Batch size must be positive";
+        }
+        if( f_async && f_queue_depth == 0 )
+        {
+            throw error() << "Queue depth must be positive";
+        }
         butterfly_house::get_instance()->register_writer( this, f_file_num );
         return;
     }
 
+    void streaming_writer::write_batch( stream_wrapper& a_swrap, uint64_t a_bytes_per_record )
+    {
+        if( f_batch.empty() ) return;
+        LTRACE( plog, "Writing batch of " << f_batch.size() << " records" );
+        if( ! a_swrap.write_records( f_batch.data(), f_batch.size(), a_bytes_per_record ) )
+        {
+            throw midge::node_nonfatal_error() << "Unable to write records to file; first record ID: " << f_batch.front().f_id;
+        }
+        f_batch.clear();
+        return;
+    }
+
+    void streaming_writer::finish_stream( stream_wrap_ptr& a_swrap_ptr, uint64_t a_bytes_per_record )
+    {
+        if( ! a_swrap_ptr ) return;
+        if( f_async )
+        {
+            f_queue.flush();
+            f_queue.wait_until_empty();
+            f_async_stream = nullptr;
+        }
+        else
+        {
+            write_batch( *a_swrap_ptr, a_bytes_per_record );
+        }
+        f_monarch_ptr->finish_stream( f_stream_no );
+        a_swrap_ptr.reset();
+        return;
+    }
+
+    void streaming_writer::write_queue()
+    {
+        LDEBUG( plog, "Streaming writer's writer thread is starting" );
+        vector< stream_wrapper::record_info > t_records( f_queue.get_batch_size() );
+        const record_batch_queue::batch* t_batch = nullptr;
+        while( ( t_batch = f_queue.next_batch() ) != nullptr )
+        {
+            // after a failure, the rest of the run is discarded; the node throws the error when it next handles a packet
+            if( ! f_async_write_failed.load() )
+            {
+                for( size_t i_record = 0; i_record < t_batch->f_n_records; ++i_record )
+                {
+                    const record_batch_queue::record& t_record = t_batch->f_records[ i_record ];
+                    t_records[ i_record ] = { t_record.f_id, t_record.f_time, t_record.f_data, t_record.f_is_new_acq };
+                }
+                LTRACE( plog, "Writing queued batch of " << t_batch->f_n_records << " records" );
+                if( f_async_stream == nullptr || ! f_async_stream->write_records( t_records.data(), t_batch->f_n_records, f_queue.get_record_size() ) )
+                {
+                    LERROR( plog, "Unable to write queued records to file; first record ID: " << t_records.front().f_id );
+                    f_async_write_failed.store( true );
+                }
+            }
+            f_queue.release_batch();
+        }
+        LDEBUG( plog, "Streaming writer's writer thread is exiting" );
+        return;
+    }
+
+    void streaming_writer::stop_writer_thread()
+    {
+        if( f_writer_thread.joinable() )
+        {
+            f_queue.close();
+            f_writer_thread.join();
+        }
+        return;
+    }
+
     void streaming_writer::execute( midge::diptera* a_midge )
     {
         LDEBUG( plog, "execute streaming writer" );
@@ -96,10 +184,35 @@ namespace psyllid
             stream_wrap_ptr t_swrap_ptr;
 
             uint64_t t_bytes_per_record = f_record_size * f_sample_size * f_data_type_size;
+            if( t_bytes_per_record != PAYLOAD_SIZE )
+            {
+                throw error() << "Record size (" << t_bytes_per_record << " bytes) must match the packet payload size (" << PAYLOAD_SIZE << " bytes)";
+            }
             uint64_t t_record_length_nsec = llrint( (double)(PAYLOAD_SIZE / 2) / (double)f_acq_rate * 1.e3 );
 
             uint64_t t_first_pkt_in_run = 0;
 
+            adc_packet_stats t_packet_stats;
+
+            const bool t_batched = f_batch_size > 1;
+            f_batch.clear();
+            if( t_batched )
+            {
+                f_batch.reserve( f_batch_size );
+                f_batch_data.resize( f_batch_size * t_bytes_per_record );
+            }
+
+            if( f_async )
+            {
+                f_queue.allocate( f_queue_depth, f_batch_size, t_bytes_per_record );
+                f_async_stream = nullptr;
+                f_async_write_failed.store( false );
+                f_writer_thread = std::thread( &streaming_writer::write_queue, this );
+                LINFO( plog, "Records will be written asynchronously, with a queue of " << f_queue_depth << " batches of " << f_batch_size << " records" );
+            }
+            const std::chrono::milliseconds t_max_stall( f_max_stall_ms );
+            bool t_dropping = false;
+
             bool t_is_new_acquisition = true;
             bool t_start_file_with_next_data = false;
 
@@ -115,12 +228,7 @@ namespace psyllid
                 {
                     LDEBUG( plog, "Streaming writer is exiting" );
 
-                    if( t_swrap_ptr )
-                    {
-                        f_monarch_ptr->finish_stream( f_stream_no );
-                        t_swrap_ptr.reset();
-                    }
-
+                    finish_stream( t_swrap_ptr, t_bytes_per_record );
                     break;
                 }
 
@@ -128,12 +236,7 @@ namespace psyllid
                 {
                     LDEBUG( plog, "Streaming writer is stopping" );
 
-                    if( t_swrap_ptr )
-                    {
-                        f_monarch_ptr->finish_stream( f_stream_no );
-                        t_swrap_ptr.reset();
-                    }
-
+                    finish_stream( t_swrap_ptr, t_bytes_per_record );
                     continue;
                 }
 
@@ -141,11 +244,34 @@ namespace psyllid
                 {
                     LDEBUG( plog, "Will start file with next data" );
 
-                    if( t_swrap_ptr ) t_swrap_ptr.reset();
+                    if( t_swrap_ptr )
+                    {
+                        if( f_async )
+                        {
+                            f_queue.flush();
+                            f_queue.wait_until_empty();
+                        }
+                        else
+                        {
+                            // records still pending in the batch belong to the old stream
+                            write_batch( *t_swrap_ptr, t_bytes_per_record );
+                        }
+                        t_swrap_ptr.reset();
+                    }
 
                     LDEBUG( plog, "Getting stream <" << f_stream_no << ">" );
                     t_swrap_ptr = f_monarch_ptr->get_stream( f_stream_no );
 
+                    f_adc_stats.reset();
+                    f_batch.clear();
+                    if( f_async )
+                    {
+                        // the queue is empty here, so the writer thread isn't using the stream
+                        f_async_stream = t_swrap_ptr.get();
+                        f_async_write_failed.store( false );
+                        f_queue.reset_stats();
+                    }
+
                     t_start_file_with_next_data = true;
                     continue;
                 }
@@ -173,13 +299,55 @@ namespace psyllid
                     if( ! t_is_new_acquisition && t_time_data->get_pkt_in_batch() != t_expected_pkt_in_batch ) t_is_new_acquisition = true;
                     f_last_pkt_in_batch = t_time_data->get_pkt_in_batch();
 
-                    if( ! t_swrap_ptr->write_record( t_time_id, t_record_length_nsec * ( t_time_id - t_first_pkt_in_run ), t_time_data->get_raw_array(), t_bytes_per_record, t_is_new_acquisition ) )
+                    monarch3::TimeType t_time = t_record_length_nsec * ( t_time_id - t_first_pkt_in_run );
+                    // the ADC statistics are computed while the packet is copied, so the packet is only read once
+                    if( f_async )
+                    {
+                        if( f_async_write_failed.load() )
+                        {
+                            throw midge::node_nonfatal_error() << "Unable to write queued records to file";
+                        }
+                        int8_t* t_record_data = f_queue.begin_record( t_max_stall );
+                        if( t_record_data == nullptr )
+                        {
+                            if( ! t_dropping ) LWARN( plog, "Record queue is full; dropping records, starting with " << t_time_id );
+                            t_dropping = true;
+                            // the next record written follows a gap
+                            t_is_new_acquisition = true;
+                            continue;
+                        }
+                        if( t_dropping ) LWARN( plog, "Record queue has space again; " << f_queue.get_n_dropped() << " records dropped so far in this run" );
+                        t_dropping = false;
+                        copy_adc_stats( *t_time_data, t_record_data, t_packet_stats );
+                        f_queue.commit_record( t_time_id, t_time, t_is_new_acquisition );
+                    }
+                    else if( t_batched )
+                    {
+                        int8_t* t_block = f_batch_data.data() + f_batch.size() * t_bytes_per_record;
+                        copy_adc_stats( *t_time_data, t_block, t_packet_stats );
+                        stream_wrapper::record_info t_info = { t_time_id, t_time, t_block, t_is_new_acquisition };
+                        f_batch.push_back( t_info );
+                        if( f_batch.size() == f_batch_size ) write_batch( *t_swrap_ptr, t_bytes_per_record );
+                    }
+                    else
                     {
-                        throw midge::node_nonfatal_error() << "Unable to write record to file; record ID: " << t_time_id;
+                        // fill the stream record in place
+                        monarch3::byte_type* t_record_data = t_swrap_ptr->begin_record();
+                        if( t_record_data == nullptr )
+                        {
+                            throw midge::node_nonfatal_error() << "Unable to write record to file; record ID: " << t_time_id;
+                        }
+                        copy_adc_stats( *t_time_data, reinterpret_cast< int8_t* >( t_record_data ), t_packet_stats );
+                        if( ! t_swrap_ptr->commit_record( t_time_id, t_time, t_is_new_acquisition ) )
+                        {
+                            throw midge::node_nonfatal_error() << "Unable to write record to file; record ID: " << t_time_id;
+                        }
                     }
 
                     LTRACE( plog, "Packet written (" << t_time_id << ")" );
 
+                    f_adc_stats.add( t_packet_stats );
+
                     t_is_new_acquisition = false;
 
                     continue;
@@ -189,17 +357,15 @@ namespace psyllid
 
             // final attempt to finish the stream if the outer while loop is broken without the stream having been stopped or exited
             // e.g. if cancelled first, before anything else happens
-            if( t_swrap_ptr )
-            {
-                f_monarch_ptr->finish_stream( f_stream_no );
-                t_swrap_ptr.reset();
-            }
+            finish_stream( t_swrap_ptr, t_bytes_per_record );
+            stop_writer_thread();
 
             return;
         }
         catch(...)
         {
             LWARN( plog, "an error occurred executing streaming writer" );
+            stop_writer_thread();
             if( a_midge ) a_midge->throw_ex( std::current_exception() );
             else throw;
         }
@@ -239,6 +405,10 @@ namespace psyllid
         }
         a_node->set_center_freq( a_config.get_value( "center-freq", a_node->get_center_freq() ) );
         a_node->set_freq_range( a_config.get_value( "freq-range", a_node->get_freq_range() ) );
+        a_node->set_batch_size( a_config.get_value( "batch-size", a_node->get_batch_size() ) );
+        a_node->set_async( a_config.get_value( "async", a_node->get_async() ) );
+        a_node->set_queue_depth( a_config.get_value( "queue-depth", a_node->get_queue_depth() ) );
+        a_node->set_max_stall_ms( a_config.get_value( "max-stall-ms", a_node->get_max_stall_ms() ) );
         return;
     }
 
@@ -257,8 +427,25 @@ namespace psyllid
         a_config.add( "device", t_dev_node );
         a_config.add( "center-freq", a_node->get_center_freq() );
         a_config.add( "freq-range", a_node->get_freq_range() );
+        a_config.add( "batch-size", a_node->get_batch_size() );
+        a_config.add( "async", a_node->get_async() );
+        a_config.add( "queue-depth", a_node->get_queue_depth() );
+        a_config.add( "max-stall-ms", a_node->get_max_stall_ms() );
         return;
     }
 
+    void streaming_writer_binding::do_dump_status( const streaming_writer* a_node, scarab::param_node& a_status ) const
+    {
+        scarab::param_node t_adc_node;
+        a_node->get_adc_stats().fill_status( t_adc_node );
+        a_status.add( "adc", t_adc_node );
+        if( a_node->get_async() )
+        {
+            scarab::param_node t_queue_node;
+            a_node->get_queue().fill_status( t_queue_node );
+            a_status.add( "queue", t_queue_node );
+        }
+        return;
+    }
 
 } /* namespace psyllid */
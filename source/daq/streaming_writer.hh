@@ -8,12 +8,18 @@
 #ifndef PSYLLID_STREAMING_WRITER_HH_
 #define PSYLLID_STREAMING_WRITER_HH_
 
+#include "adc_stats.hh"
 #include "egg_writer.hh"
 #include "node_builder.hh"
+#include "record_batch_queue.hh"
 #include "time_data.hh"
 
 #include "consumer.hh"
 
+#include <atomic>
+#include <thread>
+#include <vector>
+
 namespace psyllid
 {
 
@@ -40,10 +46,32 @@ namespace psyllid
        - "v-range": double -- voltage range for ADC calibration
      - "center-freq": double -- the center frequency of the data being digitized in Hz
      - "freq-range": double -- the frequency window (bandwidth) of the data being digitized in Hz
+     - "batch-size": uint -- number of records written to the file together (see below); 1 writes each record as it arrives
+     - "async": bool -- if true, records are written to the file by a separate writer thread (see below)
+     - "queue-depth": uint -- in async mode, the number of batches that can be queued for the writer thread
+     - "max-stall-ms": uint -- in async mode, how long to wait for the writer thread when the queue is full before dropping a record
+
+     Each record holds one packet, so the record size (record-size * sample-size * data-type-size) must equal the packet payload size.
+     With batch-size 1, each packet is copied straight into the Monarch stream record (stream_wrapper::begin_record() and commit_record()),
+     and the ADC statistics are computed during that copy.
+
+     Batched writing: if batch-size > 1, records are collected in a preallocated buffer and written with stream_wrapper::write_records(),
+     which checks the file and updates the file size once per batch instead of once per record.  The cost is one extra copy of each record,
+     and a latency of up to batch-size records; a partial batch is written when the run stops.
+
+     Asynchronous writing: if async is true, the node only copies each packet into a preallocated queue of queue-depth batches
+     (batch-size records each; see record_batch_queue), and a writer thread writes the batches to the file.  A slow write or a file switch
+     then holds up the writer thread instead of the time_data stream, as long as the queue doesn't fill.  If it does fill, the node waits
+     for up to max-stall-ms; a record that still doesn't fit is dropped, and the next record written starts a new acquisition.
+     When the run stops, the node waits for the queue to be written before finishing the file.
+     The queue's high-water mark, the time spent waiting and the number of records dropped are in the node's status (under "queue").
 
      ADC calibration: analog (V) = digital * gain + v-offset
                       gain = v-range / # of digital levels
 
+     ADC statistics (mean, RMS, extremes and saturation; see adc_stats) are accumulated for each run as the packets are written,
+     and are reported in the node's status (under "adc") by the DAQ status request.
+
      Input Stream:
      - 0: time_data
 
@@ -69,6 +97,10 @@ namespace psyllid
             mv_accessible( double, v_range ); // V
             mv_accessible( double, center_freq ); // Hz
             mv_accessible( double, freq_range ); // Hz
+            mv_accessible( unsigned, batch_size );
+            mv_accessible( bool, async );
+            mv_accessible( unsigned, queue_depth );
+            mv_accessible( unsigned, max_stall_ms );
 
         public:
             virtual void prepare_to_write( monarch_wrap_ptr a_mw_ptr, header_wrap_ptr a_hw_ptr );
@@ -77,14 +109,48 @@ namespace psyllid
             virtual void execute( midge::diptera* a_midge = nullptr );
             virtual void finalize();
 
+            /// ADC statistics for the current run; can be read from any thread
+            const adc_stats& get_adc_stats() const;
+            /// Queue for asynchronous writing; the statistics can be read from any thread
+            const record_batch_queue& get_queue() const;
+
         private:
+            /// Writes and clears the records collected for a batch; throws midge::node_nonfatal_error if they can't be written
+            void write_batch( stream_wrapper& a_swrap, uint64_t a_bytes_per_record );
+            /// Writes the batches collected (if batched) or queued (if async), and finishes the stream
+            void finish_stream( stream_wrap_ptr& a_swrap_ptr, uint64_t a_bytes_per_record );
+
+            /// Writer thread for async mode: writes queued batches to f_async_stream until the queue is closed
+            void write_queue();
+            void stop_writer_thread();
+
             unsigned f_last_pkt_in_batch;
 
+            std::vector< int8_t > f_batch_data;
+            std::vector< stream_wrapper::record_info > f_batch;
+
+            adc_stats f_adc_stats;
+
+            record_batch_queue f_queue;
+            std::thread f_writer_thread;
+            stream_wrapper* f_async_stream; // only changed while the queue is empty
+            std::atomic< bool > f_async_write_failed;
+
             monarch_wrap_ptr f_monarch_ptr;
             unsigned f_stream_no;
 
     };
 
+    inline const adc_stats& streaming_writer::get_adc_stats() const
+    {
+        return f_adc_stats;
+    }
+
+    inline const record_batch_queue& streaming_writer::get_queue() const
+    {
+        return f_queue;
+    }
+
 
     class streaming_writer_binding : public _node_binding< streaming_writer, streaming_writer_binding >
     {
@@ -95,6 +161,8 @@ namespace psyllid
         private:
             virtual void do_apply_config( streaming_writer* a_node, const scarab::param_node& a_config ) const;
             virtual void do_dump_config( const streaming_writer* a_node, scarab::param_node& a_config ) const;
+
+            virtual void do_dump_status( const streaming_writer* a_node, scarab::param_node& a_status ) const;
     };
 
 } /* namespace psyllid */
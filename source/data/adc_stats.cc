@@ -0,0 +1,288 @@
+/*
+ * adc_stats.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "adc_stats.hh"
+
+#include "spectrum_kernels.hh"
+
+#include "param.hh"
+
+#include <algorithm>
+#include <cmath>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define PSYLLID_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace psyllid
+{
+
+    // if x_copy is false, a_dest is not used
+    template< bool x_copy >
+    static void copy_adc_stats_scalar( const int8_t* a_iq, int8_t* a_dest, size_t a_n_samples, adc_packet_stats& a_stats )
+    {
+        int64_t t_sum_i = 0, t_sum_q = 0;
+        uint64_t t_sum_sq = 0, t_n_high = 0, t_n_low = 0;
+        int t_min = 127, t_max = -128;
+        for( size_t i_sample = 0; i_sample < a_n_samples; ++i_sample )
+        {
+            int t_i = a_iq[ 2*i_sample ];
+            int t_q = a_iq[ 2*i_sample + 1 ];
+            t_sum_i += t_i;
+            t_sum_q += t_q;
+            t_sum_sq += t_i * t_i + t_q * t_q;
+            t_min = std::min( t_min, std::min( t_i, t_q ) );
+            t_max = std::max( t_max, std::max( t_i, t_q ) );
+            t_n_high += ( t_i == 127 ) + ( t_q == 127 );
+            t_n_low += ( t_i <= -127 ) + ( t_q <= -127 );
+            if( x_copy )
+            {
+                a_dest[ 2*i_sample ] = (int8_t)t_i;
+                a_dest[ 2*i_sample + 1 ] = (int8_t)t_q;
+            }
+        }
+        a_stats.f_n_samples = a_n_samples;
+        a_stats.f_sum_i = t_sum_i;
+        a_stats.f_sum_q = t_sum_q;
+        a_stats.f_sum_sq = t_sum_sq;
+        a_stats.f_min = (int8_t)t_min;
+        a_stats.f_max = (int8_t)t_max;
+        a_stats.f_n_high = t_n_high;
+        a_stats.f_n_low = t_n_low;
+        return;
+    }
+
+    void compute_adc_stats_scalar( const int8_t* a_iq, size_t a_n_samples, adc_packet_stats& a_stats )
+    {
+        copy_adc_stats_scalar< false >( a_iq, nullptr, a_n_samples, a_stats );
+        return;
+    }
+
+#ifdef PSYLLID_X86_KERNELS
+
+    __attribute__(( target( "avx2" ) ))
+    static int64_t hsum_epi32_avx2( __m256i a_v )
+    {
+        // add in 64 bits, so that large sums don't overflow
+        int32_t t_lanes[ 8 ];
+        _mm256_storeu_si256( reinterpret_cast< __m256i* >( t_lanes ), a_v );
+        int64_t t_sum = 0;
+        for( unsigned i_lane = 0; i_lane < 8; ++i_lane ) t_sum += t_lanes[ i_lane ];
+        return t_sum;
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    static void copy_adc_stats_avx2( const int8_t* a_iq, int8_t* a_dest, size_t a_n_samples, adc_packet_stats& a_stats )
+    {
+        const size_t t_n_values = 2 * a_n_samples;
+        // madd with these picks out the I (even) or Q (odd) values, and sums adjacent pairs into 32-bit lanes
+        const __m256i t_i_mask = _mm256_set1_epi32( 0x00000001 );
+        const __m256i t_q_mask = _mm256_set1_epi32( 0x00010000 );
+        const __m256i t_high = _mm256_set1_epi8( 127 );
+        const __m256i t_low = _mm256_set1_epi8( -126 );
+        const __m256i t_zero = _mm256_setzero_si256();
+
+        __m256i t_min = _mm256_set1_epi8( 127 );
+        __m256i t_max = _mm256_set1_epi8( -128 );
+
+        int64_t t_total_i = 0, t_total_q = 0, t_total_sq = 0;
+        __m256i t_total_high = _mm256_setzero_si256(); // 64-bit lanes
+        __m256i t_total_low = _mm256_setzero_si256();
+
+        // the saturation counts are kept in 8-bit lanes, so they're added to the totals at least every 255 blocks of 32 values
+        const size_t t_chunk_values = 32 * 128;
+
+        size_t i_value = 0;
+        while( i_value + 32 <= t_n_values )
+        {
+            size_t t_chunk_end = std::min( i_value + t_chunk_values, t_n_values - t_n_values % 32 );
+
+            __m256i t_sum_i = _mm256_setzero_si256();
+            __m256i t_sum_q = _mm256_setzero_si256();
+            __m256i t_sum_sq = _mm256_setzero_si256();
+            __m256i t_n_high = _mm256_setzero_si256();
+            __m256i t_n_low = _mm256_setzero_si256();
+
+            for( ; i_value < t_chunk_end; i_value += 32 )
+            {
+                __m256i t_bytes = _mm256_loadu_si256( reinterpret_cast< const __m256i* >( a_iq + i_value ) );
+                if( a_dest != nullptr ) _mm256_storeu_si256( reinterpret_cast< __m256i* >( a_dest + i_value ), t_bytes );
+
+                t_min = _mm256_min_epi8( t_min, t_bytes );
+                t_max = _mm256_max_epi8( t_max, t_bytes );
+                // the comparisons give -1 where true
+                t_n_high = _mm256_sub_epi8( t_n_high, _mm256_cmpeq_epi8( t_bytes, t_high ) );
+                t_n_low = _mm256_sub_epi8( t_n_low, _mm256_cmpgt_epi8( t_low, t_bytes ) );
+
+                __m256i t_lo16 = _mm256_cvtepi8_epi16( _mm256_castsi256_si128( t_bytes ) );
+                __m256i t_hi16 = _mm256_cvtepi8_epi16( _mm256_extracti128_si256( t_bytes, 1 ) );
+                t_sum_i = _mm256_add_epi32( t_sum_i, _mm256_add_epi32( _mm256_madd_epi16( t_lo16, t_i_mask ), _mm256_madd_epi16( t_hi16, t_i_mask ) ) );
+                t_sum_q = _mm256_add_epi32( t_sum_q, _mm256_add_epi32( _mm256_madd_epi16( t_lo16, t_q_mask ), _mm256_madd_epi16( t_hi16, t_q_mask ) ) );
+                t_sum_sq = _mm256_add_epi32( t_sum_sq, _mm256_add_epi32( _mm256_madd_epi16( t_lo16, t_lo16 ), _mm256_madd_epi16( t_hi16, t_hi16 ) ) );
+            }
+
+            t_total_i += hsum_epi32_avx2( t_sum_i );
+            t_total_q += hsum_epi32_avx2( t_sum_q );
+            t_total_sq += hsum_epi32_avx2( t_sum_sq );
+            // sad against zero sums groups of 8 bytes into 64-bit lanes
+            t_total_high = _mm256_add_epi64( t_total_high, _mm256_sad_epu8( t_n_high, t_zero ) );
+            t_total_low = _mm256_add_epi64( t_total_low, _mm256_sad_epu8( t_n_low, t_zero ) );
+        }
+
+        int8_t t_mins[ 32 ], t_maxs[ 32 ];
+        _mm256_storeu_si256( reinterpret_cast< __m256i* >( t_mins ), t_min );
+        _mm256_storeu_si256( reinterpret_cast< __m256i* >( t_maxs ), t_max );
+        uint64_t t_highs[ 4 ], t_lows[ 4 ];
+        _mm256_storeu_si256( reinterpret_cast< __m256i* >( t_highs ), t_total_high );
+        _mm256_storeu_si256( reinterpret_cast< __m256i* >( t_lows ), t_total_low );
+
+        // the remaining values (always whole IQ pairs, so i_value is even)
+        adc_packet_stats t_tail;
+        if( a_dest != nullptr ) copy_adc_stats_scalar< true >( a_iq + i_value, a_dest + i_value, ( t_n_values - i_value ) / 2, t_tail );
+        else copy_adc_stats_scalar< false >( a_iq + i_value, nullptr, ( t_n_values - i_value ) / 2, t_tail );
+
+        a_stats.f_n_samples = a_n_samples;
+        a_stats.f_sum_i = t_total_i + t_tail.f_sum_i;
+        a_stats.f_sum_q = t_total_q + t_tail.f_sum_q;
+        a_stats.f_sum_sq = (uint64_t)t_total_sq + t_tail.f_sum_sq;
+        a_stats.f_min = std::min( *std::min_element( t_mins, t_mins + 32 ), t_tail.f_min );
+        a_stats.f_max = std::max( *std::max_element( t_maxs, t_maxs + 32 ), t_tail.f_max );
+        a_stats.f_n_high = t_highs[ 0 ] + t_highs[ 1 ] + t_highs[ 2 ] + t_highs[ 3 ] + t_tail.f_n_high;
+        a_stats.f_n_low = t_lows[ 0 ] + t_lows[ 1 ] + t_lows[ 2 ] + t_lows[ 3 ] + t_tail.f_n_low;
+        return;
+    }
+
+#endif /* PSYLLID_X86_KERNELS */
+
+    void compute_adc_stats( const int8_t* a_iq, size_t a_n_samples, adc_packet_stats& a_stats )
+    {
+#ifdef PSYLLID_X86_KERNELS
+        if( active_kernel_isa() == kernel_isa::avx2 )
+        {
+            copy_adc_stats_avx2( a_iq, nullptr, a_n_samples, a_stats );
+            return;
+        }
+#endif
+        copy_adc_stats_scalar< false >( a_iq, nullptr, a_n_samples, a_stats );
+        return;
+    }
+
+    void copy_adc_stats( const int8_t* a_iq, int8_t* a_dest, size_t a_n_samples, adc_packet_stats& a_stats )
+    {
+#ifdef PSYLLID_X86_KERNELS
+        if( active_kernel_isa() == kernel_isa::avx2 )
+        {
+            copy_adc_stats_avx2( a_iq, a_dest, a_n_samples, a_stats );
+            return;
+        }
+#endif
+        copy_adc_stats_scalar< true >( a_iq, a_dest, a_n_samples, a_stats );
+        return;
+    }
+
+
+    adc_stats::adc_stats() :
+            f_sequence( 0 ),
+            f_n_packets( 0 ),
+            f_n_samples( 0 ),
+            f_sum_i( 0 ),
+            f_sum_q( 0 ),
+            f_sum_sq( 0 ),
+            f_min( 127 ),
+            f_max( -128 ),
+            f_n_high( 0 ),
+            f_n_low( 0 )
+    {
+    }
+
+    adc_stats::~adc_stats()
+    {
+    }
+
+    void adc_stats::reset()
+    {
+        uint64_t t_sequence = f_sequence.load( std::memory_order_relaxed );
+        f_sequence.store( t_sequence + 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        f_n_packets.store( 0, std::memory_order_relaxed );
+        f_n_samples.store( 0, std::memory_order_relaxed );
+        f_sum_i.store( 0, std::memory_order_relaxed );
+        f_sum_q.store( 0, std::memory_order_relaxed );
+        f_sum_sq.store( 0, std::memory_order_relaxed );
+        f_min.store( 127, std::memory_order_relaxed );
+        f_max.store( -128, std::memory_order_relaxed );
+        f_n_high.store( 0, std::memory_order_relaxed );
+        f_n_low.store( 0, std::memory_order_relaxed );
+
+        f_sequence.store( t_sequence + 2, std::memory_order_release );
+        return;
+    }
+
+    void adc_stats::add( const adc_packet_stats& a_stats )
+    {
+        // only one thread updates, so plain loads and stores of the atomics are enough; the sequence counter tells readers when to retry
+        uint64_t t_sequence = f_sequence.load( std::memory_order_relaxed );
+        f_sequence.store( t_sequence + 1, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        f_n_packets.store( f_n_packets.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+        f_n_samples.store( f_n_samples.load( std::memory_order_relaxed ) + a_stats.f_n_samples, std::memory_order_relaxed );
+        f_sum_i.store( f_sum_i.load( std::memory_order_relaxed ) + a_stats.f_sum_i, std::memory_order_relaxed );
+        f_sum_q.store( f_sum_q.load( std::memory_order_relaxed ) + a_stats.f_sum_q, std::memory_order_relaxed );
+        f_sum_sq.store( f_sum_sq.load( std::memory_order_relaxed ) + a_stats.f_sum_sq, std::memory_order_relaxed );
+        f_min.store( std::min< int >( f_min.load( std::memory_order_relaxed ), a_stats.f_min ), std::memory_order_relaxed );
+        f_max.store( std::max< int >( f_max.load( std::memory_order_relaxed ), a_stats.f_max ), std::memory_order_relaxed );
+        f_n_high.store( f_n_high.load( std::memory_order_relaxed ) + a_stats.f_n_high, std::memory_order_relaxed );
+        f_n_low.store( f_n_low.load( std::memory_order_relaxed ) + a_stats.f_n_low, std::memory_order_relaxed );
+
+        f_sequence.store( t_sequence + 2, std::memory_order_release );
+        return;
+    }
+
+    adc_packet_stats adc_stats::get( uint64_t& a_n_packets ) const
+    {
+        adc_packet_stats t_stats;
+        uint64_t t_sequence_before = 0, t_sequence_after = 0;
+        do
+        {
+            t_sequence_before = f_sequence.load( std::memory_order_acquire );
+            a_n_packets = f_n_packets.load( std::memory_order_relaxed );
+            t_stats.f_n_samples = f_n_samples.load( std::memory_order_relaxed );
+            t_stats.f_sum_i = f_sum_i.load( std::memory_order_relaxed );
+            t_stats.f_sum_q = f_sum_q.load( std::memory_order_relaxed );
+            t_stats.f_sum_sq = f_sum_sq.load( std::memory_order_relaxed );
+            t_stats.f_min = (int8_t)f_min.load( std::memory_order_relaxed );
+            t_stats.f_max = (int8_t)f_max.load( std::memory_order_relaxed );
+            t_stats.f_n_high = f_n_high.load( std::memory_order_relaxed );
+            t_stats.f_n_low = f_n_low.load( std::memory_order_relaxed );
+            std::atomic_thread_fence( std::memory_order_acquire );
+            t_sequence_after = f_sequence.load( std::memory_order_relaxed );
+        } while( ( t_sequence_before & 1 ) != 0 || t_sequence_before != t_sequence_after );
+        return t_stats;
+    }
+
+    void adc_stats::fill_status( scarab::param_node& a_status ) const
+    {
+        uint64_t t_n_packets = 0;
+        adc_packet_stats t_stats = get( t_n_packets );
+
+        a_status.add( "n-packets", t_n_packets );
+        if( t_stats.f_n_samples == 0 ) return;
+
+        double t_n_samples = (double)t_stats.f_n_samples;
+        a_status.add( "mean-i", (double)t_stats.f_sum_i / t_n_samples );
+        a_status.add( "mean-q", (double)t_stats.f_sum_q / t_n_samples );
+        a_status.add( "rms", std::sqrt( (double)t_stats.f_sum_sq / ( 2. * t_n_samples ) ) );
+        a_status.add( "min", (int)t_stats.f_min );
+        a_status.add( "max", (int)t_stats.f_max );
+        a_status.add( "n-saturated", t_stats.f_n_high + t_stats.f_n_low );
+        a_status.add( "saturated-fraction", (double)( t_stats.f_n_high + t_stats.f_n_low ) / ( 2. * t_n_samples ) );
+        return;
+    }
+
+} /* namespace psyllid */
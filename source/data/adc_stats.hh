@@ -0,0 +1,119 @@
+/*
+ * adc_stats.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_ADC_STATS_HH_
+#define PSYLLID_ADC_STATS_HH_
+
+#include "time_data.hh"
+
+#include <atomic>
+#include <cstddef> // for size_t
+#include <cstdint>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace psyllid
+{
+    /*!
+     @brief Statistics of a block of int8 IQ ADC samples
+
+     @details
+     Values at +127, or at -127 or -128, are counted as saturated.
+    */
+    struct adc_packet_stats
+    {
+        uint64_t f_n_samples; // IQ pairs
+        int64_t f_sum_i;
+        int64_t f_sum_q;
+        uint64_t f_sum_sq; // sum of I^2 + Q^2
+        int8_t f_min; // over I and Q
+        int8_t f_max;
+        uint64_t f_n_high; // values at +127
+        uint64_t f_n_low; // values at -127 or -128
+    };
+
+    /// Computes the statistics of a_n_samples interleaved (I, Q) int8 pairs in one pass; vectorized if the active kernel instruction set is AVX2 (see active_kernel_isa())
+    void compute_adc_stats( const int8_t* a_iq, size_t a_n_samples, adc_packet_stats& a_stats );
+    /// Scalar reference version of compute_adc_stats()
+    void compute_adc_stats_scalar( const int8_t* a_iq, size_t a_n_samples, adc_packet_stats& a_stats );
+
+    void compute_adc_stats( const time_data& a_data, adc_packet_stats& a_stats );
+
+    /// Copies a_n_samples IQ pairs from a_iq to a_dest and computes their statistics in the same pass, so the data are only read from memory once.
+    /// The buffers must not overlap.
+    void copy_adc_stats( const int8_t* a_iq, int8_t* a_dest, size_t a_n_samples, adc_packet_stats& a_stats );
+
+    void copy_adc_stats( const time_data& a_data, int8_t* a_dest, adc_packet_stats& a_stats );
+
+
+    /*!
+     @class adc_stats
+     @brief Accumulates ADC statistics for a stream of packets, and can be read from other threads without locking
+
+     @details
+     add() may only be called by one thread (the one processing the stream);
+     fill_status() and get() may be called at any time from any thread.
+     A sequence counter lets readers retry if they overlap with an update, so the values they get are always consistent with each other.
+
+     The status contains:
+     - "n-packets": uint -- number of packets accumulated
+     - "mean-i", "mean-q": double -- mean of the I and Q values (ADC units)
+     - "rms": double -- RMS of the I and Q values (ADC units)
+     - "min", "max": int -- extreme I or Q values
+     - "n-saturated": uint -- number of values at +127, -127 or -128
+     - "saturated-fraction": double -- fraction of values that are saturated
+    */
+    class adc_stats
+    {
+        public:
+            adc_stats();
+            virtual ~adc_stats();
+
+        public:
+            /// Clears the statistics; like add(), only call from the thread processing the stream
+            void reset();
+
+            /// Adds a packet's statistics
+            void add( const adc_packet_stats& a_stats );
+
+            /// Returns the accumulated statistics, and the number of packets in a_n_packets
+            adc_packet_stats get( uint64_t& a_n_packets ) const;
+
+            /// Fills a_status with the summary described above
+            void fill_status( scarab::param_node& a_status ) const;
+
+        private:
+            std::atomic< uint64_t > f_sequence; // odd while an update is in progress
+
+            std::atomic< uint64_t > f_n_packets;
+            std::atomic< uint64_t > f_n_samples;
+            std::atomic< int64_t > f_sum_i;
+            std::atomic< int64_t > f_sum_q;
+            std::atomic< uint64_t > f_sum_sq;
+            std::atomic< int > f_min;
+            std::atomic< int > f_max;
+            std::atomic< uint64_t > f_n_high;
+            std::atomic< uint64_t > f_n_low;
+    };
+
+    inline void compute_adc_stats( const time_data& a_data, adc_packet_stats& a_stats )
+    {
+        compute_adc_stats( a_data.get_array()[ 0 ], a_data.get_array_size(), a_stats );
+        return;
+    }
+
+    inline void copy_adc_stats( const time_data& a_data, int8_t* a_dest, adc_packet_stats& a_stats )
+    {
+        copy_adc_stats( a_data.get_array()[ 0 ], a_dest, a_data.get_array_size(), a_stats );
+        return;
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_ADC_STATS_HH_ */
@@ -0,0 +1,355 @@
+/*
+ * iq_decimator.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "iq_decimator.hh"
+
+#include "psyllid_error.hh"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define PSYLLID_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace psyllid
+{
+    static const double s_two_pi = 6.283185307179586;
+
+    // returns the fractional part of a_x, in [0, 1)
+    static inline double frac( double a_x )
+    {
+        return a_x - std::floor( a_x );
+    }
+
+
+    //**********
+    // Kernels
+    //**********
+
+    // Each mixing kernel multiplies the samples by exp( -i phase ), where the phase is that of ( a_cos0, a_sin0 ) plus that of the table entry,
+    // and writes the I and Q components to separate arrays
+
+    static void mix_scalar( const int8_t* a_iq, size_t a_n_samples, float a_cos0, float a_sin0, const float* a_table_cos, const float* a_table_sin, float* a_i, float* a_q )
+    {
+        for( size_t i_sample = 0; i_sample < a_n_samples; ++i_sample )
+        {
+            float t_cos = a_cos0 * a_table_cos[ i_sample ] - a_sin0 * a_table_sin[ i_sample ];
+            float t_sin = a_sin0 * a_table_cos[ i_sample ] + a_cos0 * a_table_sin[ i_sample ];
+            float t_in_i = (float)a_iq[ 2*i_sample ];
+            float t_in_q = (float)a_iq[ 2*i_sample + 1 ];
+            a_i[ i_sample ] = t_in_i * t_cos + t_in_q * t_sin;
+            a_q[ i_sample ] = t_in_q * t_cos - t_in_i * t_sin;
+        }
+        return;
+    }
+
+    // Each filter kernel computes the dot product of the coefficients with the I and Q histories; a_n_coeffs is a multiple of 8
+
+    static void dot2_scalar( const float* a_coeffs, const float* a_i, const float* a_q, size_t a_n_coeffs, float& a_out_i, float& a_out_q )
+    {
+        float t_sum_i = 0.f, t_sum_q = 0.f;
+        for( size_t i_coeff = 0; i_coeff < a_n_coeffs; ++i_coeff )
+        {
+            t_sum_i += a_coeffs[ i_coeff ] * a_i[ i_coeff ];
+            t_sum_q += a_coeffs[ i_coeff ] * a_q[ i_coeff ];
+        }
+        a_out_i = t_sum_i;
+        a_out_q = t_sum_q;
+        return;
+    }
+
+#ifdef PSYLLID_X86_KERNELS
+
+    __attribute__(( target( "sse2" ) ))
+    static inline float hsum_sse2( __m128 a_v )
+    {
+        __m128 t_v = _mm_add_ps( a_v, _mm_movehl_ps( a_v, a_v ) );
+        t_v = _mm_add_ss( t_v, _mm_shuffle_ps( t_v, t_v, 1 ) );
+        return _mm_cvtss_f32( t_v );
+    }
+
+    __attribute__(( target( "sse2" ) ))
+    static void dot2_sse2( const float* a_coeffs, const float* a_i, const float* a_q, size_t a_n_coeffs, float& a_out_i, float& a_out_q )
+    {
+        // two accumulators per component hide the latency of the adds
+        __m128 t_sum_i0 = _mm_setzero_ps(), t_sum_i1 = _mm_setzero_ps();
+        __m128 t_sum_q0 = _mm_setzero_ps(), t_sum_q1 = _mm_setzero_ps();
+        for( size_t i_coeff = 0; i_coeff < a_n_coeffs; i_coeff += 8 )
+        {
+            __m128 t_c0 = _mm_loadu_ps( a_coeffs + i_coeff );
+            __m128 t_c1 = _mm_loadu_ps( a_coeffs + i_coeff + 4 );
+            t_sum_i0 = _mm_add_ps( t_sum_i0, _mm_mul_ps( t_c0, _mm_loadu_ps( a_i + i_coeff ) ) );
+            t_sum_i1 = _mm_add_ps( t_sum_i1, _mm_mul_ps( t_c1, _mm_loadu_ps( a_i + i_coeff + 4 ) ) );
+            t_sum_q0 = _mm_add_ps( t_sum_q0, _mm_mul_ps( t_c0, _mm_loadu_ps( a_q + i_coeff ) ) );
+            t_sum_q1 = _mm_add_ps( t_sum_q1, _mm_mul_ps( t_c1, _mm_loadu_ps( a_q + i_coeff + 4 ) ) );
+        }
+        a_out_i = hsum_sse2( _mm_add_ps( t_sum_i0, t_sum_i1 ) );
+        a_out_q = hsum_sse2( _mm_add_ps( t_sum_q0, t_sum_q1 ) );
+        return;
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    static inline float hsum_avx2( __m256 a_v )
+    {
+        __m128 t_v = _mm_add_ps( _mm256_castps256_ps128( a_v ), _mm256_extractf128_ps( a_v, 1 ) );
+        t_v = _mm_add_ps( t_v, _mm_movehl_ps( t_v, t_v ) );
+        t_v = _mm_add_ss( t_v, _mm_shuffle_ps( t_v, t_v, 1 ) );
+        return _mm_cvtss_f32( t_v );
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    static void dot2_avx2( const float* a_coeffs, const float* a_i, const float* a_q, size_t a_n_coeffs, float& a_out_i, float& a_out_q )
+    {
+        __m256 t_sum_i0 = _mm256_setzero_ps(), t_sum_i1 = _mm256_setzero_ps();
+        __m256 t_sum_q0 = _mm256_setzero_ps(), t_sum_q1 = _mm256_setzero_ps();
+        size_t i_coeff = 0;
+        for( ; i_coeff + 16 <= a_n_coeffs; i_coeff += 16 )
+        {
+            __m256 t_c0 = _mm256_loadu_ps( a_coeffs + i_coeff );
+            __m256 t_c1 = _mm256_loadu_ps( a_coeffs + i_coeff + 8 );
+            t_sum_i0 = _mm256_add_ps( t_sum_i0, _mm256_mul_ps( t_c0, _mm256_loadu_ps( a_i + i_coeff ) ) );
+            t_sum_i1 = _mm256_add_ps( t_sum_i1, _mm256_mul_ps( t_c1, _mm256_loadu_ps( a_i + i_coeff + 8 ) ) );
+            t_sum_q0 = _mm256_add_ps( t_sum_q0, _mm256_mul_ps( t_c0, _mm256_loadu_ps( a_q + i_coeff ) ) );
+            t_sum_q1 = _mm256_add_ps( t_sum_q1, _mm256_mul_ps( t_c1, _mm256_loadu_ps( a_q + i_coeff + 8 ) ) );
+        }
+        if( i_coeff < a_n_coeffs )
+        {
+            __m256 t_c0 = _mm256_loadu_ps( a_coeffs + i_coeff );
+            t_sum_i0 = _mm256_add_ps( t_sum_i0, _mm256_mul_ps( t_c0, _mm256_loadu_ps( a_i + i_coeff ) ) );
+            t_sum_q0 = _mm256_add_ps( t_sum_q0, _mm256_mul_ps( t_c0, _mm256_loadu_ps( a_q + i_coeff ) ) );
+        }
+        a_out_i = hsum_avx2( _mm256_add_ps( t_sum_i0, t_sum_i1 ) );
+        a_out_q = hsum_avx2( _mm256_add_ps( t_sum_q0, t_sum_q1 ) );
+        return;
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    static void mix_avx2( const int8_t* a_iq, size_t a_n_samples, float a_cos0, float a_sin0, const float* a_table_cos, const float* a_table_sin, float* a_i, float* a_q )
+    {
+        const __m256 t_cos0 = _mm256_set1_ps( a_cos0 );
+        const __m256 t_sin0 = _mm256_set1_ps( a_sin0 );
+        // gathers the I values of 8 pairs into the low 8 bytes, and the Q values into the high 8 bytes
+        const __m128i t_deinterleave = _mm_setr_epi8( 0, 2, 4, 6, 8, 10, 12, 14, 1, 3, 5, 7, 9, 11, 13, 15 );
+        size_t i_sample = 0;
+        for( ; i_sample + 8 <= a_n_samples; i_sample += 8 )
+        {
+            __m128i t_bytes = _mm_shuffle_epi8( _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_iq + 2*i_sample ) ), t_deinterleave );
+            __m256 t_in_i = _mm256_cvtepi32_ps( _mm256_cvtepi8_epi32( t_bytes ) );
+            __m256 t_in_q = _mm256_cvtepi32_ps( _mm256_cvtepi8_epi32( _mm_srli_si128( t_bytes, 8 ) ) );
+            __m256 t_table_cos = _mm256_loadu_ps( a_table_cos + i_sample );
+            __m256 t_table_sin = _mm256_loadu_ps( a_table_sin + i_sample );
+            __m256 t_cos = _mm256_sub_ps( _mm256_mul_ps( t_cos0, t_table_cos ), _mm256_mul_ps( t_sin0, t_table_sin ) );
+            __m256 t_sin = _mm256_add_ps( _mm256_mul_ps( t_sin0, t_table_cos ), _mm256_mul_ps( t_cos0, t_table_sin ) );
+            _mm256_storeu_ps( a_i + i_sample, _mm256_add_ps( _mm256_mul_ps( t_in_i, t_cos ), _mm256_mul_ps( t_in_q, t_sin ) ) );
+            _mm256_storeu_ps( a_q + i_sample, _mm256_sub_ps( _mm256_mul_ps( t_in_q, t_cos ), _mm256_mul_ps( t_in_i, t_sin ) ) );
+        }
+        mix_scalar( a_iq + 2*i_sample, a_n_samples - i_sample, a_cos0, a_sin0, a_table_cos + i_sample, a_table_sin + i_sample, a_i + i_sample, a_q + i_sample );
+        return;
+    }
+
+#endif /* PSYLLID_X86_KERNELS */
+
+
+    //****************
+    // iq_decimator
+    //****************
+
+    iq_decimator::iq_decimator() :
+            f_isa( active_kernel_isa() ),
+            f_taps(),
+            f_decimation( 1 ),
+            f_gain( 1. ),
+            f_n_clipped( 0 ),
+            f_offset( 0. ),
+            f_offset_block_phase( 0. ),
+            f_n_history( 0 ),
+            f_coeffs(),
+            f_hist_i(),
+            f_hist_q(),
+            f_table_cos(),
+            f_table_sin(),
+            f_out_i(),
+            f_out_q()
+    {
+        configure( 0., 1, 1, 1., 1. );
+    }
+
+    iq_decimator::~iq_decimator()
+    {
+    }
+
+    void iq_decimator::configure( double a_offset, unsigned a_decimation, unsigned a_taps_per_phase, double a_cutoff, double a_gain )
+    {
+        if( std::fabs( a_offset ) > 0.5 )
+        {
+            throw error() << "Channel offset <" << a_offset << "> cycles per sample is outside of the input band";
+        }
+        if( a_decimation == 0 || a_taps_per_phase == 0 )
+        {
+            throw error() << "Decimation factor and taps per phase must be positive";
+        }
+        if( a_cutoff <= 0. || a_cutoff > 1. )
+        {
+            throw error() << "Filter cutoff <" << a_cutoff << "> must be in (0, 1]";
+        }
+        if( a_gain < 0. )
+        {
+            throw error() << "Output gain <" << a_gain << "> must not be negative";
+        }
+
+        f_offset = a_offset;
+        f_offset_block_phase = frac( a_offset * (double)s_block_size );
+        f_decimation = a_decimation;
+
+        // windowed-sinc low-pass filter with unity gain at DC; a single tap if there's no decimation
+        unsigned t_n_taps = a_decimation == 1 ? 1 : a_taps_per_phase * a_decimation;
+        f_taps.assign( t_n_taps, 1.f );
+        if( t_n_taps > 1 )
+        {
+            double t_fc = 0.5 * a_cutoff / (double)a_decimation; // cycles per input sample
+            double t_center = 0.5 * (double)( t_n_taps - 1 );
+            double t_sum = 0.;
+            for( unsigned i_tap = 0; i_tap < t_n_taps; ++i_tap )
+            {
+                double t_x = (double)i_tap - t_center;
+                double t_sinc = t_x == 0. ? 2. * t_fc : std::sin( s_two_pi * t_fc * t_x ) / ( M_PI * t_x );
+                double t_phase = s_two_pi * (double)i_tap / (double)( t_n_taps - 1 );
+                double t_window = 0.42 - 0.5 * std::cos( t_phase ) + 0.08 * std::cos( 2. * t_phase );
+                f_taps[ i_tap ] = (float)( t_sinc * t_window );
+                t_sum += t_sinc * t_window;
+            }
+            for( float& t_tap : f_taps ) t_tap = (float)( (double)t_tap / t_sum );
+        }
+
+        if( a_gain == 0. )
+        {
+            double t_sum_sq = 0.;
+            for( float t_tap : f_taps ) t_sum_sq += (double)t_tap * (double)t_tap;
+            f_gain = 1. / std::sqrt( t_sum_sq );
+        }
+        else
+        {
+            f_gain = a_gain;
+        }
+
+        // the coefficients are the taps in reverse order, with leading zeros to make a multiple of 8
+        unsigned t_n_coeffs = ( t_n_taps + 7 ) / 8 * 8;
+        f_coeffs.assign( t_n_coeffs, 0.f );
+        for( unsigned i_tap = 0; i_tap < t_n_taps; ++i_tap )
+        {
+            f_coeffs[ t_n_coeffs - 1 - i_tap ] = f_taps[ i_tap ];
+        }
+        f_n_history = t_n_coeffs - 1;
+
+        f_hist_i.assign( f_n_history + s_block_size, 0.f );
+        f_hist_q.assign( f_n_history + s_block_size, 0.f );
+
+        f_table_cos.resize( s_block_size );
+        f_table_sin.resize( s_block_size );
+        for( size_t i_sample = 0; i_sample < s_block_size; ++i_sample )
+        {
+            double t_phase = s_two_pi * frac( a_offset * (double)i_sample );
+            f_table_cos[ i_sample ] = (float)std::cos( t_phase );
+            f_table_sin[ i_sample ] = (float)std::sin( t_phase );
+        }
+
+        f_out_i.resize( s_block_size / a_decimation + 1 );
+        f_out_q.resize( s_block_size / a_decimation + 1 );
+
+        f_n_clipped = 0;
+        return;
+    }
+
+    void iq_decimator::reset()
+    {
+        std::fill( f_hist_i.begin(), f_hist_i.end(), 0.f );
+        std::fill( f_hist_q.begin(), f_hist_q.end(), 0.f );
+        return;
+    }
+
+    void iq_decimator::mix( const int8_t* a_iq, size_t a_n_samples, uint64_t a_first_sample, float* a_i, float* a_q ) const
+    {
+        // phase of the first sample; the index is split so that the phase stays precise for large sample indices
+        uint64_t t_blocks = a_first_sample / s_block_size;
+        uint64_t t_rem = a_first_sample % s_block_size;
+        double t_phase0 = s_two_pi * frac( frac( f_offset_block_phase * (double)t_blocks ) + f_offset * (double)t_rem );
+        const float t_cos0 = (float)std::cos( t_phase0 );
+        const float t_sin0 = (float)std::sin( t_phase0 );
+
+#ifdef PSYLLID_X86_KERNELS
+        if( f_isa == kernel_isa::avx2 )
+        {
+            mix_avx2( a_iq, a_n_samples, t_cos0, t_sin0, f_table_cos.data(), f_table_sin.data(), a_i, a_q );
+            return;
+        }
+#endif
+        mix_scalar( a_iq, a_n_samples, t_cos0, t_sin0, f_table_cos.data(), f_table_sin.data(), a_i, a_q );
+        return;
+    }
+
+    size_t iq_decimator::process( const int8_t* a_iq, size_t a_n_samples, uint64_t a_first_sample, int8_t* a_out, uint64_t& a_first_out )
+    {
+        void (*t_dot2)( const float*, const float*, const float*, size_t, float&, float& ) = &dot2_scalar;
+#ifdef PSYLLID_X86_KERNELS
+        if( f_isa == kernel_isa::avx2 ) t_dot2 = &dot2_avx2;
+        else if( f_isa == kernel_isa::sse2 ) t_dot2 = &dot2_sse2;
+#endif
+
+        const float t_gain = (float)f_gain;
+        const size_t t_n_coeffs = f_coeffs.size();
+
+        a_first_out = ( a_first_sample + f_decimation - 1 ) / f_decimation;
+        size_t t_n_out = 0;
+
+        // blocks are at most s_block_size samples; the mixing table and the history buffers are that long
+        for( size_t i_block = 0; i_block < a_n_samples; i_block += s_block_size )
+        {
+            size_t t_block_size = std::min( s_block_size, a_n_samples - i_block );
+            uint64_t t_block_first = a_first_sample + i_block;
+
+            mix( a_iq + 2*i_block, t_block_size, t_block_first, f_hist_i.data() + f_n_history, f_hist_q.data() + f_n_history );
+
+            // new sample j is at f_n_history + j in the history; the output for sample j uses history samples [j, j + f_n_history]
+            size_t t_block_n_out = 0;
+            for( size_t j_sample = ( f_decimation - t_block_first % f_decimation ) % f_decimation; j_sample < t_block_size; j_sample += f_decimation )
+            {
+                t_dot2( f_coeffs.data(), f_hist_i.data() + j_sample, f_hist_q.data() + j_sample, t_n_coeffs, f_out_i[ t_block_n_out ], f_out_q[ t_block_n_out ] );
+                ++t_block_n_out;
+            }
+
+            // requantize
+            int8_t* t_out = a_out + 2*t_n_out;
+            for( size_t i_out = 0; i_out < t_block_n_out; ++i_out )
+            {
+                long t_i = lrintf( f_out_i[ i_out ] * t_gain );
+                long t_q = lrintf( f_out_q[ i_out ] * t_gain );
+                if( t_i > 127 || t_i < -128 )
+                {
+                    t_i = t_i > 127 ? 127 : -128;
+                    ++f_n_clipped;
+                }
+                if( t_q > 127 || t_q < -128 )
+                {
+                    t_q = t_q > 127 ? 127 : -128;
+                    ++f_n_clipped;
+                }
+                t_out[ 2*i_out ] = (int8_t)t_i;
+                t_out[ 2*i_out + 1 ] = (int8_t)t_q;
+            }
+            t_n_out += t_block_n_out;
+
+            // keep the end of the block as the history for the next block
+            ::memmove( f_hist_i.data(), f_hist_i.data() + t_block_size, f_n_history * sizeof( float ) );
+            ::memmove( f_hist_q.data(), f_hist_q.data() + t_block_size, f_n_history * sizeof( float ) );
+        }
+
+        return t_n_out;
+    }
+
+} /* namespace psyllid */
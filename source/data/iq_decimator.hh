@@ -0,0 +1,89 @@
+/*
+ * iq_decimator.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_IQ_DECIMATOR_HH_
+#define PSYLLID_IQ_DECIMATOR_HH_
+
+#include "spectrum_kernels.hh"
+
+#include "member_variables.hh"
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <vector>
+
+namespace psyllid
+{
+
+    /*!
+     @class iq_decimator
+     @brief Selects a sub-band of int8 IQ data: mixes it to baseband, low-pass filters it, and decimates it
+
+     @details
+     The input is interleaved (I, Q) int8 samples; the output is the same format at 1/decimation of the sample rate.
+
+     Processing steps:
+     - The band centered at offset (in cycles per input sample, relative to the center of the input band) is mixed down to baseband.
+       The mixing phase is computed from the absolute sample index, so it's continuous across calls and across gaps in the data.
+     - A windowed-sinc (Blackman) low-pass filter with taps-per-phase * decimation taps removes everything outside the output band.
+       The filter's cutoff is cutoff * (output sample rate)/2.
+     - Only every decimation-th filter output is computed; this is the same work as a polyphase filter bank for a single channel,
+       taps-per-phase multiplies per input sample.  Outputs are at the absolute sample indices that are multiples of the decimation factor.
+     - The output is scaled by gain and rounded to int8; values outside [-128, 127] are clipped and counted.
+       If the gain is 0, it's chosen so that the RMS of white noise is unchanged.
+
+     The filter uses the instruction set selected for the spectrum kernels (see active_kernel_isa()), or can be set with set_isa().
+
+     Not thread-safe.
+    */
+    class iq_decimator
+    {
+        public:
+            iq_decimator();
+            virtual ~iq_decimator();
+
+        public:
+            /// Designs the filter and clears the state; throws psyllid::error if the parameters are invalid
+            void configure( double a_offset, unsigned a_decimation, unsigned a_taps_per_phase, double a_cutoff, double a_gain );
+
+            /// Clears the filter history (e.g. after a gap in the data)
+            void reset();
+
+            /// Processes a_n_samples IQ samples, the first of which has absolute index a_first_sample.
+            /// Outputs are written to a_out (which must have room for a_n_samples / decimation + 1 samples),
+            /// and the absolute output index of the first one (i.e. its input index / decimation) is returned in a_first_out.
+            /// Returns the number of output samples.
+            size_t process( const int8_t* a_iq, size_t a_n_samples, uint64_t a_first_sample, int8_t* a_out, uint64_t& a_first_out );
+
+            mv_accessible( kernel_isa, isa );
+
+            mv_referrable_const( std::vector< float >, taps );
+            mv_accessible_noset( unsigned, decimation );
+            mv_accessible_noset( double, gain );
+            mv_accessible( uint64_t, n_clipped );
+
+        private:
+            void mix( const int8_t* a_iq, size_t a_n_samples, uint64_t a_first_sample, float* a_i, float* a_q ) const;
+
+            double f_offset; // cycles per sample
+            double f_offset_block_phase; // phase advance per s_block_size samples, in cycles
+
+            unsigned f_n_history; // number of previous samples kept for the filter
+
+            std::vector< float > f_coeffs; // time-reversed taps, with leading zeros to a multiple of 8
+            std::vector< float > f_hist_i;
+            std::vector< float > f_hist_q;
+            std::vector< float > f_table_cos;
+            std::vector< float > f_table_sin;
+            std::vector< float > f_out_i;
+            std::vector< float > f_out_q;
+
+            static const size_t s_block_size = 4096;
+    };
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_IQ_DECIMATOR_HH_ */
@@ -0,0 +1,108 @@
+/*
+ * latency_histogram.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "latency_histogram.hh"
+
+#include "param.hh"
+
+#include <cmath>
+
+namespace psyllid
+{
+
+    const unsigned latency_histogram::s_n_bins;
+
+    latency_histogram::latency_histogram() :
+            f_bins(),
+            f_count( 0 ),
+            f_sum_ns( 0 ),
+            f_max_ns( 0 )
+    {
+        reset();
+    }
+
+    latency_histogram::~latency_histogram()
+    {
+    }
+
+    void latency_histogram::reset()
+    {
+        for( std::atomic< uint64_t >& t_bin : f_bins ) t_bin.store( 0, std::memory_order_relaxed );
+        f_count.store( 0, std::memory_order_relaxed );
+        f_sum_ns.store( 0, std::memory_order_relaxed );
+        f_max_ns.store( 0, std::memory_order_relaxed );
+        return;
+    }
+
+    void latency_histogram::add( uint64_t a_latency_ns )
+    {
+        // the bin is the number of bits in the latency in us
+        uint64_t t_us = a_latency_ns / 1000;
+        unsigned t_bin = 0;
+        while( t_us != 0 && t_bin < s_n_bins - 1 )
+        {
+            t_us >>= 1;
+            ++t_bin;
+        }
+        // only one thread adds, so the updates don't need to be atomic read-modify-writes
+        f_bins[ t_bin ].store( f_bins[ t_bin ].load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+        f_count.store( f_count.load( std::memory_order_relaxed ) + 1, std::memory_order_relaxed );
+        f_sum_ns.store( f_sum_ns.load( std::memory_order_relaxed ) + a_latency_ns, std::memory_order_relaxed );
+        if( a_latency_ns > f_max_ns.load( std::memory_order_relaxed ) ) f_max_ns.store( a_latency_ns, std::memory_order_relaxed );
+        return;
+    }
+
+    double latency_histogram::get_mean_us() const
+    {
+        uint64_t t_count = get_count();
+        if( t_count == 0 ) return 0.;
+        return 1.e-3 * (double)f_sum_ns.load( std::memory_order_relaxed ) / (double)t_count;
+    }
+
+    double latency_histogram::get_max_us() const
+    {
+        return 1.e-3 * (double)f_max_ns.load( std::memory_order_relaxed );
+    }
+
+    double latency_histogram::get_percentile_us( double a_fraction ) const
+    {
+        std::array< uint64_t, s_n_bins > t_bins;
+        uint64_t t_count = 0;
+        for( unsigned i_bin = 0; i_bin < s_n_bins; ++i_bin )
+        {
+            t_bins[ i_bin ] = f_bins[ i_bin ].load( std::memory_order_relaxed );
+            t_count += t_bins[ i_bin ];
+        }
+        if( t_count == 0 ) return 0.;
+
+        uint64_t t_rank = (uint64_t)std::ceil( a_fraction * (double)t_count );
+        uint64_t t_cumulative = 0;
+        for( unsigned i_bin = 0; i_bin < s_n_bins; ++i_bin )
+        {
+            t_cumulative += t_bins[ i_bin ];
+            if( t_cumulative >= t_rank ) return std::ldexp( 1., (int)i_bin );
+        }
+        return std::ldexp( 1., (int)s_n_bins - 1 );
+    }
+
+    void latency_histogram::fill_status( scarab::param_node& a_status ) const
+    {
+        a_status.add( "count", get_count() );
+        a_status.add( "mean-us", get_mean_us() );
+        a_status.add( "p50-us", get_percentile_us( 0.5 ) );
+        a_status.add( "p99-us", get_percentile_us( 0.99 ) );
+        a_status.add( "p999-us", get_percentile_us( 0.999 ) );
+        a_status.add( "max-us", get_max_us() );
+        scarab::param_array t_bins;
+        for( const std::atomic< uint64_t >& t_bin : f_bins )
+        {
+            t_bins.push_back( scarab::param_value( t_bin.load( std::memory_order_relaxed ) ) );
+        }
+        a_status.add( "bins", t_bins );
+        return;
+    }
+
+} /* namespace psyllid */
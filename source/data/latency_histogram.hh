@@ -0,0 +1,76 @@
+/*
+ * latency_histogram.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_LATENCY_HISTOGRAM_HH_
+#define PSYLLID_LATENCY_HISTOGRAM_HH_
+
+#include <array>
+#include <atomic>
+#include <cstdint>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace psyllid
+{
+
+    /*!
+     @class latency_histogram
+     @brief Distribution of latencies in logarithmic bins, which can be read from other threads without locking
+
+     @details
+     Bin 0 holds latencies under 1 us; bin i holds latencies from 2^(i-1) us up to 2^i us; the last bin also holds anything longer.
+     Percentiles are given as the upper edge of the bin they fall in, so they're accurate to within a factor of 2.
+
+     add() may only be called by one thread; reset() must not be called while add() might be.
+     fill_status() and the getters may be called at any time from any thread; the values they return may be from slightly different moments.
+
+     The status contains:
+     - "count": uint -- number of latencies recorded
+     - "mean-us": double -- mean latency
+     - "p50-us", "p99-us", "p999-us": double -- 50th, 99th and 99.9th percentile latencies (upper edge of the bin)
+     - "max-us": double -- longest latency
+     - "bins": array of uint -- number of latencies in each bin
+    */
+    class latency_histogram
+    {
+        public:
+            static const unsigned s_n_bins = 32;
+
+        public:
+            latency_histogram();
+            ~latency_histogram();
+
+            void reset();
+
+            void add( uint64_t a_latency_ns );
+
+            uint64_t get_count() const;
+            double get_mean_us() const;
+            double get_max_us() const;
+            /// Upper edge of the bin that holds the a_fraction quantile
+            double get_percentile_us( double a_fraction ) const;
+
+            /// Fills a_status with the summary described above
+            void fill_status( scarab::param_node& a_status ) const;
+
+        private:
+            std::array< std::atomic< uint64_t >, s_n_bins > f_bins;
+            std::atomic< uint64_t > f_count;
+            std::atomic< uint64_t > f_sum_ns;
+            std::atomic< uint64_t > f_max_ns;
+    };
+
+    inline uint64_t latency_histogram::get_count() const
+    {
+        return f_count.load( std::memory_order_relaxed );
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_LATENCY_HISTOGRAM_HH_ */
@@ -0,0 +1,133 @@
+/*
+ * packet_ring.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "packet_ring.hh"
+
+#include "psyllid_error.hh"
+
+#include <cstring>
+
+namespace psyllid
+{
+
+    packet_ring::packet_ring() :
+            f_n_slots( 0 ),
+            f_buffer(),
+            f_payloads( nullptr ),
+            f_info(),
+            f_n_written( 0 ),
+            f_newest_id( 0 ),
+            f_writing_id( 0 ),
+            f_generation( 0 )
+    {
+    }
+
+    packet_ring::~packet_ring()
+    {
+        release();
+    }
+
+    void packet_ring::allocate( size_t a_n_slots, bool a_use_huge_pages )
+    {
+        if( a_n_slots == 0 )
+        {
+            throw error() << "Packet ring must have at least one slot";
+        }
+        release();
+
+        // the ring has to fill the buffer exactly so that slot indices wrap at the same place as the mirrored mapping
+        size_t t_granularity = mirrored_buffer::granularity( a_use_huge_pages );
+        size_t t_slot_granularity = t_granularity > PAYLOAD_SIZE ? t_granularity / PAYLOAD_SIZE : 1;
+        size_t t_n_slots = ( a_n_slots + t_slot_granularity - 1 ) / t_slot_granularity * t_slot_granularity;
+
+        f_buffer.allocate( t_n_slots * PAYLOAD_SIZE, a_use_huge_pages );
+        if( f_buffer.size() % PAYLOAD_SIZE != 0 )
+        {
+            size_t t_size = f_buffer.size();
+            release();
+            throw error() << "Packet ring buffer size (" << t_size << " bytes) is not a multiple of the packet size";
+        }
+        f_payloads = reinterpret_cast< int8_t* >( f_buffer.data() );
+        f_n_slots = f_buffer.size() / PAYLOAD_SIZE;
+
+        f_info.reset( new slot_info[ f_n_slots ] );
+        clear();
+        return;
+    }
+
+    void packet_ring::clear()
+    {
+        // the new generation is visible to any reader that sees a packet written after the clear
+        f_generation.fetch_add( 1 );
+
+        // IDs that can never match a slot, so that has() is false until each slot is written
+        for( size_t i_slot = 0; i_slot < f_n_slots; ++i_slot )
+        {
+            f_info[ i_slot ].f_id.store( UINT64_MAX, std::memory_order_relaxed );
+            f_info[ i_slot ].f_unix_time = 0;
+            f_info[ i_slot ].f_pkt_in_batch = 0;
+        }
+        f_n_written.store( 0, std::memory_order_release );
+        f_newest_id.store( 0, std::memory_order_release );
+        f_writing_id.store( 0, std::memory_order_release );
+        return;
+    }
+
+    void packet_ring::release()
+    {
+        f_buffer.release();
+        f_payloads = nullptr;
+        f_n_slots = 0;
+        f_info.reset();
+        return;
+    }
+
+    size_t packet_ring::n_slots_for_events( uint64_t a_pretrigger, uint64_t a_skip_tolerance, uint64_t a_latency )
+    {
+        // the packet that satisfies the trigger, plus the pretrigger and skip-tolerance packets that may be added to the event
+        // before the trigger decision is made, plus the packets that arrive while the decision is being made
+        return 1 + a_pretrigger + a_skip_tolerance + a_latency;
+    }
+
+    void packet_ring::write( const time_data& a_data )
+    {
+        uint64_t t_id = a_data.get_pkt_in_session();
+        size_t t_slot = slot( t_id );
+
+        // announce the write before the slot is touched, so that readers of the packet being replaced can detect it
+        f_writing_id.store( t_id, std::memory_order_relaxed );
+        std::atomic_thread_fence( std::memory_order_release );
+
+        ::memcpy( f_payloads + t_slot * PAYLOAD_SIZE, a_data.get_raw_array(), PAYLOAD_SIZE );
+        f_info[ t_slot ].f_unix_time = a_data.get_unix_time();
+        f_info[ t_slot ].f_pkt_in_batch = a_data.get_pkt_in_batch();
+        f_info[ t_slot ].f_id.store( t_id, std::memory_order_release );
+
+        f_newest_id.store( t_id, std::memory_order_release );
+        f_n_written.fetch_add( 1, std::memory_order_release );
+        return;
+    }
+
+    bool packet_ring::get_event_span( const id_range_event& a_event, span& a_span ) const
+    {
+        uint64_t t_start_id = a_event.get_start_id();
+        uint64_t t_end_id = a_event.get_end_id();
+        if( t_end_id < t_start_id || ! is_available( t_start_id ) || t_end_id > get_newest_id() ) return false;
+
+        // every packet in the event has to be present; slots skipped over by dropped packets hold older data
+        for( uint64_t t_id = t_start_id; t_id <= t_end_id; ++t_id )
+        {
+            if( f_info[ slot( t_id ) ].f_id.load( std::memory_order_acquire ) != t_id ) return false;
+        }
+
+        // the mirrored mapping makes the event contiguous even if it wraps around the end of the ring
+        a_span.f_first_id = t_start_id;
+        a_span.f_n_packets = t_end_id - t_start_id + 1;
+        a_span.f_payload = window( t_start_id );
+        return true;
+    }
+
+} /* namespace psyllid */
@@ -0,0 +1,207 @@
+/*
+ * packet_ring.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_PACKET_RING_HH_
+#define PSYLLID_PACKET_RING_HH_
+
+#include "id_range_event.hh"
+#include "time_data.hh"
+
+#include "mirrored_buffer.hh"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+namespace psyllid
+{
+
+    /*!
+     @class packet_ring
+     @brief Preallocated ring of time-packet payloads, indexed by packet ID
+
+     @details
+     Each packet is stored in the slot given by its ID (pkt_in_session) modulo the number of slots,
+     so a packet can be found from its ID alone, and an id_range_event maps directly onto a range of slots.
+     Events can then refer to packets in the ring instead of copying them: a writer looks up the slots for an event
+     and reads the payloads in place, as long as it does so before they're overwritten.
+
+     Payloads are stored back-to-back (PAYLOAD_SIZE bytes each) in a mirrored_buffer, which maps the ring twice in a row in virtual memory.
+     Any range of up to get_n_slots() consecutive packets is therefore one contiguous block of IQ samples, even where it wraps around
+     the end of the ring; get_event_span() and window() return pointers into the ring that can be read without splitting or copying.
+
+     For event building, the ring must hold at least pretrigger + skip-tolerance packets, plus a margin for the latency of the trigger decision;
+     see n_slots_for_events().
+
+     The payload memory can optionally be backed by huge pages, which reduces TLB pressure for large rings;
+     if huge pages are not available, normal pages are used.  The number of slots is rounded up to fill a whole number of pages
+     (256 slots for 2 MB huge pages).
+
+     Thread safety: one thread writes to the ring; any number of threads may read.  Readers should check is_intact() for the oldest ID
+     they read, after reading, to verify that the data were not overwritten while being read.
+     Since IDs can restart after clear(), a reader that may overlap a clear should also check, after is_intact(), that get_generation()
+     hasn't changed since it started.
+    */
+    class packet_ring
+    {
+        public:
+            struct span
+            {
+                uint64_t f_first_id;
+                size_t f_n_packets;
+                const int8_t* f_payload; // f_n_packets * PAYLOAD_SIZE contiguous bytes
+            };
+
+        public:
+            packet_ring();
+            virtual ~packet_ring();
+
+            packet_ring( const packet_ring& ) = delete;
+            packet_ring& operator=( const packet_ring& ) = delete;
+
+            /// Allocates the ring with at least a_n_slots slots; any existing contents are discarded
+            void allocate( size_t a_n_slots, bool a_use_huge_pages = false );
+            /// Marks all slots as empty without releasing the memory, and starts a new generation
+            void clear();
+            /// Number of times the ring has been cleared
+            uint64_t get_generation() const;
+
+            /// Number of slots needed to build events with the given pretrigger and skip tolerance, with room for a_latency packets of trigger latency
+            static size_t n_slots_for_events( uint64_t a_pretrigger, uint64_t a_skip_tolerance, uint64_t a_latency );
+
+            size_t get_n_slots() const;
+            /// Returns true if the payload memory is backed by explicitly-allocated huge pages
+            bool uses_huge_pages() const;
+
+            /// Copies the packet payload into the slot for its ID; packets must be written in increasing ID order
+            void write( const time_data& a_data );
+
+            /// Returns true if packets at and after a_id (up to the newest) are still in the ring
+            bool is_available( uint64_t a_id ) const;
+
+            /// ID of the most recently written packet; only valid if !empty()
+            uint64_t get_newest_id() const;
+            /// ID of the oldest packet still in the ring; only valid if !empty()
+            uint64_t get_oldest_id() const;
+            bool empty() const;
+
+            /// Returns true if the packet with the given ID is in the ring (it was written and has not been overwritten)
+            bool has( uint64_t a_id ) const;
+            /// Payload of the packet with the given ID; check has() first
+            const int8_t* payload( uint64_t a_id ) const;
+            /// Slot information for the packet with the given ID; check has() first
+            uint32_t get_unix_time( uint64_t a_id ) const;
+            uint32_t get_pkt_in_batch( uint64_t a_id ) const;
+
+            /// Returns true if the packet with the given ID has not been overwritten, and is not being overwritten.
+            /// Call this after reading a payload to check that the copy is valid.
+            bool is_intact( uint64_t a_id ) const;
+
+            /// Contiguous payloads of up to get_n_slots() packets, starting with the packet with the given ID; the range is not checked
+            const int8_t* window( uint64_t a_first_id ) const;
+
+            /// Fills the span of contiguous payloads covering the event.
+            /// Returns false if any part of the event is no longer (or not yet) in the ring, or if the event is longer than the ring.
+            bool get_event_span( const id_range_event& a_event, span& a_span ) const;
+
+        private:
+            size_t slot( uint64_t a_id ) const;
+            void release();
+
+            struct slot_info
+            {
+                std::atomic< uint64_t > f_id; // stored (release) after the payload and the rest of the slot info
+                uint32_t f_unix_time;
+                uint32_t f_pkt_in_batch;
+            };
+
+            size_t f_n_slots;
+            mirrored_buffer f_buffer;
+            int8_t* f_payloads;
+            std::unique_ptr< slot_info[] > f_info;
+
+            std::atomic< uint64_t > f_n_written;
+            std::atomic< uint64_t > f_newest_id;
+            std::atomic< uint64_t > f_writing_id;
+            std::atomic< uint64_t > f_generation;
+    };
+
+    inline size_t packet_ring::get_n_slots() const
+    {
+        return f_n_slots;
+    }
+
+    inline bool packet_ring::uses_huge_pages() const
+    {
+        return f_buffer.uses_huge_pages();
+    }
+
+    inline size_t packet_ring::slot( uint64_t a_id ) const
+    {
+        return a_id % f_n_slots;
+    }
+
+    inline uint64_t packet_ring::get_generation() const
+    {
+        return f_generation.load( std::memory_order_acquire );
+    }
+
+    inline bool packet_ring::empty() const
+    {
+        return f_n_written.load( std::memory_order_acquire ) == 0;
+    }
+
+    inline uint64_t packet_ring::get_newest_id() const
+    {
+        return f_newest_id.load( std::memory_order_acquire );
+    }
+
+    inline uint64_t packet_ring::get_oldest_id() const
+    {
+        uint64_t t_newest = get_newest_id();
+        return t_newest + 1 > f_n_slots ? t_newest + 1 - f_n_slots : 0;
+    }
+
+    inline bool packet_ring::is_available( uint64_t a_id ) const
+    {
+        return ! empty() && a_id >= get_oldest_id();
+    }
+
+    inline bool packet_ring::has( uint64_t a_id ) const
+    {
+        return is_available( a_id ) && a_id <= get_newest_id() && f_info[ slot( a_id ) ].f_id.load( std::memory_order_acquire ) == a_id;
+    }
+
+    inline bool packet_ring::is_intact( uint64_t a_id ) const
+    {
+        // the writer announces each ID before overwriting its slot; a slot for a_id is safe until the writer reaches a_id + n-slots
+        std::atomic_thread_fence( std::memory_order_acquire );
+        return f_info[ slot( a_id ) ].f_id.load( std::memory_order_acquire ) == a_id && f_writing_id.load( std::memory_order_relaxed ) < a_id + f_n_slots;
+    }
+
+    inline const int8_t* packet_ring::payload( uint64_t a_id ) const
+    {
+        return f_payloads + slot( a_id ) * PAYLOAD_SIZE;
+    }
+
+    inline const int8_t* packet_ring::window( uint64_t a_first_id ) const
+    {
+        return payload( a_first_id );
+    }
+
+    inline uint32_t packet_ring::get_unix_time( uint64_t a_id ) const
+    {
+        return f_info[ slot( a_id ) ].f_unix_time;
+    }
+
+    inline uint32_t packet_ring::get_pkt_in_batch( uint64_t a_id ) const
+    {
+        return f_info[ slot( a_id ) ].f_pkt_in_batch;
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_PACKET_RING_HH_ */
@@ -0,0 +1,253 @@
+/*
+ * psyllid_shm_tap.h
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Layout of the shared-memory packet ring published by psyllid's shm-tap nodes, and functions for reading it.
+ *  This header is plain C (C99 with the GCC/Clang __atomic builtins) so that analysis programs can use it without psyllid;
+ *  psyllid's writer (shm_packet_ring) uses the same definitions.
+ *
+ *  The ring is a POSIX shared-memory object containing:
+ *   - a header (struct psyllid_shm_tap_header)
+ *   - PSYLLID_SHM_TAP_MAX_READERS reader entries (struct psyllid_shm_tap_reader_entry)
+ *   - n_slots packet slots (struct psyllid_shm_tap_slot), starting at slots_offset
+ *
+ *  Every packet published gets a sequence number (0, 1, 2, ...), and is written to slot (sequence % n_slots).
+ *  The writer never waits for readers: a reader that falls more than n_slots packets behind loses the packets that were overwritten,
+ *  and counts them in its entry (n_overruns) when it skips over them.  Psyllid reports each reader's overruns in the node status,
+ *  including the packets a stalled reader has not yet noticed it lost (lag beyond n_slots).
+ *
+ *  Readers read packets in place (zero copy):
+ *
+ *      struct psyllid_shm_tap_reader reader;
+ *      if( psyllid_shm_tap_open( &reader, "/psyllid_tap" ) != 0 ) { perror( "psyllid_shm_tap_open" ); return 1; }
+ *      while( running )
+ *      {
+ *          const struct psyllid_shm_tap_slot* slot = psyllid_shm_tap_peek( &reader );
+ *          if( slot == NULL ) { usleep( 100 ); continue; }
+ *          ... process slot->payload (PSYLLID_SHM_TAP_PAYLOAD_SIZE bytes of int8 I,Q pairs) ...
+ *          if( ! psyllid_shm_tap_done( &reader ) ) { ... the packet was overwritten while it was being processed; discard the results ... }
+ *      }
+ *      psyllid_shm_tap_close( &reader );
+ *
+ *  Each process (or thread) that reads needs its own psyllid_shm_tap_reader; each one gets every packet.
+ *  Readers need read-write access to the shared-memory object, since they record their position in their reader entry.
+ *  In strict C modes, define _POSIX_C_SOURCE as 200809L (or _GNU_SOURCE) before including system headers; link with -lrt on older systems.
+ */
+
+#ifndef PSYLLID_SHM_TAP_H_
+#define PSYLLID_SHM_TAP_H_
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+#include <unistd.h>
+
+#define PSYLLID_SHM_TAP_MAGIC 0x50414854u /* "THAP" in little-endian byte order */
+#define PSYLLID_SHM_TAP_VERSION 1u
+#define PSYLLID_SHM_TAP_PAYLOAD_SIZE 8192u
+#define PSYLLID_SHM_TAP_MAX_READERS 16u
+
+/* values of psyllid_shm_tap_header.data_type */
+#define PSYLLID_SHM_TAP_TIME_DATA 0u
+#define PSYLLID_SHM_TAP_FREQ_DATA 1u
+
+/* value of psyllid_shm_tap_slot.sequence while the slot is being written */
+#define PSYLLID_SHM_TAP_WRITING UINT64_MAX
+
+struct psyllid_shm_tap_header
+{
+    uint32_t magic; /* PSYLLID_SHM_TAP_MAGIC */
+    uint32_t version; /* PSYLLID_SHM_TAP_VERSION */
+    uint32_t data_type; /* PSYLLID_SHM_TAP_TIME_DATA or PSYLLID_SHM_TAP_FREQ_DATA */
+    uint32_t max_readers; /* number of reader entries */
+    uint64_t n_slots;
+    uint64_t slot_size; /* bytes */
+    uint64_t slots_offset; /* bytes from the start of the shared memory to the first slot */
+    int32_t writer_pid;
+    uint32_t closed; /* atomic; set to 1 when the writer shuts down; no more packets will be published */
+    uint64_t n_published; /* atomic; number of packets published; the newest has sequence number n_published - 1 */
+    uint64_t reserved;
+};
+
+struct psyllid_shm_tap_reader_entry
+{
+    int32_t pid; /* atomic; process ID of the reader using this entry, or 0 if the entry is free */
+    uint32_t reserved_0;
+    uint64_t next; /* atomic; sequence number of the next packet the reader will read (written by the reader) */
+    uint64_t n_read; /* atomic; number of packets read intact (written by the reader) */
+    uint64_t n_overruns; /* atomic; number of packets overwritten before the reader read them (written by the reader) */
+    uint64_t reserved_1[ 4 ];
+};
+
+struct psyllid_shm_tap_slot
+{
+    uint64_t sequence; /* atomic; sequence number of the packet in the slot, or PSYLLID_SHM_TAP_WRITING */
+    uint64_t pkt_in_session;
+    uint32_t unix_time;
+    uint32_t pkt_in_batch;
+    uint32_t digital_id;
+    uint32_t if_id;
+    uint32_t user_data_1;
+    uint32_t user_data_0;
+    uint64_t reserved_0;
+    uint64_t reserved_1;
+    uint32_t freq_not_time;
+    uint32_t padding;
+    int8_t payload[ PSYLLID_SHM_TAP_PAYLOAD_SIZE ]; /* interleaved int8 I, Q pairs */
+};
+
+/* Size of the shared memory for a ring with a_n_slots slots */
+static inline size_t psyllid_shm_tap_size( uint64_t a_n_slots )
+{
+    return sizeof( struct psyllid_shm_tap_header ) + PSYLLID_SHM_TAP_MAX_READERS * sizeof( struct psyllid_shm_tap_reader_entry ) +
+            a_n_slots * sizeof( struct psyllid_shm_tap_slot );
+}
+
+
+struct psyllid_shm_tap_reader
+{
+    void* map;
+    size_t map_size;
+    const struct psyllid_shm_tap_header* header;
+    struct psyllid_shm_tap_reader_entry* entry;
+    const char* slots;
+    uint64_t next;
+};
+
+static inline const struct psyllid_shm_tap_slot* psyllid_shm_tap_slot_at( const struct psyllid_shm_tap_reader* a_reader, uint64_t a_sequence )
+{
+    return (const struct psyllid_shm_tap_slot*)( a_reader->slots + ( a_sequence % a_reader->header->n_slots ) * a_reader->header->slot_size );
+}
+
+/* Adds to one of the reader's counters; only the reader writes them, so no read-modify-write is needed */
+static inline void psyllid_shm_tap_count( uint64_t* a_counter, uint64_t a_n )
+{
+    __atomic_store_n( a_counter, __atomic_load_n( a_counter, __ATOMIC_RELAXED ) + a_n, __ATOMIC_RELAXED );
+    return;
+}
+
+/* Maps the ring with the given shared-memory name and claims a reader entry; reading starts with the next packet published.
+   Returns 0 on success, or -1 with errno set (EPROTO if the ring's format is not recognized; EBUSY if all reader entries are in use). */
+static inline int psyllid_shm_tap_open( struct psyllid_shm_tap_reader* a_reader, const char* a_name )
+{
+    struct stat t_stat;
+    unsigned i_entry;
+    int32_t t_pid = (int32_t)getpid();
+    int t_fd = shm_open( a_name, O_RDWR, 0 );
+    if( t_fd < 0 ) return -1;
+    if( fstat( t_fd, &t_stat ) != 0 || (size_t)t_stat.st_size < sizeof( struct psyllid_shm_tap_header ) )
+    {
+        close( t_fd );
+        errno = EPROTO;
+        return -1;
+    }
+
+    memset( a_reader, 0, sizeof( *a_reader ) );
+    a_reader->map_size = (size_t)t_stat.st_size;
+    a_reader->map = mmap( NULL, a_reader->map_size, PROT_READ | PROT_WRITE, MAP_SHARED, t_fd, 0 );
+    close( t_fd );
+    if( a_reader->map == MAP_FAILED ) return -1;
+
+    a_reader->header = (const struct psyllid_shm_tap_header*)a_reader->map;
+    if( __atomic_load_n( &a_reader->header->magic, __ATOMIC_ACQUIRE ) != PSYLLID_SHM_TAP_MAGIC || a_reader->header->version != PSYLLID_SHM_TAP_VERSION ||
+            a_reader->header->slot_size != sizeof( struct psyllid_shm_tap_slot ) || a_reader->map_size < psyllid_shm_tap_size( a_reader->header->n_slots ) )
+    {
+        munmap( a_reader->map, a_reader->map_size );
+        errno = EPROTO;
+        return -1;
+    }
+    a_reader->slots = (const char*)a_reader->map + a_reader->header->slots_offset;
+
+    /* claim a free entry, or one left behind by a reader that no longer exists */
+    for( i_entry = 0; i_entry < a_reader->header->max_readers && a_reader->entry == NULL; ++i_entry )
+    {
+        struct psyllid_shm_tap_reader_entry* t_entry = (struct psyllid_shm_tap_reader_entry*)
+                ( (char*)a_reader->map + sizeof( struct psyllid_shm_tap_header ) ) + i_entry;
+        int32_t t_owner = __atomic_load_n( &t_entry->pid, __ATOMIC_ACQUIRE );
+        if( t_owner != 0 && ( kill( t_owner, 0 ) == 0 || errno != ESRCH ) ) continue;
+        if( __atomic_compare_exchange_n( &t_entry->pid, &t_owner, t_pid, 0, __ATOMIC_ACQ_REL, __ATOMIC_ACQUIRE ) ) a_reader->entry = t_entry;
+    }
+    if( a_reader->entry == NULL )
+    {
+        munmap( a_reader->map, a_reader->map_size );
+        errno = EBUSY;
+        return -1;
+    }
+
+    a_reader->next = __atomic_load_n( &a_reader->header->n_published, __ATOMIC_ACQUIRE );
+    __atomic_store_n( &a_reader->entry->next, a_reader->next, __ATOMIC_RELEASE );
+    __atomic_store_n( &a_reader->entry->n_read, 0, __ATOMIC_RELAXED );
+    __atomic_store_n( &a_reader->entry->n_overruns, 0, __ATOMIC_RELAXED );
+    return 0;
+}
+
+/* Releases the reader entry and unmaps the ring */
+static inline void psyllid_shm_tap_close( struct psyllid_shm_tap_reader* a_reader )
+{
+    if( a_reader->map == NULL ) return;
+    __atomic_store_n( &a_reader->entry->pid, 0, __ATOMIC_RELEASE );
+    munmap( a_reader->map, a_reader->map_size );
+    memset( a_reader, 0, sizeof( *a_reader ) );
+    return;
+}
+
+/* Returns the next packet, or NULL if there is no new packet.
+   If the reader has fallen behind, it skips ahead past the packets that were overwritten (they are counted in n_overruns).
+   The slot may be read in place until psyllid_shm_tap_done() is called. */
+static inline const struct psyllid_shm_tap_slot* psyllid_shm_tap_peek( struct psyllid_shm_tap_reader* a_reader )
+{
+    for( ;; )
+    {
+        const struct psyllid_shm_tap_slot* t_slot;
+        uint64_t t_n_published = __atomic_load_n( &a_reader->header->n_published, __ATOMIC_ACQUIRE );
+        if( a_reader->next >= t_n_published ) return NULL;
+        if( t_n_published - a_reader->next > a_reader->header->n_slots )
+        {
+            psyllid_shm_tap_count( &a_reader->entry->n_overruns, t_n_published - a_reader->header->n_slots - a_reader->next );
+            a_reader->next = t_n_published - a_reader->header->n_slots;
+            __atomic_store_n( &a_reader->entry->next, a_reader->next, __ATOMIC_RELEASE );
+        }
+        t_slot = psyllid_shm_tap_slot_at( a_reader, a_reader->next );
+        if( __atomic_load_n( &t_slot->sequence, __ATOMIC_ACQUIRE ) == a_reader->next ) return t_slot;
+        /* the slot is being overwritten, so the packet was lost */
+        psyllid_shm_tap_count( &a_reader->entry->n_overruns, 1 );
+        ++a_reader->next;
+        __atomic_store_n( &a_reader->entry->next, a_reader->next, __ATOMIC_RELEASE );
+    }
+}
+
+/* Finishes with the packet returned by psyllid_shm_tap_peek() and moves on to the next one.
+   Returns 1 if the packet was intact the whole time it was being read, or 0 if it was overwritten (and the data read are not valid). */
+static inline int psyllid_shm_tap_done( struct psyllid_shm_tap_reader* a_reader )
+{
+    const struct psyllid_shm_tap_slot* t_slot = psyllid_shm_tap_slot_at( a_reader, a_reader->next );
+    int t_intact;
+    __atomic_thread_fence( __ATOMIC_ACQUIRE );
+    t_intact = __atomic_load_n( &t_slot->sequence, __ATOMIC_RELAXED ) == a_reader->next;
+    ++a_reader->next;
+    __atomic_store_n( &a_reader->entry->next, a_reader->next, __ATOMIC_RELEASE );
+    if( t_intact ) psyllid_shm_tap_count( &a_reader->entry->n_read, 1 );
+    else psyllid_shm_tap_count( &a_reader->entry->n_overruns, 1 );
+    return t_intact;
+}
+
+/* Number of packets this reader has lost because they were overwritten before it read them (as of its last call to peek or done) */
+static inline uint64_t psyllid_shm_tap_overruns( const struct psyllid_shm_tap_reader* a_reader )
+{
+    return __atomic_load_n( &a_reader->entry->n_overruns, __ATOMIC_RELAXED );
+}
+
+/* Returns nonzero if the writer has shut down */
+static inline int psyllid_shm_tap_closed( const struct psyllid_shm_tap_reader* a_reader )
+{
+    return (int)__atomic_load_n( &a_reader->header->closed, __ATOMIC_ACQUIRE );
+}
+
+#endif /* PSYLLID_SHM_TAP_H_ */
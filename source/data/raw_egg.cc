@@ -0,0 +1,592 @@
+/*
+ * raw_egg.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "raw_egg.hh"
+
+#include "psyllid_error.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+
+namespace psyllid
+{
+
+    namespace
+    {
+        const char s_magic[ 8 ] = { 'P', 'S', 'Y', 'R', 'A', 'W', 'E', 'G' };
+
+        const size_t s_source_offset = 128;
+        const size_t s_source_size = 64;
+        const size_t s_timestamp_offset = 192;
+        const size_t s_timestamp_size = 64;
+        const size_t s_filename_offset = 256;
+        const size_t s_filename_size = 512;
+        const size_t s_description_length_offset = 768;
+        const size_t s_description_offset = 772;
+
+        template< typename x_type >
+        void put( char* a_block, size_t a_offset, x_type a_value )
+        {
+            ::memcpy( a_block + a_offset, &a_value, sizeof( x_type ) );
+            return;
+        }
+
+        template< typename x_type >
+        x_type get( const char* a_block, size_t a_offset )
+        {
+            x_type t_value;
+            ::memcpy( &t_value, a_block + a_offset, sizeof( x_type ) );
+            return t_value;
+        }
+
+        // copies up to a_size - 1 characters, so that the string is always null-terminated
+        void put_string( char* a_block, size_t a_offset, size_t a_size, const std::string& a_string )
+        {
+            ::memcpy( a_block + a_offset, a_string.data(), std::min( a_string.size(), a_size - 1 ) );
+            return;
+        }
+
+        std::string get_string( const char* a_block, size_t a_offset, size_t a_size )
+        {
+            const char* t_start = a_block + a_offset;
+            return std::string( t_start, std::find( t_start, t_start + a_size, '\0' ) );
+        }
+
+        void read_fully( int a_fd, char* a_buffer, size_t a_bytes, uint64_t a_offset, const std::string& a_filename )
+        {
+            while( a_bytes > 0 )
+            {
+                ssize_t t_read = ::pread( a_fd, a_buffer, a_bytes, (off_t)a_offset );
+                if( t_read < 0 && errno == EINTR ) continue;
+                if( t_read < 0 )
+                {
+                    throw error() << "Unable to read raw egg file <" << a_filename << ">: " << strerror( errno );
+                }
+                if( t_read == 0 )
+                {
+                    throw error() << "Raw egg file <" << a_filename << "> ends unexpectedly at byte " << a_offset;
+                }
+                a_buffer += t_read;
+                a_bytes -= t_read;
+                a_offset += t_read;
+            }
+            return;
+        }
+    }
+
+
+    //******************
+    // raw_egg_header
+    //******************
+
+    const size_t raw_egg_header::s_size;
+    const uint32_t raw_egg_header::s_version;
+
+    const uint32_t raw_egg_index_entry::s_valid;
+    const uint32_t raw_egg_index_entry::s_new_acq;
+    const uint32_t raw_egg_index_entry::s_compressed;
+
+    raw_egg_header::raw_egg_header() :
+            f_record_bytes( 0 ),
+            f_capacity( 0 ),
+            f_n_records( 0 ),
+            f_index_offset( 0 ),
+            f_state( state::writing ),
+            f_source(),
+            f_acq_rate( 0 ),
+            f_record_size( 0 ),
+            f_sample_size( 0 ),
+            f_data_type_size( 0 ),
+            f_data_format( 0 ),
+            f_bit_depth( 0 ),
+            f_bit_alignment( 0 ),
+            f_v_offset( 0. ),
+            f_v_range( 0. ),
+            f_dac_gain( 0. ),
+            f_freq_min( 0. ),
+            f_freq_range( 0. ),
+            f_filename(),
+            f_timestamp(),
+            f_description(),
+            f_run_duration( 0 ),
+            f_compression( record_compression::none )
+    {
+    }
+
+    void raw_egg_header::encode( char* a_block ) const
+    {
+        ::memset( a_block, 0, s_size );
+        ::memcpy( a_block, s_magic, sizeof( s_magic ) );
+        put< uint32_t >( a_block, 8, s_version );
+        put< uint32_t >( a_block, 12, s_size );
+        put< uint32_t >( a_block, 16, f_record_bytes );
+        put< uint32_t >( a_block, 20, sizeof( raw_egg_index_entry ) );
+        put< uint64_t >( a_block, 24, f_capacity );
+        put< uint64_t >( a_block, 32, f_n_records );
+        put< uint64_t >( a_block, 40, f_index_offset );
+        put< uint32_t >( a_block, 48, static_cast< uint32_t >( f_state ) );
+        put< uint32_t >( a_block, 52, f_acq_rate );
+        put< uint32_t >( a_block, 56, f_record_size );
+        put< uint32_t >( a_block, 60, f_sample_size );
+        put< uint32_t >( a_block, 64, f_data_type_size );
+        put< uint32_t >( a_block, 68, f_data_format );
+        put< uint32_t >( a_block, 72, f_bit_depth );
+        put< uint32_t >( a_block, 76, f_bit_alignment );
+        put< uint32_t >( a_block, 80, f_run_duration );
+        put< uint32_t >( a_block, 84, static_cast< uint32_t >( f_compression ) );
+        put< double >( a_block, 88, f_v_offset );
+        put< double >( a_block, 96, f_v_range );
+        put< double >( a_block, 104, f_dac_gain );
+        put< double >( a_block, 112, f_freq_min );
+        put< double >( a_block, 120, f_freq_range );
+        put_string( a_block, s_source_offset, s_source_size, f_source );
+        put_string( a_block, s_timestamp_offset, s_timestamp_size, f_timestamp );
+        put_string( a_block, s_filename_offset, s_filename_size, f_filename );
+        uint32_t t_desc_length = std::min( f_description.size(), s_size - s_description_offset );
+        put< uint32_t >( a_block, s_description_length_offset, t_desc_length );
+        ::memcpy( a_block + s_description_offset, f_description.data(), t_desc_length );
+        return;
+    }
+
+    void raw_egg_header::decode( const char* a_block )
+    {
+        if( ::memcmp( a_block, s_magic, sizeof( s_magic ) ) != 0 )
+        {
+            throw error() << "Not a raw egg file";
+        }
+        uint32_t t_version = get< uint32_t >( a_block, 8 );
+        if( t_version != s_version )
+        {
+            throw error() << "Unknown raw egg file version: " << t_version;
+        }
+        if( get< uint32_t >( a_block, 12 ) != s_size || get< uint32_t >( a_block, 20 ) != sizeof( raw_egg_index_entry ) )
+        {
+            throw error() << "Raw egg file has an unexpected header or index entry size";
+        }
+        f_record_bytes = get< uint32_t >( a_block, 16 );
+        f_capacity = get< uint64_t >( a_block, 24 );
+        f_n_records = get< uint64_t >( a_block, 32 );
+        f_index_offset = get< uint64_t >( a_block, 40 );
+        f_state = static_cast< state >( get< uint32_t >( a_block, 48 ) );
+        f_acq_rate = get< uint32_t >( a_block, 52 );
+        f_record_size = get< uint32_t >( a_block, 56 );
+        f_sample_size = get< uint32_t >( a_block, 60 );
+        f_data_type_size = get< uint32_t >( a_block, 64 );
+        f_data_format = get< uint32_t >( a_block, 68 );
+        f_bit_depth = get< uint32_t >( a_block, 72 );
+        f_bit_alignment = get< uint32_t >( a_block, 76 );
+        f_run_duration = get< uint32_t >( a_block, 80 );
+        uint32_t t_compression = get< uint32_t >( a_block, 84 );
+        if( t_compression > static_cast< uint32_t >( record_compression::bitshuffle_deflate ) )
+        {
+            throw error() << "Raw egg file has an unknown compression: " << t_compression;
+        }
+        f_compression = static_cast< record_compression >( t_compression );
+        f_v_offset = get< double >( a_block, 88 );
+        f_v_range = get< double >( a_block, 96 );
+        f_dac_gain = get< double >( a_block, 104 );
+        f_freq_min = get< double >( a_block, 112 );
+        f_freq_range = get< double >( a_block, 120 );
+        f_source = get_string( a_block, s_source_offset, s_source_size );
+        f_timestamp = get_string( a_block, s_timestamp_offset, s_timestamp_size );
+        f_filename = get_string( a_block, s_filename_offset, s_filename_size );
+        uint32_t t_desc_length = std::min< uint32_t >( get< uint32_t >( a_block, s_description_length_offset ), s_size - s_description_offset );
+        f_description.assign( a_block + s_description_offset, t_desc_length );
+        return;
+    }
+
+
+    //***********************
+    // raw_egg_file_writer
+    //***********************
+
+    const size_t raw_egg_file_writer::s_direct_io_alignment;
+
+    raw_egg_file_writer::raw_egg_file_writer() :
+            f_filename(),
+            f_header(),
+            f_data_fd( -1 ),
+            f_meta_fd( -1 ),
+            f_direct_io( false ),
+            f_n_records( 0 ),
+            f_data_bytes( 0 ),
+            f_segments(),
+            f_entries(),
+            f_uring( nullptr ),
+            f_file_uring( nullptr ),
+            f_index()
+    {
+    }
+
+    raw_egg_file_writer::~raw_egg_file_writer()
+    {
+        try
+        {
+            finish();
+        }
+        catch( error& )
+        {
+            close_files();
+        }
+    }
+
+    uint64_t raw_egg_file_writer::capacity_for_size( double a_max_size_mb, uint32_t a_record_bytes )
+    {
+        double t_bytes = a_max_size_mb * 1.e6 - (double)raw_egg_header::s_size;
+        if( t_bytes <= 0. || a_record_bytes == 0 ) return 0;
+        return (uint64_t)( t_bytes / (double)( a_record_bytes + sizeof( raw_egg_index_entry ) ) );
+    }
+
+    void raw_egg_file_writer::open( const std::string& a_filename, const raw_egg_header& a_header, uint64_t a_capacity, bool a_direct_io )
+    {
+        if( is_open() )
+        {
+            throw error() << "Raw egg file <" << f_filename << "> is still open";
+        }
+        if( a_header.f_record_bytes == 0 || a_capacity == 0 )
+        {
+            throw error() << "Raw egg file must have room for at least one record of at least one byte";
+        }
+        // compressed records are packed, so they can't be written with direct I/O
+        a_direct_io = a_direct_io && a_header.f_compression == record_compression::none;
+        if( a_direct_io && a_header.f_record_bytes % s_direct_io_alignment != 0 )
+        {
+            throw error() << "With direct I/O, the record size (" << a_header.f_record_bytes << " bytes) must be a multiple of " << s_direct_io_alignment << " bytes";
+        }
+
+        f_filename = a_filename;
+        f_header = a_header;
+        f_header.f_capacity = a_capacity;
+        f_header.f_n_records = 0;
+        f_header.f_index_offset = raw_egg_header::s_size + a_capacity * a_header.f_record_bytes;
+        f_header.f_state = raw_egg_header::state::writing;
+        f_n_records = 0;
+        f_data_bytes = 0;
+        f_file_uring = f_uring;
+        f_index.clear();
+        if( f_file_uring != nullptr ) f_index.reserve( a_capacity );
+
+        f_meta_fd = ::open( a_filename.c_str(), O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644 );
+        if( f_meta_fd < 0 )
+        {
+            throw error() << "Unable to create raw egg file <" << a_filename << ">: " << strerror( errno );
+        }
+
+        // size the file for the full capacity; the index entries start out zeroed, and so invalid
+        off_t t_file_size = (off_t)( f_header.f_index_offset + a_capacity * sizeof( raw_egg_index_entry ) );
+#ifdef __linux__
+        if( ::fallocate( f_meta_fd, 0, 0, t_file_size ) != 0 )
+#endif
+        {
+            if( ::ftruncate( f_meta_fd, t_file_size ) != 0 )
+            {
+                int t_errno = errno;
+                close_files();
+                throw error() << "Unable to size raw egg file <" << a_filename << "> for " << a_capacity << " records: " << strerror( t_errno );
+            }
+        }
+
+        std::vector< char > t_block( raw_egg_header::s_size );
+        f_header.encode( t_block.data() );
+        f_segments.assign( 1, { t_block.data(), t_block.size() } );
+        write_segments( f_meta_fd, f_segments, 0 );
+
+        f_direct_io = false;
+        f_data_fd = f_meta_fd;
+#ifdef O_DIRECT
+        if( a_direct_io )
+        {
+            int t_fd = ::open( a_filename.c_str(), O_WRONLY | O_DIRECT | O_CLOEXEC );
+            if( t_fd >= 0 )
+            {
+                f_data_fd = t_fd;
+                f_direct_io = true;
+            }
+        }
+#endif
+        return;
+    }
+
+    void raw_egg_file_writer::write_segments( int a_fd, std::vector< struct iovec >& a_segments, uint64_t a_offset )
+    {
+        size_t t_first = 0;
+        while( t_first < a_segments.size() )
+        {
+            int t_n_segments = (int)std::min< size_t >( a_segments.size() - t_first, IOV_MAX );
+            ssize_t t_written = ::pwritev( a_fd, &a_segments[ t_first ], t_n_segments, (off_t)a_offset );
+            if( t_written < 0 && errno == EINTR ) continue;
+            if( t_written < 0 )
+            {
+                throw error() << "Unable to write to raw egg file <" << f_filename << ">: " << strerror( errno );
+            }
+            a_offset += t_written;
+
+            // skip the segments that were written completely, and trim one that was written partially
+            size_t t_remaining = t_written;
+            while( t_first < a_segments.size() && t_remaining >= a_segments[ t_first ].iov_len )
+            {
+                t_remaining -= a_segments[ t_first ].iov_len;
+                ++t_first;
+            }
+            if( t_remaining > 0 )
+            {
+                a_segments[ t_first ].iov_base = static_cast< char* >( a_segments[ t_first ].iov_base ) + t_remaining;
+                a_segments[ t_first ].iov_len -= t_remaining;
+            }
+        }
+        return;
+    }
+
+    uint64_t raw_egg_file_writer::write( const int8_t* const* a_records, const raw_egg_index_entry* a_entries, uint64_t a_n )
+    {
+        if( ! is_open() )
+        {
+            throw error() << "Raw egg file is not open";
+        }
+        uint64_t t_n = std::min( a_n, f_header.f_capacity - f_n_records );
+        if( t_n == 0 ) return 0;
+
+        // records that are adjacent in memory are written as one segment
+        f_segments.clear();
+        uint64_t t_data_bytes = 0;
+        for( uint64_t i_record = 0; i_record < t_n; ++i_record )
+        {
+            char* t_data = const_cast< char* >( reinterpret_cast< const char* >( a_records[ i_record ] ) );
+            if( f_direct_io && reinterpret_cast< uintptr_t >( t_data ) % s_direct_io_alignment != 0 )
+            {
+                throw error() << "With direct I/O, record memory must be aligned to " << s_direct_io_alignment << " bytes";
+            }
+            size_t t_bytes = f_header.f_record_bytes;
+            if( a_entries[ i_record ].is_compressed() )
+            {
+                t_bytes = a_entries[ i_record ].f_stored_bytes;
+                if( f_header.f_compression == record_compression::none || t_bytes == 0 || t_bytes > f_header.f_record_bytes )
+                {
+                    throw error() << "Compressed record of " << t_bytes << " bytes can't be written to raw egg file <" << f_filename << ">";
+                }
+            }
+            if( ! f_segments.empty() && static_cast< char* >( f_segments.back().iov_base ) + f_segments.back().iov_len == t_data )
+            {
+                f_segments.back().iov_len += t_bytes;
+            }
+            else
+            {
+                f_segments.push_back( { t_data, t_bytes } );
+            }
+            t_data_bytes += t_bytes;
+        }
+        uint64_t t_data_offset = raw_egg_header::s_size + f_data_bytes;
+        uint64_t t_index_offset = f_header.f_index_offset + f_n_records * sizeof( raw_egg_index_entry );
+
+        if( f_file_uring != nullptr )
+        {
+            if( f_file_uring->has_failed() )
+            {
+                throw error() << "Unable to write to raw egg file <" << f_filename << ">: " << f_file_uring->get_error();
+            }
+            // the entries are kept in the full index, whose memory doesn't move while the writes are in flight
+            size_t t_first_entry = f_index.size();
+            f_index.insert( f_index.end(), a_entries, a_entries + t_n );
+            for( auto t_it = f_index.begin() + t_first_entry; t_it != f_index.end(); ++t_it )
+            {
+                t_it->f_flags |= raw_egg_index_entry::s_valid;
+                if( ! t_it->is_compressed() ) t_it->f_stored_bytes = f_header.f_record_bytes;
+            }
+            // the index write is linked after the data write, so that a valid entry means that its record was written
+            struct iovec t_index_segment = { &f_index[ t_first_entry ], t_n * sizeof( raw_egg_index_entry ) };
+            uring_writer::write t_writes[ 2 ] = {
+                    { f_data_fd, f_segments.data(), (unsigned)f_segments.size(), t_data_offset },
+                    { f_meta_fd, &t_index_segment, 1, t_index_offset } };
+            f_file_uring->submit( t_writes, 2 );
+            f_n_records += t_n;
+            f_data_bytes += t_data_bytes;
+            return t_n;
+        }
+
+        write_segments( f_data_fd, f_segments, t_data_offset );
+
+        // the index entries are written after the data, so that a valid entry means that its record was written
+        f_entries.assign( a_entries, a_entries + t_n );
+        for( raw_egg_index_entry& t_entry : f_entries )
+        {
+            t_entry.f_flags |= raw_egg_index_entry::s_valid;
+            if( ! t_entry.is_compressed() ) t_entry.f_stored_bytes = f_header.f_record_bytes;
+        }
+        f_segments.assign( 1, { f_entries.data(), t_n * sizeof( raw_egg_index_entry ) } );
+        write_segments( f_meta_fd, f_segments, t_index_offset );
+
+        f_n_records += t_n;
+        f_data_bytes += t_data_bytes;
+        return t_n;
+    }
+
+    void raw_egg_file_writer::finish()
+    {
+        if( ! is_open() ) return;
+
+        if( f_file_uring != nullptr )
+        {
+            f_file_uring->wait_for_all();
+            f_index.clear();
+            if( f_file_uring->has_failed() )
+            {
+                // the file is left unfinished, so that the reader only uses the records whose writes succeeded
+                close_files();
+                throw error() << "Unable to write to raw egg file <" << f_filename << ">: " << f_file_uring->get_error();
+            }
+        }
+
+        // move the index to just after the last record; it's read completely first, since the old and new positions can overlap
+        uint64_t t_index_offset = raw_egg_header::s_size + f_data_bytes;
+        std::vector< raw_egg_index_entry > t_index( f_n_records );
+        if( f_n_records > 0 )
+        {
+            read_fully( f_meta_fd, reinterpret_cast< char* >( t_index.data() ), f_n_records * sizeof( raw_egg_index_entry ), f_header.f_index_offset, f_filename );
+            f_segments.assign( 1, { t_index.data(), t_index.size() * sizeof( raw_egg_index_entry ) } );
+            write_segments( f_meta_fd, f_segments, t_index_offset );
+        }
+
+        f_header.f_n_records = f_n_records;
+        f_header.f_index_offset = t_index_offset;
+        f_header.f_state = raw_egg_header::state::finished;
+        std::vector< char > t_block( raw_egg_header::s_size );
+        f_header.encode( t_block.data() );
+        f_segments.assign( 1, { t_block.data(), t_block.size() } );
+        write_segments( f_meta_fd, f_segments, 0 );
+
+        if( ::ftruncate( f_meta_fd, (off_t)( t_index_offset + f_n_records * sizeof( raw_egg_index_entry ) ) ) != 0 )
+        {
+            int t_errno = errno;
+            close_files();
+            throw error() << "Unable to truncate raw egg file <" << f_filename << ">: " << strerror( t_errno );
+        }
+
+        close_files();
+        return;
+    }
+
+    void raw_egg_file_writer::close_files()
+    {
+        if( f_data_fd >= 0 && f_data_fd != f_meta_fd ) ::close( f_data_fd );
+        if( f_meta_fd >= 0 ) ::close( f_meta_fd );
+        f_data_fd = -1;
+        f_meta_fd = -1;
+        return;
+    }
+
+
+    //***********************
+    // raw_egg_file_reader
+    //***********************
+
+    raw_egg_file_reader::raw_egg_file_reader() :
+            f_fd( -1 ),
+            f_header(),
+            f_index(),
+            f_offsets(),
+            f_codec(),
+            f_stored()
+    {
+    }
+
+    raw_egg_file_reader::~raw_egg_file_reader()
+    {
+        close();
+    }
+
+    void raw_egg_file_reader::open( const std::string& a_filename )
+    {
+        close();
+        f_fd = ::open( a_filename.c_str(), O_RDONLY | O_CLOEXEC );
+        if( f_fd < 0 )
+        {
+            throw error() << "Unable to open raw egg file <" << a_filename << ">: " << strerror( errno );
+        }
+
+        try
+        {
+            std::vector< char > t_block( raw_egg_header::s_size );
+            read_fully( f_fd, t_block.data(), t_block.size(), 0, a_filename );
+            f_header.decode( t_block.data() );
+
+            // an unfinished file has an index entry for each record of its capacity; the valid entries come first
+            uint64_t t_n_entries = was_finished() ? f_header.f_n_records : f_header.f_capacity;
+            f_index.resize( t_n_entries );
+            read_fully( f_fd, reinterpret_cast< char* >( f_index.data() ), t_n_entries * sizeof( raw_egg_index_entry ), f_header.f_index_offset, a_filename );
+            if( ! was_finished() )
+            {
+                f_index.erase( std::find_if( f_index.begin(), f_index.end(), []( const raw_egg_index_entry& a_entry ){ return ! a_entry.is_valid(); } ), f_index.end() );
+                f_header.f_n_records = f_index.size();
+            }
+
+            // the records are back to back; files written before records had a stored size have 0 for it
+            f_offsets.resize( f_index.size() );
+            uint64_t t_offset = raw_egg_header::s_size;
+            for( size_t i_record = 0; i_record < f_index.size(); ++i_record )
+            {
+                raw_egg_index_entry& t_entry = f_index[ i_record ];
+                if( t_entry.f_stored_bytes == 0 ) t_entry.f_stored_bytes = f_header.f_record_bytes;
+                if( t_entry.f_stored_bytes > f_header.f_record_bytes || ( t_entry.is_compressed() && f_header.f_compression == record_compression::none ) )
+                {
+                    throw error() << "Raw egg file <" << a_filename << "> has an invalid index entry for record " << i_record;
+                }
+                f_offsets[ i_record ] = t_offset;
+                t_offset += t_entry.f_stored_bytes;
+            }
+            if( f_header.f_compression != record_compression::none )
+            {
+                f_codec.reset( new record_codec( f_header.f_compression, Z_DEFAULT_COMPRESSION ) );
+            }
+        }
+        catch( error& )
+        {
+            close();
+            throw;
+        }
+        return;
+    }
+
+    void raw_egg_file_reader::close()
+    {
+        if( f_fd >= 0 ) ::close( f_fd );
+        f_fd = -1;
+        f_index.clear();
+        f_offsets.clear();
+        f_codec.reset();
+        return;
+    }
+
+    void raw_egg_file_reader::read_record( uint64_t a_record, int8_t* a_buffer )
+    {
+        if( a_record >= f_index.size() )
+        {
+            throw error() << "Record " << a_record << " is not in the raw egg file; it has " << f_index.size() << " records";
+        }
+        const raw_egg_index_entry& t_entry = f_index[ a_record ];
+        if( ! t_entry.is_compressed() )
+        {
+            read_fully( f_fd, reinterpret_cast< char* >( a_buffer ), f_header.f_record_bytes, f_offsets[ a_record ], f_header.f_filename );
+            return;
+        }
+        f_stored.resize( t_entry.f_stored_bytes );
+        read_fully( f_fd, reinterpret_cast< char* >( f_stored.data() ), f_stored.size(), f_offsets[ a_record ], f_header.f_filename );
+        try
+        {
+            f_codec->decompress( f_stored.data(), f_stored.size(), a_buffer, f_header.f_record_bytes );
+        }
+        catch( error& e )
+        {
+            throw error() << "Unable to read record " << a_record << " of raw egg file <" << f_header.f_filename << ">: " << e.what();
+        }
+        return;
+    }
+
+} /* namespace psyllid */
@@ -0,0 +1,322 @@
+/*
+ * raw_egg.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_RAW_EGG_HH_
+#define PSYLLID_RAW_EGG_HH_
+
+#include "record_compression.hh"
+#include "uring_writer.hh"
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace psyllid
+{
+
+    /*!
+     @struct raw_egg_header
+     @brief Metadata at the start of a raw egg file
+
+     @details
+     A raw egg file is an append-only alternative to an egg3 (HDF5) file, for the highest-rate streams: fixed-size records are written
+     straight into a pre-sized file, without going through HDF5.  raw_to_egg3 converts a raw egg file to a standard egg3 file offline.
+
+     File layout (all values in the byte order of the machine that wrote the file):
+     - header: s_size bytes, starting with the magic string "PSYRAWEG"; holds the same run and stream metadata as the egg3 header
+     - records: the record data, record-bytes each, back to back, starting at offset s_size
+     - index: one raw_egg_index_entry per record (ID, time, flags, stored size), starting at index-offset
+
+     If the file is compressed (see record_compression), each record is stored compressed if that made it smaller, and as it is otherwise;
+     the records are still back to back, so a record's offset is the sum of the stored sizes of the records before it.
+
+     While the file is being written, the data region has room for capacity records, and the index follows it;
+     when the file is finished, the index is moved to just after the last record, and the file is truncated.
+     If the writer stops without finishing the file, the records can still be recovered from the valid entries at the start of the index.
+
+     Header layout (byte offsets): magic (0, 8 bytes), version (8), header size (12), record bytes (16), index entry size (20),
+     capacity (24), number of records (32), index offset (40), state (48), acq-rate (52), record-size (56), sample-size (60),
+     data-type-size (64), data format (68), bit depth (72), bit alignment (76), run duration (80), compression (84), v-offset (88), v-range (96), DAC gain (104),
+     minimum frequency (112), frequency range (120), source (128, 64 bytes), timestamp (192, 64 bytes), filename (256, 512 bytes),
+     description length (768), description (772, to the end of the header).  Strings are null-padded.
+    */
+    struct raw_egg_header
+    {
+        static const size_t s_size = 4096;
+        static const uint32_t s_version = 1;
+
+        enum class state : uint32_t
+        {
+            writing = 0,
+            finished = 1
+        };
+
+        uint32_t f_record_bytes;
+        uint64_t f_capacity; // records
+        uint64_t f_n_records; // valid once the file is finished
+        uint64_t f_index_offset; // bytes from the start of the file
+        state f_state;
+
+        // stream and channel metadata, as in the egg3 stream and channel headers
+        std::string f_source;
+        uint32_t f_acq_rate; // MHz
+        uint32_t f_record_size; // samples
+        uint32_t f_sample_size;
+        uint32_t f_data_type_size;
+        uint32_t f_data_format;
+        uint32_t f_bit_depth;
+        uint32_t f_bit_alignment;
+        double f_v_offset;
+        double f_v_range;
+        double f_dac_gain;
+        double f_freq_min;
+        double f_freq_range;
+
+        // run metadata, as in the egg3 file header
+        std::string f_filename;
+        std::string f_timestamp;
+        std::string f_description;
+        uint32_t f_run_duration; // ms
+
+        record_compression f_compression;
+
+        raw_egg_header();
+
+        /// Writes the header into a_block, which must hold s_size bytes; strings that are too long are truncated
+        void encode( char* a_block ) const;
+        /// Reads the header from a_block; throws psyllid::error if it isn't a raw egg header of a known version
+        void decode( const char* a_block );
+    };
+
+    /*!
+     @struct raw_egg_index_entry
+     @brief One record's entry in the index of a raw egg file
+    */
+    struct raw_egg_index_entry
+    {
+        static const uint32_t s_valid = 0x1;
+        static const uint32_t s_new_acq = 0x2;
+        static const uint32_t s_compressed = 0x4;
+
+        uint64_t f_id;
+        uint64_t f_time; // ns
+        uint32_t f_flags;
+        uint32_t f_stored_bytes; // size of the record in the file
+
+        bool is_valid() const;
+        bool is_new_acq() const;
+        bool is_compressed() const;
+    };
+    static_assert( sizeof( raw_egg_index_entry ) == 24, "raw_egg_index_entry must be 24 bytes" );
+
+    inline bool raw_egg_index_entry::is_valid() const
+    {
+        return ( f_flags & s_valid ) != 0;
+    }
+
+    inline bool raw_egg_index_entry::is_new_acq() const
+    {
+        return ( f_flags & s_new_acq ) != 0;
+    }
+
+    inline bool raw_egg_index_entry::is_compressed() const
+    {
+        return ( f_flags & s_compressed ) != 0;
+    }
+
+
+    /*!
+     @class raw_egg_file_writer
+     @brief Writes records to a raw egg file
+
+     @details
+     The file is sized for a fixed number of records when it's opened (with fallocate if the filesystem supports it, so that its extents are
+     allocated up front), and records are written with pwritev: one call for the data of a group of records, and one for their index entries.
+     Adjacent records in memory are written as a single segment.
+
+     With direct I/O, the data is written with O_DIRECT, bypassing the page cache; the record size must then be a multiple of s_direct_io_alignment,
+     and the records' memory must be aligned to it.  The header and index are always written through the page cache.
+     If the filesystem doesn't support O_DIRECT, the page cache is used instead; uses_direct_io() tells which was used.
+
+     If the header's compression isn't none, the records passed to write() are the stored records: a record whose entry has the compressed flag
+     is f_stored_bytes long, and any other record is record-bytes long (see record_compressor, which packs a batch that way).
+     Compressed records aren't aligned, so direct I/O isn't used.
+
+     With an io_uring backend (set_uring()), write() submits the data and index writes for the records as one chain and returns without
+     waiting for them; the index write is only done if the data write succeeded.  The records' memory must then be left untouched until
+     the chain has completed (see uring_writer), and the index entries are kept in memory until the file is finished.
+     finish() waits for the writes in flight; if one of them failed, the file is closed without being finished, so that only the records
+     that were written are recovered from it.
+
+     Not thread-safe.
+    */
+    class raw_egg_file_writer
+    {
+        public:
+            static const size_t s_direct_io_alignment = 4096;
+
+        public:
+            raw_egg_file_writer();
+            ~raw_egg_file_writer();
+
+            raw_egg_file_writer( const raw_egg_file_writer& ) = delete;
+            raw_egg_file_writer& operator=( const raw_egg_file_writer& ) = delete;
+
+            /// Number of records of a_record_bytes that fit in a file of a_max_size_mb, including the header and index
+            static uint64_t capacity_for_size( double a_max_size_mb, uint32_t a_record_bytes );
+
+            /// Sets the io_uring backend used for the files opened from now on; nullptr (the default) writes with pwritev
+            void set_uring( uring_writer* a_uring );
+            uring_writer* get_uring() const;
+
+            /// Creates the file, sized for a_capacity records of a_header.f_record_bytes; throws psyllid::error on failure
+            void open( const std::string& a_filename, const raw_egg_header& a_header, uint64_t a_capacity, bool a_direct_io );
+            bool is_open() const;
+
+            /// Writes up to a_n records, until the file is full; a_records[ i ] points to the data for record i, with index entry a_entries[ i ]
+            /// (the valid flag and, for uncompressed records, the stored size are set by the writer).  Returns the number of records written (with io_uring: submitted);
+            /// throws psyllid::error if the write fails (with io_uring: if an earlier write failed).
+            uint64_t write( const int8_t* const* a_records, const raw_egg_index_entry* a_entries, uint64_t a_n );
+
+            /// Moves the index to just after the last record, marks the file as finished, truncates it and closes it
+            /// With io_uring, waits for the writes in flight first, and throws psyllid::error if any failed
+            void finish();
+
+            const std::string& get_filename() const;
+            uint64_t get_n_records() const;
+            uint64_t get_capacity() const;
+            bool is_full() const;
+            bool uses_direct_io() const;
+
+        private:
+            /// Writes the segments at a_offset, repeating the call as needed; the segments are used up in the process
+            void write_segments( int a_fd, std::vector< struct iovec >& a_segments, uint64_t a_offset );
+            void close_files();
+
+            std::string f_filename;
+            raw_egg_header f_header;
+            int f_data_fd;
+            int f_meta_fd;
+            bool f_direct_io;
+            uint64_t f_n_records;
+            uint64_t f_data_bytes; // bytes of records written so far
+
+            std::vector< struct iovec > f_segments;
+            std::vector< raw_egg_index_entry > f_entries;
+
+            uring_writer* f_uring;
+            uring_writer* f_file_uring; // the backend for the open file
+            std::vector< raw_egg_index_entry > f_index; // with io_uring, the whole index; reserved when the file is opened, so it's never moved
+    };
+
+    inline void raw_egg_file_writer::set_uring( uring_writer* a_uring )
+    {
+        f_uring = a_uring;
+        return;
+    }
+
+    inline uring_writer* raw_egg_file_writer::get_uring() const
+    {
+        return f_uring;
+    }
+
+    inline bool raw_egg_file_writer::is_open() const
+    {
+        return f_meta_fd >= 0;
+    }
+
+    inline const std::string& raw_egg_file_writer::get_filename() const
+    {
+        return f_filename;
+    }
+
+    inline uint64_t raw_egg_file_writer::get_n_records() const
+    {
+        return f_n_records;
+    }
+
+    inline uint64_t raw_egg_file_writer::get_capacity() const
+    {
+        return f_header.f_capacity;
+    }
+
+    inline bool raw_egg_file_writer::is_full() const
+    {
+        return f_n_records >= f_header.f_capacity;
+    }
+
+    inline bool raw_egg_file_writer::uses_direct_io() const
+    {
+        return f_direct_io;
+    }
+
+
+    /*!
+     @class raw_egg_file_reader
+     @brief Reads a raw egg file
+
+     @details
+     The index is read when the file is opened.  If the file wasn't finished, the records with valid index entries are used.
+     Compressed records are decompressed by read_record().
+    */
+    class raw_egg_file_reader
+    {
+        public:
+            raw_egg_file_reader();
+            ~raw_egg_file_reader();
+
+            raw_egg_file_reader( const raw_egg_file_reader& ) = delete;
+            raw_egg_file_reader& operator=( const raw_egg_file_reader& ) = delete;
+
+            /// Opens the file and reads its header and index; throws psyllid::error on failure
+            void open( const std::string& a_filename );
+            void close();
+
+            const raw_egg_header& header() const;
+            /// Returns false if the writer didn't finish the file, and the records were recovered from the index
+            bool was_finished() const;
+            uint64_t get_n_records() const;
+            const raw_egg_index_entry& get_entry( uint64_t a_record ) const;
+
+            /// Reads the data of record a_record into a_buffer, which must hold header().f_record_bytes bytes; throws psyllid::error on failure
+            void read_record( uint64_t a_record, int8_t* a_buffer );
+
+        private:
+            int f_fd;
+            raw_egg_header f_header;
+            std::vector< raw_egg_index_entry > f_index;
+            std::vector< uint64_t > f_offsets; // of each record, from the start of the file
+
+            std::unique_ptr< record_codec > f_codec;
+            std::vector< int8_t > f_stored;
+    };
+
+    inline const raw_egg_header& raw_egg_file_reader::header() const
+    {
+        return f_header;
+    }
+
+    inline bool raw_egg_file_reader::was_finished() const
+    {
+        return f_header.f_state == raw_egg_header::state::finished;
+    }
+
+    inline uint64_t raw_egg_file_reader::get_n_records() const
+    {
+        return f_index.size();
+    }
+
+    inline const raw_egg_index_entry& raw_egg_file_reader::get_entry( uint64_t a_record ) const
+    {
+        return f_index[ a_record ];
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_RAW_EGG_HH_ */
@@ -0,0 +1,177 @@
+/*
+ * record_batch_queue.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "record_batch_queue.hh"
+
+#include "psyllid_error.hh"
+
+#include "param.hh"
+
+namespace psyllid
+{
+
+    record_batch_queue::record_batch_queue() :
+            f_n_batches( 0 ),
+            f_batch_size( 0 ),
+            f_record_size( 0 ),
+            f_storage(),
+            f_batches(),
+            f_head( 0 ),
+            f_n_queued( 0 ),
+            f_closed( false ),
+            f_filling( nullptr ),
+            f_n_taken( 0 ),
+            f_mutex(),
+            f_batch_queued(),
+            f_batch_released(),
+            f_high_water( 0 ),
+            f_n_stalls( 0 ),
+            f_stall_time( 0 ),
+            f_n_dropped( 0 )
+    {
+    }
+
+    record_batch_queue::~record_batch_queue()
+    {
+    }
+
+    void record_batch_queue::allocate( size_t a_n_batches, size_t a_batch_size, size_t a_record_size )
+    {
+        if( a_n_batches == 0 || a_batch_size == 0 || a_record_size == 0 )
+        {
+            throw error() << "Record batch queue must have at least one batch, of at least one record, of at least one byte";
+        }
+
+        f_batch_size.store( a_batch_size, std::memory_order_relaxed );
+        f_record_size = a_record_size;
+        // each batch is padded to a multiple of the alignment, so that every batch starts on an aligned address
+        size_t t_batch_bytes = ( a_batch_size * a_record_size + s_alignment - 1 ) / s_alignment * s_alignment;
+        f_storage.assign( a_n_batches * t_batch_bytes + s_alignment, 0 );
+        int8_t* t_start = f_storage.data() + ( s_alignment - reinterpret_cast< uintptr_t >( f_storage.data() ) % s_alignment ) % s_alignment;
+        f_batches.resize( a_n_batches );
+        for( size_t i_batch = 0; i_batch < a_n_batches; ++i_batch )
+        {
+            f_batches[ i_batch ].f_records.resize( a_batch_size );
+            f_batches[ i_batch ].f_n_records = 0;
+            f_batches[ i_batch ].f_data = t_start + i_batch * t_batch_bytes;
+        }
+        f_n_batches.store( a_n_batches, std::memory_order_relaxed );
+
+        f_head = 0;
+        f_n_queued.store( 0 );
+        f_closed = false;
+        f_filling = nullptr;
+        f_n_taken = 0;
+        reset_stats();
+        return;
+    }
+
+    bool record_batch_queue::get_free_batch( std::chrono::milliseconds a_max_stall )
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        if( f_n_queued.load( std::memory_order_relaxed ) == f_batches.size() )
+        {
+            f_n_stalls.fetch_add( 1, std::memory_order_relaxed );
+            auto t_start = std::chrono::steady_clock::now();
+            bool t_freed = f_batch_released.wait_for( t_lock, a_max_stall, [this](){ return f_n_queued.load( std::memory_order_relaxed ) < f_batches.size(); } );
+            f_stall_time.fetch_add( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - t_start ).count(), std::memory_order_relaxed );
+            if( ! t_freed )
+            {
+                f_n_dropped.fetch_add( 1, std::memory_order_relaxed );
+                return false;
+            }
+        }
+        f_filling = &f_batches[ ( f_head + f_n_queued.load( std::memory_order_relaxed ) ) % f_batches.size() ];
+        f_filling->f_n_records = 0;
+        return true;
+    }
+
+    void record_batch_queue::queue_batch()
+    {
+        {
+            std::unique_lock< std::mutex > t_lock( f_mutex );
+            size_t t_n_queued = f_n_queued.load( std::memory_order_relaxed ) + 1;
+            f_n_queued.store( t_n_queued, std::memory_order_relaxed );
+            if( t_n_queued > f_high_water.load( std::memory_order_relaxed ) ) f_high_water.store( t_n_queued, std::memory_order_relaxed );
+        }
+        f_filling = nullptr;
+        f_batch_queued.notify_one();
+        return;
+    }
+
+    void record_batch_queue::flush()
+    {
+        if( f_filling != nullptr && f_filling->f_n_records > 0 ) queue_batch();
+        return;
+    }
+
+    void record_batch_queue::wait_until_empty()
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        f_batch_released.wait( t_lock, [this](){ return f_n_queued.load( std::memory_order_relaxed ) == 0; } );
+        return;
+    }
+
+    void record_batch_queue::close()
+    {
+        {
+            std::unique_lock< std::mutex > t_lock( f_mutex );
+            f_closed = true;
+        }
+        f_batch_queued.notify_all();
+        return;
+    }
+
+    const record_batch_queue::batch* record_batch_queue::next_batch()
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        f_batch_queued.wait( t_lock, [this](){ return f_n_queued.load( std::memory_order_relaxed ) > f_n_taken || f_closed; } );
+        if( f_n_queued.load( std::memory_order_relaxed ) == f_n_taken ) return nullptr;
+        return &f_batches[ ( f_head + f_n_taken++ ) % f_batches.size() ];
+    }
+
+    const record_batch_queue::batch* record_batch_queue::try_next_batch()
+    {
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        if( f_n_queued.load( std::memory_order_relaxed ) == f_n_taken ) return nullptr;
+        return &f_batches[ ( f_head + f_n_taken++ ) % f_batches.size() ];
+    }
+
+    void record_batch_queue::release_batch()
+    {
+        {
+            std::unique_lock< std::mutex > t_lock( f_mutex );
+            f_head = ( f_head + 1 ) % f_batches.size();
+            f_n_queued.store( f_n_queued.load( std::memory_order_relaxed ) - 1, std::memory_order_relaxed );
+            --f_n_taken;
+        }
+        // both the producer and wait_until_empty() may be waiting
+        f_batch_released.notify_all();
+        return;
+    }
+
+    void record_batch_queue::reset_stats()
+    {
+        f_high_water.store( f_n_queued.load() );
+        f_n_stalls.store( 0 );
+        f_stall_time.store( 0 );
+        f_n_dropped.store( 0 );
+        return;
+    }
+
+    void record_batch_queue::fill_status( scarab::param_node& a_status ) const
+    {
+        a_status.add( "n-batches", get_n_batches() );
+        a_status.add( "batch-size", get_batch_size() );
+        a_status.add( "depth", get_depth() );
+        a_status.add( "high-water", get_high_water() );
+        a_status.add( "n-stalls", get_n_stalls() );
+        a_status.add( "stall-time-ms", 1.e-6 * (double)get_stall_time() );
+        a_status.add( "n-dropped", get_n_dropped() );
+        return;
+    }
+
+} /* namespace psyllid */
@@ -0,0 +1,232 @@
+/*
+ * record_batch_queue.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_RECORD_BATCH_QUEUE_HH_
+#define PSYLLID_RECORD_BATCH_QUEUE_HH_
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace psyllid
+{
+
+    /*!
+     @class record_batch_queue
+     @brief Bounded queue of preallocated record batches, for handing records from one thread to a writer thread
+
+     @details
+     The queue holds a fixed number of batches, each with room for batch-size records of a fixed size; all of the memory is allocated up front.
+     The producer fills records in place in the current batch (begin_record(), then commit_record()); a full batch is passed to the consumer,
+     and flush() passes a partial batch.  The consumer takes batches in order with next_batch(), and gives each back with release_batch()
+     once it has been written.  The consumer can hold several batches at once (e.g. while asynchronous writes of them are in flight);
+     they're released oldest first.  Locking is only done once per batch.
+     The records of a batch are contiguous in memory, and each batch starts on an s_alignment boundary, so that batches can be written with direct I/O.
+
+     If every batch is queued when the producer needs a new one, the producer waits for the consumer, for up to a maximum stall time;
+     if no batch is free by then, the record is dropped.  The queue keeps track of its high-water mark, the time the producer spent stalled,
+     and the number of records dropped.
+
+     Thread safety: one producer thread and one consumer thread.  The statistics (and fill_status()) can be read from any thread, even while allocate() runs.
+     allocate() and reset_stats() must not be called while either thread is using the queue.
+
+     The status contains:
+     - "n-batches": uint -- number of batches in the queue
+     - "batch-size": uint -- number of records in each batch
+     - "depth": uint -- number of batches currently queued
+     - "high-water": uint -- largest number of batches queued at once
+     - "n-stalls": uint -- number of times the producer waited for a free batch
+     - "stall-time-ms": double -- total time the producer spent waiting
+     - "n-dropped": uint -- number of records dropped because no batch became free
+    */
+    class record_batch_queue
+    {
+        public:
+            struct record
+            {
+                uint64_t f_id;
+                uint64_t f_time;
+                bool f_is_new_acq;
+                const int8_t* f_data;
+            };
+
+            struct batch
+            {
+                std::vector< record > f_records; // the first f_n_records are filled
+                size_t f_n_records;
+                int8_t* f_data; // batch-size * record-size bytes
+            };
+
+        public:
+            static const size_t s_alignment = 4096;
+
+        public:
+            record_batch_queue();
+            virtual ~record_batch_queue();
+
+            record_batch_queue( const record_batch_queue& ) = delete;
+            record_batch_queue& operator=( const record_batch_queue& ) = delete;
+
+            /// Allocates a_n_batches batches of a_batch_size records, each of a_record_size bytes; opens the queue and clears the statistics
+            void allocate( size_t a_n_batches, size_t a_batch_size, size_t a_record_size );
+
+            size_t get_n_batches() const;
+            size_t get_batch_size() const;
+            size_t get_record_size() const;
+
+            /// The memory that holds all of the batches, e.g. for registering with the kernel for I/O; valid until the next allocate()
+            const int8_t* get_storage() const;
+            size_t get_storage_size() const;
+
+            //**************
+            // Producer
+            //**************
+
+            /// Returns the memory for the next record, to be filled with get_record_size() bytes; waits for up to a_max_stall for a free batch if necessary.
+            /// Returns nullptr, and counts the record as dropped, if no batch became free.
+            int8_t* begin_record( std::chrono::milliseconds a_max_stall );
+            /// Completes the record started with begin_record(); the batch is queued if it's full
+            void commit_record( uint64_t a_id, uint64_t a_time, bool a_is_new_acq );
+            /// Queues the current batch, if it has any records
+            void flush();
+            /// Waits until the consumer has released every queued batch
+            void wait_until_empty();
+            /// Closes the queue: once the queued batches are taken, next_batch() returns nullptr
+            void close();
+
+            //**************
+            // Consumer
+            //**************
+
+            /// Waits for the next batch after the ones already taken; returns nullptr if the queue is closed and has no more batches
+            const batch* next_batch();
+            /// Returns the next batch if one is queued, without waiting; otherwise returns nullptr
+            const batch* try_next_batch();
+            /// Returns the oldest batch taken with next_batch() or try_next_batch() to the producer
+            void release_batch();
+
+            //**************
+            // Statistics
+            //**************
+
+            size_t get_depth() const;
+            size_t get_high_water() const;
+            uint64_t get_n_stalls() const;
+            /// Total time the producer has spent waiting for a free batch, in ns
+            uint64_t get_stall_time() const;
+            uint64_t get_n_dropped() const;
+
+            void reset_stats();
+
+            /// Fills a_status with the summary described above
+            void fill_status( scarab::param_node& a_status ) const;
+
+        private:
+            bool get_free_batch( std::chrono::milliseconds a_max_stall );
+            void queue_batch();
+
+            // the sizes are atomic so that fill_status() can read them while allocate() runs on another thread
+            std::atomic< size_t > f_n_batches;
+            std::atomic< size_t > f_batch_size;
+            size_t f_record_size;
+            std::vector< int8_t > f_storage; // over-allocated by s_alignment; the batches start at the first aligned address
+            std::vector< batch > f_batches;
+
+            // batches f_head, f_head + 1, ... (mod n-batches) are queued; the producer fills the one after them
+            size_t f_head;
+            std::atomic< size_t > f_n_queued;
+            bool f_closed;
+            batch* f_filling; // only used by the producer
+            size_t f_n_taken; // number of the queued batches that the consumer holds; only used by the consumer
+
+            std::mutex f_mutex;
+            std::condition_variable f_batch_queued;
+            std::condition_variable f_batch_released;
+
+            std::atomic< size_t > f_high_water;
+            std::atomic< uint64_t > f_n_stalls;
+            std::atomic< uint64_t > f_stall_time;
+            std::atomic< uint64_t > f_n_dropped;
+    };
+
+    inline size_t record_batch_queue::get_n_batches() const
+    {
+        return f_n_batches.load( std::memory_order_relaxed );
+    }
+
+    inline size_t record_batch_queue::get_batch_size() const
+    {
+        return f_batch_size.load( std::memory_order_relaxed );
+    }
+
+    inline size_t record_batch_queue::get_record_size() const
+    {
+        return f_record_size;
+    }
+
+    inline const int8_t* record_batch_queue::get_storage() const
+    {
+        return f_batches.empty() ? nullptr : f_batches.front().f_data;
+    }
+
+    inline size_t record_batch_queue::get_storage_size() const
+    {
+        return f_batches.empty() ? 0 : f_storage.size() - ( f_batches.front().f_data - f_storage.data() );
+    }
+
+    inline int8_t* record_batch_queue::begin_record( std::chrono::milliseconds a_max_stall )
+    {
+        if( f_filling == nullptr && ! get_free_batch( a_max_stall ) ) return nullptr;
+        return f_filling->f_data + f_filling->f_n_records * f_record_size;
+    }
+
+    inline void record_batch_queue::commit_record( uint64_t a_id, uint64_t a_time, bool a_is_new_acq )
+    {
+        record& t_record = f_filling->f_records[ f_filling->f_n_records ];
+        t_record.f_id = a_id;
+        t_record.f_time = a_time;
+        t_record.f_is_new_acq = a_is_new_acq;
+        t_record.f_data = f_filling->f_data + f_filling->f_n_records * f_record_size;
+        if( ++f_filling->f_n_records == f_batch_size.load( std::memory_order_relaxed ) ) queue_batch();
+        return;
+    }
+
+    inline size_t record_batch_queue::get_depth() const
+    {
+        return f_n_queued.load( std::memory_order_relaxed );
+    }
+
+    inline size_t record_batch_queue::get_high_water() const
+    {
+        return f_high_water.load( std::memory_order_relaxed );
+    }
+
+    inline uint64_t record_batch_queue::get_n_stalls() const
+    {
+        return f_n_stalls.load( std::memory_order_relaxed );
+    }
+
+    inline uint64_t record_batch_queue::get_stall_time() const
+    {
+        return f_stall_time.load( std::memory_order_relaxed );
+    }
+
+    inline uint64_t record_batch_queue::get_n_dropped() const
+    {
+        return f_n_dropped.load( std::memory_order_relaxed );
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_RECORD_BATCH_QUEUE_HH_ */
@@ -0,0 +1,346 @@
+/*
+ * record_compression.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "record_compression.hh"
+
+#include "psyllid_error.hh"
+
+#include "param.hh"
+
+#include <chrono>
+#include <cstring>
+
+namespace psyllid
+{
+
+    record_compression record_compression_from_string( const std::string& a_name )
+    {
+        if( a_name == "none" ) return record_compression::none;
+        if( a_name == "deflate" ) return record_compression::deflate;
+        if( a_name == "bitshuffle-deflate" ) return record_compression::bitshuffle_deflate;
+        throw error() << "Unknown compression <" << a_name << ">; the options are \"none\", \"deflate\" and \"bitshuffle-deflate\"";
+    }
+
+    std::string to_string( record_compression a_compression )
+    {
+        switch( a_compression )
+        {
+            case record_compression::none: return "none";
+            case record_compression::deflate: return "deflate";
+            case record_compression::bitshuffle_deflate: return "bitshuffle-deflate";
+        }
+        return "unknown";
+    }
+
+    namespace
+    {
+        // transposes the 8x8 bit matrix whose rows are the bytes of a_x (Hacker's Delight, section 7-3); it's its own inverse
+        inline uint64_t transpose_8x8( uint64_t a_x )
+        {
+            uint64_t t_t = ( a_x ^ ( a_x >> 7 ) ) & 0x00AA00AA00AA00AAULL;
+            a_x = a_x ^ t_t ^ ( t_t << 7 );
+            t_t = ( a_x ^ ( a_x >> 14 ) ) & 0x0000CCCC0000CCCCULL;
+            a_x = a_x ^ t_t ^ ( t_t << 14 );
+            t_t = ( a_x ^ ( a_x >> 28 ) ) & 0x00000000F0F0F0F0ULL;
+            a_x = a_x ^ t_t ^ ( t_t << 28 );
+            return a_x;
+        }
+    }
+
+    void bitshuffle( const int8_t* a_in, int8_t* a_out, size_t a_bytes )
+    {
+        size_t t_n_groups = a_bytes / 8;
+        for( size_t i_group = 0; i_group < t_n_groups; ++i_group )
+        {
+            uint64_t t_group;
+            ::memcpy( &t_group, a_in + 8 * i_group, 8 );
+            t_group = transpose_8x8( t_group );
+            for( unsigned i_plane = 0; i_plane < 8; ++i_plane )
+            {
+                a_out[ i_plane * t_n_groups + i_group ] = (int8_t)( t_group >> ( 8 * i_plane ) );
+            }
+        }
+        return;
+    }
+
+    void bitunshuffle( const int8_t* a_in, int8_t* a_out, size_t a_bytes )
+    {
+        size_t t_n_groups = a_bytes / 8;
+        for( size_t i_group = 0; i_group < t_n_groups; ++i_group )
+        {
+            uint64_t t_group = 0;
+            for( unsigned i_plane = 0; i_plane < 8; ++i_plane )
+            {
+                t_group |= (uint64_t)(uint8_t)a_in[ i_plane * t_n_groups + i_group ] << ( 8 * i_plane );
+            }
+            t_group = transpose_8x8( t_group );
+            ::memcpy( a_out + 8 * i_group, &t_group, 8 );
+        }
+        return;
+    }
+
+
+    //****************
+    // record_codec
+    //****************
+
+    record_codec::record_codec( record_compression a_compression, int a_level ) :
+            f_compression( a_compression ),
+            f_deflate(),
+            f_inflate(),
+            f_scratch()
+    {
+        ::memset( &f_deflate, 0, sizeof( f_deflate ) );
+        ::memset( &f_inflate, 0, sizeof( f_inflate ) );
+        // raw deflate streams (negative window bits): the records don't need zlib's header and checksum
+        if( deflateInit2( &f_deflate, a_level, Z_DEFLATED, -15, 8, Z_DEFAULT_STRATEGY ) != Z_OK )
+        {
+            throw error() << "Unable to initialize compression with level " << a_level;
+        }
+        if( inflateInit2( &f_inflate, -15 ) != Z_OK )
+        {
+            deflateEnd( &f_deflate );
+            throw error() << "Unable to initialize decompression";
+        }
+    }
+
+    record_codec::~record_codec()
+    {
+        deflateEnd( &f_deflate );
+        inflateEnd( &f_inflate );
+    }
+
+    size_t record_codec::compress( const int8_t* a_in, size_t a_bytes, int8_t* a_out )
+    {
+        if( f_compression == record_compression::none || a_bytes < 2 ) return 0;
+
+        const int8_t* t_in = a_in;
+        if( f_compression == record_compression::bitshuffle_deflate && a_bytes % 8 == 0 )
+        {
+            f_scratch.resize( a_bytes );
+            bitshuffle( a_in, f_scratch.data(), a_bytes );
+            t_in = f_scratch.data();
+        }
+
+        deflateReset( &f_deflate );
+        f_deflate.next_in = reinterpret_cast< Bytef* >( const_cast< int8_t* >( t_in ) );
+        f_deflate.avail_in = (uInt)a_bytes;
+        f_deflate.next_out = reinterpret_cast< Bytef* >( a_out );
+        // anything that doesn't fit in less than the record is stored as it is
+        f_deflate.avail_out = (uInt)( a_bytes - 1 );
+        if( deflate( &f_deflate, Z_FINISH ) != Z_STREAM_END ) return 0;
+        return f_deflate.total_out;
+    }
+
+    void record_codec::decompress( const int8_t* a_in, size_t a_stored_bytes, int8_t* a_out, size_t a_bytes )
+    {
+        bool t_shuffled = f_compression == record_compression::bitshuffle_deflate && a_bytes % 8 == 0;
+        int8_t* t_out = a_out;
+        if( t_shuffled )
+        {
+            f_scratch.resize( a_bytes );
+            t_out = f_scratch.data();
+        }
+
+        inflateReset( &f_inflate );
+        f_inflate.next_in = reinterpret_cast< Bytef* >( const_cast< int8_t* >( a_in ) );
+        f_inflate.avail_in = (uInt)a_stored_bytes;
+        f_inflate.next_out = reinterpret_cast< Bytef* >( t_out );
+        f_inflate.avail_out = (uInt)a_bytes;
+        if( inflate( &f_inflate, Z_FINISH ) != Z_STREAM_END || f_inflate.total_out != a_bytes )
+        {
+            throw error() << "Compressed record is corrupt";
+        }
+
+        if( t_shuffled ) bitunshuffle( t_out, a_out, a_bytes );
+        return;
+    }
+
+
+    //*********************
+    // record_compressor
+    //*********************
+
+    record_compressor::record_compressor() :
+            f_compression( record_compression::none ),
+            f_record_bytes( 0 ),
+            f_codecs(),
+            f_threads(),
+            f_n_threads( 0 ),
+            f_mutex(),
+            f_job_ready(),
+            f_job_done(),
+            f_job_number( 0 ),
+            f_stopping( false ),
+            f_job_records( nullptr ),
+            f_job_n( 0 ),
+            f_job_out( nullptr ),
+            f_job_sizes( nullptr ),
+            f_next_record( 0 ),
+            f_n_finished( 0 ),
+            f_n_records( 0 ),
+            f_bytes_in( 0 ),
+            f_bytes_out( 0 ),
+            f_busy_ns( 0 )
+    {
+    }
+
+    record_compressor::~record_compressor()
+    {
+        stop();
+    }
+
+    void record_compressor::start( record_compression a_compression, int a_level, unsigned a_n_threads, size_t a_record_bytes )
+    {
+        if( is_running() )
+        {
+            throw error() << "Record compressor is already running";
+        }
+        if( a_compression == record_compression::none || a_n_threads == 0 )
+        {
+            throw error() << "Record compressor needs a compression and at least one thread";
+        }
+
+        f_compression = a_compression;
+        f_record_bytes = a_record_bytes;
+        f_codecs.clear();
+        for( unsigned i_thread = 0; i_thread < a_n_threads; ++i_thread )
+        {
+            f_codecs.emplace_back( new record_codec( a_compression, a_level ) );
+        }
+        f_stopping = false;
+        f_job_number = 0;
+        for( unsigned i_thread = 0; i_thread < a_n_threads; ++i_thread )
+        {
+            f_threads.emplace_back( &record_compressor::run_worker, this, i_thread );
+        }
+        f_n_threads.store( a_n_threads );
+        return;
+    }
+
+    void record_compressor::stop()
+    {
+        if( ! is_running() ) return;
+        {
+            std::unique_lock< std::mutex > t_lock( f_mutex );
+            f_stopping = true;
+        }
+        f_job_ready.notify_all();
+        for( std::thread& t_thread : f_threads ) t_thread.join();
+        f_threads.clear();
+        f_n_threads.store( 0 );
+        f_codecs.clear();
+        return;
+    }
+
+    void record_compressor::compress( const int8_t* const* a_records, size_t a_n, int8_t* a_out, uint32_t* a_stored_bytes )
+    {
+        if( ! is_running() )
+        {
+            throw error() << "Record compressor is not running";
+        }
+        if( a_n == 0 ) return;
+
+        {
+            std::unique_lock< std::mutex > t_lock( f_mutex );
+            f_job_records = a_records;
+            f_job_n = a_n;
+            f_job_out = a_out;
+            f_job_sizes = a_stored_bytes;
+            f_next_record.store( 0 );
+            f_n_finished = 0;
+            ++f_job_number;
+        }
+        f_job_ready.notify_all();
+        {
+            std::unique_lock< std::mutex > t_lock( f_mutex );
+            f_job_done.wait( t_lock, [this](){ return f_n_finished == f_threads.size(); } );
+        }
+
+        // pack the records; each one starts at or before its slot, so moving them in order never overwrites one that's still to be moved
+        size_t t_offset = 0;
+        for( size_t i_record = 0; i_record < a_n; ++i_record )
+        {
+            if( a_stored_bytes[ i_record ] == 0 ) a_stored_bytes[ i_record ] = f_record_bytes;
+            if( t_offset != i_record * f_record_bytes )
+            {
+                ::memmove( a_out + t_offset, a_out + i_record * f_record_bytes, a_stored_bytes[ i_record ] );
+            }
+            t_offset += a_stored_bytes[ i_record ];
+        }
+        f_n_records.fetch_add( a_n, std::memory_order_relaxed );
+        f_bytes_in.fetch_add( a_n * f_record_bytes, std::memory_order_relaxed );
+        f_bytes_out.fetch_add( t_offset, std::memory_order_relaxed );
+        return;
+    }
+
+    void record_compressor::run_worker( unsigned a_thread )
+    {
+        record_codec& t_codec = *f_codecs[ a_thread ];
+        uint64_t t_job_number = 0;
+        std::unique_lock< std::mutex > t_lock( f_mutex );
+        while( true )
+        {
+            f_job_ready.wait( t_lock, [this, t_job_number](){ return f_stopping || f_job_number != t_job_number; } );
+            if( f_stopping ) return;
+            t_job_number = f_job_number;
+            const int8_t* const* t_records = f_job_records;
+            size_t t_n = f_job_n;
+            int8_t* t_out = f_job_out;
+            uint32_t* t_sizes = f_job_sizes;
+            t_lock.unlock();
+
+            auto t_start = std::chrono::steady_clock::now();
+            size_t i_record;
+            while( ( i_record = f_next_record.fetch_add( 1 ) ) < t_n )
+            {
+                int8_t* t_slot = t_out + i_record * f_record_bytes;
+                size_t t_size = t_codec.compress( t_records[ i_record ], f_record_bytes, t_slot );
+                if( t_size == 0 ) ::memcpy( t_slot, t_records[ i_record ], f_record_bytes );
+                t_sizes[ i_record ] = (uint32_t)t_size;
+            }
+            f_busy_ns.fetch_add( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - t_start ).count(), std::memory_order_relaxed );
+
+            t_lock.lock();
+            if( ++f_n_finished == f_threads.size() ) f_job_done.notify_one();
+        }
+    }
+
+    double record_compressor::get_ratio() const
+    {
+        uint64_t t_bytes_out = f_bytes_out.load( std::memory_order_relaxed );
+        if( t_bytes_out == 0 ) return 1.;
+        return (double)f_bytes_in.load( std::memory_order_relaxed ) / (double)t_bytes_out;
+    }
+
+    double record_compressor::get_rate_per_thread() const
+    {
+        uint64_t t_busy_ns = f_busy_ns.load( std::memory_order_relaxed );
+        if( t_busy_ns == 0 ) return 0.;
+        // bytes per ns is GB/s
+        return 1.e3 * (double)f_bytes_in.load( std::memory_order_relaxed ) / (double)t_busy_ns;
+    }
+
+    void record_compressor::reset_stats()
+    {
+        f_n_records.store( 0 );
+        f_bytes_in.store( 0 );
+        f_bytes_out.store( 0 );
+        f_busy_ns.store( 0 );
+        return;
+    }
+
+    void record_compressor::fill_status( scarab::param_node& a_status ) const
+    {
+        a_status.add( "compression", to_string( f_compression ) );
+        a_status.add( "n-threads", get_n_threads() );
+        a_status.add( "n-records", get_n_records() );
+        a_status.add( "ratio", get_ratio() );
+        a_status.add( "mb-per-sec-per-thread", get_rate_per_thread() );
+        return;
+    }
+
+} /* namespace psyllid */
@@ -0,0 +1,199 @@
+/*
+ * record_compression.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_RECORD_COMPRESSION_HH_
+#define PSYLLID_RECORD_COMPRESSION_HH_
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <zlib.h>
+
+namespace scarab
+{
+    class param_node;
+}
+
+namespace psyllid
+{
+
+    /*!
+     @enum record_compression
+     @brief Lossless compression of records
+
+     - none: records are stored as they are
+     - deflate: each record is compressed with deflate (zlib)
+     - bitshuffle_deflate: the bits of each record are transposed in groups of 8 bytes (bit planes), then compressed with deflate;
+       for low-amplitude 8-bit samples, most of the high bit planes are constant, so they compress much better than the bytes themselves
+    */
+    enum class record_compression : uint32_t
+    {
+        none = 0,
+        deflate = 1,
+        bitshuffle_deflate = 2
+    };
+
+    /// Returns the compression named a_name ("none", "deflate" or "bitshuffle-deflate"); throws psyllid::error for other names
+    record_compression record_compression_from_string( const std::string& a_name );
+    std::string to_string( record_compression a_compression );
+
+    /// Transposes the bits of a_bytes bytes (a multiple of 8) in groups of 8 bytes: bit plane k of group g goes to a_out[ k * a_bytes / 8 + g ]
+    void bitshuffle( const int8_t* a_in, int8_t* a_out, size_t a_bytes );
+    /// Reverses bitshuffle()
+    void bitunshuffle( const int8_t* a_in, int8_t* a_out, size_t a_bytes );
+
+
+    /*!
+     @class record_codec
+     @brief Compresses and decompresses single records, reusing its zlib state and scratch memory
+
+     @details
+     A record is only stored compressed if that makes it smaller.
+     Bitshuffling needs the record size to be a multiple of 8 bytes; other records are compressed without it.
+
+     Not thread-safe: use one codec per thread.
+    */
+    class record_codec
+    {
+        public:
+            /// a_level is the zlib compression level (1: fastest, to 9: smallest)
+            record_codec( record_compression a_compression, int a_level );
+            ~record_codec();
+
+            record_codec( const record_codec& ) = delete;
+            record_codec& operator=( const record_codec& ) = delete;
+
+            record_compression get_compression() const;
+
+            /// Compresses a_bytes bytes from a_in into a_out, which must hold a_bytes bytes.
+            /// Returns the compressed size, or 0 if compressing wouldn't make the record smaller (a_out is then not meaningful).
+            size_t compress( const int8_t* a_in, size_t a_bytes, int8_t* a_out );
+
+            /// Decompresses a_stored_bytes bytes from a_in into a_bytes bytes at a_out; throws psyllid::error if the data are corrupt
+            void decompress( const int8_t* a_in, size_t a_stored_bytes, int8_t* a_out, size_t a_bytes );
+
+        private:
+            record_compression f_compression;
+            z_stream f_deflate;
+            z_stream f_inflate;
+            std::vector< int8_t > f_scratch;
+    };
+
+    inline record_compression record_codec::get_compression() const
+    {
+        return f_compression;
+    }
+
+
+    /*!
+     @class record_compressor
+     @brief Compresses batches of records on a pool of threads
+
+     @details
+     compress() splits a batch between the pool's threads and returns when every record is done.  The compressed records are packed
+     back to back in the output, in order; a record that doesn't shrink is copied as it is.
+
+     The statistics include the compression ratio, and the rate at which one thread compresses (MB/s of uncompressed data per thread-second
+     spent compressing), which tells how many threads are needed to keep up with a given data rate.
+
+     start(), stop(), compress() and reset_stats() must not be called concurrently.  The statistics (and fill_status()) can be read from any thread.
+
+     The status contains:
+     - "compression": string -- the compression used
+     - "n-threads": uint -- number of compression threads
+     - "n-records": uint -- number of records compressed
+     - "ratio": double -- uncompressed bytes / stored bytes
+     - "mb-per-sec-per-thread": double -- MB of uncompressed data compressed per second of a thread's time
+    */
+    class record_compressor
+    {
+        public:
+            record_compressor();
+            ~record_compressor();
+
+            record_compressor( const record_compressor& ) = delete;
+            record_compressor& operator=( const record_compressor& ) = delete;
+
+            /// Starts a_n_threads threads for records of a_record_bytes; throws psyllid::error if a_compression is none or a_n_threads is 0
+            void start( record_compression a_compression, int a_level, unsigned a_n_threads, size_t a_record_bytes );
+            void stop();
+            bool is_running() const;
+
+            /// Compresses a_n records, a_records[ i ] pointing to record i; the records are packed into a_out, which must hold a_n records,
+            /// and a_stored_bytes[ i ] gets the size record i is stored with (record i is compressed if that's less than the record size)
+            void compress( const int8_t* const* a_records, size_t a_n, int8_t* a_out, uint32_t* a_stored_bytes );
+
+            record_compression get_compression() const;
+            unsigned get_n_threads() const;
+
+            uint64_t get_n_records() const;
+            /// Uncompressed bytes / stored bytes; 1 if nothing has been compressed
+            double get_ratio() const;
+            /// MB of uncompressed data per second of thread time spent compressing
+            double get_rate_per_thread() const;
+
+            void reset_stats();
+
+            /// Fills a_status with the summary described above
+            void fill_status( scarab::param_node& a_status ) const;
+
+        private:
+            void run_worker( unsigned a_thread );
+
+            record_compression f_compression;
+            size_t f_record_bytes;
+            std::vector< std::unique_ptr< record_codec > > f_codecs; // one per thread
+            std::vector< std::thread > f_threads;
+            std::atomic< unsigned > f_n_threads;
+
+            // the current job: every thread takes part in every job, and the next job isn't posted until they've all finished
+            std::mutex f_mutex;
+            std::condition_variable f_job_ready;
+            std::condition_variable f_job_done;
+            uint64_t f_job_number;
+            bool f_stopping;
+            const int8_t* const* f_job_records;
+            size_t f_job_n;
+            int8_t* f_job_out; // record i is compressed into a_out + i * record-bytes, and then packed
+            uint32_t* f_job_sizes; // compressed size of each record; 0 if it didn't shrink
+            std::atomic< size_t > f_next_record;
+            unsigned f_n_finished;
+
+            std::atomic< uint64_t > f_n_records;
+            std::atomic< uint64_t > f_bytes_in;
+            std::atomic< uint64_t > f_bytes_out;
+            std::atomic< uint64_t > f_busy_ns;
+    };
+
+    inline bool record_compressor::is_running() const
+    {
+        return ! f_threads.empty();
+    }
+
+    inline record_compression record_compressor::get_compression() const
+    {
+        return f_compression;
+    }
+
+    inline unsigned record_compressor::get_n_threads() const
+    {
+        return f_n_threads.load( std::memory_order_relaxed );
+    }
+
+    inline uint64_t record_compressor::get_n_records() const
+    {
+        return f_n_records.load( std::memory_order_relaxed );
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_RECORD_COMPRESSION_HH_ */
@@ -0,0 +1,189 @@
+/*
+ * shm_packet_ring.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "shm_packet_ring.hh"
+
+#include "psyllid_error.hh"
+
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+static_assert( PSYLLID_SHM_TAP_PAYLOAD_SIZE == PAYLOAD_SIZE, "shared-memory slot payloads must hold one packet payload" );
+static_assert( sizeof( psyllid_shm_tap_header ) == 64 && sizeof( psyllid_shm_tap_reader_entry ) == 64, "shared-memory header and reader entries should each fill one cache line" );
+static_assert( sizeof( psyllid_shm_tap_slot ) == 64 + PAYLOAD_SIZE, "shared-memory slot header should fill one cache line" );
+
+namespace psyllid
+{
+
+    shm_packet_ring::shm_packet_ring() :
+            f_name(),
+            f_n_slots( 0 ),
+            f_map( nullptr ),
+            f_map_size( 0 ),
+            f_header( nullptr ),
+            f_slots( nullptr ),
+            f_n_published( 0 ),
+            f_map_mutex()
+    {
+    }
+
+    shm_packet_ring::~shm_packet_ring()
+    {
+        destroy();
+    }
+
+    void shm_packet_ring::create( const std::string& a_name, size_t a_n_slots, uint32_t a_data_type )
+    {
+        if( a_n_slots == 0 )
+        {
+            throw error() << "Shared-memory ring must have at least one slot";
+        }
+        if( a_name.size() < 2 || a_name[ 0 ] != '/' || a_name.find( '/', 1 ) != std::string::npos )
+        {
+            throw error() << "Invalid shared-memory name <" << a_name << ">; it should be of the form \"/name\"";
+        }
+        destroy();
+
+        // a ring left behind by a previous process is replaced; its readers keep their mapping of the old memory
+        ::shm_unlink( a_name.c_str() );
+        int t_fd = ::shm_open( a_name.c_str(), O_CREAT | O_EXCL | O_RDWR, 0660 );
+        if( t_fd < 0 )
+        {
+            throw error() << "Unable to create shared memory <" << a_name << ">: " << strerror( errno );
+        }
+        // the mode passed to shm_open is masked by the umask
+        ::fchmod( t_fd, 0660 );
+
+        size_t t_size = psyllid_shm_tap_size( a_n_slots );
+        if( ::ftruncate( t_fd, t_size ) != 0 )
+        {
+            int t_errno = errno;
+            ::close( t_fd );
+            ::shm_unlink( a_name.c_str() );
+            throw error() << "Unable to size shared memory <" << a_name << "> to " << t_size << " bytes: " << strerror( t_errno );
+        }
+
+#ifdef MAP_POPULATE
+        int t_map_flags = MAP_SHARED | MAP_POPULATE;
+#else
+        int t_map_flags = MAP_SHARED;
+#endif
+        void* t_map = ::mmap( nullptr, t_size, PROT_READ | PROT_WRITE, t_map_flags, t_fd, 0 );
+        int t_errno = errno;
+        ::close( t_fd );
+        if( t_map == MAP_FAILED )
+        {
+            ::shm_unlink( a_name.c_str() );
+            throw error() << "Unable to map shared memory <" << a_name << ">: " << strerror( t_errno );
+        }
+
+        std::unique_lock< std::mutex > t_lock( f_map_mutex );
+        f_name = a_name;
+        f_n_slots = a_n_slots;
+        f_map = t_map;
+        f_map_size = t_size;
+        f_header = static_cast< psyllid_shm_tap_header* >( t_map );
+        f_slots = static_cast< char* >( t_map ) + sizeof( psyllid_shm_tap_header ) + PSYLLID_SHM_TAP_MAX_READERS * sizeof( psyllid_shm_tap_reader_entry );
+        f_n_published = 0;
+
+        // ftruncate zero-fills, so the reader entries are free; slots are marked so that no sequence number matches them
+        for( size_t i_slot = 0; i_slot < f_n_slots; ++i_slot )
+        {
+            slot( i_slot )->sequence = PSYLLID_SHM_TAP_WRITING;
+        }
+
+        f_header->version = PSYLLID_SHM_TAP_VERSION;
+        f_header->data_type = a_data_type;
+        f_header->max_readers = PSYLLID_SHM_TAP_MAX_READERS;
+        f_header->n_slots = f_n_slots;
+        f_header->slot_size = sizeof( psyllid_shm_tap_slot );
+        f_header->slots_offset = f_slots - static_cast< char* >( t_map );
+        f_header->writer_pid = ::getpid();
+        f_header->closed = 0;
+        f_header->n_published = 0;
+        // readers check the magic number last
+        __atomic_store_n( &f_header->magic, PSYLLID_SHM_TAP_MAGIC, __ATOMIC_RELEASE );
+        return;
+    }
+
+    void shm_packet_ring::destroy()
+    {
+        std::unique_lock< std::mutex > t_lock( f_map_mutex );
+        if( f_map == nullptr ) return;
+        __atomic_store_n( &f_header->closed, 1, __ATOMIC_RELEASE );
+        ::munmap( f_map, f_map_size );
+        ::shm_unlink( f_name.c_str() );
+        f_map = nullptr;
+        f_map_size = 0;
+        f_header = nullptr;
+        f_slots = nullptr;
+        f_n_slots = 0;
+        return;
+    }
+
+    void shm_packet_ring::publish( const roach_packet_data& a_data, uint64_t a_pkt_in_session )
+    {
+        uint64_t t_sequence = f_n_published;
+        psyllid_shm_tap_slot* t_slot = slot( t_sequence );
+
+        // mark the slot as being written before touching it, so that readers of the packet being replaced can detect it
+        __atomic_store_n( &t_slot->sequence, PSYLLID_SHM_TAP_WRITING, __ATOMIC_RELAXED );
+        __atomic_thread_fence( __ATOMIC_RELEASE );
+
+        t_slot->pkt_in_session = a_pkt_in_session;
+        t_slot->unix_time = a_data.get_unix_time();
+        t_slot->pkt_in_batch = a_data.get_pkt_in_batch();
+        t_slot->digital_id = a_data.get_digital_id();
+        t_slot->if_id = a_data.get_if_id();
+        t_slot->user_data_1 = a_data.get_user_data_1();
+        t_slot->user_data_0 = a_data.get_user_data_0();
+        t_slot->reserved_0 = a_data.get_reserved_0();
+        t_slot->reserved_1 = a_data.get_reserved_1();
+        t_slot->freq_not_time = a_data.get_freq_not_time() ? 1 : 0;
+        ::memcpy( t_slot->payload, a_data.get_raw_array(), PAYLOAD_SIZE );
+
+        __atomic_store_n( &t_slot->sequence, t_sequence, __ATOMIC_RELEASE );
+        f_n_published = t_sequence + 1;
+        __atomic_store_n( &f_header->n_published, f_n_published, __ATOMIC_RELEASE );
+        return;
+    }
+
+    uint64_t shm_packet_ring::get_n_published() const
+    {
+        std::unique_lock< std::mutex > t_lock( f_map_mutex );
+        if( f_header == nullptr ) return 0;
+        return __atomic_load_n( &f_header->n_published, __ATOMIC_ACQUIRE );
+    }
+
+    std::vector< shm_packet_ring::reader_status > shm_packet_ring::get_readers() const
+    {
+        std::vector< reader_status > t_readers;
+        std::unique_lock< std::mutex > t_lock( f_map_mutex );
+        if( f_map == nullptr ) return t_readers;
+
+        uint64_t t_n_published = __atomic_load_n( &f_header->n_published, __ATOMIC_ACQUIRE );
+        for( unsigned i_reader = 0; i_reader < PSYLLID_SHM_TAP_MAX_READERS; ++i_reader )
+        {
+            const psyllid_shm_tap_reader_entry* t_entry = reader_entry( i_reader );
+            int32_t t_pid = __atomic_load_n( &t_entry->pid, __ATOMIC_ACQUIRE );
+            if( t_pid == 0 ) continue;
+            uint64_t t_next = __atomic_load_n( &t_entry->next, __ATOMIC_ACQUIRE );
+            reader_status t_status;
+            t_status.f_pid = t_pid;
+            t_status.f_lag = t_n_published > t_next ? t_n_published - t_next : 0;
+            t_status.f_n_read = __atomic_load_n( &t_entry->n_read, __ATOMIC_RELAXED );
+            // a reader counts the packets it lost when it skips over them; until then, those beyond the ring's length are lost too
+            t_status.f_n_overruns = __atomic_load_n( &t_entry->n_overruns, __ATOMIC_RELAXED ) + ( t_status.f_lag > f_n_slots ? t_status.f_lag - f_n_slots : 0 );
+            t_readers.push_back( t_status );
+        }
+        return t_readers;
+    }
+
+} /* namespace psyllid */
@@ -0,0 +1,115 @@
+/*
+ * shm_packet_ring.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_SHM_PACKET_RING_HH_
+#define PSYLLID_SHM_PACKET_RING_HH_
+
+#include "psyllid_shm_tap.h"
+#include "roach_packet.hh"
+
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace psyllid
+{
+
+    /*!
+     @class shm_packet_ring
+     @brief Writer of a ring of packets in POSIX shared memory, which other processes can read in place
+
+     @details
+     The layout of the shared memory, and the functions that readers use, are in the C header psyllid_shm_tap.h.
+
+     Each packet published gets the next sequence number and goes in slot (sequence % n-slots).  There is one writer and
+     up to PSYLLID_SHM_TAP_MAX_READERS readers, each of which receives every packet.  The writer never waits for the readers,
+     and never looks at them while publishing: a reader that falls behind skips the packets that were overwritten and counts them as overruns.
+     get_readers() adds the packets that a stalled reader has lost but not yet skipped.
+     The slots are protected by sequence numbers, so a reader can tell whether a packet was overwritten while it was reading it.
+
+     The shared-memory object is created with permissions 0660, so readers must run as the same user or group as psyllid.
+
+     Thread safety: publish() may only be called by one thread, and not while the ring is being created or destroyed.
+     get_n_published() and get_readers() may be called from any thread, including while the ring is created or destroyed:
+     the mapping is only changed, and only read by them, with the map mutex locked.
+    */
+    class shm_packet_ring
+    {
+        public:
+            struct reader_status
+            {
+                int32_t f_pid;
+                uint64_t f_lag; // packets published but not yet read
+                uint64_t f_n_read;
+                uint64_t f_n_overruns; // packets overwritten before the reader read them
+            };
+
+        public:
+            shm_packet_ring();
+            virtual ~shm_packet_ring();
+
+            shm_packet_ring( const shm_packet_ring& ) = delete;
+            shm_packet_ring& operator=( const shm_packet_ring& ) = delete;
+
+            /// Creates the shared-memory object with the given name (e.g. "/psyllid_tap"), replacing any existing object with that name; throws psyllid::error on failure
+            void create( const std::string& a_name, size_t a_n_slots, uint32_t a_data_type );
+            /// Marks the ring as closed for the readers, unmaps it, and removes the name; readers that have it mapped can finish reading
+            void destroy();
+
+            bool is_created() const;
+            const std::string& get_name() const;
+            size_t get_n_slots() const;
+
+            /// Writes the packet header values and payload to the next slot
+            void publish( const roach_packet_data& a_data, uint64_t a_pkt_in_session );
+
+            uint64_t get_n_published() const;
+            /// Status of the readers currently attached
+            std::vector< reader_status > get_readers() const;
+
+        private:
+            psyllid_shm_tap_slot* slot( uint64_t a_sequence );
+            psyllid_shm_tap_reader_entry* reader_entry( unsigned a_index ) const;
+
+            std::string f_name;
+            size_t f_n_slots;
+            void* f_map;
+            size_t f_map_size;
+            psyllid_shm_tap_header* f_header;
+            char* f_slots;
+            uint64_t f_n_published;
+
+            mutable std::mutex f_map_mutex;
+    };
+
+    inline bool shm_packet_ring::is_created() const
+    {
+        return f_map != nullptr;
+    }
+
+    inline const std::string& shm_packet_ring::get_name() const
+    {
+        return f_name;
+    }
+
+    inline size_t shm_packet_ring::get_n_slots() const
+    {
+        return f_n_slots;
+    }
+
+    inline psyllid_shm_tap_slot* shm_packet_ring::slot( uint64_t a_sequence )
+    {
+        return reinterpret_cast< psyllid_shm_tap_slot* >( f_slots + ( a_sequence % f_n_slots ) * sizeof( psyllid_shm_tap_slot ) );
+    }
+
+    inline psyllid_shm_tap_reader_entry* shm_packet_ring::reader_entry( unsigned a_index ) const
+    {
+        return reinterpret_cast< psyllid_shm_tap_reader_entry* >( reinterpret_cast< char* >( f_map ) + sizeof( psyllid_shm_tap_header ) ) + a_index;
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_SHM_PACKET_RING_HH_ */
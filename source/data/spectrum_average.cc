@@ -0,0 +1,52 @@
+/*
+ * spectrum_average.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "spectrum_average.hh"
+
+#include "psyllid_error.hh"
+#include "roach_packet.hh"
+
+#include <algorithm>
+#include <cmath>
+
+namespace psyllid
+{
+    double spectrum_rate( unsigned a_acq_rate )
+    {
+        return (double)a_acq_rate * 1.e6 / (double)(PAYLOAD_SIZE / 2);
+    }
+
+    unsigned spectra_per_integration( unsigned a_n_spectra, double a_integration_time, unsigned a_acq_rate )
+    {
+        if( a_integration_time > 0. )
+        {
+            a_n_spectra = std::max< long >( 1, lrint( a_integration_time * spectrum_rate( a_acq_rate ) ) );
+        }
+        if( a_n_spectra == 0 )
+        {
+            throw error() << "Number of spectra per integration must be positive";
+        }
+        return a_n_spectra;
+    }
+
+    void average_spectra( float* a_sum, unsigned a_n_spectra, unsigned a_decimation, float* a_out, size_t a_n_out )
+    {
+        const float t_norm = 1.f / ( (float)a_n_spectra * (float)a_decimation );
+        const float* t_sum = a_sum;
+        for( size_t i_out = 0; i_out < a_n_out; ++i_out )
+        {
+            float t_bin_sum = 0.f;
+            for( unsigned i_sub = 0; i_sub < a_decimation; ++i_sub, ++t_sum )
+            {
+                t_bin_sum += *t_sum;
+            }
+            a_out[ i_out ] = t_bin_sum * t_norm;
+        }
+        std::fill( a_sum, a_sum + a_n_out * a_decimation, 0.f );
+        return;
+    }
+
+} /* namespace psyllid */
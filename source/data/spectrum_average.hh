@@ -0,0 +1,33 @@
+/*
+ * spectrum_average.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_SPECTRUM_AVERAGE_HH_
+#define PSYLLID_SPECTRUM_AVERAGE_HH_
+
+#include <cstddef> // for size_t
+
+namespace psyllid
+{
+    /*!
+     @brief Helpers for averaging power spectra over time and frequency
+
+     @details
+     Used by the nodes that integrate freq_data power spectra (spectrum_integrator and spectrum_monitor).
+     The spectra are summed with accumulate_power (see spectrum_kernels.hh); these helpers set the integration length and produce the average.
+    */
+
+    /// Number of power spectra per second for a digitizer acquisition rate in MHz (one spectrum per freq_data packet)
+    double spectrum_rate( unsigned a_acq_rate );
+
+    /// Returns the number of spectra to average: the number in a_integration_time (s), at least 1, if a_integration_time > 0, and a_n_spectra otherwise; throws psyllid::error if that's 0
+    unsigned spectra_per_integration( unsigned a_n_spectra, double a_integration_time, unsigned a_acq_rate );
+
+    /// Averages a_n_spectra summed spectra, and groups of a_decimation adjacent bins, into a_n_out output bins; a_sum holds a_n_out * a_decimation bins and is cleared
+    void average_spectra( float* a_sum, unsigned a_n_spectra, unsigned a_decimation, float* a_out, size_t a_n_out );
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_SPECTRUM_AVERAGE_HH_ */
@@ -0,0 +1,391 @@
+/*
+ * spectrum_kernels.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "spectrum_kernels.hh"
+
+#include "psyllid_error.hh"
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+
+#if defined( __x86_64__ ) || defined( __i386__ )
+#define PSYLLID_X86_KERNELS
+#include <immintrin.h>
+#endif
+
+namespace psyllid
+{
+    // 10 * log10( 2 ): converts log2 to dB
+    static const float s_db_per_log2 = 3.01029995664f;
+
+    // Coefficients of the polynomial approximation of log2( 1 + t ) on [0, 1), lowest order first;
+    // the maximum error is 1.5e-5 (4.4e-5 dB)
+    static const float s_log2_c1 = 1.4419656f;
+    static const float s_log2_c2 = -0.70966721f;
+    static const float s_log2_c3 = 0.41762183f;
+    static const float s_log2_c4 = -0.1963145f;
+    static const float s_log2_c5 = 0.046409033f;
+
+
+    std::string to_string( kernel_isa a_isa )
+    {
+        switch( a_isa )
+        {
+            case kernel_isa::scalar: return "scalar";
+            case kernel_isa::sse2: return "sse2";
+            case kernel_isa::avx2: return "avx2";
+        }
+        return "unknown";
+    }
+
+
+    //***********
+    // Scalar
+    //***********
+
+    void iq_to_power_scalar( const int8_t* a_iq, float* a_power, size_t a_n_samples )
+    {
+        for( size_t i_sample = 0; i_sample < a_n_samples; ++i_sample )
+        {
+            int32_t t_i = a_iq[ 2*i_sample ];
+            int32_t t_q = a_iq[ 2*i_sample + 1 ];
+            a_power[ i_sample ] = (float)( t_i * t_i + t_q * t_q );
+        }
+        return;
+    }
+
+    void iq_to_db_scalar( const int8_t* a_iq, float* a_db, size_t a_n_samples )
+    {
+        for( size_t i_sample = 0; i_sample < a_n_samples; ++i_sample )
+        {
+            int32_t t_i = a_iq[ 2*i_sample ];
+            int32_t t_q = a_iq[ 2*i_sample + 1 ];
+            a_db[ i_sample ] = 10.f * std::log10( std::max( (float)( t_i * t_i + t_q * t_q ), s_power_floor ) );
+        }
+        return;
+    }
+
+    void accumulate_power_scalar( const int8_t* a_iq, float* a_sum, size_t a_n_samples )
+    {
+        for( size_t i_sample = 0; i_sample < a_n_samples; ++i_sample )
+        {
+            int32_t t_i = a_iq[ 2*i_sample ];
+            int32_t t_q = a_iq[ 2*i_sample + 1 ];
+            a_sum[ i_sample ] += (float)( t_i * t_i + t_q * t_q );
+        }
+        return;
+    }
+
+    void max_hold_power_scalar( const int8_t* a_iq, float* a_max, size_t a_n_samples )
+    {
+        for( size_t i_sample = 0; i_sample < a_n_samples; ++i_sample )
+        {
+            int32_t t_i = a_iq[ 2*i_sample ];
+            int32_t t_q = a_iq[ 2*i_sample + 1 ];
+            a_max[ i_sample ] = std::max( a_max[ i_sample ], (float)( t_i * t_i + t_q * t_q ) );
+        }
+        return;
+    }
+
+
+#ifdef PSYLLID_X86_KERNELS
+
+    //***********
+    // SSE2
+    //***********
+
+    // Power of 8 IQ pairs (16 bytes); pairs 0-3 go in a_lo, and 4-7 in a_hi
+    __attribute__(( target( "sse2" ) ))
+    static inline void power_8_sse2( const int8_t* a_iq, __m128& a_lo, __m128& a_hi )
+    {
+        __m128i t_bytes = _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_iq ) );
+        // interleaving the bytes with themselves and shifting right sign-extends them to 16 bits
+        __m128i t_lo16 = _mm_srai_epi16( _mm_unpacklo_epi8( t_bytes, t_bytes ), 8 );
+        __m128i t_hi16 = _mm_srai_epi16( _mm_unpackhi_epi8( t_bytes, t_bytes ), 8 );
+        // madd gives I*I + Q*Q for each pair as a 32-bit integer
+        a_lo = _mm_cvtepi32_ps( _mm_madd_epi16( t_lo16, t_lo16 ) );
+        a_hi = _mm_cvtepi32_ps( _mm_madd_epi16( t_hi16, t_hi16 ) );
+        return;
+    }
+
+    __attribute__(( target( "sse2" ) ))
+    static inline __m128 power_to_db_sse2( __m128 a_power )
+    {
+        __m128i t_bits = _mm_castps_si128( _mm_max_ps( a_power, _mm_set1_ps( s_power_floor ) ) );
+        __m128 t_exp = _mm_cvtepi32_ps( _mm_sub_epi32( _mm_srli_epi32( t_bits, 23 ), _mm_set1_epi32( 127 ) ) );
+        __m128 t_t = _mm_sub_ps( _mm_castsi128_ps( _mm_or_si128( _mm_and_si128( t_bits, _mm_set1_epi32( 0x007fffff ) ), _mm_set1_epi32( 0x3f800000 ) ) ), _mm_set1_ps( 1.f ) );
+        __m128 t_poly = _mm_set1_ps( s_log2_c5 );
+        t_poly = _mm_add_ps( _mm_mul_ps( t_poly, t_t ), _mm_set1_ps( s_log2_c4 ) );
+        t_poly = _mm_add_ps( _mm_mul_ps( t_poly, t_t ), _mm_set1_ps( s_log2_c3 ) );
+        t_poly = _mm_add_ps( _mm_mul_ps( t_poly, t_t ), _mm_set1_ps( s_log2_c2 ) );
+        t_poly = _mm_add_ps( _mm_mul_ps( t_poly, t_t ), _mm_set1_ps( s_log2_c1 ) );
+        t_poly = _mm_mul_ps( t_poly, t_t );
+        return _mm_mul_ps( _mm_add_ps( t_exp, t_poly ), _mm_set1_ps( s_db_per_log2 ) );
+    }
+
+    __attribute__(( target( "sse2" ) ))
+    static void iq_to_power_sse2( const int8_t* a_iq, float* a_power, size_t a_n_samples )
+    {
+        size_t i_sample = 0;
+        __m128 t_lo, t_hi;
+        for( ; i_sample + 8 <= a_n_samples; i_sample += 8 )
+        {
+            power_8_sse2( a_iq + 2*i_sample, t_lo, t_hi );
+            _mm_storeu_ps( a_power + i_sample, t_lo );
+            _mm_storeu_ps( a_power + i_sample + 4, t_hi );
+        }
+        iq_to_power_scalar( a_iq + 2*i_sample, a_power + i_sample, a_n_samples - i_sample );
+        return;
+    }
+
+    __attribute__(( target( "sse2" ) ))
+    static void iq_to_db_sse2( const int8_t* a_iq, float* a_db, size_t a_n_samples )
+    {
+        size_t i_sample = 0;
+        __m128 t_lo, t_hi;
+        for( ; i_sample + 8 <= a_n_samples; i_sample += 8 )
+        {
+            power_8_sse2( a_iq + 2*i_sample, t_lo, t_hi );
+            _mm_storeu_ps( a_db + i_sample, power_to_db_sse2( t_lo ) );
+            _mm_storeu_ps( a_db + i_sample + 4, power_to_db_sse2( t_hi ) );
+        }
+        iq_to_db_scalar( a_iq + 2*i_sample, a_db + i_sample, a_n_samples - i_sample );
+        return;
+    }
+
+    __attribute__(( target( "sse2" ) ))
+    static void accumulate_power_sse2( const int8_t* a_iq, float* a_sum, size_t a_n_samples )
+    {
+        size_t i_sample = 0;
+        __m128 t_lo, t_hi;
+        for( ; i_sample + 8 <= a_n_samples; i_sample += 8 )
+        {
+            power_8_sse2( a_iq + 2*i_sample, t_lo, t_hi );
+            _mm_storeu_ps( a_sum + i_sample, _mm_add_ps( _mm_loadu_ps( a_sum + i_sample ), t_lo ) );
+            _mm_storeu_ps( a_sum + i_sample + 4, _mm_add_ps( _mm_loadu_ps( a_sum + i_sample + 4 ), t_hi ) );
+        }
+        accumulate_power_scalar( a_iq + 2*i_sample, a_sum + i_sample, a_n_samples - i_sample );
+        return;
+    }
+
+    __attribute__(( target( "sse2" ) ))
+    static void max_hold_power_sse2( const int8_t* a_iq, float* a_max, size_t a_n_samples )
+    {
+        size_t i_sample = 0;
+        __m128 t_lo, t_hi;
+        for( ; i_sample + 8 <= a_n_samples; i_sample += 8 )
+        {
+            power_8_sse2( a_iq + 2*i_sample, t_lo, t_hi );
+            _mm_storeu_ps( a_max + i_sample, _mm_max_ps( _mm_loadu_ps( a_max + i_sample ), t_lo ) );
+            _mm_storeu_ps( a_max + i_sample + 4, _mm_max_ps( _mm_loadu_ps( a_max + i_sample + 4 ), t_hi ) );
+        }
+        max_hold_power_scalar( a_iq + 2*i_sample, a_max + i_sample, a_n_samples - i_sample );
+        return;
+    }
+
+
+    //***********
+    // AVX2
+    //***********
+
+    // Power of 16 IQ pairs (32 bytes); pairs 0-7 go in a_lo, and 8-15 in a_hi
+    __attribute__(( target( "avx2" ) ))
+    static inline void power_16_avx2( const int8_t* a_iq, __m256& a_lo, __m256& a_hi )
+    {
+        __m256i t_lo16 = _mm256_cvtepi8_epi16( _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_iq ) ) );
+        __m256i t_hi16 = _mm256_cvtepi8_epi16( _mm_loadu_si128( reinterpret_cast< const __m128i* >( a_iq + 16 ) ) );
+        a_lo = _mm256_cvtepi32_ps( _mm256_madd_epi16( t_lo16, t_lo16 ) );
+        a_hi = _mm256_cvtepi32_ps( _mm256_madd_epi16( t_hi16, t_hi16 ) );
+        return;
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    static inline __m256 power_to_db_avx2( __m256 a_power )
+    {
+        __m256i t_bits = _mm256_castps_si256( _mm256_max_ps( a_power, _mm256_set1_ps( s_power_floor ) ) );
+        __m256 t_exp = _mm256_cvtepi32_ps( _mm256_sub_epi32( _mm256_srli_epi32( t_bits, 23 ), _mm256_set1_epi32( 127 ) ) );
+        __m256 t_t = _mm256_sub_ps( _mm256_castsi256_ps( _mm256_or_si256( _mm256_and_si256( t_bits, _mm256_set1_epi32( 0x007fffff ) ), _mm256_set1_epi32( 0x3f800000 ) ) ), _mm256_set1_ps( 1.f ) );
+        __m256 t_poly = _mm256_set1_ps( s_log2_c5 );
+        t_poly = _mm256_add_ps( _mm256_mul_ps( t_poly, t_t ), _mm256_set1_ps( s_log2_c4 ) );
+        t_poly = _mm256_add_ps( _mm256_mul_ps( t_poly, t_t ), _mm256_set1_ps( s_log2_c3 ) );
+        t_poly = _mm256_add_ps( _mm256_mul_ps( t_poly, t_t ), _mm256_set1_ps( s_log2_c2 ) );
+        t_poly = _mm256_add_ps( _mm256_mul_ps( t_poly, t_t ), _mm256_set1_ps( s_log2_c1 ) );
+        t_poly = _mm256_mul_ps( t_poly, t_t );
+        return _mm256_mul_ps( _mm256_add_ps( t_exp, t_poly ), _mm256_set1_ps( s_db_per_log2 ) );
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    static void iq_to_power_avx2( const int8_t* a_iq, float* a_power, size_t a_n_samples )
+    {
+        size_t i_sample = 0;
+        __m256 t_lo, t_hi;
+        for( ; i_sample + 16 <= a_n_samples; i_sample += 16 )
+        {
+            power_16_avx2( a_iq + 2*i_sample, t_lo, t_hi );
+            _mm256_storeu_ps( a_power + i_sample, t_lo );
+            _mm256_storeu_ps( a_power + i_sample + 8, t_hi );
+        }
+        iq_to_power_scalar( a_iq + 2*i_sample, a_power + i_sample, a_n_samples - i_sample );
+        return;
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    static void iq_to_db_avx2( const int8_t* a_iq, float* a_db, size_t a_n_samples )
+    {
+        size_t i_sample = 0;
+        __m256 t_lo, t_hi;
+        for( ; i_sample + 16 <= a_n_samples; i_sample += 16 )
+        {
+            power_16_avx2( a_iq + 2*i_sample, t_lo, t_hi );
+            _mm256_storeu_ps( a_db + i_sample, power_to_db_avx2( t_lo ) );
+            _mm256_storeu_ps( a_db + i_sample + 8, power_to_db_avx2( t_hi ) );
+        }
+        iq_to_db_scalar( a_iq + 2*i_sample, a_db + i_sample, a_n_samples - i_sample );
+        return;
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    static void accumulate_power_avx2( const int8_t* a_iq, float* a_sum, size_t a_n_samples )
+    {
+        size_t i_sample = 0;
+        __m256 t_lo, t_hi;
+        for( ; i_sample + 16 <= a_n_samples; i_sample += 16 )
+        {
+            power_16_avx2( a_iq + 2*i_sample, t_lo, t_hi );
+            _mm256_storeu_ps( a_sum + i_sample, _mm256_add_ps( _mm256_loadu_ps( a_sum + i_sample ), t_lo ) );
+            _mm256_storeu_ps( a_sum + i_sample + 8, _mm256_add_ps( _mm256_loadu_ps( a_sum + i_sample + 8 ), t_hi ) );
+        }
+        accumulate_power_scalar( a_iq + 2*i_sample, a_sum + i_sample, a_n_samples - i_sample );
+        return;
+    }
+
+    __attribute__(( target( "avx2" ) ))
+    static void max_hold_power_avx2( const int8_t* a_iq, float* a_max, size_t a_n_samples )
+    {
+        size_t i_sample = 0;
+        __m256 t_lo, t_hi;
+        for( ; i_sample + 16 <= a_n_samples; i_sample += 16 )
+        {
+            power_16_avx2( a_iq + 2*i_sample, t_lo, t_hi );
+            _mm256_storeu_ps( a_max + i_sample, _mm256_max_ps( _mm256_loadu_ps( a_max + i_sample ), t_lo ) );
+            _mm256_storeu_ps( a_max + i_sample + 8, _mm256_max_ps( _mm256_loadu_ps( a_max + i_sample + 8 ), t_hi ) );
+        }
+        max_hold_power_scalar( a_iq + 2*i_sample, a_max + i_sample, a_n_samples - i_sample );
+        return;
+    }
+
+#endif /* PSYLLID_X86_KERNELS */
+
+
+    //***************
+    // Dispatching
+    //***************
+
+    struct kernel_table
+    {
+        kernel_isa f_isa;
+        void (*f_iq_to_power)( const int8_t*, float*, size_t );
+        void (*f_iq_to_db)( const int8_t*, float*, size_t );
+        void (*f_accumulate_power)( const int8_t*, float*, size_t );
+        void (*f_max_hold_power)( const int8_t*, float*, size_t );
+    };
+
+    static const kernel_table s_scalar_kernels = { kernel_isa::scalar, &iq_to_power_scalar, &iq_to_db_scalar, &accumulate_power_scalar, &max_hold_power_scalar };
+#ifdef PSYLLID_X86_KERNELS
+    static const kernel_table s_sse2_kernels = { kernel_isa::sse2, &iq_to_power_sse2, &iq_to_db_sse2, &accumulate_power_sse2, &max_hold_power_sse2 };
+    static const kernel_table s_avx2_kernels = { kernel_isa::avx2, &iq_to_power_avx2, &iq_to_db_avx2, &accumulate_power_avx2, &max_hold_power_avx2 };
+#endif
+
+    static std::atomic< const kernel_table* > s_active_kernels( nullptr );
+
+    static const kernel_table* get_kernel_table( kernel_isa a_isa )
+    {
+        switch( a_isa )
+        {
+#ifdef PSYLLID_X86_KERNELS
+            case kernel_isa::avx2: return &s_avx2_kernels;
+            case kernel_isa::sse2: return &s_sse2_kernels;
+#endif
+            default: return &s_scalar_kernels;
+        }
+    }
+
+    static inline const kernel_table* kernels()
+    {
+        const kernel_table* t_table = s_active_kernels.load( std::memory_order_acquire );
+        if( t_table == nullptr )
+        {
+            t_table = get_kernel_table( best_kernel_isa() );
+            s_active_kernels.store( t_table, std::memory_order_release );
+        }
+        return t_table;
+    }
+
+    bool kernel_isa_supported( kernel_isa a_isa )
+    {
+        switch( a_isa )
+        {
+            case kernel_isa::scalar: return true;
+#ifdef PSYLLID_X86_KERNELS
+            case kernel_isa::sse2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports( "sse2" );
+            case kernel_isa::avx2:
+                __builtin_cpu_init();
+                return __builtin_cpu_supports( "avx2" );
+#endif
+            default: return false;
+        }
+    }
+
+    kernel_isa best_kernel_isa()
+    {
+        if( kernel_isa_supported( kernel_isa::avx2 ) ) return kernel_isa::avx2;
+        if( kernel_isa_supported( kernel_isa::sse2 ) ) return kernel_isa::sse2;
+        return kernel_isa::scalar;
+    }
+
+    kernel_isa active_kernel_isa()
+    {
+        return kernels()->f_isa;
+    }
+
+    void select_kernel_isa( kernel_isa a_isa )
+    {
+        if( ! kernel_isa_supported( a_isa ) )
+        {
+            throw error() << "Kernel instruction set <" << to_string( a_isa ) << "> is not supported on this CPU";
+        }
+        s_active_kernels.store( get_kernel_table( a_isa ), std::memory_order_release );
+        return;
+    }
+
+    void iq_to_power( const int8_t* a_iq, float* a_power, size_t a_n_samples )
+    {
+        kernels()->f_iq_to_power( a_iq, a_power, a_n_samples );
+        return;
+    }
+
+    void iq_to_db( const int8_t* a_iq, float* a_db, size_t a_n_samples )
+    {
+        kernels()->f_iq_to_db( a_iq, a_db, a_n_samples );
+        return;
+    }
+
+    void accumulate_power( const int8_t* a_iq, float* a_sum, size_t a_n_samples )
+    {
+        kernels()->f_accumulate_power( a_iq, a_sum, a_n_samples );
+        return;
+    }
+
+    void max_hold_power( const int8_t* a_iq, float* a_max, size_t a_n_samples )
+    {
+        kernels()->f_max_hold_power( a_iq, a_max, a_n_samples );
+        return;
+    }
+
+} /* namespace psyllid */
@@ -0,0 +1,105 @@
+/*
+ * spectrum_kernels.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_SPECTRUM_KERNELS_HH_
+#define PSYLLID_SPECTRUM_KERNELS_HH_
+
+#include "freq_data.hh"
+
+#include <cstddef> // for size_t
+#include <cstdint>
+#include <string>
+
+namespace psyllid
+{
+    /*!
+     @brief Vectorized kernels for computing power from int8 IQ data
+
+     @details
+     All kernels operate on a_n_samples interleaved (I, Q) pairs of int8_t, as stored in freq_data and time_data.
+     The power of a sample is I*I + Q*Q, which is exact in single-precision float for int8 inputs.
+
+     The dispatched kernels use the best instruction set available on the CPU (determined at runtime on first use).
+     The scalar versions are the reference implementations, and are also used on non-x86 architectures.
+
+     Kernels:
+     - iq_to_power: power = I^2 + Q^2
+     - iq_to_db: power in dB, 10 log10( power ); zero power is floored at s_power_floor (-30 dB)
+     - accumulate_power: sum += power (e.g. for averaging spectra)
+     - max_hold_power: max = max( max, power )
+
+     The vectorized dB kernel uses a polynomial approximation of log2; it agrees with the scalar version to better than 1e-4 dB.
+    */
+
+    enum class kernel_isa : unsigned
+    {
+        scalar = 0,
+        sse2 = 1,
+        avx2 = 2
+    };
+    std::string to_string( kernel_isa a_isa );
+
+    /// Returns true if the given instruction set can be used on this CPU
+    bool kernel_isa_supported( kernel_isa a_isa );
+    /// Returns the best instruction set available on this CPU
+    kernel_isa best_kernel_isa();
+    /// Returns the instruction set used by the dispatched kernels
+    kernel_isa active_kernel_isa();
+    /// Selects the instruction set used by the dispatched kernels; throws psyllid::error if it's not supported on this CPU
+    void select_kernel_isa( kernel_isa a_isa );
+
+    /// Power floor used by iq_to_db to avoid log(0)
+    static const float s_power_floor = 1.e-3f;
+
+    // Dispatched kernels
+
+    void iq_to_power( const int8_t* a_iq, float* a_power, size_t a_n_samples );
+    void iq_to_db( const int8_t* a_iq, float* a_db, size_t a_n_samples );
+    void accumulate_power( const int8_t* a_iq, float* a_sum, size_t a_n_samples );
+    void max_hold_power( const int8_t* a_iq, float* a_max, size_t a_n_samples );
+
+    // Scalar reference kernels
+
+    void iq_to_power_scalar( const int8_t* a_iq, float* a_power, size_t a_n_samples );
+    void iq_to_db_scalar( const int8_t* a_iq, float* a_db, size_t a_n_samples );
+    void accumulate_power_scalar( const int8_t* a_iq, float* a_sum, size_t a_n_samples );
+    void max_hold_power_scalar( const int8_t* a_iq, float* a_max, size_t a_n_samples );
+
+    // Convenience overloads for frequency data; the output arrays must have room for a_data.get_array_size() values
+
+    void iq_to_power( const freq_data& a_data, float* a_power );
+    void iq_to_db( const freq_data& a_data, float* a_db );
+    void accumulate_power( const freq_data& a_data, float* a_sum );
+    void max_hold_power( const freq_data& a_data, float* a_max );
+
+
+    inline void iq_to_power( const freq_data& a_data, float* a_power )
+    {
+        iq_to_power( a_data.get_array()[ 0 ], a_power, a_data.get_array_size() );
+        return;
+    }
+
+    inline void iq_to_db( const freq_data& a_data, float* a_db )
+    {
+        iq_to_db( a_data.get_array()[ 0 ], a_db, a_data.get_array_size() );
+        return;
+    }
+
+    inline void accumulate_power( const freq_data& a_data, float* a_sum )
+    {
+        accumulate_power( a_data.get_array()[ 0 ], a_sum, a_data.get_array_size() );
+        return;
+    }
+
+    inline void max_hold_power( const freq_data& a_data, float* a_max )
+    {
+        max_hold_power( a_data.get_array()[ 0 ], a_max, a_data.get_array_size() );
+        return;
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_SPECTRUM_KERNELS_HH_ */
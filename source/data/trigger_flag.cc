@@ -7,12 +7,23 @@
 
 #include "trigger_flag.hh"
 
+#include "psyllid_error.hh"
+
+#include <algorithm>
+
 namespace psyllid
 {
 
+    const unsigned trigger_flag::s_bits_per_word;
+    const unsigned trigger_flag::s_max_levels;
+
     trigger_flag::trigger_flag() :
             f_flag( false ),
-            f_id( 0 )
+            f_id( 0 ),
+            f_high_threshold( false ),
+            f_level( 0 ),
+            f_n_bins( 0 ),
+            f_bitmap()
     {
     }
 
@@ -20,4 +31,90 @@ namespace psyllid
     {
     }
 
+    void trigger_flag::resize_bitmap( size_t a_n_bins )
+    {
+        f_n_bins = a_n_bins;
+        f_bitmap.assign( ( a_n_bins + s_bits_per_word - 1 ) / s_bits_per_word, 0 );
+        return;
+    }
+
+    void trigger_flag::clear_bins()
+    {
+        std::fill( f_bitmap.begin(), f_bitmap.end(), 0 );
+        return;
+    }
+
+    size_t trigger_flag::n_bins_crossed() const
+    {
+        size_t t_count = 0;
+        for( auto t_word : f_bitmap )
+        {
+            t_count += __builtin_popcountll( t_word );
+        }
+        return t_count;
+    }
+
+    void trigger_flag::get_crossed_bins( std::vector< unsigned >& a_bins ) const
+    {
+        a_bins.clear();
+        for( unsigned i_word = 0; i_word < f_bitmap.size(); ++i_word )
+        {
+            bitmap_word_t t_word = f_bitmap[ i_word ];
+            while( t_word != 0 )
+            {
+                a_bins.push_back( i_word * s_bits_per_word + __builtin_ctzll( t_word ) );
+                t_word &= t_word - 1; // clear the lowest set bit
+            }
+        }
+        return;
+    }
+
+
+    void apply_threshold_levels( const float* a_power, const float* a_masks, unsigned a_n_levels, size_t a_n_bins, trigger_flag& a_flag )
+    {
+        if( a_n_levels > trigger_flag::s_max_levels )
+        {
+            throw error() << "Too many threshold levels: " << a_n_levels << "; the maximum is " << trigger_flag::s_max_levels;
+        }
+        if( a_flag.get_n_bins() != a_n_bins ) a_flag.resize_bitmap( a_n_bins );
+
+        const unsigned t_block_size = trigger_flag::s_bits_per_word;
+        trigger_flag::bitmap_word_t* t_bitmap = a_flag.get_bitmap();
+
+        // number of levels crossed by each bin in the current block
+        uint8_t t_n_crossed[ t_block_size ];
+        uint8_t t_max_level = 0;
+
+        for( size_t i_block_start = 0; i_block_start < a_n_bins; i_block_start += t_block_size )
+        {
+            const unsigned t_this_block = std::min< size_t >( t_block_size, a_n_bins - i_block_start );
+            const float* t_power = a_power + i_block_start;
+
+            std::fill( t_n_crossed, t_n_crossed + t_block_size, 0 );
+
+            // branch-free compares; these inner loops vectorize
+            for( unsigned i_level = 0; i_level < a_n_levels; ++i_level )
+            {
+                const float* t_mask = a_masks + i_level * a_n_bins + i_block_start;
+                for( unsigned i_bin = 0; i_bin < t_this_block; ++i_bin )
+                {
+                    t_n_crossed[ i_bin ] += t_power[ i_bin ] > t_mask[ i_bin ];
+                }
+            }
+
+            trigger_flag::bitmap_word_t t_word = 0;
+            for( unsigned i_bin = 0; i_bin < t_this_block; ++i_bin )
+            {
+                t_word |= trigger_flag::bitmap_word_t( t_n_crossed[ i_bin ] != 0 ) << i_bin;
+                t_max_level = std::max( t_max_level, t_n_crossed[ i_bin ] );
+            }
+            t_bitmap[ i_block_start / t_block_size ] = t_word;
+        }
+
+        a_flag.set_level( t_max_level );
+        a_flag.set_flag( t_max_level > 0 );
+        a_flag.set_high_threshold( a_n_levels > 0 && t_max_level == a_n_levels );
+        return;
+    }
+
 } /* namespace psyllid */
@@ -10,11 +10,28 @@
 
 #include "member_variables.hh"
 
+#include <cstddef> // for size_t
 #include <cstdint>
+#include <vector>
 
 namespace psyllid
 {
 
+    /*!
+     @class trigger_flag
+     @author N. S. Oblath
+
+     @brief Trigger decision for a single packet
+
+     @details
+     In addition to the overall decision (flag), the trigger flag carries:
+     - level: the highest threshold level crossed by any bin (0 if no level was crossed; 1 is the lowest threshold)
+     - high_threshold: kept for two-level triggering; true if the highest configured level was crossed
+     - bin bitmap: one bit per frequency bin, set for the bins that crossed the lowest threshold
+
+     The bitmap is sized once with resize_bitmap() and then reused for each packet, so it doesn't allocate in the data path.
+     Downstream nodes can use the bitmap (or the sparse list of crossed bins) to make sub-band or priority decisions without recomputing the power.
+    */
     class trigger_flag
     {
         public:
@@ -25,8 +42,84 @@ namespace psyllid
             mv_accessible( bool, flag );
             mv_accessible( uint64_t, id );
             mv_accessible( bool, high_threshold);
+            mv_accessible( unsigned, level );
+
+        public:
+            typedef uint64_t bitmap_word_t;
+            static const unsigned s_bits_per_word = 64;
+            /// Maximum number of threshold levels for apply_threshold_levels(); the per-bin level counts are 8 bits, so that the compares vectorize well
+            static const unsigned s_max_levels = 255;
+
+            /// Sets the number of bins covered by the bitmap, and clears it
+            void resize_bitmap( size_t a_n_bins );
+            /// Clears all of the bits in the bitmap
+            void clear_bins();
+
+            void set_bin( size_t a_bin );
+            bool bin_crossed( size_t a_bin ) const;
+
+            /// Number of bins that crossed the lowest threshold
+            size_t n_bins_crossed() const;
+            /// Fills a sparse list of the indices of the bins that crossed the lowest threshold
+            void get_crossed_bins( std::vector< unsigned >& a_bins ) const;
+
+            size_t get_n_bins() const;
+            const bitmap_word_t* get_bitmap() const;
+            bitmap_word_t* get_bitmap();
+            size_t get_n_bitmap_words() const;
+
+        private:
+            size_t f_n_bins;
+            std::vector< bitmap_word_t > f_bitmap;
     };
 
+    /*!
+     Evaluates N threshold levels against a power spectrum in a single pass over the bins, and fills the trigger flag.
+
+     The masks are stored level-major in a contiguous array: a_masks[ i_level * a_n_bins + i_bin ].
+     Levels must be ordered by increasing threshold, so that the number of levels a bin crosses is the highest level it crosses.
+     Bins are processed in blocks the size of a bitmap word, so that all levels for a block are compared while the block is in cache,
+     and the compare loops are simple enough to be vectorized by the compiler.
+
+     On return, the flag is set if any bin crossed level 1, the level is the highest level crossed by any bin,
+     high_threshold is set if the highest level was crossed, and the bitmap contains the bins that crossed level 1.
+     The bitmap is resized if needed.  The packet ID is not modified.
+     Throws psyllid::error if there are more than trigger_flag::s_max_levels levels.
+    */
+    void apply_threshold_levels( const float* a_power, const float* a_masks, unsigned a_n_levels, size_t a_n_bins, trigger_flag& a_flag );
+
+
+    inline void trigger_flag::set_bin( size_t a_bin )
+    {
+        f_bitmap[ a_bin / s_bits_per_word ] |= bitmap_word_t( 1 ) << ( a_bin % s_bits_per_word );
+        return;
+    }
+
+    inline bool trigger_flag::bin_crossed( size_t a_bin ) const
+    {
+        return ( f_bitmap[ a_bin / s_bits_per_word ] >> ( a_bin % s_bits_per_word ) ) & 1;
+    }
+
+    inline size_t trigger_flag::get_n_bins() const
+    {
+        return f_n_bins;
+    }
+
+    inline const trigger_flag::bitmap_word_t* trigger_flag::get_bitmap() const
+    {
+        return f_bitmap.data();
+    }
+
+    inline trigger_flag::bitmap_word_t* trigger_flag::get_bitmap()
+    {
+        return f_bitmap.data();
+    }
+
+    inline size_t trigger_flag::get_n_bitmap_words() const
+    {
+        return f_bitmap.size();
+    }
+
 } /* namespace psyllid */
 
 #endif /* DATA_TRIGGER_FLAG_HH_ */
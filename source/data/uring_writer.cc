@@ -0,0 +1,426 @@
+/*
+ * uring_writer.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "uring_writer.hh"
+
+#include "psyllid_error.hh"
+
+#include <algorithm>
+#include <cerrno>
+#include <climits>
+#include <cstring>
+#include <thread>
+
+#ifdef USE_IO_URING
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace psyllid
+{
+
+    const unsigned uring_writer::s_max_chain_length;
+
+    uring_writer::uring_writer() :
+            f_ring_fd( -1 ),
+            f_queue_depth( 0 ),
+            f_sq_ring( nullptr ),
+            f_sq_ring_size( 0 ),
+            f_sq_head( nullptr ),
+            f_sq_tail( nullptr ),
+            f_sq_mask( 0 ),
+            f_sq_entries( 0 ),
+            f_sq_array( nullptr ),
+            f_sqes( nullptr ),
+            f_sqes_size( 0 ),
+            f_cq_ring( nullptr ),
+            f_cq_ring_size( 0 ),
+            f_cq_head( nullptr ),
+            f_cq_tail( nullptr ),
+            f_cq_mask( 0 ),
+            f_cqes( nullptr ),
+            f_buffer( nullptr ),
+            f_buffer_size( 0 ),
+            f_chains(),
+            f_n_submitted( 0 ),
+            f_n_completed( 0 ),
+            f_error(),
+            f_submit_latency(),
+            f_complete_latency()
+    {
+    }
+
+    uring_writer::~uring_writer()
+    {
+        try
+        {
+            close();
+        }
+        catch( error& )
+        {
+        }
+    }
+
+    void uring_writer::reset_stats()
+    {
+        f_submit_latency.reset();
+        f_complete_latency.reset();
+        return;
+    }
+
+#ifdef USE_IO_URING
+
+    void uring_writer::initialize( unsigned a_queue_depth )
+    {
+        if( is_initialized() )
+        {
+            throw error() << "io_uring writer is already initialized";
+        }
+        if( a_queue_depth == 0 )
+        {
+            throw error() << "io_uring queue depth must be positive";
+        }
+
+        struct io_uring_params t_params;
+        ::memset( &t_params, 0, sizeof( t_params ) );
+        int t_fd = (int)::syscall( __NR_io_uring_setup, a_queue_depth * s_max_chain_length, &t_params );
+        if( t_fd < 0 )
+        {
+            throw error() << "Unable to set up io_uring: " << strerror( errno );
+        }
+        f_ring_fd = t_fd;
+        if( ( t_params.features & IORING_FEAT_RW_CUR_POS ) == 0 )
+        {
+            // IORING_FEAT_RW_CUR_POS arrived in the same kernel version as IORING_OP_WRITE
+            close();
+            throw error() << "io_uring on this kernel doesn't support the operations needed (Linux 5.6 or later is required)";
+        }
+
+        f_sq_ring_size = t_params.sq_off.array + t_params.sq_entries * sizeof( unsigned );
+        f_cq_ring_size = t_params.cq_off.cqes + t_params.cq_entries * sizeof( struct io_uring_cqe );
+        bool t_single_mmap = ( t_params.features & IORING_FEAT_SINGLE_MMAP ) != 0;
+        if( t_single_mmap ) f_sq_ring_size = f_cq_ring_size = std::max( f_sq_ring_size, f_cq_ring_size );
+
+        f_sq_ring = ::mmap( nullptr, f_sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, f_ring_fd, IORING_OFF_SQ_RING );
+        if( f_sq_ring == MAP_FAILED )
+        {
+            int t_errno = errno;
+            f_sq_ring = nullptr;
+            close();
+            throw error() << "Unable to map the io_uring submission queue: " << strerror( t_errno );
+        }
+        if( t_single_mmap )
+        {
+            f_cq_ring = f_sq_ring;
+        }
+        else
+        {
+            f_cq_ring = ::mmap( nullptr, f_cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, f_ring_fd, IORING_OFF_CQ_RING );
+            if( f_cq_ring == MAP_FAILED )
+            {
+                int t_errno = errno;
+                f_cq_ring = nullptr;
+                close();
+                throw error() << "Unable to map the io_uring completion queue: " << strerror( t_errno );
+            }
+        }
+        f_sqes_size = t_params.sq_entries * sizeof( struct io_uring_sqe );
+        f_sqes = ::mmap( nullptr, f_sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, f_ring_fd, IORING_OFF_SQES );
+        if( f_sqes == MAP_FAILED )
+        {
+            int t_errno = errno;
+            f_sqes = nullptr;
+            close();
+            throw error() << "Unable to map the io_uring submission entries: " << strerror( t_errno );
+        }
+
+        char* t_sq = static_cast< char* >( f_sq_ring );
+        f_sq_head = reinterpret_cast< unsigned* >( t_sq + t_params.sq_off.head );
+        f_sq_tail = reinterpret_cast< unsigned* >( t_sq + t_params.sq_off.tail );
+        f_sq_mask = *reinterpret_cast< unsigned* >( t_sq + t_params.sq_off.ring_mask );
+        f_sq_entries = t_params.sq_entries;
+        f_sq_array = reinterpret_cast< unsigned* >( t_sq + t_params.sq_off.array );
+        char* t_cq = static_cast< char* >( f_cq_ring );
+        f_cq_head = reinterpret_cast< unsigned* >( t_cq + t_params.cq_off.head );
+        f_cq_tail = reinterpret_cast< unsigned* >( t_cq + t_params.cq_off.tail );
+        f_cq_mask = *reinterpret_cast< unsigned* >( t_cq + t_params.cq_off.ring_mask );
+        f_cqes = t_cq + t_params.cq_off.cqes;
+
+        f_queue_depth = a_queue_depth;
+        f_chains.assign( a_queue_depth, chain() );
+        f_n_submitted = 0;
+        f_n_completed = 0;
+        f_error.clear();
+        return;
+    }
+
+    void uring_writer::close()
+    {
+        if( ! is_initialized() ) return;
+        if( f_sqes != nullptr ) wait_for_all();
+        if( f_sqes != nullptr ) ::munmap( f_sqes, f_sqes_size );
+        if( f_cq_ring != nullptr && f_cq_ring != f_sq_ring ) ::munmap( f_cq_ring, f_cq_ring_size );
+        if( f_sq_ring != nullptr ) ::munmap( f_sq_ring, f_sq_ring_size );
+        // closing the ring also unregisters the buffer
+        ::close( f_ring_fd );
+        f_ring_fd = -1;
+        f_sqes = f_cq_ring = f_sq_ring = nullptr;
+        f_buffer = nullptr;
+        f_buffer_size = 0;
+        f_queue_depth = 0;
+        return;
+    }
+
+    bool uring_writer::register_buffer( const void* a_buffer, size_t a_size )
+    {
+        if( ! is_initialized() ) return false;
+        unregister_buffer();
+        struct iovec t_buffer = { const_cast< void* >( a_buffer ), a_size };
+        if( ::syscall( __NR_io_uring_register, f_ring_fd, IORING_REGISTER_BUFFERS, &t_buffer, 1 ) != 0 ) return false;
+        f_buffer = static_cast< const char* >( a_buffer );
+        f_buffer_size = a_size;
+        return true;
+    }
+
+    void uring_writer::unregister_buffer()
+    {
+        if( ! is_initialized() || f_buffer == nullptr ) return;
+        // fixed-buffer writes in flight may still be using the buffer
+        wait_for_all();
+        ::syscall( __NR_io_uring_register, f_ring_fd, IORING_UNREGISTER_BUFFERS, nullptr, 0 );
+        f_buffer = nullptr;
+        f_buffer_size = 0;
+        return;
+    }
+
+    uint64_t uring_writer::submit( const write* a_writes, unsigned a_n_writes )
+    {
+        if( ! is_initialized() )
+        {
+            throw error() << "io_uring writer is not initialized";
+        }
+        if( a_n_writes == 0 || a_n_writes > s_max_chain_length )
+        {
+            throw error() << "io_uring write chains must have between 1 and " << s_max_chain_length << " writes";
+        }
+
+        while( get_n_in_flight() >= f_queue_depth ) wait_for_completion();
+
+        uint64_t t_number = f_n_submitted;
+        chain& t_chain = f_chains[ t_number % f_queue_depth ];
+        t_chain.f_segments.clear();
+        unsigned t_n_segments = 0;
+        for( unsigned i_write = 0; i_write < a_n_writes; ++i_write ) t_n_segments += a_writes[ i_write ].f_n_segments;
+        // no reallocation once the pointers have been handed to the kernel
+        t_chain.f_segments.reserve( t_n_segments );
+
+        // the queue is never more than full, since each chain in flight uses at most s_max_chain_length entries
+        struct io_uring_sqe* t_sqes = static_cast< struct io_uring_sqe* >( f_sqes );
+        unsigned t_tail = *f_sq_tail;
+        for( unsigned i_write = 0; i_write < a_n_writes; ++i_write )
+        {
+            const write& t_write = a_writes[ i_write ];
+            uint64_t t_bytes = 0;
+            for( unsigned i_seg = 0; i_seg < t_write.f_n_segments; ++i_seg ) t_bytes += t_write.f_segments[ i_seg ].iov_len;
+            if( t_write.f_n_segments == 0 || t_write.f_n_segments > IOV_MAX || t_bytes > UINT32_MAX )
+            {
+                throw error() << "io_uring writes must have between 1 and " << IOV_MAX << " segments, of less than 4 GB in total";
+            }
+
+            unsigned t_index = t_tail & f_sq_mask;
+            struct io_uring_sqe& t_sqe = t_sqes[ t_index ];
+            ::memset( &t_sqe, 0, sizeof( t_sqe ) );
+            t_sqe.fd = t_write.f_fd;
+            t_sqe.off = t_write.f_offset;
+            const char* t_base = static_cast< const char* >( t_write.f_segments[ 0 ].iov_base );
+            if( t_write.f_n_segments == 1 && f_buffer != nullptr && t_base >= f_buffer && t_base + t_bytes <= f_buffer + f_buffer_size )
+            {
+                t_sqe.opcode = IORING_OP_WRITE_FIXED;
+                t_sqe.addr = reinterpret_cast< uint64_t >( t_base );
+                t_sqe.len = (uint32_t)t_bytes;
+                t_sqe.buf_index = 0;
+            }
+            else if( t_write.f_n_segments == 1 )
+            {
+                t_sqe.opcode = IORING_OP_WRITE;
+                t_sqe.addr = reinterpret_cast< uint64_t >( t_base );
+                t_sqe.len = (uint32_t)t_bytes;
+            }
+            else
+            {
+                size_t t_first = t_chain.f_segments.size();
+                t_chain.f_segments.insert( t_chain.f_segments.end(), t_write.f_segments, t_write.f_segments + t_write.f_n_segments );
+                t_sqe.opcode = IORING_OP_WRITEV;
+                t_sqe.addr = reinterpret_cast< uint64_t >( &t_chain.f_segments[ t_first ] );
+                t_sqe.len = t_write.f_n_segments;
+            }
+            if( i_write + 1 < a_n_writes ) t_sqe.flags = IOSQE_IO_LINK;
+            t_sqe.user_data = t_number * s_max_chain_length + i_write;
+            t_chain.f_bytes[ i_write ] = (uint32_t)t_bytes;
+
+            f_sq_array[ t_index ] = t_index;
+            ++t_tail;
+        }
+        __atomic_store_n( f_sq_tail, t_tail, __ATOMIC_RELEASE );
+
+        t_chain.f_n_pending = a_n_writes;
+        t_chain.f_done = false;
+        t_chain.f_submit_time = std::chrono::steady_clock::now();
+        ++f_n_submitted;
+
+        enter( a_n_writes, 0 );
+        f_submit_latency.add( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - t_chain.f_submit_time ).count() );
+        return t_number;
+    }
+
+    void uring_writer::enter( unsigned a_to_submit, unsigned a_min_complete )
+    {
+        unsigned t_flags = a_min_complete > 0 ? IORING_ENTER_GETEVENTS : 0;
+        while( true )
+        {
+            int t_result = (int)::syscall( __NR_io_uring_enter, f_ring_fd, a_to_submit, a_min_complete, t_flags, nullptr, 0 );
+            if( t_result >= 0 )
+            {
+                // entries that weren't consumed are still in the queue, and are submitted by the next call
+                a_to_submit -= std::min( (unsigned)t_result, a_to_submit );
+                if( a_to_submit == 0 ) return;
+                continue;
+            }
+            if( errno == EINTR ) continue;
+            if( errno == EAGAIN || errno == EBUSY )
+            {
+                // the kernel is short of resources, or the completion queue is full
+                process_completions();
+                std::this_thread::yield();
+                continue;
+            }
+            throw error() << "io_uring_enter failed: " << strerror( errno );
+        }
+    }
+
+    void uring_writer::process_completions()
+    {
+        const struct io_uring_cqe* t_cqes = static_cast< const struct io_uring_cqe* >( f_cqes );
+        unsigned t_head = *f_cq_head;
+        unsigned t_tail = __atomic_load_n( f_cq_tail, __ATOMIC_ACQUIRE );
+        while( t_head != t_tail )
+        {
+            const struct io_uring_cqe& t_cqe = t_cqes[ t_head & f_cq_mask ];
+            uint64_t t_number = t_cqe.user_data / s_max_chain_length;
+            unsigned t_write = (unsigned)( t_cqe.user_data % s_max_chain_length );
+            chain& t_chain = f_chains[ t_number % f_queue_depth ];
+            if( f_error.empty() )
+            {
+                if( t_cqe.res < 0 )
+                {
+                    f_error = std::string( "io_uring write failed: " ) + strerror( -t_cqe.res );
+                }
+                else if( (uint32_t)t_cqe.res != t_chain.f_bytes[ t_write ] )
+                {
+                    f_error = "io_uring write was short: " + std::to_string( t_cqe.res ) + " of " + std::to_string( t_chain.f_bytes[ t_write ] ) + " bytes written";
+                }
+            }
+            if( --t_chain.f_n_pending == 0 )
+            {
+                t_chain.f_done = true;
+                f_complete_latency.add( std::chrono::duration_cast< std::chrono::nanoseconds >( std::chrono::steady_clock::now() - t_chain.f_submit_time ).count() );
+            }
+            ++t_head;
+        }
+        __atomic_store_n( f_cq_head, t_head, __ATOMIC_RELEASE );
+
+        // chains can complete out of order; the count only includes chains whose predecessors are all complete
+        while( f_n_completed < f_n_submitted && f_chains[ f_n_completed % f_queue_depth ].f_done )
+        {
+            f_chains[ f_n_completed % f_queue_depth ].f_done = false;
+            ++f_n_completed;
+        }
+        return;
+    }
+
+    void uring_writer::poll()
+    {
+        if( ! is_initialized() ) return;
+        process_completions();
+        return;
+    }
+
+    void uring_writer::wait_for_completion()
+    {
+        if( ! is_initialized() ) return;
+        uint64_t t_n_completed = f_n_completed;
+        process_completions();
+        while( f_n_completed == t_n_completed && get_n_in_flight() > 0 )
+        {
+            enter( 0, 1 );
+            process_completions();
+        }
+        return;
+    }
+
+    void uring_writer::wait_for_all()
+    {
+        while( get_n_in_flight() > 0 ) wait_for_completion();
+        return;
+    }
+
+#else /* USE_IO_URING */
+
+    void uring_writer::initialize( unsigned )
+    {
+        throw error() << "Psyllid was built without io_uring support";
+    }
+
+    void uring_writer::close()
+    {
+        return;
+    }
+
+    bool uring_writer::register_buffer( const void*, size_t )
+    {
+        return false;
+    }
+
+    void uring_writer::unregister_buffer()
+    {
+        return;
+    }
+
+    uint64_t uring_writer::submit( const write*, unsigned )
+    {
+        throw error() << "Psyllid was built without io_uring support";
+    }
+
+    void uring_writer::enter( unsigned, unsigned )
+    {
+        return;
+    }
+
+    void uring_writer::process_completions()
+    {
+        return;
+    }
+
+    void uring_writer::poll()
+    {
+        return;
+    }
+
+    void uring_writer::wait_for_completion()
+    {
+        return;
+    }
+
+    void uring_writer::wait_for_all()
+    {
+        return;
+    }
+
+#endif /* USE_IO_URING */
+
+} /* namespace psyllid */
@@ -0,0 +1,208 @@
+/*
+ * uring_writer.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_URING_WRITER_HH_
+#define PSYLLID_URING_WRITER_HH_
+
+#include "latency_histogram.hh"
+
+#include <array>
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+#include <sys/uio.h>
+
+namespace psyllid
+{
+
+    /*!
+     @class uring_writer
+     @brief Keeps several file writes in flight with io_uring
+
+     @details
+     Writes are submitted in chains: the writes in a chain are done in order, and if one fails (or is short), the rest of the chain is canceled.
+     Up to queue-depth chains can be in flight at once; submitting a chain when the queue is full waits for the oldest one to complete.
+     The caller must keep the memory being written untouched until its chain has completed: chains are numbered in order of submission
+     from 0, and get_n_completed() gives the number of chains, from the first, that have all completed.
+
+     Memory that's written repeatedly (e.g. the storage of a record_batch_queue) can be registered with register_buffer(); a single-segment
+     write from registered memory is done as a fixed-buffer write, which saves the kernel mapping the pages for every write.
+     Registering needs enough locked-memory allowance (RLIMIT_MEMLOCK); if the kernel refuses, writes go through unregistered.
+
+     The system calls are made directly, so liburing isn't needed.  io_uring support is built if USE_IO_URING is defined (see the
+     Psyllid_ENABLE_IO_URING CMake option); otherwise, and on kernels without io_uring (before 5.6, or when it's disabled), initialize() throws.
+
+     Two latency distributions are kept: submit latency (the time spent in the submission system call, which is the time the writing thread
+     is blocked by a submission when the queue isn't full) and completion latency (from submission until the whole chain completed).
+
+     Not thread-safe, apart from the latency distributions, which can be read from any thread.
+    */
+    class uring_writer
+    {
+        public:
+            /// One write in a chain: a_n_segments segments, written to a_fd starting at a_offset
+            struct write
+            {
+                int f_fd;
+                const struct iovec* f_segments;
+                unsigned f_n_segments;
+                uint64_t f_offset;
+            };
+
+            static const unsigned s_max_chain_length = 4;
+
+        public:
+            uring_writer();
+            ~uring_writer();
+
+            uring_writer( const uring_writer& ) = delete;
+            uring_writer& operator=( const uring_writer& ) = delete;
+
+            /// Sets up the ring for a_queue_depth chains in flight; throws psyllid::error if io_uring isn't available
+            void initialize( unsigned a_queue_depth );
+            bool is_initialized() const;
+            /// Waits for the writes in flight to complete, and closes the ring
+            void close();
+
+            /// Registers a_size bytes at a_buffer for fixed-buffer writes, replacing any earlier registration; returns false if the kernel refuses
+            bool register_buffer( const void* a_buffer, size_t a_size );
+            void unregister_buffer();
+            bool has_registered_buffer() const;
+
+            /// Submits a chain of up to s_max_chain_length writes, waiting first if the queue is full; returns the chain's number.
+            /// Throws psyllid::error if the submission fails; failures of the writes themselves are reported by get_error().
+            uint64_t submit( const write* a_writes, unsigned a_n_writes );
+
+            /// Processes any completions that are ready, without waiting
+            void poll();
+            /// Waits until at least one more chain completes; returns immediately if nothing is in flight
+            void wait_for_completion();
+            /// Waits until every chain in flight has completed
+            void wait_for_all();
+
+            uint64_t get_n_submitted() const;
+            uint64_t get_n_completed() const;
+            unsigned get_n_in_flight() const;
+            unsigned get_queue_depth() const;
+
+            /// True once a write has failed; the first failure is described by get_error()
+            bool has_failed() const;
+            const std::string& get_error() const;
+            void clear_error();
+
+            const latency_histogram& get_submit_latency() const;
+            const latency_histogram& get_complete_latency() const;
+            void reset_stats();
+
+        private:
+            struct chain
+            {
+                unsigned f_n_pending;
+                bool f_done;
+                std::array< uint32_t, s_max_chain_length > f_bytes; // bytes in each write
+                std::chrono::steady_clock::time_point f_submit_time;
+                std::vector< struct iovec > f_segments; // copies, for vectored writes; they must stay valid until the writes are done
+            };
+
+            void process_completions();
+            void enter( unsigned a_to_submit, unsigned a_min_complete );
+
+            int f_ring_fd;
+            unsigned f_queue_depth;
+
+            // submission queue
+            void* f_sq_ring;
+            size_t f_sq_ring_size;
+            unsigned* f_sq_head;
+            unsigned* f_sq_tail;
+            unsigned f_sq_mask;
+            unsigned f_sq_entries;
+            unsigned* f_sq_array;
+            void* f_sqes;
+            size_t f_sqes_size;
+
+            // completion queue
+            void* f_cq_ring;
+            size_t f_cq_ring_size;
+            unsigned* f_cq_head;
+            unsigned* f_cq_tail;
+            unsigned f_cq_mask;
+            void* f_cqes;
+
+            const char* f_buffer;
+            size_t f_buffer_size;
+
+            std::vector< chain > f_chains; // indexed by chain number % queue depth
+            uint64_t f_n_submitted;
+            uint64_t f_n_completed;
+
+            std::string f_error;
+
+            latency_histogram f_submit_latency;
+            latency_histogram f_complete_latency;
+    };
+
+    inline bool uring_writer::is_initialized() const
+    {
+        return f_ring_fd >= 0;
+    }
+
+    inline bool uring_writer::has_registered_buffer() const
+    {
+        return f_buffer != nullptr;
+    }
+
+    inline uint64_t uring_writer::get_n_submitted() const
+    {
+        return f_n_submitted;
+    }
+
+    inline uint64_t uring_writer::get_n_completed() const
+    {
+        return f_n_completed;
+    }
+
+    inline unsigned uring_writer::get_n_in_flight() const
+    {
+        return (unsigned)( f_n_submitted - f_n_completed );
+    }
+
+    inline unsigned uring_writer::get_queue_depth() const
+    {
+        return f_queue_depth;
+    }
+
+    inline bool uring_writer::has_failed() const
+    {
+        return ! f_error.empty();
+    }
+
+    inline const std::string& uring_writer::get_error() const
+    {
+        return f_error;
+    }
+
+    inline void uring_writer::clear_error()
+    {
+        f_error.clear();
+        return;
+    }
+
+    inline const latency_histogram& uring_writer::get_submit_latency() const
+    {
+        return f_submit_latency;
+    }
+
+    inline const latency_histogram& uring_writer::get_complete_latency() const
+    {
+        return f_complete_latency;
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_URING_WRITER_HH_ */
@@ -0,0 +1,130 @@
+/*
+ * test_adc_stats.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Checks the dispatched ADC statistics kernel against the scalar reference, including saturated values and the unvectorized tail,
+ *  and checks that the accumulated statistics read by another thread are always consistent while packets are being added.
+ *  Reports the time per packet for each version of the kernel.
+ *
+ *  Usage: > test_adc_stats
+ *
+ *  Returns 0 if the checks pass; -1 otherwise.
+ */
+
+#include "adc_stats.hh"
+#include "spectrum_kernels.hh"
+
+#include "logger.hh"
+
+#include <atomic>
+#include <chrono>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_adc_stats" );
+
+bool same_stats( const adc_packet_stats& a_first, const adc_packet_stats& a_second )
+{
+    return a_first.f_n_samples == a_second.f_n_samples && a_first.f_sum_i == a_second.f_sum_i && a_first.f_sum_q == a_second.f_sum_q &&
+            a_first.f_sum_sq == a_second.f_sum_sq && a_first.f_min == a_second.f_min && a_first.f_max == a_second.f_max &&
+            a_first.f_n_high == a_second.f_n_high && a_first.f_n_low == a_second.f_n_low;
+}
+
+int main()
+{
+    // one packet's worth of samples plus a few, to exercise the tail
+    const size_t t_n_samples = PAYLOAD_SIZE / 2 + 5;
+
+    std::mt19937 t_rng( 2718 );
+    std::normal_distribution< double > t_dist( 3., 60. );
+    std::vector< int8_t > t_iq( 2 * t_n_samples );
+    for( auto& t_value : t_iq ) t_value = (int8_t)std::max( -128., std::min( 127., std::round( t_dist( t_rng ) ) ) );
+    // extremes, including in the tail
+    t_iq[ 0 ] = -128; t_iq[ 1 ] = 127; t_iq[ 2 ] = -127;
+    t_iq[ t_iq.size() - 1 ] = 127; t_iq[ t_iq.size() - 2 ] = -128;
+
+    unsigned t_n_bad = 0;
+
+    adc_packet_stats t_ref;
+    compute_adc_stats_scalar( t_iq.data(), t_n_samples, t_ref );
+    LINFO( plog, "Reference: sum-i " << t_ref.f_sum_i << "; sum-q " << t_ref.f_sum_q << "; sum-sq " << t_ref.f_sum_sq <<
+            "; min " << (int)t_ref.f_min << "; max " << (int)t_ref.f_max << "; high " << t_ref.f_n_high << "; low " << t_ref.f_n_low );
+
+    for( kernel_isa t_isa : { kernel_isa::scalar, kernel_isa::avx2 } )
+    {
+        if( ! kernel_isa_supported( t_isa ) )
+        {
+            LINFO( plog, to_string( t_isa ) << " is not supported on this CPU" );
+            continue;
+        }
+        select_kernel_isa( t_isa );
+
+        adc_packet_stats t_test;
+        compute_adc_stats( t_iq.data(), t_n_samples, t_test );
+        if( ! same_stats( t_test, t_ref ) )
+        {
+            LERROR( plog, to_string( t_isa ) << " statistics differ from the scalar reference" );
+            ++t_n_bad;
+        }
+
+        const unsigned t_n_packets = 100000;
+        auto t_start = std::chrono::steady_clock::now();
+        uint64_t t_check = 0;
+        for( unsigned i_packet = 0; i_packet < t_n_packets; ++i_packet )
+        {
+            compute_adc_stats( t_iq.data(), PAYLOAD_SIZE / 2, t_test );
+            t_check += t_test.f_sum_sq;
+        }
+        double t_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - t_start ).count() / (double)t_n_packets;
+        LINFO( plog, to_string( t_isa ) << ": " << t_ns << " ns per packet (check " << t_check % 1000 << ")" );
+    }
+    select_kernel_isa( best_kernel_isa() );
+
+    // a reader sees consistent statistics while they're being updated: every packet added has the same statistics
+    adc_packet_stats t_packet;
+    compute_adc_stats( t_iq.data(), PAYLOAD_SIZE / 2, t_packet );
+    adc_stats t_accumulated;
+    std::atomic< bool > t_done( false );
+    std::atomic< unsigned > t_n_inconsistent( 0 );
+    std::atomic< unsigned > t_n_reads( 0 );
+    std::thread t_reader( [&]()
+    {
+        while( ! t_done.load() )
+        {
+            uint64_t t_n_packets = 0;
+            adc_packet_stats t_stats = t_accumulated.get( t_n_packets );
+            if( t_stats.f_n_samples != t_n_packets * t_packet.f_n_samples || t_stats.f_sum_sq != t_n_packets * t_packet.f_sum_sq ||
+                    t_stats.f_n_high != t_n_packets * t_packet.f_n_high )
+            {
+                ++t_n_inconsistent;
+            }
+            ++t_n_reads;
+        }
+    } );
+    for( unsigned i_packet = 0; i_packet < 2000000; ++i_packet )
+    {
+        if( i_packet % 500000 == 0 ) t_accumulated.reset();
+        t_accumulated.add( t_packet );
+    }
+    t_done.store( true );
+    t_reader.join();
+    LINFO( plog, "Reader made " << t_n_reads.load() << " reads while the statistics were updated" );
+    if( t_n_inconsistent.load() != 0 )
+    {
+        LERROR( plog, t_n_inconsistent.load() << " reads were inconsistent" );
+        ++t_n_bad;
+    }
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, "Found " << t_n_bad << " problems" );
+        return -1;
+    }
+
+    LINFO( plog, "ADC statistics checks passed" );
+    return 0;
+}
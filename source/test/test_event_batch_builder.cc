@@ -0,0 +1,243 @@
+/*
+ * test_event_batch_builder.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Checks that the batch path of event_batch_builder gives the same events as the per-flag path:
+ *    - for the reference sequence from test_event_builder:
+ *        Trigger ids:          0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15 ,16, 17, 18, 19
+ *        Sequence of triggers: 0, 0, 0, 1, 1, 1, 0, 1, 1, 0,  0,  1,  1,  1,  0,  1,  0,  0,  0,  1
+ *        Pretrigger: 2
+ *        Skip tolerance: 1
+ *        Events should be: 1-8, 9-15, 17-19
+ *      processed as one batch, and split into batches of every size;
+ *    - for random flag sequences with a range of trigger rates, n-triggers values, skip tolerances (including ones longer than a bitmap word)
+ *      and high-threshold flags.
+ *  Then times both paths at each trigger rate, and checks that the batch path is faster at high trigger rates.
+ *
+ *  Usage: > test_event_batch_builder
+ *
+ *  Returns 0 if the events agree and the batch path is faster at high trigger rates; -1 otherwise.
+ */
+
+#include "event_batch_builder.hh"
+
+#include "logger.hh"
+
+#include <chrono>
+#include <random>
+#include <sstream>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_event_batch_builder" );
+
+typedef std::vector< id_range_event > events_t;
+
+std::string to_string( const events_t& a_events )
+{
+    std::stringstream t_str;
+    for( const id_range_event& t_event : a_events )
+    {
+        t_str << t_event.get_start_id() << "-" << t_event.get_end_id() << " ";
+    }
+    return t_str.str();
+}
+
+bool same_events( const events_t& a_lhs, const events_t& a_rhs )
+{
+    if( a_lhs.size() != a_rhs.size() ) return false;
+    for( size_t i_event = 0; i_event < a_lhs.size(); ++i_event )
+    {
+        if( a_lhs[ i_event ].get_start_id() != a_rhs[ i_event ].get_start_id() || a_lhs[ i_event ].get_end_id() != a_rhs[ i_event ].get_end_id() ) return false;
+    }
+    return true;
+}
+
+void configure( event_batch_builder& a_builder, uint64_t a_pretrigger, uint64_t a_skip_tolerance, uint64_t a_n_triggers )
+{
+    a_builder.set_pretrigger( a_pretrigger );
+    a_builder.set_skip_tolerance( a_skip_tolerance );
+    a_builder.set_n_triggers( a_n_triggers );
+    a_builder.reset();
+    return;
+}
+
+events_t run_per_flag( event_batch_builder& a_builder, const std::vector< trigger_flag >& a_flags )
+{
+    events_t t_events;
+    for( const trigger_flag& t_flag : a_flags ) a_builder.process_flag( t_flag, t_events );
+    a_builder.flush( t_events );
+    return t_events;
+}
+
+events_t run_batch( event_batch_builder& a_builder, const std::vector< trigger_flag >& a_flags, size_t a_batch_size )
+{
+    events_t t_events;
+    for( size_t i_start = 0; i_start < a_flags.size(); i_start += a_batch_size )
+    {
+        a_builder.process_batch( a_flags.data() + i_start, std::min( a_batch_size, a_flags.size() - i_start ), t_events );
+    }
+    a_builder.flush( t_events );
+    return t_events;
+}
+
+int main()
+{
+    unsigned t_n_bad = 0;
+    event_batch_builder t_builder;
+
+    // reference sequence
+    bool t_ref_flags[ 20 ] = { 0, 0, 0, 1, 1, 1, 0, 1, 1, 0, 0, 1, 1, 1, 0, 1, 0, 0, 0, 1 };
+    std::vector< trigger_flag > t_flags( 20 );
+    for( uint64_t t_id = 0; t_id < 20; ++t_id )
+    {
+        t_flags[ t_id ].set_id( t_id );
+        t_flags[ t_id ].set_flag( t_ref_flags[ t_id ] );
+    }
+
+    const std::string t_expected( "1-8 9-15 17-19 " );
+    LINFO( plog, "Expecting the following events: " << t_expected );
+
+    configure( t_builder, 2, 1, 1 );
+    events_t t_ref_events = run_per_flag( t_builder, t_flags );
+    LINFO( plog, "Per-flag events: " << to_string( t_ref_events ) );
+    if( to_string( t_ref_events ) != t_expected )
+    {
+        LERROR( plog, "Per-flag events do not match the expected events" );
+        ++t_n_bad;
+    }
+    for( size_t t_batch_size = 1; t_batch_size <= t_flags.size(); ++t_batch_size )
+    {
+        configure( t_builder, 2, 1, 1 );
+        events_t t_events = run_batch( t_builder, t_flags, t_batch_size );
+        if( to_string( t_events ) != t_expected )
+        {
+            LERROR( plog, "Batch events (batch size " << t_batch_size << ") do not match the expected events: " << to_string( t_events ) );
+            ++t_n_bad;
+        }
+    }
+
+    // random sequences
+    std::mt19937 t_rng( 2718 );
+    const size_t t_n_flags = 1 << 20;
+    t_flags.resize( t_n_flags );
+    double t_rates[ 4 ] = { 0.01, 0.2, 0.6, 0.95 };
+    for( double t_rate : t_rates )
+    {
+        // flags come in bursts with an average length of 8 packets, separated by gaps sized to give the requested flagged fraction
+        const double t_burst_length = 8.;
+        double t_gap_length = t_burst_length * ( 1. - t_rate ) / t_rate;
+        std::bernoulli_distribution t_end_burst( 1. / t_burst_length ), t_end_gap( 1. / t_gap_length ), t_high( 0.02 );
+        bool t_flag = false;
+        for( uint64_t t_id = 0; t_id < t_n_flags; ++t_id )
+        {
+            t_flag = t_flag ? ! t_end_burst( t_rng ) : t_end_gap( t_rng );
+            t_flags[ t_id ].set_id( 1000 + t_id );
+            t_flags[ t_id ].set_flag( t_flag );
+            t_flags[ t_id ].set_high_threshold( t_flag && t_high( t_rng ) );
+        }
+
+        for( uint64_t t_n_triggers = 1; t_n_triggers <= 3; ++t_n_triggers )
+        {
+            uint64_t t_skips[ 3 ] = { 0, 3, 70 };
+            for( uint64_t t_skip : t_skips )
+            {
+                configure( t_builder, 5, t_skip, t_n_triggers );
+                t_ref_events = run_per_flag( t_builder, t_flags );
+                size_t t_batch_sizes[ 3 ] = { 37, 256, 4096 };
+                for( size_t t_batch_size : t_batch_sizes )
+                {
+                    configure( t_builder, 5, t_skip, t_n_triggers );
+                    events_t t_events = run_batch( t_builder, t_flags, t_batch_size );
+                    if( ! same_events( t_events, t_ref_events ) )
+                    {
+                        LERROR( plog, "Batch and per-flag events differ: rate " << t_rate << "; n-triggers " << t_n_triggers << "; skip tolerance " << t_skip <<
+                                "; batch size " << t_batch_size << "; " << t_events.size() << " vs. " << t_ref_events.size() << " events" );
+                        ++t_n_bad;
+                    }
+                }
+            }
+        }
+
+        // timing, with n-triggers 2 and skip tolerance 3, a batch at a time (the flags of a batch are in cache when it's processed, as they are in the DAQ chain):
+        //   - per-flag path;
+        //   - batch path from trigger_flag objects (includes packing the flags into bitmaps);
+        //   - batch path from bitmaps (for flags that are produced as bitmaps)
+        // The fastest of several trials is used for each path, to reduce the effect of other activity on the machine.
+        std::vector< uint64_t > t_flag_bits( t_n_flags / 64, 0 ), t_high_bits( t_n_flags / 64, 0 );
+        for( size_t i_flag = 0; i_flag < t_n_flags; ++i_flag )
+        {
+            t_flag_bits[ i_flag / 64 ] |= uint64_t( t_flags[ i_flag ].get_flag() ) << ( i_flag % 64 );
+            t_high_bits[ i_flag / 64 ] |= uint64_t( t_flags[ i_flag ].get_high_threshold() ) << ( i_flag % 64 );
+        }
+
+        typedef std::chrono::steady_clock clock_t;
+        const unsigned t_n_trials = 10;
+        const size_t t_batch_size = 4096;
+        double t_per_flag_ns = 1.e9, t_batch_ns = 1.e9, t_bitmap_ns = 1.e9;
+        size_t t_n_events = 0;
+        for( unsigned i_trial = 0; i_trial < t_n_trials; ++i_trial )
+        {
+            event_batch_builder t_per_flag_builder, t_batch_builder, t_bitmap_builder;
+            configure( t_per_flag_builder, 5, 3, 2 );
+            configure( t_batch_builder, 5, 3, 2 );
+            configure( t_bitmap_builder, 5, 3, 2 );
+            events_t t_per_flag_events, t_batch_events, t_bitmap_events;
+            t_per_flag_events.reserve( t_n_flags / 8 );
+            t_batch_events.reserve( t_n_flags / 8 );
+            t_bitmap_events.reserve( t_n_flags / 8 );
+            clock_t::duration t_per_flag_time( 0 ), t_batch_time( 0 ), t_bitmap_time( 0 );
+            uint64_t t_id_sum = 0;
+            for( size_t i_start = 0; i_start < t_n_flags; i_start += t_batch_size )
+            {
+                const trigger_flag* t_batch = t_flags.data() + i_start;
+                for( size_t i_flag = 0; i_flag < t_batch_size; ++i_flag ) t_id_sum += t_batch[ i_flag ].get_id();
+
+                auto t_start = clock_t::now();
+                for( size_t i_flag = 0; i_flag < t_batch_size; ++i_flag ) t_per_flag_builder.process_flag( t_batch[ i_flag ], t_per_flag_events );
+                auto t_per_flag_end = clock_t::now();
+                t_batch_builder.process_batch( t_batch, t_batch_size, t_batch_events );
+                auto t_batch_end = clock_t::now();
+                t_bitmap_builder.process_batch( 1000 + i_start, t_flag_bits.data() + i_start / 64, t_high_bits.data() + i_start / 64, t_batch_size, t_bitmap_events );
+                auto t_bitmap_end = clock_t::now();
+
+                t_per_flag_time += t_per_flag_end - t_start;
+                t_batch_time += t_batch_end - t_per_flag_end;
+                t_bitmap_time += t_bitmap_end - t_batch_end;
+            }
+            t_per_flag_builder.flush( t_per_flag_events );
+            t_batch_builder.flush( t_batch_events );
+            t_bitmap_builder.flush( t_bitmap_events );
+            if( t_id_sum == 0 || ! same_events( t_batch_events, t_per_flag_events ) || ! same_events( t_bitmap_events, t_per_flag_events ) )
+            {
+                LERROR( plog, "Events differ in the timing runs: " << t_per_flag_events.size() << ", " << t_batch_events.size() << ", " << t_bitmap_events.size() );
+                ++t_n_bad;
+            }
+            t_n_events = t_per_flag_events.size();
+
+            double t_norm = 1. / (double)t_n_flags;
+            t_per_flag_ns = std::min( t_per_flag_ns, std::chrono::duration< double, std::nano >( t_per_flag_time ).count() * t_norm );
+            t_batch_ns = std::min( t_batch_ns, std::chrono::duration< double, std::nano >( t_batch_time ).count() * t_norm );
+            t_bitmap_ns = std::min( t_bitmap_ns, std::chrono::duration< double, std::nano >( t_bitmap_time ).count() * t_norm );
+        }
+
+        LINFO( plog, "Flagged fraction " << t_rate << " (" << t_n_events << " events): per-flag " << t_per_flag_ns <<
+                " ns/flag;  batch " << t_batch_ns << " ns/flag;  batch from bitmaps " << t_bitmap_ns << " ns/flag" );
+        // at high trigger rates, the batch path has to be faster than the per-flag path, even including packing the flags
+        if( t_rate >= 0.5 && t_batch_ns >= t_per_flag_ns )
+        {
+            LERROR( plog, "The batch path is not faster than the per-flag path at flagged fraction " << t_rate );
+            ++t_n_bad;
+        }
+    }
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, "Found " << t_n_bad << " problems" );
+        return -1;
+    }
+
+    LINFO( plog, "Batch and per-flag event building agree" );
+    return 0;
+}
@@ -0,0 +1,149 @@
+/*
+ * test_file_switch_latency.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Writes records through a monarch_wrapper with a small maximum file size, so that it switches files many times,
+ *  and measures the time to write each record.  Writing should not wait for the file switches, so the worst-case record time
+ *  should be that of a slow write, not that of opening and finishing files.  The report gives the mean, 99.9th-percentile and worst-case record times,
+ *  and the number of switches for which no on-deck file was ready.
+ *  With preallocation, also checks that the finished files don't keep the reserved space past their ends.
+ *  With a number of records per file, the files are rotated by record count instead of by size, and the number of files is checked.
+ *
+ *  Usage: > test_file_switch_latency [output directory] [on-deck depth] [preallocate (0 or 1)] [records per file]
+ *
+ *  The files are written as switch_latency*.egg in the output directory (default: the current directory), and removed afterwards.
+ *
+ *  Returns 0 if the records were all written; -1 otherwise.
+ */
+
+#include "monarch3_wrap.hh"
+#include "psyllid_error.hh"
+
+#include "logger.hh"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include <sys/stat.h>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_file_switch_latency" );
+
+int main( const int argc, const char** argv )
+{
+    std::string t_dir( argc > 1 ? argv[ 1 ] : "." );
+    std::string t_filename( t_dir + "/switch_latency.egg" );
+    unsigned t_on_deck_depth = argc > 2 ? std::stoul( argv[ 2 ] ) : 1;
+    bool t_preallocate = argc > 3 && std::string( argv[ 3 ] ) != "0";
+    unsigned t_records_per_file = argc > 4 ? std::stoul( argv[ 4 ] ) : 0;
+
+    const unsigned t_record_size = 4096; // IQ samples: one packet
+    const double t_max_file_size_mb = 2.;
+    const unsigned t_n_records = 20000; // 160 MB
+
+    std::vector< double > t_record_us( t_n_records );
+    unsigned t_n_failed = 0;
+    unsigned t_n_files = 0;
+    uint64_t t_n_dry = 0;
+    unsigned t_n_untrimmed = 0;
+
+    try
+    {
+        monarch_wrap_ptr t_mwp( new monarch_wrapper( t_filename ) );
+        t_mwp->set_max_file_size( t_max_file_size_mb );
+        t_mwp->set_on_deck_depth( t_on_deck_depth );
+        t_mwp->set_preallocate( t_preallocate );
+        t_mwp->set_max_file_records( t_records_per_file );
+
+        header_wrap_ptr t_hwp( t_mwp->get_header() );
+        unsigned t_stream_no = 0;
+        {
+            unique_lock t_header_lock( t_hwp->get_lock() );
+            t_hwp->header().SetFilename( t_filename );
+            t_hwp->header().SetDescription( "File-switch latency test" );
+            std::vector< unsigned > t_chan_vec;
+            t_stream_no = t_hwp->header().AddStream( "test", 100, t_record_size, 2, 1, monarch3::sDigitizedS, 8, monarch3::sBitsAlignedLeft, &t_chan_vec );
+        }
+        t_mwp->start_using();
+
+        stream_wrap_ptr t_swp = t_mwp->get_stream( t_stream_no );
+        for( unsigned i_record = 0; i_record < t_n_records; ++i_record )
+        {
+            auto t_start = std::chrono::steady_clock::now();
+            monarch3::byte_type* t_data = t_swp->begin_record();
+            if( t_data == nullptr )
+            {
+                ++t_n_failed;
+                continue;
+            }
+            ::memset( t_data, (int)( i_record % 256 ), 2 * t_record_size );
+            if( ! t_swp->commit_record( i_record, 1000 * i_record, i_record == 0 ) ) ++t_n_failed;
+            t_record_us[ i_record ] = std::chrono::duration< double, std::micro >( std::chrono::steady_clock::now() - t_start ).count();
+        }
+
+        t_mwp->finish_stream( t_stream_no );
+        t_swp.reset();
+        t_mwp->cancel();
+        t_mwp->stop_using();
+        t_mwp->finish_file();
+        t_n_dry = t_mwp->get_n_on_deck_dry();
+    }
+    catch( std::exception& e )
+    {
+        LERROR( plog, "Exception while writing: " << e.what() );
+        return -1;
+    }
+
+    // count and remove the files
+    boost::filesystem::directory_iterator t_end;
+    for( boost::filesystem::directory_iterator t_it( t_dir ); t_it != t_end; ++t_it )
+    {
+        std::string t_name = t_it->path().filename().string();
+        if( t_name.compare( 0, 14, "switch_latency" ) == 0 && t_it->path().extension() == ".egg" )
+        {
+            ++t_n_files;
+            // a trimmed file has no more than a filesystem block of space allocated past its end
+            struct stat t_stat;
+            if( ::stat( t_it->path().c_str(), &t_stat ) == 0 && 512 * t_stat.st_blocks > t_stat.st_size + 2 * t_stat.st_blksize )
+            {
+                LERROR( plog, "File <" << t_name << "> has " << 512 * t_stat.st_blocks << " bytes allocated for " << t_stat.st_size << " bytes of data" );
+                ++t_n_untrimmed;
+            }
+            boost::filesystem::remove( t_it->path() );
+        }
+    }
+
+    std::vector< double > t_sorted( t_record_us );
+    std::sort( t_sorted.begin(), t_sorted.end() );
+    double t_mean = 0.;
+    for( double t_us : t_sorted ) t_mean += t_us;
+    t_mean /= (double)t_sorted.size();
+
+    LINFO( plog, "Wrote " << t_n_records - t_n_failed << " records to " << t_n_files << " files" );
+    LINFO( plog, "Record write time (us): mean " << t_mean << "; 99.9% " << t_sorted[ t_sorted.size() * 999 / 1000 ] <<
+            "; max " << t_sorted.back() );
+    LINFO( plog, "On-deck depth " << t_on_deck_depth << ": no on-deck file was ready for " << t_n_dry << " of " << ( t_n_files > 0 ? t_n_files - 1 : 0 ) << " switches" );
+
+    if( t_n_failed != 0 || t_n_files < 2 || t_n_untrimmed != 0 )
+    {
+        LERROR( plog, t_n_failed << " records could not be written; " << t_n_files << " files were written, " << t_n_untrimmed << " of them untrimmed" );
+        return -1;
+    }
+
+    // with rotation by record count, every file but the last is full, and no empty file is left at the end
+    if( t_records_per_file > 0 && t_n_files != ( t_n_records + t_records_per_file - 1 ) / t_records_per_file )
+    {
+        LERROR( plog, t_n_files << " files were written; expected " << ( t_n_records + t_records_per_file - 1 ) / t_records_per_file );
+        return -1;
+    }
+
+    LINFO( plog, "File-switch latency test complete" );
+    return 0;
+}
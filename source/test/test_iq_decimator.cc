@@ -0,0 +1,177 @@
+/*
+ * test_iq_decimator.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Checks the IQ decimator used by the channelizer:
+ *    - a tone inside the selected channel comes out at the expected frequency and amplitude,
+ *    - a tone outside the channel is suppressed,
+ *    - processing in blocks of different sizes gives the same output,
+ *    - every instruction set supported on this CPU gives the same output.
+ *  Then reports the throughput for each instruction set.
+ *
+ *  Usage: > test_iq_decimator [decimation] [taps per phase]
+ *
+ *  Returns 0 if the checks pass; -1 otherwise.
+ */
+
+#include "iq_decimator.hh"
+
+#include "logger.hh"
+
+#include <chrono>
+#include <cmath>
+#include <complex>
+#include <cstdlib>
+#include <random>
+#include <vector>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_iq_decimator" );
+
+// complex tone plus a little noise, quantized to int8
+std::vector< int8_t > make_tone( size_t a_n_samples, double a_freq, double a_amplitude )
+{
+    std::mt19937 t_rng( 1234 );
+    std::normal_distribution< double > t_noise( 0., 1. );
+    std::vector< int8_t > t_iq( 2 * a_n_samples );
+    for( size_t i_sample = 0; i_sample < a_n_samples; ++i_sample )
+    {
+        double t_phase = 2. * M_PI * a_freq * (double)i_sample;
+        t_iq[ 2*i_sample ] = (int8_t)std::lrint( a_amplitude * std::cos( t_phase ) + t_noise( t_rng ) );
+        t_iq[ 2*i_sample + 1 ] = (int8_t)std::lrint( a_amplitude * std::sin( t_phase ) + t_noise( t_rng ) );
+    }
+    return t_iq;
+}
+
+// decimates the whole input in blocks of a_block samples
+std::vector< int8_t > decimate( iq_decimator& a_decimator, const std::vector< int8_t >& a_iq, size_t a_block )
+{
+    size_t t_n_samples = a_iq.size() / 2;
+    std::vector< int8_t > t_out( 2 * ( t_n_samples / a_decimator.get_decimation() + 2 ) );
+    size_t t_n_out = 0;
+    uint64_t t_first_out = 0;
+    a_decimator.reset();
+    for( size_t i_sample = 0; i_sample < t_n_samples; i_sample += a_block )
+    {
+        size_t t_n = std::min( a_block, t_n_samples - i_sample );
+        t_n_out += a_decimator.process( a_iq.data() + 2*i_sample, t_n, i_sample, t_out.data() + 2*t_n_out, t_first_out );
+    }
+    t_out.resize( 2 * t_n_out );
+    return t_out;
+}
+
+// amplitude of the component of a_iq at frequency a_freq (cycles per sample), skipping the filter's startup transient
+double amplitude_at( const std::vector< int8_t >& a_iq, double a_freq, size_t a_skip )
+{
+    std::complex< double > t_sum( 0., 0. );
+    size_t t_n = a_iq.size() / 2;
+    for( size_t i_sample = a_skip; i_sample < t_n; ++i_sample )
+    {
+        std::complex< double > t_value( a_iq[ 2*i_sample ], a_iq[ 2*i_sample + 1 ] );
+        t_sum += t_value * std::polar( 1., -2. * M_PI * a_freq * (double)i_sample );
+    }
+    return std::abs( t_sum ) / (double)( t_n - a_skip );
+}
+
+unsigned max_difference( const std::vector< int8_t >& a_first, const std::vector< int8_t >& a_second )
+{
+    if( a_first.size() != a_second.size() ) return 256;
+    unsigned t_max = 0;
+    for( size_t i = 0; i < a_first.size(); ++i )
+    {
+        t_max = std::max< unsigned >( t_max, std::abs( (int)a_first[ i ] - (int)a_second[ i ] ) );
+    }
+    return t_max;
+}
+
+int main( int argc, char** argv )
+{
+    unsigned t_decimation = argc > 1 ? atoi( argv[ 1 ] ) : 10;
+    unsigned t_taps_per_phase = argc > 2 ? atoi( argv[ 2 ] ) : 16;
+    if( t_decimation < 2 )
+    {
+        LERROR( plog, "Decimation factor must be at least 2" );
+        return -1;
+    }
+
+    const size_t t_n_samples = 64 * PAYLOAD_SIZE / 2;
+    const double t_offset = 0.21; // channel center, cycles per input sample
+    const double t_in_band = 0.1 / (double)t_decimation; // tone offset from the channel center, cycles per input sample
+    const double t_amplitude = 40.;
+
+    unsigned t_n_bad = 0;
+
+    iq_decimator t_decimator;
+    t_decimator.configure( t_offset, t_decimation, t_taps_per_phase, 0.8, 1. );
+    LINFO( plog, "Decimation " << t_decimation << " with " << t_decimator.taps().size() << " taps; native instruction set: " << to_string( t_decimator.get_isa() ) );
+    size_t t_skip = t_decimator.taps().size() / t_decimation + 1;
+
+    // a tone in the channel appears at its offset from the channel center, scaled up by the decimation factor
+    std::vector< int8_t > t_tone = make_tone( t_n_samples, t_offset + t_in_band, t_amplitude );
+    std::vector< int8_t > t_ref = decimate( t_decimator, t_tone, PAYLOAD_SIZE / 2 );
+    double t_in_amp = amplitude_at( t_ref, t_in_band * (double)t_decimation, t_skip );
+    LINFO( plog, "In-channel tone: amplitude " << t_in_amp << " (input " << t_amplitude << ")" );
+    if( std::fabs( t_in_amp - t_amplitude ) > 0.02 * t_amplitude )
+    {
+        LERROR( plog, "In-channel tone amplitude is wrong" );
+        ++t_n_bad;
+    }
+
+    // a tone outside the channel is suppressed
+    std::vector< int8_t > t_out_tone = make_tone( t_n_samples, t_offset + 1.5 / (double)t_decimation, 100. );
+    std::vector< int8_t > t_out_dec = decimate( t_decimator, t_out_tone, PAYLOAD_SIZE / 2 );
+    double t_out_rms = 0.;
+    for( size_t i = 2 * t_skip; i < t_out_dec.size(); ++i ) t_out_rms += (double)t_out_dec[ i ] * (double)t_out_dec[ i ];
+    t_out_rms = std::sqrt( t_out_rms / (double)( t_out_dec.size() - 2 * t_skip ) );
+    LINFO( plog, "Out-of-channel tone: RMS " << t_out_rms << " (input amplitude 100)" );
+    if( t_out_rms > 1. )
+    {
+        LERROR( plog, "Out-of-channel tone is not suppressed" );
+        ++t_n_bad;
+    }
+
+    // the block size doesn't matter (to within rounding of the mixing phase)
+    std::vector< int8_t > t_odd_blocks = decimate( t_decimator, t_tone, 1000 );
+    if( max_difference( t_odd_blocks, t_ref ) > 1 )
+    {
+        LERROR( plog, "Output depends on the block size" );
+        ++t_n_bad;
+    }
+
+    // each supported instruction set agrees with the scalar version, and its throughput
+    t_decimator.set_isa( kernel_isa::scalar );
+    std::vector< int8_t > t_scalar = decimate( t_decimator, t_tone, PAYLOAD_SIZE / 2 );
+    for( kernel_isa t_isa : { kernel_isa::scalar, kernel_isa::sse2, kernel_isa::avx2 } )
+    {
+        if( ! kernel_isa_supported( t_isa ) )
+        {
+            LINFO( plog, to_string( t_isa ) << " is not supported on this CPU" );
+            continue;
+        }
+        t_decimator.set_isa( t_isa );
+        std::vector< int8_t > t_test = decimate( t_decimator, t_tone, PAYLOAD_SIZE / 2 );
+        if( max_difference( t_test, t_scalar ) > 1 )
+        {
+            LERROR( plog, to_string( t_isa ) << " differs from scalar" );
+            ++t_n_bad;
+        }
+
+        const unsigned t_n_reps = 5;
+        auto t_start = std::chrono::steady_clock::now();
+        for( unsigned i_rep = 0; i_rep < t_n_reps; ++i_rep ) decimate( t_decimator, t_tone, PAYLOAD_SIZE / 2 );
+        double t_sec = std::chrono::duration< double >( std::chrono::steady_clock::now() - t_start ).count();
+        double t_msps = 1.e-6 * (double)( t_n_reps * t_n_samples ) / t_sec;
+        LINFO( plog, to_string( t_isa ) << ": " << t_msps << " input MS/s" );
+    }
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, "Found " << t_n_bad << " problems" );
+        return -1;
+    }
+
+    LINFO( plog, "IQ decimator checks passed" );
+    return 0;
+}
@@ -0,0 +1,192 @@
+/*
+ * test_mirrored_buffer.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Checks that the mirrored buffer's two mappings share the same memory, and that packet_ring windows that wrap around
+ *  the end of the ring are contiguous and correct.
+ *  Then compares the cost of processing windows of packets that wrap around the end of a ring in three ways:
+ *    - copying wrapped windows into a contiguous scratch buffer,
+ *    - processing the two pieces of wrapped windows separately,
+ *    - processing the window in place in the mirrored ring.
+ *
+ *  Usage: > test_mirrored_buffer [window length in packets]
+ *
+ *  Returns 0 if the checks pass; -1 otherwise.
+ */
+
+#include "mirrored_buffer.hh"
+#include "packet_ring.hh"
+
+#include "logger.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_mirrored_buffer" );
+
+// sum of squares of the samples; stands in for any algorithm that needs a contiguous window
+int64_t window_energy( const int8_t* a_data, size_t a_n_bytes )
+{
+    // 32-bit partial sums (which can't overflow within a packet's worth of bytes) let the compiler vectorize the loop
+    int64_t t_sum = 0;
+    for( size_t i_start = 0; i_start < a_n_bytes; i_start += PAYLOAD_SIZE )
+    {
+        size_t t_end = std::min< size_t >( i_start + PAYLOAD_SIZE, a_n_bytes );
+        int32_t t_partial = 0;
+        for( size_t i = i_start; i < t_end; ++i )
+        {
+            t_partial += (int32_t)a_data[ i ] * (int32_t)a_data[ i ];
+        }
+        t_sum += t_partial;
+    }
+    return t_sum;
+}
+
+int main( int argc, char** argv )
+{
+    unsigned t_window = argc > 1 ? atoi( argv[ 1 ] ) : 16;
+    const unsigned t_n_slots = 64;
+    const unsigned t_n_passes = 200;
+
+    unsigned t_n_bad = 0;
+
+    // the two mappings of the mirrored buffer share the same memory
+    mirrored_buffer t_buffer;
+    t_buffer.allocate( 3 * 4096 + 1 );
+    LINFO( plog, "Mirrored buffer size: " << t_buffer.size() << " bytes" );
+    for( size_t i = 0; i < t_buffer.size(); ++i ) t_buffer.data()[ i ] = (char)( i * 7 );
+    t_buffer.data()[ t_buffer.size() + 5 ] = 42;
+    if( t_buffer.data()[ 5 ] != 42 || memcmp( t_buffer.data() + 6, t_buffer.data() + t_buffer.size() + 6, t_buffer.size() - 6 ) != 0 )
+    {
+        LERROR( plog, "The two mappings of the mirrored buffer differ" );
+        ++t_n_bad;
+    }
+
+    // fill a packet ring and check a window that wraps around the end
+    packet_ring t_ring;
+    t_ring.allocate( t_n_slots );
+    if( t_window > t_ring.get_n_slots() )
+    {
+        LERROR( plog, "Window length must be no more than " << t_ring.get_n_slots() << " packets" );
+        return -1;
+    }
+    time_data t_packet;
+    uint64_t t_n_packets = 3 * t_ring.get_n_slots() + t_window / 2;
+    for( uint64_t t_id = 0; t_id < t_n_packets; ++t_id )
+    {
+        t_packet.set_pkt_in_session( t_id );
+        for( unsigned i_sample = 0; i_sample < t_packet.get_array_size(); ++i_sample )
+        {
+            t_packet.get_array()[ i_sample ][ 0 ] = (int8_t)( t_id + i_sample );
+            t_packet.get_array()[ i_sample ][ 1 ] = (int8_t)( t_id * 3 - i_sample );
+        }
+        t_ring.write( t_packet );
+    }
+
+    id_range_event t_event;
+    t_event.set_end_id( t_ring.get_newest_id() );
+    t_event.set_start_id( t_ring.get_newest_id() + 1 - t_window );
+    packet_ring::span t_span;
+    if( ! t_ring.get_event_span( t_event, t_span ) || t_span.f_n_packets != t_window )
+    {
+        LERROR( plog, "Unable to get the span for packets " << t_event.get_start_id() << " to " << t_event.get_end_id() );
+        ++t_n_bad;
+    }
+    else
+    {
+        for( uint64_t t_id = t_event.get_start_id(); t_id <= t_event.get_end_id(); ++t_id )
+        {
+            if( memcmp( t_span.f_payload + ( t_id - t_event.get_start_id() ) * PAYLOAD_SIZE, t_ring.payload( t_id ), PAYLOAD_SIZE ) != 0 )
+            {
+                LERROR( plog, "Window contents differ from packet " << t_id );
+                ++t_n_bad;
+            }
+        }
+    }
+
+    // benchmark: process the window starting at every slot in the ring
+    const size_t t_ring_bytes = t_ring.get_n_slots() * PAYLOAD_SIZE;
+    const size_t t_window_bytes = t_window * PAYLOAD_SIZE;
+    const int8_t* t_base = t_ring.window( 0 );
+    std::vector< int8_t > t_scratch( t_window_bytes );
+
+    int64_t t_sum_copy = 0, t_sum_split = 0, t_sum_mirror = 0;
+
+    auto t_start = std::chrono::steady_clock::now();
+    for( unsigned i_pass = 0; i_pass < t_n_passes; ++i_pass )
+    {
+        for( size_t i_slot = 0; i_slot < t_ring.get_n_slots(); ++i_slot )
+        {
+            size_t t_offset = i_slot * PAYLOAD_SIZE;
+            if( t_offset + t_window_bytes <= t_ring_bytes )
+            {
+                t_sum_copy += window_energy( t_base + t_offset, t_window_bytes );
+            }
+            else
+            {
+                size_t t_first_bytes = t_ring_bytes - t_offset;
+                ::memcpy( t_scratch.data(), t_base + t_offset, t_first_bytes );
+                ::memcpy( t_scratch.data() + t_first_bytes, t_base, t_window_bytes - t_first_bytes );
+                t_sum_copy += window_energy( t_scratch.data(), t_window_bytes );
+            }
+        }
+    }
+    auto t_copy_end = std::chrono::steady_clock::now();
+    for( unsigned i_pass = 0; i_pass < t_n_passes; ++i_pass )
+    {
+        for( size_t i_slot = 0; i_slot < t_ring.get_n_slots(); ++i_slot )
+        {
+            size_t t_offset = i_slot * PAYLOAD_SIZE;
+            if( t_offset + t_window_bytes <= t_ring_bytes )
+            {
+                t_sum_split += window_energy( t_base + t_offset, t_window_bytes );
+            }
+            else
+            {
+                size_t t_first_bytes = t_ring_bytes - t_offset;
+                t_sum_split += window_energy( t_base + t_offset, t_first_bytes );
+                t_sum_split += window_energy( t_base, t_window_bytes - t_first_bytes );
+            }
+        }
+    }
+    auto t_split_end = std::chrono::steady_clock::now();
+    for( unsigned i_pass = 0; i_pass < t_n_passes; ++i_pass )
+    {
+        for( size_t i_slot = 0; i_slot < t_ring.get_n_slots(); ++i_slot )
+        {
+            t_sum_mirror += window_energy( t_base + i_slot * PAYLOAD_SIZE, t_window_bytes );
+        }
+    }
+    auto t_mirror_end = std::chrono::steady_clock::now();
+
+    if( t_sum_copy != t_sum_mirror || t_sum_split != t_sum_mirror )
+    {
+        LERROR( plog, "Window results differ: copy: " << t_sum_copy << "; split: " << t_sum_split << "; mirrored: " << t_sum_mirror );
+        ++t_n_bad;
+    }
+
+    double t_n_windows = (double)t_n_passes * (double)t_ring.get_n_slots();
+    double t_copy_ns = std::chrono::duration< double, std::nano >( t_copy_end - t_start ).count() / t_n_windows;
+    double t_split_ns = std::chrono::duration< double, std::nano >( t_split_end - t_copy_end ).count() / t_n_windows;
+    double t_mirror_ns = std::chrono::duration< double, std::nano >( t_mirror_end - t_split_end ).count() / t_n_windows;
+    LINFO( plog, "Windows of " << t_window << " packets in a ring of " << t_ring.get_n_slots() << " packets (" <<
+            100. * (double)( t_window - 1 ) / (double)t_ring.get_n_slots() << "% of windows wrap)" );
+    LINFO( plog, "Copy wrapped windows:     " << t_copy_ns << " ns per window" );
+    LINFO( plog, "Split wrapped windows:    " << t_split_ns << " ns per window" );
+    LINFO( plog, "Mirrored ring (in place): " << t_mirror_ns << " ns per window" );
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, "Found " << t_n_bad << " problems" );
+        return -1;
+    }
+
+    LINFO( plog, "Mirrored buffer checks passed" );
+    return 0;
+}
@@ -0,0 +1,317 @@
+/*
+ * test_raw_egg.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Writes raw egg files and reads them back:
+ *    - the header metadata and every record's data, ID, time and new-acquisition flag are read back intact;
+ *    - writing stops when the file is full, and finishing it moves the index to just after the last record and truncates the file;
+ *    - a copy of the file taken before it was finished can still be read, using the records that were indexed;
+ *    - the same checks pass with direct I/O, if the filesystem supports it, and with the io_uring backend, if the kernel supports it;
+ *    - the same checks pass with compressed records, some of which compress, and some of which (noise) are stored as they are.
+ *  Reports the write rate, and with io_uring, the submit and completion latencies.
+ *
+ *  Usage: > test_raw_egg [output directory]
+ *
+ *  The files are written as test_raw_egg*.rawegg in the output directory (default: the current directory), and removed afterwards.
+ *
+ *  Returns 0 if the checks pass; -1 otherwise.
+ */
+
+#include "psyllid_error.hh"
+#include "raw_egg.hh"
+#include "record_compression.hh"
+
+#include "logger.hh"
+
+#include <boost/filesystem.hpp>
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <string>
+#include <vector>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_raw_egg" );
+
+const uint32_t s_record_bytes = 8192;
+
+// every 7th record is noise, which doesn't compress; the others are constant apart from their ID
+void fill_record( int8_t* a_record, uint64_t a_id )
+{
+    if( a_id % 7 == 0 )
+    {
+        uint64_t t_state = a_id;
+        for( uint32_t i_byte = 0; i_byte < s_record_bytes; ++i_byte )
+        {
+            t_state = t_state * 6364136223846793005ULL + 1442695040888963407ULL;
+            a_record[ i_byte ] = (int8_t)( t_state >> 56 );
+        }
+    }
+    else
+    {
+        ::memset( a_record, (int8_t)a_id, s_record_bytes );
+    }
+    ::memcpy( a_record, &a_id, sizeof( a_id ) );
+    return;
+}
+
+bool check_record( const int8_t* a_record, uint64_t a_id )
+{
+    std::vector< int8_t > t_expected( s_record_bytes );
+    fill_record( t_expected.data(), a_id );
+    return ::memcmp( a_record, t_expected.data(), s_record_bytes ) == 0;
+}
+
+/// Checks the header and the first a_n_records records of a file written by write_file(); returns the number of problems found
+unsigned check_file( const std::string& a_filename, uint64_t a_n_records, bool a_finished, record_compression a_compression )
+{
+    unsigned t_n_bad = 0;
+    raw_egg_file_reader t_reader;
+    t_reader.open( a_filename );
+    const raw_egg_header& t_header = t_reader.header();
+    if( t_reader.was_finished() != a_finished || t_reader.get_n_records() != a_n_records )
+    {
+        LERROR( plog, "<" << a_filename << ">: finished: " << t_reader.was_finished() << "; " << t_reader.get_n_records() << " records (expected " << a_n_records << ")" );
+        ++t_n_bad;
+    }
+    if( t_header.f_record_bytes != s_record_bytes || t_header.f_source != "test_raw_egg" || t_header.f_acq_rate != 100 ||
+            t_header.f_record_size != 4096 || t_header.f_sample_size != 2 || t_header.f_bit_depth != 8 ||
+            t_header.f_v_range != 0.5 || t_header.f_freq_min != 25.e6 || t_header.f_description != "Raw egg test" || t_header.f_run_duration != 1234 ||
+            t_header.f_compression != a_compression )
+    {
+        LERROR( plog, "<" << a_filename << ">: header metadata was not read back correctly" );
+        ++t_n_bad;
+    }
+
+    std::vector< int8_t > t_buffer( s_record_bytes );
+    uint64_t t_data_bytes = 0;
+    for( uint64_t i_record = 0; i_record < t_reader.get_n_records(); ++i_record )
+    {
+        const raw_egg_index_entry& t_entry = t_reader.get_entry( i_record );
+        t_reader.read_record( i_record, t_buffer.data() );
+        // with compression, the noise records are stored as they are, and the others compressed
+        bool t_expect_compressed = a_compression != record_compression::none && t_entry.f_id % 7 != 0;
+        if( t_entry.f_id != 10 + i_record || t_entry.f_time != 1000 * i_record || t_entry.is_new_acq() != ( i_record % 100 == 0 ) ||
+                t_entry.is_compressed() != t_expect_compressed || ! check_record( t_buffer.data(), t_entry.f_id ) )
+        {
+            if( t_n_bad < 10 ) LERROR( plog, "<" << a_filename << ">: record " << i_record << " was not read back correctly" );
+            ++t_n_bad;
+        }
+        t_data_bytes += t_entry.f_stored_bytes;
+    }
+
+    if( a_finished )
+    {
+        uint64_t t_expected_size = raw_egg_header::s_size + t_data_bytes + a_n_records * sizeof( raw_egg_index_entry );
+        if( t_header.f_index_offset != raw_egg_header::s_size + t_data_bytes || boost::filesystem::file_size( a_filename ) != t_expected_size )
+        {
+            LERROR( plog, "<" << a_filename << ">: the file was not truncated after the last record and its index" );
+            ++t_n_bad;
+        }
+    }
+    return t_n_bad;
+}
+
+/// Writes a file with records in groups of t_group_size, stopping after a_n_records or when the file is full; returns the problems found.
+/// If a_uring isn't nullptr, it's used as the writer's backend.  With compression, each group is compressed as the raw-streaming-writer does.
+unsigned test_file( const std::string& a_filename, uint64_t a_capacity, uint64_t a_n_records, bool a_direct_io, uring_writer* a_uring,
+        record_compression a_compression = record_compression::none )
+{
+    const uint64_t t_group_size = 32;
+    const uint64_t t_n_blocks = 16;
+    unsigned t_n_bad = 0;
+
+    raw_egg_header t_header;
+    t_header.f_record_bytes = s_record_bytes;
+    t_header.f_source = "test_raw_egg";
+    t_header.f_acq_rate = 100;
+    t_header.f_record_size = 4096;
+    t_header.f_sample_size = 2;
+    t_header.f_data_type_size = 1;
+    t_header.f_bit_depth = 8;
+    t_header.f_v_range = 0.5;
+    t_header.f_freq_min = 25.e6;
+    t_header.f_freq_range = 50.e6;
+    t_header.f_filename = a_filename;
+    t_header.f_description = "Raw egg test";
+    t_header.f_run_duration = 1234;
+    t_header.f_compression = a_compression;
+
+    // each group's records are in one aligned block, as they are in a record_batch_queue batch; with io_uring, a block isn't reused until its writes are done
+    int8_t* t_blocks = nullptr;
+    if( ::posix_memalign( reinterpret_cast< void** >( &t_blocks ), raw_egg_file_writer::s_direct_io_alignment, t_n_blocks * t_group_size * s_record_bytes ) != 0 )
+    {
+        throw error() << "Unable to allocate the record blocks";
+    }
+    std::vector< uint64_t > t_block_chains( t_n_blocks, 0 ); // number of io_uring chains submitted by the end of each block's last write
+    std::vector< const int8_t* > t_records( t_group_size );
+    std::vector< raw_egg_index_entry > t_entries( t_group_size );
+
+    // the compressed groups are written from blocks of their own
+    record_compressor t_compressor;
+    std::vector< int8_t > t_compressed_blocks;
+    std::vector< uint32_t > t_stored_bytes( t_group_size );
+    if( a_compression != record_compression::none )
+    {
+        t_compressor.start( a_compression, 1, 2, s_record_bytes );
+        t_compressed_blocks.resize( t_n_blocks * t_group_size * s_record_bytes );
+    }
+
+    if( a_uring != nullptr )
+    {
+        if( ! a_uring->register_buffer( t_blocks, t_n_blocks * t_group_size * s_record_bytes ) ) LWARN( plog, "Unable to register the record blocks with io_uring" );
+        a_uring->reset_stats();
+    }
+
+    raw_egg_file_writer t_writer;
+    t_writer.set_uring( a_uring );
+    t_writer.open( a_filename, t_header, a_capacity, a_direct_io );
+    LINFO( plog, "Writing <" << a_filename << ">; direct I/O requested: " << a_direct_io << "; used: " << t_writer.uses_direct_io() << "; io_uring: " << ( a_uring != nullptr ) );
+
+    uint64_t t_n_written = 0;
+    uint64_t t_n_to_write = std::min( a_n_records, a_capacity + 2 * t_group_size ); // past the end of the file, to check that writing stops
+    auto t_start = std::chrono::steady_clock::now();
+    for( uint64_t i_group = 0; t_n_written < t_n_to_write; ++i_group )
+    {
+        int8_t* t_block = t_blocks + ( i_group % t_n_blocks ) * t_group_size * s_record_bytes;
+        if( a_uring != nullptr )
+        {
+            while( a_uring->get_n_completed() < t_block_chains[ i_group % t_n_blocks ] ) a_uring->wait_for_completion();
+        }
+
+        uint64_t t_n_group = std::min( t_group_size, t_n_to_write - t_n_written );
+        for( uint64_t i_record = 0; i_record < t_n_group; ++i_record )
+        {
+            uint64_t t_index = t_n_written + i_record;
+            t_records[ i_record ] = t_block + i_record * s_record_bytes;
+            fill_record( t_block + i_record * s_record_bytes, 10 + t_index );
+            t_entries[ i_record ] = { 10 + t_index, 1000 * t_index, t_index % 100 == 0 ? raw_egg_index_entry::s_new_acq : 0U, 0U };
+        }
+        if( t_compressor.is_running() )
+        {
+            int8_t* t_compressed = t_compressed_blocks.data() + ( i_group % t_n_blocks ) * t_group_size * s_record_bytes;
+            t_compressor.compress( t_records.data(), t_n_group, t_compressed, t_stored_bytes.data() );
+            for( uint64_t i_record = 0; i_record < t_n_group; ++i_record )
+            {
+                t_records[ i_record ] = t_compressed;
+                if( t_stored_bytes[ i_record ] < s_record_bytes )
+                {
+                    t_entries[ i_record ].f_flags |= raw_egg_index_entry::s_compressed;
+                    t_entries[ i_record ].f_stored_bytes = t_stored_bytes[ i_record ];
+                }
+                t_compressed += t_stored_bytes[ i_record ];
+            }
+        }
+        uint64_t t_n_group_written = t_writer.write( t_records.data(), t_entries.data(), t_n_group );
+        if( a_uring != nullptr ) t_block_chains[ i_group % t_n_blocks ] = a_uring->get_n_submitted();
+        t_n_written += t_n_group_written;
+        if( t_n_group_written < t_n_group ) break;
+    }
+    if( a_uring != nullptr )
+    {
+        a_uring->wait_for_all();
+        if( a_uring->has_failed() )
+        {
+            LERROR( plog, "io_uring write failed: " << a_uring->get_error() );
+            ++t_n_bad;
+        }
+    }
+    double t_write_sec = std::chrono::duration< double >( std::chrono::steady_clock::now() - t_start ).count();
+
+    uint64_t t_expected_records = std::min( a_n_records, a_capacity );
+    if( t_n_written != t_expected_records || t_writer.is_full() != ( a_n_records >= a_capacity ) )
+    {
+        LERROR( plog, "Wrote " << t_n_written << " records (expected " << t_expected_records << ")" );
+        ++t_n_bad;
+    }
+    LINFO( plog, "Wrote " << t_n_written << " records at " << 1.e-6 * (double)( t_n_written * s_record_bytes ) / t_write_sec << " MB/s" );
+    if( t_compressor.is_running() )
+    {
+        LINFO( plog, "Compression ratio: " << t_compressor.get_ratio() << "; " << t_compressor.get_rate_per_thread() << " MB/s per thread" );
+    }
+    if( a_uring != nullptr && t_n_written > 0 )
+    {
+        const latency_histogram& t_submit = a_uring->get_submit_latency();
+        const latency_histogram& t_complete = a_uring->get_complete_latency();
+        LINFO( plog, "Submit latency (us): mean " << t_submit.get_mean_us() << "; 99% < " << t_submit.get_percentile_us( 0.99 ) << "; max " << t_submit.get_max_us() );
+        LINFO( plog, "Completion latency (us): mean " << t_complete.get_mean_us() << "; 99% < " << t_complete.get_percentile_us( 0.99 ) << "; max " << t_complete.get_max_us() );
+        if( t_submit.get_count() != t_complete.get_count() || t_submit.get_count() == 0 )
+        {
+            LERROR( plog, t_submit.get_count() << " chains were submitted, and " << t_complete.get_count() << " completed" );
+            ++t_n_bad;
+        }
+    }
+
+    // a copy of the unfinished file, as if the writer had stopped here
+    std::string t_unfinished_filename( a_filename + ".unfinished.rawegg" );
+    boost::filesystem::copy_file( a_filename, t_unfinished_filename, boost::filesystem::copy_option::overwrite_if_exists );
+
+    t_writer.finish();
+    if( a_uring != nullptr ) a_uring->unregister_buffer();
+    ::free( t_blocks );
+
+    t_n_bad += check_file( a_filename, t_expected_records, true, a_compression );
+    t_n_bad += check_file( t_unfinished_filename, t_expected_records, false, a_compression );
+
+    boost::filesystem::remove( a_filename );
+    boost::filesystem::remove( t_unfinished_filename );
+    return t_n_bad;
+}
+
+int main( const int argc, const char** argv )
+{
+    std::string t_dir( argc > 1 ? argv[ 1 ] : "." );
+
+    unsigned t_n_bad = 0;
+    try
+    {
+        uring_writer t_uring;
+        try
+        {
+            t_uring.initialize( 8 );
+        }
+        catch( error& e )
+        {
+            LWARN( plog, "io_uring is not available; only testing pwritev\n" << e.what() );
+        }
+
+        // a partly filled file, a file filled exactly, and a file written past its end; with and without direct I/O, and with pwritev and io_uring
+        for( bool t_use_uring : { false, true } )
+        {
+            if( t_use_uring && ! t_uring.is_initialized() ) continue;
+            for( bool t_direct_io : { false, true } )
+            {
+                std::string t_base( t_dir + "/test_raw_egg" + ( t_direct_io ? "_direct" : "" ) + ( t_use_uring ? "_uring" : "" ) );
+                uring_writer* t_uring_ptr = t_use_uring ? &t_uring : nullptr;
+                t_n_bad += test_file( t_base + "_partial.rawegg", 10000, 7777, t_direct_io, t_uring_ptr );
+                t_n_bad += test_file( t_base + "_full.rawegg", 4096, 4096, t_direct_io, t_uring_ptr );
+                t_n_bad += test_file( t_base + "_overfull.rawegg", 1000, 5000, t_direct_io, t_uring_ptr );
+            }
+            // compressed; direct I/O is requested, but can't be used
+            std::string t_base( t_dir + "/test_raw_egg_compressed" + ( t_use_uring ? "_uring" : "" ) );
+            uring_writer* t_uring_ptr = t_use_uring ? &t_uring : nullptr;
+            t_n_bad += test_file( t_base + "_partial.rawegg", 10000, 7777, true, t_uring_ptr, record_compression::bitshuffle_deflate );
+            t_n_bad += test_file( t_base + "_overfull.rawegg", 1000, 5000, true, t_uring_ptr, record_compression::deflate );
+        }
+        // nothing written
+        t_n_bad += test_file( t_dir + "/test_raw_egg_empty.rawegg", 100, 0, false, nullptr );
+    }
+    catch( std::exception& e )
+    {
+        LERROR( plog, "Exception while testing: " << e.what() );
+        return -1;
+    }
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, t_n_bad << " problems were found" );
+        return -1;
+    }
+
+    LINFO( plog, "Raw egg test complete" );
+    return 0;
+}
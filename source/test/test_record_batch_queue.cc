@@ -0,0 +1,175 @@
+/*
+ * test_record_batch_queue.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Passes records through a record_batch_queue from a producer to a consumer thread:
+ *    - with a consumer that keeps up, and a long maximum stall, every record arrives in order and intact, and none are dropped;
+ *    - with a consumer that's blocked, the producer stalls for the maximum stall time and then drops records, and the drops are counted;
+ *    - flush() passes a partial batch, wait_until_empty() returns once it's written, and close() ends the consumer.
+ *  Reports the time per record through the queue.
+ *
+ *  Usage: > test_record_batch_queue
+ *
+ *  Returns 0 if the checks pass; -1 otherwise.
+ */
+
+#include "record_batch_queue.hh"
+
+#include "logger.hh"
+
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <thread>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_record_batch_queue" );
+
+const size_t s_record_size = 8192;
+
+void fill_record( int8_t* a_record, uint64_t a_id )
+{
+    ::memset( a_record, (int8_t)a_id, s_record_size );
+    ::memcpy( a_record, &a_id, sizeof( a_id ) );
+    return;
+}
+
+bool check_record( const int8_t* a_record, uint64_t a_id )
+{
+    uint64_t t_id = 0;
+    ::memcpy( &t_id, a_record, sizeof( t_id ) );
+    return t_id == a_id && a_record[ s_record_size - 1 ] == (int8_t)a_id;
+}
+
+int main()
+{
+    const size_t t_n_batches = 8;
+    const size_t t_batch_size = 4;
+    const uint64_t t_n_records = 100000;
+
+    unsigned t_n_bad = 0;
+
+    record_batch_queue t_queue;
+    t_queue.allocate( t_n_batches, t_batch_size, s_record_size );
+
+    // the consumer checks that records arrive in order; it can be blocked to fill the queue
+    std::atomic< bool > t_block_consumer( false );
+    std::atomic< uint64_t > t_n_consumed( 0 );
+    std::atomic< uint64_t > t_n_wrong( 0 );
+    uint64_t t_next_expected = 0;
+    std::thread t_consumer( [&]()
+    {
+        const record_batch_queue::batch* t_batch = nullptr;
+        while( ( t_batch = t_queue.next_batch() ) != nullptr )
+        {
+            while( t_block_consumer.load() ) std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+            for( size_t i_record = 0; i_record < t_batch->f_n_records; ++i_record )
+            {
+                const record_batch_queue::record& t_record = t_batch->f_records[ i_record ];
+                // after drops, the IDs jump ahead, and the record is marked as a new acquisition
+                if( t_record.f_id < t_next_expected || ( t_record.f_id != t_next_expected && ! t_record.f_is_new_acq ) ||
+                        t_record.f_time != 2 * t_record.f_id || ! check_record( t_record.f_data, t_record.f_id ) )
+                {
+                    t_n_wrong.fetch_add( 1 );
+                }
+                t_next_expected = t_record.f_id + 1;
+            }
+            t_n_consumed.fetch_add( t_batch->f_n_records );
+            t_queue.release_batch();
+        }
+    } );
+
+    // a consumer that keeps up: nothing is dropped
+    auto t_start = std::chrono::steady_clock::now();
+    for( uint64_t t_id = 0; t_id < t_n_records; ++t_id )
+    {
+        int8_t* t_record = t_queue.begin_record( std::chrono::milliseconds( 10000 ) );
+        if( t_record == nullptr )
+        {
+            ++t_n_bad;
+            continue;
+        }
+        fill_record( t_record, t_id );
+        t_queue.commit_record( t_id, 2 * t_id, t_id == 0 );
+    }
+    t_queue.flush();
+    t_queue.wait_until_empty();
+    double t_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - t_start ).count() / (double)t_n_records;
+    LINFO( plog, "Passed " << t_n_records << " records through the queue: " << t_ns << " ns per record (including filling); high-water mark " <<
+            t_queue.get_high_water() << " of " << t_n_batches << " batches; " << t_queue.get_n_stalls() << " stalls totaling " <<
+            1.e-6 * (double)t_queue.get_stall_time() << " ms" );
+    if( t_n_consumed.load() != t_n_records || t_queue.get_n_dropped() != 0 || t_queue.get_depth() != 0 || t_queue.get_high_water() > t_n_batches )
+    {
+        LERROR( plog, "Consumed " << t_n_consumed.load() << " of " << t_n_records << " records, with " << t_queue.get_n_dropped() << " dropped" );
+        ++t_n_bad;
+    }
+
+    // a blocked consumer: the producer fills the queue, then stalls and drops
+    t_queue.reset_stats();
+    t_block_consumer.store( true );
+    const std::chrono::milliseconds t_max_stall( 5 );
+    const uint64_t t_n_blocked_records = ( t_n_batches + 2 ) * t_batch_size + 10;
+    bool t_after_gap = false;
+    for( uint64_t t_id = t_n_records; t_id < t_n_records + t_n_blocked_records; ++t_id )
+    {
+        int8_t* t_record = t_queue.begin_record( t_max_stall );
+        if( t_record == nullptr )
+        {
+            t_after_gap = true;
+            continue;
+        }
+        fill_record( t_record, t_id );
+        t_queue.commit_record( t_id, 2 * t_id, t_after_gap );
+        t_after_gap = false;
+    }
+    // the consumer holds one batch, and the producer fills the other n-batches batches; the remaining records are dropped
+    uint64_t t_expected_dropped = t_n_blocked_records - t_n_batches * t_batch_size;
+    LINFO( plog, "With a blocked consumer: " << t_queue.get_n_dropped() << " records dropped (expected " << t_expected_dropped << "); " <<
+            t_queue.get_n_stalls() << " stalls totaling " << 1.e-6 * (double)t_queue.get_stall_time() << " ms; high-water mark " << t_queue.get_high_water() );
+    if( t_queue.get_n_dropped() != t_expected_dropped || t_queue.get_n_stalls() != t_expected_dropped ||
+            t_queue.get_stall_time() < t_expected_dropped * std::chrono::duration_cast< std::chrono::nanoseconds >( t_max_stall ).count() ||
+            t_queue.get_high_water() != t_n_batches )
+    {
+        LERROR( plog, "Drops or stalls were not counted correctly" );
+        ++t_n_bad;
+    }
+
+    // once the consumer is unblocked, a record after the gap goes through, and the partial batch is written by flush()
+    t_block_consumer.store( false );
+    uint64_t t_last_id = t_n_records + t_n_blocked_records + 100;
+    int8_t* t_record = t_queue.begin_record( std::chrono::milliseconds( 10000 ) );
+    if( t_record == nullptr ) ++t_n_bad;
+    else
+    {
+        fill_record( t_record, t_last_id );
+        t_queue.commit_record( t_last_id, 2 * t_last_id, true );
+    }
+    t_queue.flush();
+    t_queue.wait_until_empty();
+
+    t_queue.close();
+    t_consumer.join();
+
+    uint64_t t_expected_consumed = t_n_records + t_n_batches * t_batch_size + 1;
+    if( t_n_consumed.load() != t_expected_consumed || t_next_expected != t_last_id + 1 )
+    {
+        LERROR( plog, "Consumed " << t_n_consumed.load() << " records; expected " << t_expected_consumed );
+        ++t_n_bad;
+    }
+    if( t_n_wrong.load() != 0 )
+    {
+        LERROR( plog, t_n_wrong.load() << " records arrived out of order or corrupted" );
+        ++t_n_bad;
+    }
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, "Found " << t_n_bad << " problems" );
+        return -1;
+    }
+
+    LINFO( plog, "Record batch queue checks passed" );
+    return 0;
+}
@@ -0,0 +1,161 @@
+/*
+ * test_record_compression.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Benchmarks the lossless record compression used for raw egg files:
+ *    - bitshuffle() and bitunshuffle() are inverses;
+ *    - every record compressed by a record_compressor, with each compression and number of threads, decompresses to the original.
+ *  For each set of records, reports the compression ratio, the rate per compression thread, and the total rate.
+ *
+ *  The records are simulated 8-bit IQ packets: Gaussian noise at several RMS levels (in ADC counts), and noise plus a tone.
+ *  If a raw egg file is given, its records are benchmarked too (up to the first 4096).
+ *
+ *  Usage: > test_record_compression [raw egg file]
+ *
+ *  Returns 0 if the checks pass; -1 otherwise.
+ */
+
+#include "psyllid_error.hh"
+#include "raw_egg.hh"
+#include "record_compression.hh"
+
+#include "logger.hh"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_record_compression" );
+
+const size_t s_batch_size = 64;
+
+/// Fills a_n_records records of a_record_bytes with IQ samples: Gaussian noise of RMS a_rms, plus a tone of amplitude a_tone
+std::vector< int8_t > simulate_records( size_t a_n_records, size_t a_record_bytes, double a_rms, double a_tone )
+{
+    std::vector< int8_t > t_records( a_n_records * a_record_bytes );
+    std::mt19937 t_engine( 1234 );
+    std::normal_distribution< double > t_noise( 0., a_rms );
+    const double t_phase_step = 2. * M_PI * 0.0137;
+    for( size_t i_sample = 0; i_sample < t_records.size() / 2; ++i_sample )
+    {
+        double t_phase = t_phase_step * (double)i_sample;
+        double t_i = t_noise( t_engine ) + a_tone * std::cos( t_phase );
+        double t_q = t_noise( t_engine ) + a_tone * std::sin( t_phase );
+        t_records[ 2 * i_sample ] = (int8_t)std::max( -128., std::min( 127., std::round( t_i ) ) );
+        t_records[ 2 * i_sample + 1 ] = (int8_t)std::max( -128., std::min( 127., std::round( t_q ) ) );
+    }
+    return t_records;
+}
+
+/// Compresses the records in batches with each compression and number of threads, and checks that they decompress to the originals;
+/// returns the number of problems found
+unsigned benchmark( const std::string& a_name, const std::vector< int8_t >& a_records, size_t a_record_bytes )
+{
+    unsigned t_n_bad = 0;
+    size_t t_n_records = a_records.size() / a_record_bytes;
+    std::vector< int8_t > t_packed( s_batch_size * a_record_bytes );
+    std::vector< uint32_t > t_stored_bytes( s_batch_size );
+    std::vector< const int8_t* > t_pointers( s_batch_size );
+    std::vector< int8_t > t_decompressed( a_record_bytes );
+
+    for( record_compression t_compression : { record_compression::deflate, record_compression::bitshuffle_deflate } )
+    {
+        record_codec t_codec( t_compression, 1 );
+        for( unsigned t_n_threads : { 1U, 2U, 4U } )
+        {
+            record_compressor t_compressor;
+            t_compressor.start( t_compression, 1, t_n_threads, a_record_bytes );
+            double t_wall_sec = 0.;
+            for( size_t i_first = 0; i_first < t_n_records; i_first += s_batch_size )
+            {
+                size_t t_n = std::min( s_batch_size, t_n_records - i_first );
+                for( size_t i_record = 0; i_record < t_n; ++i_record ) t_pointers[ i_record ] = a_records.data() + ( i_first + i_record ) * a_record_bytes;
+
+                auto t_start = std::chrono::steady_clock::now();
+                t_compressor.compress( t_pointers.data(), t_n, t_packed.data(), t_stored_bytes.data() );
+                t_wall_sec += std::chrono::duration< double >( std::chrono::steady_clock::now() - t_start ).count();
+
+                const int8_t* t_stored = t_packed.data();
+                for( size_t i_record = 0; i_record < t_n; ++i_record )
+                {
+                    const int8_t* t_restored = t_stored;
+                    if( t_stored_bytes[ i_record ] < a_record_bytes )
+                    {
+                        t_codec.decompress( t_stored, t_stored_bytes[ i_record ], t_decompressed.data(), a_record_bytes );
+                        t_restored = t_decompressed.data();
+                    }
+                    if( ::memcmp( t_restored, t_pointers[ i_record ], a_record_bytes ) != 0 )
+                    {
+                        if( t_n_bad < 10 ) LERROR( plog, a_name << ": record " << i_first + i_record << " was not restored with " << to_string( t_compression ) );
+                        ++t_n_bad;
+                    }
+                    t_stored += t_stored_bytes[ i_record ];
+                }
+            }
+            LINFO( plog, a_name << ", " << to_string( t_compression ) << ", " << t_n_threads << " thread(s): ratio " << t_compressor.get_ratio() <<
+                    "; " << t_compressor.get_rate_per_thread() << " MB/s per thread; " << 1.e-6 * (double)a_records.size() / t_wall_sec << " MB/s total" );
+        }
+    }
+    return t_n_bad;
+}
+
+int main( const int argc, const char** argv )
+{
+    const size_t t_record_bytes = 8192;
+    const size_t t_n_records = 2048;
+
+    unsigned t_n_bad = 0;
+    try
+    {
+        std::vector< int8_t > t_in = simulate_records( 1, t_record_bytes, 20., 0. );
+        std::vector< int8_t > t_shuffled( t_record_bytes ), t_unshuffled( t_record_bytes );
+        bitshuffle( t_in.data(), t_shuffled.data(), t_record_bytes );
+        bitunshuffle( t_shuffled.data(), t_unshuffled.data(), t_record_bytes );
+        if( t_unshuffled != t_in )
+        {
+            LERROR( plog, "Bitshuffling is not reversible" );
+            ++t_n_bad;
+        }
+
+        for( double t_rms : { 1., 4., 16. } )
+        {
+            t_n_bad += benchmark( "Noise, RMS " + std::to_string( (int)t_rms ), simulate_records( t_n_records, t_record_bytes, t_rms, 0. ), t_record_bytes );
+        }
+        t_n_bad += benchmark( "Noise, RMS 4, plus tone", simulate_records( t_n_records, t_record_bytes, 4., 30. ), t_record_bytes );
+
+        if( argc > 1 )
+        {
+            raw_egg_file_reader t_reader;
+            t_reader.open( argv[ 1 ] );
+            size_t t_file_record_bytes = t_reader.header().f_record_bytes;
+            size_t t_n_file_records = std::min< uint64_t >( t_reader.get_n_records(), 4096 );
+            std::vector< int8_t > t_file_records( t_n_file_records * t_file_record_bytes );
+            for( size_t i_record = 0; i_record < t_n_file_records; ++i_record )
+            {
+                t_reader.read_record( i_record, t_file_records.data() + i_record * t_file_record_bytes );
+            }
+            t_n_bad += benchmark( std::string( "<" ) + argv[ 1 ] + ">", t_file_records, t_file_record_bytes );
+        }
+    }
+    catch( std::exception& e )
+    {
+        LERROR( plog, "Exception while testing: " << e.what() );
+        return -1;
+    }
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, t_n_bad << " problems were found" );
+        return -1;
+    }
+
+    LINFO( plog, "Record compression test complete" );
+    return 0;
+}
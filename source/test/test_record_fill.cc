@@ -0,0 +1,142 @@
+/*
+ * test_record_fill.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Benchmarks the ways streaming_writer can move a packet into the Monarch record buffer, over a pool of packets larger than the CPU caches:
+ *    - copy then stats: memcpy into the record, then a separate pass for the ADC statistics (each packet is read twice);
+ *    - fused: copy_adc_stats() into the record, as streaming_writer does with batch-size 1 (each packet is read once);
+ *    - staged: copy_adc_stats() into a batch buffer, then memcpy into the record, as streaming_writer does with batch-size > 1.
+ *  Checks that the fused copy gives the same record contents and statistics as the scalar reference, for each kernel instruction set.
+ *
+ *  Usage: > test_record_fill
+ *
+ *  Returns 0 if the checks pass; -1 otherwise.
+ */
+
+#include "adc_stats.hh"
+#include "spectrum_kernels.hh"
+
+#include "logger.hh"
+
+#include <chrono>
+#include <cstring>
+#include <random>
+#include <vector>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_record_fill" );
+
+bool same_stats( const adc_packet_stats& a_first, const adc_packet_stats& a_second )
+{
+    return a_first.f_n_samples == a_second.f_n_samples && a_first.f_sum_i == a_second.f_sum_i && a_first.f_sum_q == a_second.f_sum_q &&
+            a_first.f_sum_sq == a_second.f_sum_sq && a_first.f_min == a_second.f_min && a_first.f_max == a_second.f_max &&
+            a_first.f_n_high == a_second.f_n_high && a_first.f_n_low == a_second.f_n_low;
+}
+
+int main()
+{
+    // 64 MB of packets, so that they come from memory rather than cache, as they do in the writer
+    const size_t t_n_packets = 8192;
+    const size_t t_n_samples = PAYLOAD_SIZE / 2;
+    const size_t t_batch_size = 16;
+    const unsigned t_n_passes = 5;
+
+    std::mt19937 t_rng( 1618 );
+    std::uniform_int_distribution< int > t_dist( -128, 127 );
+    std::vector< int8_t > t_packets( t_n_packets * PAYLOAD_SIZE );
+    for( auto& t_value : t_packets ) t_value = (int8_t)t_dist( t_rng );
+
+    std::vector< int8_t > t_record( PAYLOAD_SIZE );
+    std::vector< int8_t > t_staging( t_batch_size * PAYLOAD_SIZE );
+
+    unsigned t_n_bad = 0;
+
+    // one packet with a tail that isn't a whole vector, to check the copy of the tail
+    const size_t t_odd_samples = t_n_samples - 3;
+    adc_packet_stats t_ref;
+    compute_adc_stats_scalar( t_packets.data(), t_odd_samples, t_ref );
+
+    for( kernel_isa t_isa : { kernel_isa::scalar, kernel_isa::avx2 } )
+    {
+        if( ! kernel_isa_supported( t_isa ) )
+        {
+            LINFO( plog, to_string( t_isa ) << " is not supported on this CPU" );
+            continue;
+        }
+        select_kernel_isa( t_isa );
+
+        std::vector< int8_t > t_dest( PAYLOAD_SIZE, 0 );
+        adc_packet_stats t_test;
+        copy_adc_stats( t_packets.data(), t_dest.data(), t_odd_samples, t_test );
+        if( ! same_stats( t_test, t_ref ) || ::memcmp( t_dest.data(), t_packets.data(), 2 * t_odd_samples ) != 0 ||
+                t_dest[ 2 * t_odd_samples ] != 0 )
+        {
+            LERROR( plog, to_string( t_isa ) << ": fused copy differs from the source or the reference statistics, or wrote past the end" );
+            ++t_n_bad;
+        }
+
+        adc_packet_stats t_stats;
+        uint64_t t_check = 0;
+
+        auto t_start = std::chrono::steady_clock::now();
+        for( unsigned i_pass = 0; i_pass < t_n_passes; ++i_pass )
+        {
+            for( size_t i_packet = 0; i_packet < t_n_packets; ++i_packet )
+            {
+                const int8_t* t_packet = t_packets.data() + i_packet * PAYLOAD_SIZE;
+                ::memcpy( t_record.data(), t_packet, PAYLOAD_SIZE );
+                compute_adc_stats( t_packet, t_n_samples, t_stats );
+                t_check += t_stats.f_sum_sq + (uint8_t)t_record[ i_packet % PAYLOAD_SIZE ];
+            }
+        }
+        double t_separate_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - t_start ).count() / (double)( t_n_passes * t_n_packets );
+
+        t_start = std::chrono::steady_clock::now();
+        for( unsigned i_pass = 0; i_pass < t_n_passes; ++i_pass )
+        {
+            for( size_t i_packet = 0; i_packet < t_n_packets; ++i_packet )
+            {
+                copy_adc_stats( t_packets.data() + i_packet * PAYLOAD_SIZE, t_record.data(), t_n_samples, t_stats );
+                t_check += t_stats.f_sum_sq + (uint8_t)t_record[ i_packet % PAYLOAD_SIZE ];
+            }
+        }
+        double t_fused_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - t_start ).count() / (double)( t_n_passes * t_n_packets );
+
+        t_start = std::chrono::steady_clock::now();
+        for( unsigned i_pass = 0; i_pass < t_n_passes; ++i_pass )
+        {
+            for( size_t i_packet = 0; i_packet < t_n_packets; ++i_packet )
+            {
+                int8_t* t_block = t_staging.data() + ( i_packet % t_batch_size ) * PAYLOAD_SIZE;
+                copy_adc_stats( t_packets.data() + i_packet * PAYLOAD_SIZE, t_block, t_n_samples, t_stats );
+                if( i_packet % t_batch_size == t_batch_size - 1 )
+                {
+                    for( size_t i_block = 0; i_block < t_batch_size; ++i_block )
+                    {
+                        ::memcpy( t_record.data(), t_staging.data() + i_block * PAYLOAD_SIZE, PAYLOAD_SIZE );
+                        t_check += (uint8_t)t_record[ i_block ];
+                    }
+                }
+                t_check += t_stats.f_sum_sq;
+            }
+        }
+        double t_staged_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - t_start ).count() / (double)( t_n_passes * t_n_packets );
+
+        // packet bytes read from memory for each record: the fused and staged versions read each packet once
+        LINFO( plog, "<" << to_string( t_isa ) << "> per packet:  copy then stats: " << t_separate_ns << " ns, " << 2 * PAYLOAD_SIZE <<
+                " bytes read;  fused: " << t_fused_ns << " ns, " << PAYLOAD_SIZE << " bytes read;  staged in batches of " << t_batch_size <<
+                ": " << t_staged_ns << " ns, " << PAYLOAD_SIZE << " bytes read  (check " << t_check % 1000 << ")" );
+    }
+    select_kernel_isa( best_kernel_isa() );
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, "Found " << t_n_bad << " problems" );
+        return -1;
+    }
+
+    LINFO( plog, "Record fill checks passed" );
+    return 0;
+}
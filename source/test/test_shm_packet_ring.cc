@@ -0,0 +1,188 @@
+/*
+ * test_shm_packet_ring.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Publishes packets to a shared-memory ring and reads them with the C reader functions in psyllid_shm_tap.h:
+ *    - a reader in another thread receives packets in order and intact, and every packet is either received or counted as an overrun;
+ *    - a reader that stops reading loses the packets that are overwritten, and exactly those are counted as overruns,
+ *      both in the writer's view of the readers and by the reader once it catches up;
+ *    - the writer's publishing rate is reported, with and without a reader attached.
+ *
+ *  Usage: > test_shm_packet_ring
+ *
+ *  Returns 0 if the checks pass; -1 otherwise.
+ */
+
+#include "shm_packet_ring.hh"
+#include "time_data.hh"
+
+#include "logger.hh"
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_shm_packet_ring" );
+
+void fill_packet( time_data& a_packet, uint64_t a_id )
+{
+    a_packet.set_pkt_in_session( a_id );
+    for( unsigned i_sample = 0; i_sample < a_packet.get_array_size(); ++i_sample )
+    {
+        a_packet.get_array()[ i_sample ][ 0 ] = (int8_t)( a_id + i_sample );
+        a_packet.get_array()[ i_sample ][ 1 ] = (int8_t)( a_id * 3 );
+    }
+    return;
+}
+
+bool check_slot( const psyllid_shm_tap_slot* a_slot )
+{
+    uint64_t t_id = a_slot->pkt_in_session;
+    return a_slot->payload[ 0 ] == (int8_t)t_id && a_slot->payload[ 1 ] == (int8_t)( t_id * 3 ) &&
+            a_slot->payload[ PSYLLID_SHM_TAP_PAYLOAD_SIZE - 2 ] == (int8_t)( t_id + PSYLLID_SHM_TAP_PAYLOAD_SIZE / 2 - 1 );
+}
+
+int main()
+{
+    const std::string t_name( "/psyllid_test_shm_packet_ring" );
+    const size_t t_n_slots = 64;
+    const uint64_t t_n_packets = 200000;
+
+    unsigned t_n_bad = 0;
+
+    shm_packet_ring t_ring;
+    t_ring.create( t_name, t_n_slots, PSYLLID_SHM_TAP_TIME_DATA );
+
+    time_data t_packet;
+
+    // writer rate with nobody reading
+    auto t_start = std::chrono::steady_clock::now();
+    for( uint64_t t_id = 0; t_id < t_n_packets; ++t_id )
+    {
+        fill_packet( t_packet, t_id );
+        t_ring.publish( t_packet, t_id );
+    }
+    double t_no_reader_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - t_start ).count() / (double)t_n_packets;
+    LINFO( plog, "Publishing with no readers: " << t_no_reader_ns << " ns per packet (including filling the packet)" );
+
+    // a stalled reader: attached, but never reads
+    psyllid_shm_tap_reader t_stalled;
+    if( psyllid_shm_tap_open( &t_stalled, t_name.c_str() ) != 0 )
+    {
+        LERROR( plog, "Unable to open the stalled reader" );
+        return -1;
+    }
+
+    // an active reader, in another thread
+    std::atomic< bool > t_ready( false );
+    std::atomic< bool > t_writer_done( false );
+    uint64_t t_n_received = 0, t_n_out_of_order = 0, t_n_corrupt = 0, t_n_torn = 0;
+    uint64_t t_active_overruns = 0;
+    std::thread t_reader( [&]()
+    {
+        psyllid_shm_tap_reader t_active;
+        if( psyllid_shm_tap_open( &t_active, t_name.c_str() ) != 0 )
+        {
+            t_ready.store( true );
+            return;
+        }
+        t_ready.store( true );
+        uint64_t t_expected = t_n_packets;
+        while( true )
+        {
+            // done is loaded before peeking, so an empty ring after the writer finished means everything was read
+            bool t_done = t_writer_done.load();
+            const psyllid_shm_tap_slot* t_slot = psyllid_shm_tap_peek( &t_active );
+            if( t_slot == nullptr )
+            {
+                if( t_done ) break;
+                continue;
+            }
+            bool t_ok = check_slot( t_slot );
+            uint64_t t_id = t_slot->pkt_in_session;
+            if( ! psyllid_shm_tap_done( &t_active ) )
+            {
+                ++t_n_torn;
+                continue;
+            }
+            if( t_id != t_expected ) ++t_n_out_of_order;
+            if( ! t_ok ) ++t_n_corrupt;
+            t_expected = t_id + 1;
+            ++t_n_received;
+        }
+        t_active_overruns = psyllid_shm_tap_overruns( &t_active );
+        psyllid_shm_tap_close( &t_active );
+    } );
+    while( ! t_ready.load() ) std::this_thread::yield();
+
+    // publish at a modest rate, so that the active reader can keep up with most of the packets
+    t_start = std::chrono::steady_clock::now();
+    for( uint64_t t_id = t_n_packets; t_id < 2 * t_n_packets; ++t_id )
+    {
+        fill_packet( t_packet, t_id );
+        t_ring.publish( t_packet, t_id );
+        if( t_id % 32 == 0 )
+        {
+            // let the reader catch up without the writer ever waiting on it
+            auto t_pause = std::chrono::steady_clock::now() + std::chrono::microseconds( 50 );
+            while( std::chrono::steady_clock::now() < t_pause );
+        }
+    }
+    double t_reader_ns = std::chrono::duration< double, std::nano >( std::chrono::steady_clock::now() - t_start ).count() / (double)t_n_packets;
+    t_writer_done.store( true );
+    t_reader.join();
+
+    LINFO( plog, "Active reader received " << t_n_received << " of " << t_n_packets << " packets; " << t_n_torn << " torn; " <<
+            t_active_overruns << " overruns; " << t_n_out_of_order << " out of order; " << t_n_corrupt << " corrupt" );
+    LINFO( plog, "Publishing with readers attached: " << t_reader_ns << " ns per packet (including filling the packet and pauses)" );
+    if( t_n_received + t_active_overruns != t_n_packets || t_n_corrupt != 0 || t_n_out_of_order > t_active_overruns )
+    {
+        LERROR( plog, "The active reader received corrupt or out-of-order packets, or lost packets were not counted" );
+        ++t_n_bad;
+    }
+
+    // the stalled reader lost everything except the last n-slots packets
+    std::vector< shm_packet_ring::reader_status > t_readers = t_ring.get_readers();
+    if( t_readers.size() != 1 || t_readers[ 0 ].f_lag != t_n_packets || t_readers[ 0 ].f_n_overruns != t_n_packets - t_n_slots )
+    {
+        LERROR( plog, "Writer should see one reader, lagging by " << t_n_packets << " packets, with " << t_n_packets - t_n_slots << " overruns" );
+        ++t_n_bad;
+    }
+    // after skipping ahead, the stalled reader gets the remaining packets in order
+    uint64_t t_n_remaining = 0;
+    const psyllid_shm_tap_slot* t_slot = nullptr;
+    while( ( t_slot = psyllid_shm_tap_peek( &t_stalled ) ) != nullptr )
+    {
+        if( t_slot->pkt_in_session != 2 * t_n_packets - t_n_slots + t_n_remaining || ! check_slot( t_slot ) ) ++t_n_bad;
+        psyllid_shm_tap_done( &t_stalled );
+        ++t_n_remaining;
+    }
+    if( t_n_remaining != t_n_slots )
+    {
+        LERROR( plog, "Stalled reader read " << t_n_remaining << " packets after catching up; expected " << t_n_slots );
+        ++t_n_bad;
+    }
+    uint64_t t_stalled_overruns = psyllid_shm_tap_overruns( &t_stalled );
+    LINFO( plog, "Stalled reader overruns: " << t_stalled_overruns << " (expected " << t_n_packets - t_n_slots << ")" );
+    if( t_stalled_overruns != t_n_packets - t_n_slots )
+    {
+        LERROR( plog, "Stalled reader overruns are not correct" );
+        ++t_n_bad;
+    }
+    psyllid_shm_tap_close( &t_stalled );
+
+    t_ring.destroy();
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, "Found " << t_n_bad << " problems" );
+        return -1;
+    }
+
+    LINFO( plog, "Shared-memory ring checks passed" );
+    return 0;
+}
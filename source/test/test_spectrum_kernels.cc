@@ -0,0 +1,156 @@
+/*
+ * test_spectrum_kernels.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Checks the vectorized spectrum kernels against the scalar reference implementations,
+ *  for every instruction set supported on this CPU, and reports the throughput of each.
+ *  Also checks the time and frequency averaging of summed spectra.
+ *
+ *  Usage: > test_spectrum_kernels
+ *
+ *  Returns 0 if all kernels agree with the scalar reference; -1 otherwise.
+ */
+
+#include "spectrum_average.hh"
+#include "spectrum_kernels.hh"
+
+#include "logger.hh"
+
+#include <chrono>
+#include <cmath>
+#include <random>
+#include <vector>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_spectrum_kernels" );
+
+// compares two arrays; returns the number of values that differ by more than the tolerance
+unsigned compare( const std::vector< float >& a_test, const std::vector< float >& a_ref, float a_tol, const std::string& a_name )
+{
+    unsigned t_n_bad = 0;
+    for( size_t i_bin = 0; i_bin < a_ref.size(); ++i_bin )
+    {
+        if( std::fabs( a_test[ i_bin ] - a_ref[ i_bin ] ) > a_tol )
+        {
+            if( t_n_bad < 5 )
+            {
+                LERROR( plog, a_name << ": mismatch in bin " << i_bin << ": " << a_test[ i_bin ] << " vs. " << a_ref[ i_bin ] );
+            }
+            ++t_n_bad;
+        }
+    }
+    return t_n_bad;
+}
+
+int main()
+{
+    // one packet's worth of samples, plus a few extra to exercise the non-vectorized tails
+    const size_t t_n_samples = PAYLOAD_SIZE / 2 + 7;
+    const unsigned t_n_packets = 4;
+    const float t_db_tol = 1.e-4;
+
+    std::mt19937 t_rng( 8675309 );
+    std::uniform_int_distribution< int > t_dist( -128, 127 );
+
+    std::vector< int8_t > t_iq( 2 * t_n_samples * t_n_packets );
+    for( auto& t_value : t_iq ) t_value = (int8_t)t_dist( t_rng );
+    // include the extremes explicitly
+    t_iq[ 0 ] = -128; t_iq[ 1 ] = -128;
+    t_iq[ 2 ] = 127; t_iq[ 3 ] = -128;
+    t_iq[ 4 ] = 0; t_iq[ 5 ] = 0;
+
+    // scalar reference
+    std::vector< float > t_ref_power( t_n_samples ), t_ref_db( t_n_samples ), t_ref_sum( t_n_samples, 0. ), t_ref_max( t_n_samples, 0. );
+    iq_to_power_scalar( t_iq.data(), t_ref_power.data(), t_n_samples );
+    iq_to_db_scalar( t_iq.data(), t_ref_db.data(), t_n_samples );
+    for( unsigned i_packet = 0; i_packet < t_n_packets; ++i_packet )
+    {
+        accumulate_power_scalar( t_iq.data() + 2 * t_n_samples * i_packet, t_ref_sum.data(), t_n_samples );
+        max_hold_power_scalar( t_iq.data() + 2 * t_n_samples * i_packet, t_ref_max.data(), t_n_samples );
+    }
+
+    unsigned t_n_bad = 0;
+
+    kernel_isa t_isas[ 3 ] = { kernel_isa::scalar, kernel_isa::sse2, kernel_isa::avx2 };
+    for( kernel_isa t_isa : t_isas )
+    {
+        if( ! kernel_isa_supported( t_isa ) )
+        {
+            LINFO( plog, "Instruction set <" << to_string( t_isa ) << "> is not supported on this CPU; skipping" );
+            continue;
+        }
+        select_kernel_isa( t_isa );
+        LINFO( plog, "Testing kernels with instruction set <" << to_string( active_kernel_isa() ) << ">" );
+
+        std::vector< float > t_power( t_n_samples ), t_db( t_n_samples ), t_sum( t_n_samples, 0. ), t_max( t_n_samples, 0. );
+        iq_to_power( t_iq.data(), t_power.data(), t_n_samples );
+        iq_to_db( t_iq.data(), t_db.data(), t_n_samples );
+        for( unsigned i_packet = 0; i_packet < t_n_packets; ++i_packet )
+        {
+            accumulate_power( t_iq.data() + 2 * t_n_samples * i_packet, t_sum.data(), t_n_samples );
+            max_hold_power( t_iq.data() + 2 * t_n_samples * i_packet, t_max.data(), t_n_samples );
+        }
+
+        t_n_bad += compare( t_power, t_ref_power, 0., "iq_to_power" );
+        t_n_bad += compare( t_db, t_ref_db, t_db_tol, "iq_to_db" );
+        t_n_bad += compare( t_sum, t_ref_sum, 0., "accumulate_power" );
+        t_n_bad += compare( t_max, t_ref_max, 0., "max_hold_power" );
+
+        // throughput, in packets per second, for the power and dB kernels
+        const unsigned t_n_reps = 20000;
+        auto t_start = std::chrono::steady_clock::now();
+        for( unsigned i_rep = 0; i_rep < t_n_reps; ++i_rep )
+        {
+            iq_to_power( t_iq.data(), t_power.data(), PAYLOAD_SIZE / 2 );
+        }
+        auto t_mid = std::chrono::steady_clock::now();
+        for( unsigned i_rep = 0; i_rep < t_n_reps; ++i_rep )
+        {
+            iq_to_db( t_iq.data(), t_db.data(), PAYLOAD_SIZE / 2 );
+        }
+        auto t_end = std::chrono::steady_clock::now();
+        double t_power_sec = std::chrono::duration< double >( t_mid - t_start ).count();
+        double t_db_sec = std::chrono::duration< double >( t_end - t_mid ).count();
+        LINFO( plog, "<" << to_string( t_isa ) << "> iq_to_power: " << t_n_reps / t_power_sec << " packets/s;  iq_to_db: " << t_n_reps / t_db_sec << " packets/s" );
+    }
+
+    // averaging: the packets' power spectra, summed, averaged, and decimated by 4, against a direct average of each group of bins
+    const unsigned t_decimation = 4;
+    const size_t t_n_avg_bins = PAYLOAD_SIZE / 2;
+    std::vector< float > t_sum( t_n_avg_bins, 0.f );
+    std::vector< float > t_avg_ref( t_n_avg_bins / t_decimation, 0.f );
+    for( unsigned i_pkt = 0; i_pkt < t_n_packets; ++i_pkt )
+    {
+        const int8_t* t_pkt_iq = t_iq.data() + 2 * t_n_samples * i_pkt;
+        accumulate_power_scalar( t_pkt_iq, t_sum.data(), t_n_avg_bins );
+        for( size_t i_bin = 0; i_bin < t_n_avg_bins; ++i_bin )
+        {
+            int32_t t_i = t_pkt_iq[ 2*i_bin ];
+            int32_t t_q = t_pkt_iq[ 2*i_bin + 1 ];
+            t_avg_ref[ i_bin / t_decimation ] += (float)( t_i * t_i + t_q * t_q ) / (float)( t_n_packets * t_decimation );
+        }
+    }
+    std::vector< float > t_avg( t_avg_ref.size() );
+    average_spectra( t_sum.data(), t_n_packets, t_decimation, t_avg.data(), t_avg.size() );
+    t_n_bad += compare( t_avg, t_avg_ref, 1.e-2, "average_spectra" );
+    for( size_t i_bin = 0; i_bin < t_sum.size(); ++i_bin )
+    {
+        if( t_sum[ i_bin ] != 0.f )
+        {
+            LERROR( plog, "average_spectra: the sum was not cleared" );
+            ++t_n_bad;
+            break;
+        }
+    }
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, "Found " << t_n_bad << " mismatched values" );
+        return -1;
+    }
+
+    LINFO( plog, "All kernels agree with the scalar reference" );
+    return 0;
+}
@@ -0,0 +1,158 @@
+/*
+ * test_trigger_flag.cc
+ *
+ *  Created on: Oct 18, 2026
+ *
+ *  Checks apply_threshold_levels() against a scalar reference, for several numbers of levels and of bins
+ *  (including numbers of bins that aren't a multiple of the bitmap word size):
+ *    - the flag, level and high_threshold;
+ *    - the bin bitmap, n_bins_crossed() and get_crossed_bins();
+ *  and checks that too many levels are rejected.
+ *
+ *  Usage: > test_trigger_flag
+ *
+ *  Returns 0 if the results agree with the reference; -1 otherwise.
+ */
+
+#include "trigger_flag.hh"
+
+#include "psyllid_error.hh"
+
+#include "logger.hh"
+
+#include <random>
+#include <string>
+#include <vector>
+
+using namespace psyllid;
+
+LOGGER( plog, "test_trigger_flag" );
+
+// applies the levels to a random spectrum and compares with the reference; returns the number of mismatches
+unsigned check_levels( unsigned a_n_levels, size_t a_n_bins, std::mt19937& a_rng, trigger_flag& a_flag )
+{
+    std::uniform_real_distribution< float > t_dist( 0., 1. );
+
+    // increasing thresholds, so that the number of levels crossed is the highest level crossed
+    std::vector< float > t_masks( a_n_levels * a_n_bins );
+    for( unsigned i_level = 0; i_level < a_n_levels; ++i_level )
+    {
+        for( size_t i_bin = 0; i_bin < a_n_bins; ++i_bin )
+        {
+            t_masks[ i_level * a_n_bins + i_bin ] = ( (float)i_level + 0.5f ) / (float)a_n_levels;
+        }
+    }
+
+    std::vector< float > t_power( a_n_bins );
+    for( auto& t_value : t_power ) t_value = t_dist( a_rng ) * 0.8f;
+    // the last bin crosses every level, if there are any bins
+    if( a_n_bins > 0 ) t_power.back() = 2.f;
+
+    apply_threshold_levels( t_power.data(), t_masks.data(), a_n_levels, a_n_bins, a_flag );
+
+    // scalar reference
+    unsigned t_ref_level = 0;
+    std::vector< unsigned > t_ref_bins;
+    for( size_t i_bin = 0; i_bin < a_n_bins; ++i_bin )
+    {
+        unsigned t_bin_level = 0;
+        for( unsigned i_level = 0; i_level < a_n_levels; ++i_level )
+        {
+            if( t_power[ i_bin ] > t_masks[ i_level * a_n_bins + i_bin ] ) t_bin_level = i_level + 1;
+        }
+        if( t_bin_level > 0 ) t_ref_bins.push_back( i_bin );
+        if( t_bin_level > t_ref_level ) t_ref_level = t_bin_level;
+    }
+    bool t_ref_flag = t_ref_level > 0;
+    bool t_ref_high = a_n_levels > 0 && t_ref_level == a_n_levels;
+
+    std::string t_name( std::to_string( a_n_levels ) + " levels, " + std::to_string( a_n_bins ) + " bins" );
+    unsigned t_n_bad = 0;
+    if( a_flag.get_flag() != t_ref_flag || a_flag.get_level() != t_ref_level || a_flag.get_high_threshold() != t_ref_high )
+    {
+        LERROR( plog, t_name << ": flag/level/high-threshold are " << a_flag.get_flag() << "/" << a_flag.get_level() << "/" << a_flag.get_high_threshold() <<
+                "; expected " << t_ref_flag << "/" << t_ref_level << "/" << t_ref_high );
+        ++t_n_bad;
+    }
+
+    if( a_flag.get_n_bins() != a_n_bins || a_flag.get_n_bitmap_words() != ( a_n_bins + trigger_flag::s_bits_per_word - 1 ) / trigger_flag::s_bits_per_word )
+    {
+        LERROR( plog, t_name << ": bitmap covers " << a_flag.get_n_bins() << " bins in " << a_flag.get_n_bitmap_words() << " words" );
+        ++t_n_bad;
+    }
+
+    size_t i_ref = 0;
+    for( size_t i_bin = 0; i_bin < a_n_bins; ++i_bin )
+    {
+        bool t_ref_crossed = i_ref < t_ref_bins.size() && t_ref_bins[ i_ref ] == i_bin;
+        if( t_ref_crossed ) ++i_ref;
+        if( a_flag.bin_crossed( i_bin ) != t_ref_crossed )
+        {
+            if( t_n_bad < 5 ) LERROR( plog, t_name << ": bitmap mismatch in bin " << i_bin );
+            ++t_n_bad;
+        }
+    }
+    // the bits past the last bin must be clear
+    if( a_n_bins % trigger_flag::s_bits_per_word != 0 && ( a_flag.get_bitmap()[ a_flag.get_n_bitmap_words() - 1 ] >> ( a_n_bins % trigger_flag::s_bits_per_word ) ) != 0 )
+    {
+        LERROR( plog, t_name << ": bits are set past the last bin" );
+        ++t_n_bad;
+    }
+
+    std::vector< unsigned > t_bins;
+    a_flag.get_crossed_bins( t_bins );
+    if( a_flag.n_bins_crossed() != t_ref_bins.size() || t_bins != t_ref_bins )
+    {
+        LERROR( plog, t_name << ": " << a_flag.n_bins_crossed() << " bins crossed (" << t_bins.size() << " listed); expected " << t_ref_bins.size() );
+        ++t_n_bad;
+    }
+
+    return t_n_bad;
+}
+
+int main()
+{
+    std::mt19937 t_rng( 8675309 );
+    unsigned t_n_bad = 0;
+
+    try
+    {
+        // one flag is reused, as in the data path, so the bitmap is resized and overwritten between checks
+        trigger_flag t_flag;
+        for( unsigned t_n_levels : { 0U, 1U, 2U, 5U, trigger_flag::s_max_levels } )
+        {
+            for( size_t t_n_bins : { 0UL, 1UL, 63UL, 64UL, 65UL, 1000UL, 4096UL } )
+            {
+                t_n_bad += check_levels( t_n_levels, t_n_bins, t_rng, t_flag );
+            }
+        }
+    }
+    catch( std::exception& e )
+    {
+        LERROR( plog, "Exception while testing: " << e.what() );
+        return -1;
+    }
+
+    // more levels than the per-bin counts can hold must be rejected rather than wrapping
+    try
+    {
+        trigger_flag t_flag;
+        std::vector< float > t_power( 10, 1.f ), t_masks( 10 * ( trigger_flag::s_max_levels + 1 ), 0.f );
+        apply_threshold_levels( t_power.data(), t_masks.data(), trigger_flag::s_max_levels + 1, 10, t_flag );
+        LERROR( plog, "Too many levels were not rejected" );
+        ++t_n_bad;
+    }
+    catch( psyllid::error& e )
+    {
+        LINFO( plog, "Too many levels were rejected: " << e.what() );
+    }
+
+    if( t_n_bad != 0 )
+    {
+        LERROR( plog, t_n_bad << " problems were found" );
+        return -1;
+    }
+
+    LINFO( plog, "Trigger flag test complete" );
+    return 0;
+}
@@ -0,0 +1,173 @@
+/*
+ * mirrored_buffer.cc
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#include "mirrored_buffer.hh"
+
+#include "psyllid_error.hh"
+
+#include <atomic>
+#include <cerrno>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <unistd.h>
+
+namespace psyllid
+{
+
+    mirrored_buffer::mirrored_buffer() :
+            f_data( nullptr ),
+            f_size( 0 ),
+            f_huge_pages( false )
+    {
+    }
+
+    mirrored_buffer::~mirrored_buffer()
+    {
+        release();
+    }
+
+    namespace
+    {
+        // the default huge page size ("Hugepagesize:    2048 kB"); 0 if it's unknown
+        size_t read_huge_page_size()
+        {
+#ifdef __linux__
+            std::ifstream t_meminfo( "/proc/meminfo" );
+            std::string t_line;
+            while( std::getline( t_meminfo, t_line ) )
+            {
+                if( t_line.compare( 0, 13, "Hugepagesize:" ) != 0 ) continue;
+                std::istringstream t_value( t_line.substr( 13 ) );
+                size_t t_kb = 0;
+                if( t_value >> t_kb ) return t_kb * 1024;
+                break;
+            }
+#endif
+            return 0;
+        }
+    }
+
+    size_t mirrored_buffer::granularity( bool a_huge_pages )
+    {
+        size_t t_page_size = (size_t)::sysconf( _SC_PAGESIZE );
+        if( ! a_huge_pages ) return t_page_size;
+
+        static std::atomic< size_t > s_huge_page_size( 0 );
+        size_t t_huge_page_size = s_huge_page_size.load( std::memory_order_relaxed );
+        if( t_huge_page_size == 0 )
+        {
+            t_huge_page_size = read_huge_page_size();
+            // without huge pages, the buffer falls back to normal pages
+            if( t_huge_page_size < t_page_size ) t_huge_page_size = t_page_size;
+            s_huge_page_size.store( t_huge_page_size, std::memory_order_relaxed );
+        }
+        return t_huge_page_size;
+    }
+
+    void mirrored_buffer::allocate( size_t a_min_bytes, bool a_use_huge_pages )
+    {
+        if( a_min_bytes == 0 )
+        {
+            throw error() << "Mirrored buffer size must be positive";
+        }
+        release();
+
+        if( a_use_huge_pages )
+        {
+            size_t t_gran = granularity( true );
+            if( try_map( ( a_min_bytes + t_gran - 1 ) / t_gran * t_gran, true ) ) return;
+        }
+
+        size_t t_gran = granularity( false );
+        if( ! try_map( ( a_min_bytes + t_gran - 1 ) / t_gran * t_gran, false ) )
+        {
+            int t_errno = errno;
+            throw error() << "Unable to create a mirrored buffer of " << a_min_bytes << " bytes: " << strerror( t_errno );
+        }
+        return;
+    }
+
+    bool mirrored_buffer::try_map( size_t a_bytes, bool a_huge_pages )
+    {
+#ifdef __linux__
+        int t_fd = ::memfd_create( "psyllid_mirrored_buffer", MFD_CLOEXEC | ( a_huge_pages ? MFD_HUGETLB : 0 ) );
+        if( t_fd < 0 ) return false;
+        int t_populate = a_huge_pages ? MAP_POPULATE : 0;
+#else
+        if( a_huge_pages ) return false;
+        // the object is unlinked right away, so only the mappings refer to it;
+        // the name has to be short (31 characters on macOS), so it's the process ID and a counter, in hex
+        static std::atomic< unsigned > s_shm_counter( 0 );
+        std::stringstream t_name_sstr;
+        t_name_sstr << "/psymb" << std::hex << (unsigned)::getpid() << "_" << s_shm_counter.fetch_add( 1 );
+        int t_fd = ::shm_open( t_name_sstr.str().c_str(), O_RDWR | O_CREAT | O_EXCL, 0600 );
+        if( t_fd < 0 ) return false;
+        ::shm_unlink( t_name_sstr.str().c_str() );
+        int t_populate = 0;
+#endif
+
+        if( ::ftruncate( t_fd, a_bytes ) != 0 )
+        {
+            int t_errno = errno;
+            ::close( t_fd );
+            errno = t_errno;
+            return false;
+        }
+
+        // reserve twice the space, then map the file into each half
+        void* t_reserved = ::mmap( nullptr, 2 * a_bytes, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0 );
+        if( t_reserved == MAP_FAILED )
+        {
+            int t_errno = errno;
+            ::close( t_fd );
+            errno = t_errno;
+            return false;
+        }
+        char* t_base = static_cast< char* >( t_reserved );
+
+        if( ::mmap( t_base, a_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED | t_populate, t_fd, 0 ) == MAP_FAILED ||
+            ::mmap( t_base + a_bytes, a_bytes, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, t_fd, 0 ) == MAP_FAILED )
+        {
+            int t_errno = errno;
+            ::munmap( t_base, 2 * a_bytes );
+            ::close( t_fd );
+            errno = t_errno;
+            return false;
+        }
+
+        // the mappings keep the memory alive
+        ::close( t_fd );
+
+        if( ! a_huge_pages )
+        {
+            // touch the memory now so that page faults don't happen while the buffer is in use
+            ::memset( t_base, 0, a_bytes );
+        }
+
+        f_data = t_base;
+        f_size = a_bytes;
+        f_huge_pages = a_huge_pages;
+        return true;
+    }
+
+    void mirrored_buffer::release()
+    {
+        if( f_data != nullptr )
+        {
+            ::munmap( f_data, 2 * f_size );
+            f_data = nullptr;
+        }
+        f_size = 0;
+        f_huge_pages = false;
+        return;
+    }
+
+} /* namespace psyllid */
@@ -0,0 +1,84 @@
+/*
+ * mirrored_buffer.hh
+ *
+ *  Created on: Oct 18, 2026
+ */
+
+#ifndef PSYLLID_MIRRORED_BUFFER_HH_
+#define PSYLLID_MIRRORED_BUFFER_HH_
+
+#include <cstddef>
+
+namespace psyllid
+{
+
+    /*!
+     @class mirrored_buffer
+     @brief Circular buffer memory that is mapped twice, back-to-back, in virtual memory
+
+     @details
+     The same physical pages (from a memfd) are mapped at [data(), data() + size()) and again at [data() + size(), data() + 2*size()).
+     Any range of up to size() bytes starting anywhere in the first mapping is therefore contiguous in virtual memory,
+     even if it wraps around the end of the buffer; circular-buffer users don't need to split or copy ranges that wrap.
+
+     The size is rounded up to a multiple of the page size (or of the huge page size, if huge pages are used).
+     If huge pages are requested but aren't available, normal pages are used.
+
+     On Linux, the memory comes from memfd_create, and huge pages (of the system's default huge page size) can be used.
+     Elsewhere, an unlinked POSIX shared-memory object is used, with normal pages only.
+    */
+    class mirrored_buffer
+    {
+        public:
+            mirrored_buffer();
+            ~mirrored_buffer();
+
+            mirrored_buffer( const mirrored_buffer& ) = delete;
+            mirrored_buffer& operator=( const mirrored_buffer& ) = delete;
+
+            /// Allocates and maps the buffer, releasing any existing buffer; throws psyllid::error on failure
+            void allocate( size_t a_min_bytes, bool a_use_huge_pages = false );
+            void release();
+
+            /// Size of the buffer (the length of one mapping)
+            size_t size() const;
+            /// Start of the first mapping; the second mapping starts at data() + size()
+            char* data();
+            const char* data() const;
+
+            bool uses_huge_pages() const;
+
+            /// Granularity of the buffer size for the given page type; for huge pages, this is the Hugepagesize from /proc/meminfo
+            static size_t granularity( bool a_huge_pages );
+
+        private:
+            bool try_map( size_t a_bytes, bool a_huge_pages );
+
+            char* f_data;
+            size_t f_size;
+            bool f_huge_pages;
+    };
+
+    inline size_t mirrored_buffer::size() const
+    {
+        return f_size;
+    }
+
+    inline char* mirrored_buffer::data()
+    {
+        return f_data;
+    }
+
+    inline const char* mirrored_buffer::data() const
+    {
+        return f_data;
+    }
+
+    inline bool mirrored_buffer::uses_huge_pages() const
+    {
+        return f_huge_pages;
+    }
+
+} /* namespace psyllid */
+
+#endif /* PSYLLID_MIRRORED_BUFFER_HH_ */